@@ -0,0 +1,64 @@
+#include "../src/kernels.h"
+#include "../src/support_functions.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <utility>
+
+namespace
+{
+    using ActivationFunctions::Accuracy;
+    using ActivationFunctions::ActivationType;
+
+    /// Values per second of the value and derivative of one function over a buffer that stays in the L1 cache
+    template<typename T>
+    double Throughput(const Activation& activation)
+    {
+        const size_t count = 4096;
+        std::vector<T> inputs(count), outputs(count), derivatives(count);
+        for (size_t i = 0 ; i < count ; i++)
+        {
+            inputs[i] = static_cast<T>(6.0 * i / count - 3);
+        }
+
+        int repeats = 0;
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0;
+        do
+        {
+            for (int i = 0 ; i < 50 ; i++, repeats++)
+            {
+                activation.ApplyWithDerivative(inputs.data(), count, outputs.data(), derivatives.data());
+            }
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        while (seconds < 0.1);
+        return static_cast<double>(count) * repeats / seconds;
+    }
+
+    template<typename T>
+    void Run(const char* precision)
+    {
+        const std::pair<const char*, ActivationType> functions[] = {
+            {"sigmoid", ActivationType::Sigmoid}, {"tanh", ActivationType::Tanh}, {"elu", ActivationType::Elu},
+            {"softplus", ActivationType::Softplus}, {"gelu", ActivationType::Gelu}, {"silu", ActivationType::Silu}};
+        for (const auto& function : functions)
+        {
+            const double libm = Throughput<T>(Activation(function.second, Accuracy::Exact));
+            const double approximated = Throughput<T>(Activation(function.second, Accuracy::Fast));
+            std::cout << precision << "\t" << std::setw(8) << function.first << std::scientific << std::setprecision(2)
+                      << "\tvalues per second\tlibm " << libm << "\tfast " << approximated
+                      << std::fixed << std::setprecision(1) << "\t" << approximated / libm << "x" << std::endl;
+        }
+    }
+}
+
+int main()
+{
+    std::cout << "Instruction set: " << Kernels::GetInstructionSetName(Kernels::DetectInstructionSet()) << std::endl;
+    Run<double>("double");
+    Run<float>("float");
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    /// Synthetic regression dataset with a few outputs, y_j = sin(x_j + x_{j+1})
+    void MakeDataset(int rows, int inputs, int outputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(17);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(outputs));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            for (double& value : x[r]) { value = distribution(generator); }
+            for (int j = 0 ; j < outputs ; j++) { y[r][j] = std::sin(x[r][j] + x[r][j + 1]); }
+        }
+    }
+
+    /// Seconds per epoch of a wide network, with and without huge pages behind the workspaces
+    double SecondsPerEpoch(bool hugePages)
+    {
+        std::vector<std::vector<double>> x, y;
+        MakeDataset(4096, 16, 4, x, y);
+        NeuralNetwork network({512, 512}, ActivationFunctions::relu, LossFunctions::mse, 2, 0.001);
+        network.SetSeed(2);
+        network.SetBatchSize(256);
+        network.SetHugePages(hugePages);
+        network.Initialize(x, y);
+
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        network.Train();
+        const auto start = std::chrono::steady_clock::now();
+        network.Train();
+        std::cout.rdbuf(original);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 2;
+    }
+}
+
+int main()
+{
+    const double regular = SecondsPerEpoch(false);
+    const double huge = SecondsPerEpoch(true);
+    std::cout << std::fixed << std::setprecision(3) << "16-512-512-4, batch 256\tseconds per epoch " << regular
+              << "\twith huge pages " << huge << "\t" << regular / huge << "x" << std::endl;
+    return 0;
+}
@@ -0,0 +1,496 @@
+#include "benchmark.h"
+
+#include <cmath>
+#include <ctime>
+#include <regex>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <unistd.h>
+
+namespace Benchmark
+{
+    namespace
+    {
+        /// Upper bound on the iterations of a single run, as in Google Benchmark
+        constexpr long MaxIterations = 1000000000;
+
+        double RealNow()
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        double CpuNow()
+        {
+            return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+        }
+
+        std::vector<std::unique_ptr<Registration>>& Registry()
+        {
+            static std::vector<std::unique_ptr<Registration>> registrations;
+            return registrations;
+        }
+
+        std::vector<std::pair<std::string, std::string>>& Context()
+        {
+            static std::vector<std::pair<std::string, std::string>> context;
+            return context;
+        }
+
+        /// Number of units in a second for each time unit a benchmark can be reported in
+        double UnitsPerSecond(const std::string& unit)
+        {
+            if (unit == "s")  return 1;
+            if (unit == "ms") return 1e3;
+            if (unit == "us") return 1e6;
+            if (unit == "ns") return 1e9;
+            throw(std::invalid_argument("Unknown time unit " + unit));
+        }
+
+        std::string EscapeJson(const std::string& text)
+        {
+            std::string escaped;
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    escaped += '\\';
+                    escaped += c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", c);
+                    escaped += code;
+                }
+                else
+                {
+                    escaped += c;
+                }
+            }
+            return escaped;
+        }
+
+        /// Formats a count the way Google Benchmark prints counters, with a k/M/G suffix
+        std::string HumanReadable(double value)
+        {
+            const char* suffixes[] = {"", "k", "M", "G", "T"};
+            int index = 0;
+            while (std::abs(value) >= 1000 && index < 4)
+            {
+                value /= 1000;
+                index++;
+            }
+            std::ostringstream text;
+            text << std::setprecision(value < 100 ? 3 : 4) << value << suffixes[index];
+            return text.str();
+        }
+    }
+
+    /// Results of one run of a benchmark with one set of arguments
+    struct Result
+    {
+        std::string name;
+        std::string runName;
+        long iterations;
+        double realTime;
+        double cpuTime;
+        std::string unit;
+        std::string label;
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    struct Runner
+    {
+        /// Lists the names and arguments of every run of a benchmark, where a benchmark without arguments has one run
+        static std::vector<std::pair<std::string, std::vector<long>>> ListRuns(const Registration& registration)
+        {
+            std::vector<std::vector<long>> runs = registration.runs;
+            if (runs.empty())
+            {
+                runs.emplace_back();
+            }
+            std::vector<std::pair<std::string, std::vector<long>>> named;
+            for (const std::vector<long>& args : runs)
+            {
+                std::string name = registration.name;
+                for (long arg : args)
+                {
+                    name += "/" + std::to_string(arg);
+                }
+                named.emplace_back(name, args);
+            }
+            return named;
+        }
+
+        /// Runs a benchmark for a fixed number of iterations and returns its state
+        static State RunOnce(const Registration& registration, const std::vector<long>& args, long iterations)
+        {
+            State state(args, iterations);
+            registration.function(state);
+            if (state.running)
+            {
+                throw(std::logic_error("Benchmark " + registration.name + " did not finish its loop over the state"));
+            }
+            return state;
+        }
+
+        /// Grows the number of iterations until a run takes at least the minimum time, and summarises the last run
+        static Result Run(const Registration& registration, const std::vector<long>& args, const std::string& name, double minTime)
+        {
+            long iterations = registration.iterations > 0 ? registration.iterations : 1;
+            State state = RunOnce(registration, args, iterations);
+            while (registration.iterations <= 0 && state.realTime < minTime && iterations < MaxIterations)
+            {
+                // Aim slightly past the minimum time, and jump by at most ten times while the estimate is unreliable
+                const double multiplier = minTime * 1.4 / std::max(state.realTime, 1e-9);
+                const double growth = state.realTime / minTime > 0.1 ? multiplier : 10;
+                iterations = std::min(MaxIterations, std::max(iterations + 1, static_cast<long>(iterations * std::min(growth, 10.0))));
+                state = RunOnce(registration, args, iterations);
+            }
+
+            Result result;
+            result.name = name;
+            result.runName = name;
+            result.iterations = iterations;
+            result.unit = registration.unit;
+            const double units = UnitsPerSecond(registration.unit);
+            result.realTime = state.realTime / iterations * units;
+            result.cpuTime = state.cpuTime / iterations * units;
+            result.label = state.label;
+            if (state.bytesProcessed > 0)
+            {
+                result.counters.emplace_back("bytes_per_second", state.bytesProcessed / state.realTime);
+            }
+            if (state.itemsProcessed > 0)
+            {
+                result.counters.emplace_back("items_per_second", state.itemsProcessed / state.realTime);
+            }
+            for (const auto& counter : state.counters)
+            {
+                double value = counter.second.value;
+                if (counter.second.flags & Counter::IsRate)
+                {
+                    value /= state.realTime;
+                }
+                if (counter.second.flags & Counter::AvgIterations)
+                {
+                    value /= iterations;
+                }
+                result.counters.emplace_back(counter.first, value);
+            }
+            return result;
+        }
+
+        static void WriteJson(std::ostream& out, const std::vector<Result>& results, const char* executable)
+        {
+            char hostName[256] = "unknown";
+            gethostname(hostName, sizeof(hostName) - 1);
+            char date[64];
+            const std::time_t now = std::time(nullptr);
+            std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+            out << std::setprecision(10);
+            out << "{\n  \"context\": {\n";
+            out << "    \"date\": \"" << date << "\",\n";
+            out << "    \"host_name\": \"" << EscapeJson(hostName) << "\",\n";
+            out << "    \"executable\": \"" << EscapeJson(executable) << "\",\n";
+            out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+            for (const auto& entry : Context())
+            {
+                out << "    \"" << EscapeJson(entry.first) << "\": \"" << EscapeJson(entry.second) << "\",\n";
+            }
+#ifdef __OPTIMIZE__
+            out << "    \"library_build_type\": \"release\"\n";
+#else
+            out << "    \"library_build_type\": \"debug\"\n";
+#endif
+            out << "  },\n  \"benchmarks\": [";
+            for (size_t i = 0 ; i < results.size() ; i++)
+            {
+                const Result& result = results[i];
+                out << (i ? ",\n" : "\n") << "    {\n";
+                out << "      \"name\": \"" << EscapeJson(result.name) << "\",\n";
+                out << "      \"run_name\": \"" << EscapeJson(result.runName) << "\",\n";
+                out << "      \"run_type\": \"iteration\",\n";
+                out << "      \"repetitions\": 1,\n";
+                out << "      \"repetition_index\": 0,\n";
+                out << "      \"threads\": 1,\n";
+                out << "      \"iterations\": " << result.iterations << ",\n";
+                out << "      \"real_time\": " << result.realTime << ",\n";
+                out << "      \"cpu_time\": " << result.cpuTime << ",\n";
+                out << "      \"time_unit\": \"" << result.unit << "\"";
+                for (const auto& counter : result.counters)
+                {
+                    out << ",\n      \"" << EscapeJson(counter.first) << "\": " << counter.second;
+                }
+                if (!result.label.empty())
+                {
+                    out << ",\n      \"label\": \"" << EscapeJson(result.label) << "\"";
+                }
+                out << "\n    }";
+            }
+            out << "\n  ]\n}\n";
+        }
+    };
+
+    State::State(const std::vector<long>& inputArgs, long inputMaxIterations)
+                :
+                args(inputArgs),
+                maxIterations(inputMaxIterations),
+                running(false),
+                realStart(0),
+                cpuStart(0),
+                realTime(0),
+                cpuTime(0),
+                itemsProcessed(0),
+                bytesProcessed(0)
+    {
+    }
+
+    bool State::Iterator::operator!=(const Iterator&) const
+    {
+        if (remaining > 0)
+        {
+            return true;
+        }
+        state->PauseTiming();
+        return false;
+    }
+
+    State::Iterator State::begin()
+    {
+        ResumeTiming();
+        return Iterator(this, maxIterations);
+    }
+
+    State::Iterator State::end()
+    {
+        return Iterator(this, 0);
+    }
+
+    long State::Range(int index) const
+    {
+        if (index < 0 || index >= static_cast<int>(args.size()))
+        {
+            throw(std::out_of_range("Benchmark argument index is out of bounds"));
+        }
+        return args[index];
+    }
+
+    long State::Iterations() const
+    {
+        return this->maxIterations;
+    }
+
+    void State::PauseTiming()
+    {
+        if (running)
+        {
+            realTime += RealNow() - realStart;
+            cpuTime += CpuNow() - cpuStart;
+            running = false;
+        }
+    }
+
+    void State::ResumeTiming()
+    {
+        if (!running)
+        {
+            running = true;
+            cpuStart = CpuNow();
+            realStart = RealNow();
+        }
+    }
+
+    void State::SetItemsProcessed(double items)
+    {
+        this->itemsProcessed = items;
+    }
+
+    void State::SetBytesProcessed(double bytes)
+    {
+        this->bytesProcessed = bytes;
+    }
+
+    void State::SetLabel(const std::string& inputLabel)
+    {
+        this->label = inputLabel;
+    }
+
+    Registration::Registration(const std::string& inputName, Function inputFunction)
+                              :
+                              name(inputName),
+                              function(inputFunction),
+                              iterations(0),
+                              unit("ns")
+    {
+    }
+
+    Registration* Registration::Arg(long value)
+    {
+        runs.push_back({value});
+        return this;
+    }
+
+    Registration* Registration::Args(std::initializer_list<long> values)
+    {
+        runs.push_back(values);
+        return this;
+    }
+
+    Registration* Registration::Range(long start, long limit, long multiplier)
+    {
+        if (start < 1 || limit < start || multiplier < 2)
+        {
+            throw(std::invalid_argument("Benchmark ranges need 1 <= start <= limit and a multiplier of at least 2"));
+        }
+        runs.push_back({start});
+        for (long value = multiplier ; value < limit ; value *= multiplier)
+        {
+            if (value > start)
+            {
+                runs.push_back({value});
+            }
+        }
+        if (limit > start)
+        {
+            runs.push_back({limit});
+        }
+        return this;
+    }
+
+    Registration* Registration::Iterations(long inputIterations)
+    {
+        if (inputIterations < 1)
+        {
+            throw(std::invalid_argument("A benchmark needs at least one iteration"));
+        }
+        this->iterations = inputIterations;
+        return this;
+    }
+
+    Registration* Registration::Unit(const std::string& inputUnit)
+    {
+        UnitsPerSecond(inputUnit);
+        this->unit = inputUnit;
+        return this;
+    }
+
+    Registration* Register(const std::string& name, Function function)
+    {
+        Registry().emplace_back(new Registration(name, function));
+        return Registry().back().get();
+    }
+
+    void AddCustomContext(const std::string& key, const std::string& value)
+    {
+        Context().emplace_back(key, value);
+    }
+
+    int RunSpecifiedBenchmarks(int argc, char** argv)
+    {
+        std::string filter = ".";
+        std::string outputPath;
+        double minTime = 0.5;
+        bool listOnly = false;
+        for (int i = 1 ; i < argc ; i++)
+        {
+            const std::string flag = argv[i];
+            auto value = [&flag](const char* name) { return flag.substr(std::strlen(name)); };
+            if (flag.rfind("--benchmark_filter=", 0) == 0)
+            {
+                filter = value("--benchmark_filter=");
+            }
+            else if (flag.rfind("--benchmark_out=", 0) == 0)
+            {
+                outputPath = value("--benchmark_out=");
+            }
+            else if (flag.rfind("--benchmark_min_time=", 0) == 0)
+            {
+                // Google Benchmark accepts a trailing "s" on the time
+                minTime = std::stod(value("--benchmark_min_time="));
+            }
+            else if (flag == "--benchmark_list_tests" || flag == "--benchmark_list_tests=true")
+            {
+                listOnly = true;
+            }
+            else
+            {
+                std::cerr << "Unknown flag " << flag << std::endl;
+                return 1;
+            }
+        }
+
+        const std::regex pattern(filter);
+        std::vector<std::pair<const Registration*, std::vector<long>>> selected;
+        std::vector<std::string> names;
+        size_t nameWidth = 9;
+        for (const auto& registration : Registry())
+        {
+            for (const auto& run : Runner::ListRuns(*registration))
+            {
+                if (std::regex_search(run.first, pattern))
+                {
+                    selected.emplace_back(registration.get(), run.second);
+                    names.push_back(run.first);
+                    nameWidth = std::max(nameWidth, run.first.size());
+                }
+            }
+        }
+
+        if (listOnly)
+        {
+            for (const std::string& name : names)
+            {
+                std::cout << name << std::endl;
+            }
+            return 0;
+        }
+
+        std::cout << std::left << std::setw(nameWidth + 2) << "Benchmark" << std::right << std::setw(15) << "Time"
+                  << std::setw(15) << "CPU" << std::setw(12) << "Iterations" << " UserCounters..." << std::endl;
+        std::cout << std::string(nameWidth + 2 + 42 + 16, '-') << std::endl;
+
+        std::vector<Result> results;
+        for (size_t i = 0 ; i < selected.size() ; i++)
+        {
+            const Result result = Runner::Run(*selected[i].first, selected[i].second, names[i], minTime);
+            std::cout << std::left << std::setw(nameWidth + 2) << result.name << std::right << std::fixed << std::setprecision(0)
+                      << std::setw(12) << result.realTime << " " << std::setw(2) << result.unit
+                      << std::setw(12) << result.cpuTime << " " << std::setw(2) << result.unit
+                      << std::setw(12) << result.iterations << std::defaultfloat;
+            for (const auto& counter : result.counters)
+            {
+                const bool rate = counter.first.size() > 11 && counter.first.compare(counter.first.size() - 11, 11, "_per_second") == 0;
+                std::cout << " " << counter.first << "=" << HumanReadable(counter.second) << (rate ? "/s" : "");
+            }
+            if (!result.label.empty())
+            {
+                std::cout << " " << result.label;
+            }
+            std::cout << std::endl;
+            results.push_back(result);
+        }
+
+        if (!outputPath.empty())
+        {
+            std::ofstream file(outputPath, std::ios::trunc);
+            Runner::WriteJson(file, results, argv[0]);
+            if (!file)
+            {
+                std::cerr << "Could not write " << outputPath << std::endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,184 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <initializer_list>
+
+namespace Benchmark
+{
+    /// @brief Small benchmark harness modelled on Google Benchmark, so that its command line flags and JSON output can be
+    ///        used by the same tooling without the library being available. Functions registered with NN_BENCHMARK() are
+    ///        run once per set of arguments, for as many iterations as it takes to fill a minimum time, and the mean time
+    ///        per iteration is reported on the console and, with --benchmark_out=<file>, as JSON.
+
+    /// @brief A user-defined value reported alongside the timings of a benchmark
+    struct Counter
+    {
+        enum Flags
+        {
+            /// Reported as is
+            Default = 0,
+            /// Divided by the elapsed real time, so that it is reported per second
+            IsRate = 1,
+            /// Divided by the number of iterations
+            AvgIterations = 2
+        };
+
+        Counter(double inputValue = 0, Flags inputFlags = Default) : value(inputValue), flags(inputFlags) {}
+
+        double value;
+        Flags flags;
+    };
+
+    class State
+    {
+        public:
+            /// @class               Passed to every benchmark function, which runs the code being measured once per step of
+            ///                      a range-based for loop over the state: for (auto _ : state) { ... }
+            /// @param inputArgs     The arguments of this run of the benchmark, see Range()
+            /// @param maxIterations The number of iterations the loop should run for
+            State(const std::vector<long>& inputArgs, long maxIterations);
+
+            /// @brief Value of each step of the loop, which only exists so that the loop variable is not reported as unused
+            struct Value
+            {
+                Value() {}
+                ~Value() {}
+            };
+
+            class Iterator
+            {
+                public:
+                    Iterator(State* inputState, long inputRemaining) : state(inputState), remaining(inputRemaining) {}
+                    Value operator*() const { return Value(); }
+                    void operator++() { remaining--; }
+                    bool operator!=(const Iterator&) const;
+
+                private:
+                    State* state;
+                    long remaining;
+            };
+
+            /// @brief Starts the timer and returns the first step of the loop
+            Iterator begin();
+            Iterator end();
+
+            /// @brief       Returns one of the arguments of this run
+            /// @param index Index of the argument
+            /// @return      The argument
+            long Range(int index = 0) const;
+
+            /// @brief  Get the number of iterations of this run
+            /// @return The number of iterations
+            long Iterations() const;
+
+            /// @brief Stops the timer, so that setup inside the loop is not measured, until ResumeTiming() is called
+            void PauseTiming();
+            void ResumeTiming();
+
+            /// @brief       Sets the number of items or bytes processed by the whole run, reported per second of real time
+            /// @param items The number of items or bytes
+            void SetItemsProcessed(double items);
+            void SetBytesProcessed(double bytes);
+
+            /// @brief       Sets a short description printed after the results of this run
+            /// @param label The description
+            void SetLabel(const std::string& label);
+
+            /// @brief Counters reported alongside the timings, by name
+            std::map<std::string, Counter> counters;
+
+        private:
+            friend struct Runner;
+
+            std::vector<long> args;
+            long maxIterations;
+            bool running;
+            double realStart;
+            double cpuStart;
+            double realTime;
+            double cpuTime;
+            double itemsProcessed;
+            double bytesProcessed;
+            std::string label;
+    };
+
+    using Function = void (*)(State&);
+
+    class Registration
+    {
+        public:
+            /// @class          A registered benchmark, returned by NN_BENCHMARK() so that its arguments can be set with
+            ///                 chained calls
+            /// @param name     Name of the benchmark, which prefixes the name of every run
+            /// @param function The benchmark function
+            Registration(const std::string& name, Function function);
+
+            /// @brief       Adds a run with a single argument, or one run per argument
+            /// @param value The argument
+            Registration* Arg(long value);
+            Registration* Args(std::initializer_list<long> values);
+
+            /// @brief       Adds runs for every power of multiplier between two values, including the values themselves
+            /// @param start The smallest argument
+            /// @param limit The largest argument
+            Registration* Range(long start, long limit, long multiplier = 8);
+
+            /// @brief            Runs the benchmark for exactly this many iterations instead of filling the minimum time,
+            ///                   for benchmarks whose single iteration is already long
+            /// @param iterations The number of iterations
+            Registration* Iterations(long iterations);
+
+            /// @brief      Sets the unit the times of this benchmark are reported in: "ns", "us", "ms" or "s"
+            /// @param unit The time unit
+            Registration* Unit(const std::string& unit);
+
+        private:
+            friend struct Runner;
+
+            std::string name;
+            Function function;
+            std::vector<std::vector<long>> runs;
+            long iterations;
+            std::string unit;
+    };
+
+    /// @brief          Adds a benchmark to the set that RunSpecifiedBenchmarks() runs
+    /// @param name     Name of the benchmark
+    /// @param function The benchmark function
+    /// @return         The registration, to add arguments to
+    Registration* Register(const std::string& name, Function function);
+
+    /// @brief       Adds a key and value to the "context" section of the JSON output, such as the instruction set in use
+    /// @param key   Name of the value
+    /// @param value The value
+    void AddCustomContext(const std::string& key, const std::string& value);
+
+    /// @brief      Runs every registered benchmark that matches the command line flags, printing a table on the console.
+    ///             Supported flags are --benchmark_filter=<regex>, --benchmark_out=<file>, --benchmark_min_time=<seconds>
+    ///             and --benchmark_list_tests.
+    /// @param argc The number of command line arguments
+    /// @param argv The command line arguments
+    /// @return     The exit code for main(), non-zero if a flag was invalid or the output file could not be written
+    int RunSpecifiedBenchmarks(int argc, char** argv);
+
+    /// @brief       Keeps the compiler from optimizing away a value that is computed but never used
+    /// @param value The value
+    template<typename T>
+    inline void DoNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+}
+
+#define NN_BENCHMARK_CONCAT_(a, b) a##b
+#define NN_BENCHMARK_CONCAT(a, b) NN_BENCHMARK_CONCAT_(a, b)
+
+/// @brief Registers a benchmark function, which may be a template instantiation such as Function<float, double>
+#define NN_BENCHMARK(...) \
+    static Benchmark::Registration* NN_BENCHMARK_CONCAT(benchmarkRegistration, __LINE__) [[maybe_unused]] = \
+        Benchmark::Register(#__VA_ARGS__, __VA_ARGS__)
+
+#endif // BENCHMARK_H
@@ -0,0 +1,82 @@
+#include "../src/network.h"
+#include "../src/data_pipeline.h"
+
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+
+namespace
+{
+    /// Synthetic regression dataset, y = sin(sum of x) with inputs drawn uniformly from [-1, 1]
+    void MakeDataset(int rows, int inputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(1));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double sum = 0;
+            for (double& value : x[r]) { value = distribution(generator); sum += value; }
+            y[r][0] = std::sin(sum);
+        }
+    }
+
+    /// Seconds to train a network from the shared initial weights through a shuffling pipeline, writing checkpoints when a
+    /// directory is given
+    double Run(const std::string& initialModel, InMemoryDataSource& source, const std::string& directory = "")
+    {
+        NeuralNetwork network = NeuralNetwork::Load(initialModel);
+        network.SetEpochs(8);
+        network.SetBatchSize(32);
+        network.SetNumThreads(2);
+        network.SetOptimizer(Optimizers::Adam(0.003));
+        network.Initialize(source);
+        if (!directory.empty())
+        {
+            network.SetCheckpointing(directory, 130, 3);
+        }
+
+        DataPipeline::Options options;
+        options.batchRows = 64;
+        options.seed = 7;
+        DataPipeline pipeline(source, options);
+
+        // Train() reports every epoch on std::cout, which would drown out the results
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        auto start = std::chrono::steady_clock::now();
+        network.Train(pipeline);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout.rdbuf(original);
+        return seconds;
+    }
+}
+
+int main()
+{
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(3200, 4, x, y);
+    InMemoryDataSource source(x, y);
+
+    const std::string initialModel = "checkpoint_bench_initial.nnm";
+    const std::string directory = "checkpoint_bench_checkpoints";
+    std::filesystem::remove_all(directory);
+    NeuralNetwork initial({32, 16}, ActivationFunctions::tanh, LossFunctions::mse);
+    initial.Initialize(x, y);
+    initial.Save(initialModel);
+
+    // 100 steps per epoch over 8 epochs, with a checkpoint every 130 steps of which the last 3 are kept
+    const double uninterrupted = Run(initialModel, source);
+    const double checkpointed = Run(initialModel, source, directory);
+    std::filesystem::remove_all(directory);
+    std::remove(initialModel.c_str());
+
+    std::cout << std::fixed;
+    std::cout << "training without checkpoints\t" << uninterrupted << " s" << std::endl;
+    std::cout << "training with checkpoints\t" << checkpointed << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    /// Synthetic regression dataset, y = sin(sum of x) with inputs drawn uniformly from [-1, 1], plus optional noise on y
+    void MakeDataset(int rows, int inputs, double noise, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(1));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double sum = 0;
+            for (double& value : x[r]) { value = distribution(generator); sum += value; }
+            y[r][0] = std::sin(sum) + noise * distribution(generator);
+        }
+    }
+}
+
+int main()
+{
+    const int maxEpochs = 600;
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(2500, 4, 0.3, x, y);
+
+    // Train() reports every epoch on std::cout, which would drown out the results
+    std::ostringstream discarded;
+    std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+
+    // Without early stopping every epoch runs, long after the validation loss has stopped improving
+    NeuralNetwork full({16}, ActivationFunctions::tanh, LossFunctions::mse, maxEpochs, 0.01);
+    full.SetBatchSize(16);
+    full.SetValidationSplit(0.2);
+    full.SetOptimizer(Optimizers::Adam(0.003));
+    full.Initialize(x, y);
+    auto start = std::chrono::steady_clock::now();
+    full.Train();
+    const double fullSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    NeuralNetwork stopped({16}, ActivationFunctions::tanh, LossFunctions::mse, maxEpochs, 0.01);
+    stopped.SetBatchSize(16);
+    stopped.SetValidationSplit(0.2);
+    stopped.SetValidationInterval(2);
+    stopped.SetOptimizer(Optimizers::Adam(0.003));
+    stopped.SetLearningRateSchedule(Schedules::Warmup(3, Schedules::ReduceOnPlateau(0.5, 5, 1e-4)));
+    stopped.SetEarlyStopping(15, 1e-4, true);
+    stopped.Initialize(x, y);
+    start = std::chrono::steady_clock::now();
+    stopped.Train();
+    const double stoppedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout.rdbuf(original);
+
+    auto best = [](const std::vector<NeuralNetwork::EpochStats>& history)
+    {
+        double loss = std::numeric_limits<double>::infinity();
+        for (const NeuralNetwork::EpochStats& stats : history)
+        {
+            loss = std::isnan(stats.validationLoss) ? loss : std::min(loss, stats.validationLoss);
+        }
+        return loss;
+    };
+
+    const std::vector<NeuralNetwork::EpochStats>& fullHistory = full.GetHistory();
+    const std::vector<NeuralNetwork::EpochStats>& history = stopped.GetHistory();
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "no early stopping\tepochs " << fullHistory.size() << "\t" << fullSeconds << " s\tbest validation mse "
+              << best(fullHistory) << "\tfinal " << fullHistory.back().validationLoss << std::endl;
+    std::cout << "early stopping\t\tepochs " << history.size() << "\t" << stoppedSeconds << " s\tbest validation mse "
+              << best(history) << "\tfinal learning rate " << history.back().learningRate << std::endl;
+    return 0;
+}
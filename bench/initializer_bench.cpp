@@ -0,0 +1,64 @@
+#include "../src/network.h"
+
+#include <chrono>
+#include <random>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    /// Every weight of a network, layer after layer
+    std::vector<double> Weights(const NeuralNetwork& network)
+    {
+        std::vector<double> weights;
+        for (int i = 1 ; i < network.GetNumLayers() ; i++)
+        {
+            const NeuralNetwork::Layer& layer = network.GetLayer(i);
+            weights.insert(weights.end(), layer.GetWeights(), layer.GetWeights() + layer.GetNumWeights());
+        }
+        return weights;
+    }
+
+    /// Initializes a wide network and returns the time it took, and its weights
+    double InitializeWide(uint64_t seed, int threads, std::vector<double>& weights, const Initializer* initializer = nullptr)
+    {
+        std::vector<std::vector<double>> x(1, std::vector<double>(1024)), y(1, std::vector<double>(1));
+        NeuralNetwork network({1024, 1024}, ActivationFunctions::relu, LossFunctions::mse);
+        network.SetSeed(seed);
+        network.SetNumThreads(threads);
+        if (initializer)
+        {
+            network.SetWeightInitializer(*initializer);
+        }
+        auto start = std::chrono::steady_clock::now();
+        network.Initialize(x, y);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        weights = Weights(network);
+        return seconds;
+    }
+}
+
+int main()
+{
+    std::vector<double> single, parallel;
+    const double singleSeconds = InitializeWide(7, 1, single);
+    const double parallelSeconds = InitializeWide(7, 4, parallel);
+
+    // What the network used to do for every weight: a new std::random_device and std::mt19937, and an integer in [-5, 5]
+    auto start = std::chrono::steady_clock::now();
+    volatile double sink = 0;
+    const size_t legacyCount = 1 << 16;
+    for (size_t i = 0 ; i < legacyCount ; i++)
+    {
+        std::random_device device;
+        std::mt19937 generator(device());
+        sink = sink + std::uniform_int_distribution<int>(-5, 5)(generator);
+    }
+    const double legacySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * single.size() / legacyCount;
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "initializing " << single.size() << " weights\tcounter based " << singleSeconds << " s (4 threads "
+              << parallelSeconds << " s, with a training workspace per thread)\tper weight random_device " << legacySeconds
+              << " s (estimated)" << std::endl;
+    return 0;
+}
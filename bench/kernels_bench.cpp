@@ -0,0 +1,141 @@
+#include "../src/kernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    template<typename T>
+    std::vector<T> RandomVector(size_t size, std::mt19937& generator)
+    {
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        std::vector<T> values(size);
+        for (auto& v : values) { v = static_cast<T>(distribution(generator)); }
+        return values;
+    }
+
+    /// Name of each supported combination of data and accumulator types
+    template<typename T, typename Accumulator> const char* PrecisionName();
+    template<> const char* PrecisionName<double, double>() { return "double"; }
+    template<> const char* PrecisionName<float, float>() { return "float"; }
+    template<> const char* PrecisionName<float, double>() { return "mixed"; }
+
+    /// Random quantized operands, A in the [0, 127] range the integer kernels require and B over the whole int8 range
+    void RandomQuantized(size_t size, std::mt19937& generator, std::vector<uint8_t>& a, std::vector<int8_t>& b)
+    {
+        std::uniform_int_distribution<int> unsignedValues(0, 127), signedValues(-128, 127);
+        a.resize(size);
+        b.resize(size);
+        for (auto& v : a) { v = static_cast<uint8_t>(unsignedValues(generator)); }
+        for (auto& v : b) { v = static_cast<int8_t>(signedValues(generator)); }
+    }
+
+    /// Runs a kernel repeatedly for at least a fixed time and returns the achieved GFLOP/s
+    template <typename Function>
+    double MeasureGflops(double flopsPerCall, Function function)
+    {
+        using Clock = std::chrono::steady_clock;
+        function();
+
+        long calls = 0;
+        auto start = Clock::now();
+        double elapsed = 0;
+        while (elapsed < 0.25)
+        {
+            function();
+            calls++;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        return flopsPerCall * calls / elapsed * 1e-9;
+    }
+
+    template<typename T, typename Accumulator>
+    void Benchmark(Kernels::InstructionSet set)
+    {
+        Kernels::SetInstructionSet(set);
+        std::mt19937 generator(7);
+        const std::string name = std::string(Kernels::GetInstructionSetName(set)) + "\t" + PrecisionName<T, Accumulator>();
+
+        for (int size : {64, 256, 1024})
+        {
+            std::vector<T> a = RandomVector<T>(static_cast<size_t>(size) * size, generator);
+            std::vector<T> b = RandomVector<T>(static_cast<size_t>(size) * size, generator);
+            std::vector<T> c(static_cast<size_t>(size) * size);
+            double gflops = MeasureGflops(2.0 * size * size * size, [&]()
+            {
+                Kernels::Gemm<T, Accumulator>(false, true, size, size, size, 1, a.data(), size, b.data(), size, 0, c.data(), size);
+            });
+            std::cout << name << "\tgemm\t" << size << "x" << size << "x" << size << "\t" << gflops << " GFLOP/s" << std::endl;
+        }
+
+        for (int size : {256, 2048})
+        {
+            std::vector<T> a = RandomVector<T>(static_cast<size_t>(size) * size, generator);
+            std::vector<T> x = RandomVector<T>(size, generator);
+            std::vector<T> y(size);
+            for (int transA = 0 ; transA < 2 ; transA++)
+            {
+                double gflops = MeasureGflops(2.0 * size * size, [&]()
+                {
+                    Kernels::Gemv<T, Accumulator>(transA, size, size, 1, a.data(), size, x.data(), 0, y.data());
+                });
+                std::cout << name << "\tgemv" << (transA ? "T" : "N") << "\t" << size << "x" << size << "\t" << gflops << " GFLOP/s" << std::endl;
+            }
+
+            double gflops = MeasureGflops(2.0 * size * size, [&]()
+            {
+                Kernels::Ger(size, size, static_cast<T>(1e-9), x.data(), y.data(), a.data(), size);
+            });
+            std::cout << name << "\tger\t" << size << "x" << size << "\t" << gflops << " GFLOP/s" << std::endl;
+        }
+    }
+
+    void BenchmarkQuantized(Kernels::InstructionSet set)
+    {
+        Kernels::SetInstructionSet(set);
+        std::mt19937 generator(7);
+        const std::string name = std::string(Kernels::GetInstructionSetName(set)) + "\tint8";
+
+        for (int rows : {1, 64})
+        {
+            for (int size : {256, 1024})
+            {
+                std::vector<uint8_t> a, unused;
+                std::vector<int8_t> b, unusedSigned;
+                RandomQuantized(static_cast<size_t>(rows) * size, generator, a, unusedSigned);
+                RandomQuantized(static_cast<size_t>(size) * size, generator, unused, b);
+                std::vector<int32_t> c(static_cast<size_t>(rows) * size);
+                double gops = MeasureGflops(2.0 * rows * size * size, [&]()
+                {
+                    Kernels::QuantizedGemm(rows, size, size, a.data(), size, b.data(), size, c.data(), size);
+                });
+                std::cout << name << "\tgemm\t" << rows << "x" << size << "x" << size << "\t" << gops << " GOP/s" << std::endl;
+            }
+        }
+    }
+}
+
+int main()
+{
+    const Kernels::InstructionSet sets[] = {Kernels::InstructionSet::Scalar, Kernels::InstructionSet::Avx2, Kernels::InstructionSet::Avx512};
+    const Kernels::InstructionSet detected = Kernels::DetectInstructionSet();
+
+    std::cout << "Detected instruction set: " << Kernels::GetInstructionSetName(detected) << std::endl;
+    for (auto set : sets)
+    {
+        if (static_cast<int>(set) > static_cast<int>(detected))
+        {
+            continue;
+        }
+
+        Benchmark<double, double>(set);
+        Benchmark<float, float>(set);
+        Benchmark<float, double>(set);
+        BenchmarkQuantized(set);
+    }
+    return 0;
+}
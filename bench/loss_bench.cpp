@@ -0,0 +1,110 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    using LossFunctions::LossType;
+
+    /// Logits and targets of a batch, one-hot for cross entropy and probabilities for binary cross entropy
+    void MakeBatch(LossType type, int rows, int columns, double spread, std::vector<double>& logits, std::vector<double>& targets)
+    {
+        std::mt19937 generator(99);
+        std::uniform_real_distribution<double> distribution(-spread, spread);
+        logits.resize(static_cast<size_t>(rows) * columns);
+        targets.resize(logits.size());
+        for (size_t k = 0 ; k < logits.size() ; k++)
+        {
+            logits[k] = distribution(generator);
+            targets[k] = (type == LossType::SoftmaxCrossEntropy) ? 0 : 0.5 + 0.5 * distribution(generator) / spread;
+        }
+        if (type == LossType::SoftmaxCrossEntropy)
+        {
+            for (int r = 0 ; r < rows ; r++)
+            {
+                targets[static_cast<size_t>(r) * columns + generator() % columns] = 1;
+            }
+        }
+    }
+
+    /// Seconds per call of a function, repeated until at least 0.1 s has passed
+    template<typename Function>
+    double Time(Function function)
+    {
+        int repeats = 0;
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0;
+        do
+        {
+            for (int i = 0 ; i < 10 ; i++, repeats++)
+            {
+                function();
+            }
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        while (seconds < 0.1);
+        return seconds / repeats;
+    }
+
+    /// Compares the batched loss and gradient with what the output layer used to do, a std::function derivative per output
+    /// and a copy of every row into vectors for the loss, and with a softmax computed separately from the loss
+    void Throughput()
+    {
+        const int rows = 256, columns = 10;
+        std::vector<double> logits, targets, gradients(rows * columns), probabilities(rows * columns);
+        MakeBatch(LossType::SoftmaxCrossEntropy, rows, columns, 4, logits, targets);
+        volatile double sink = 0;
+
+        const std::function<double(double, double)> derivative = LossFunctions::d_mse;
+        const std::function<double(std::vector<double>, std::vector<double>)> loss = LossFunctions::mse;
+        const double perOutput = Time([&]()
+        {
+            for (size_t k = 0 ; k < logits.size() ; k++)
+            {
+                gradients[k] = derivative(logits[k], targets[k]);
+            }
+            std::vector<double> predicted(columns), actual(columns);
+            double sum = 0;
+            for (int r = 0 ; r < rows ; r++)
+            {
+                std::copy(logits.begin() + r * columns, logits.begin() + (r + 1) * columns, predicted.begin());
+                std::copy(targets.begin() + r * columns, targets.begin() + (r + 1) * columns, actual.begin());
+                sum += loss(predicted, actual);
+            }
+            sink = sum;
+        });
+        const double batchedMse = Time([&]() { sink = LossFunctions::BatchLoss<double>(LossType::Mse, columns, logits, targets, gradients); });
+
+        const double separate = Time([&]()
+        {
+            probabilities = logits;
+            LossFunctions::LogitsToProbabilities<double>(LossType::SoftmaxCrossEntropy, columns, probabilities);
+            double sum = 0;
+            for (size_t k = 0 ; k < logits.size() ; k++)
+            {
+                sum -= targets[k] * std::log(probabilities[k]);
+                gradients[k] = probabilities[k] - targets[k];
+            }
+            sink = sum;
+        });
+        const double fused = Time([&]()
+        {
+            sink = LossFunctions::BatchLoss<double>(LossType::SoftmaxCrossEntropy, columns, logits, targets, gradients);
+        });
+
+        std::cout << std::fixed << std::setprecision(1) << "rows per second (" << rows << " x " << columns << ")"
+                  << "\tmse per output " << rows / perOutput << "\tmse batched " << rows / batchedMse
+                  << "\t" << perOutput / batchedMse << "x" << std::endl;
+        std::cout << "\t\t\t\tsoftmax then loss " << rows / separate << "\tfused cross entropy " << rows / fused
+                  << "\t" << separate / fused << "x" << std::endl;
+    }
+}
+
+int main()
+{
+    Throughput();
+    return 0;
+}
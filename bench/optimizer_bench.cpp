@@ -0,0 +1,112 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    /// Synthetic regression dataset, y = sin(sum of x) with inputs drawn uniformly from [-1, 1]
+    void MakeDataset(int rows, int inputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(1));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double sum = 0;
+            for (double& value : x[r]) { value = distribution(generator); sum += value; }
+            y[r][0] = std::sin(sum);
+        }
+    }
+
+    /// Mean squared error of the network over the whole dataset
+    double MeanSquaredError(const NeuralNetwork& network, const std::vector<std::vector<double>>& x, const std::vector<std::vector<double>>& y)
+    {
+        std::vector<double> flat, outputs(x.size());
+        for (const std::vector<double>& row : x)
+        {
+            flat.insert(flat.end(), row.begin(), row.end());
+        }
+        network.PredictBatch(Span<const double>(flat.data(), flat.size()), Span<double>(outputs.data(), outputs.size()));
+
+        double sum = 0;
+        for (size_t r = 0 ; r < x.size() ; r++)
+        {
+            sum += (outputs[r] - y[r][0]) * (outputs[r] - y[r][0]);
+        }
+        return sum / x.size();
+    }
+
+    struct Result
+    {
+        int epochs = 0;
+        double seconds = 0;
+        double error = 0;
+        bool converged = false;
+    };
+
+    /// Trains a copy of the initial network one epoch at a time until it reaches the target error, timing only Train()
+    Result Run(const char* name, const Optimizer& optimizer, const std::string& initialModel, int maxEpochs, double target,
+               const std::vector<std::vector<double>>& x, const std::vector<std::vector<double>>& y)
+    {
+        NeuralNetwork network = NeuralNetwork::Load(initialModel);
+        network.SetBatchSize(32);
+        network.SetEpochs(1);
+        network.SetOptimizer(optimizer);
+        network.Initialize(x, y);
+
+        Result result;
+        std::ostringstream discarded;
+        while (result.epochs < maxEpochs && !result.converged)
+        {
+            // Train() reports every epoch on std::cout, which would drown out the results
+            std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+            auto start = std::chrono::steady_clock::now();
+            network.Train();
+            result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout.rdbuf(original);
+
+            result.epochs++;
+            result.error = MeanSquaredError(network, x, y);
+            result.converged = result.error <= target;
+        }
+
+        std::cout << std::setw(9) << name << "\tepochs " << std::setw(3) << result.epochs << "\t" << std::setw(7) << result.seconds
+                  << " s\tmse " << result.error << (result.converged ? "" : "\t(did not reach the target)") << std::endl;
+        return result;
+    }
+}
+
+int main()
+{
+    const int maxEpochs = 100;
+    const double target = 0.002;
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(8000, 4, x, y);
+
+    // Every optimizer starts from the same weights, saved once and loaded for each run
+    const std::string initialModel = "optimizer_bench_initial.nn";
+    NeuralNetwork initial({32, 16}, ActivationFunctions::tanh, LossFunctions::mse);
+    initial.Initialize(x, y);
+    initial.Save(initialModel);
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "epochs and training time to reach a mean squared error of " << target << ", starting at "
+              << MeanSquaredError(initial, x, y) << std::endl;
+    const Result sgd = Run("sgd", Optimizers::Sgd(0.01), initialModel, maxEpochs, target, x, y);
+    const Result momentum = Run("momentum", Optimizers::Momentum(0.01, 0.9), initialModel, maxEpochs, target, x, y);
+    const Result rmsprop = Run("rmsprop", Optimizers::RmsProp(0.003), initialModel, maxEpochs, target, x, y);
+    const Result adam = Run("adam", Optimizers::Adam(0.003), initialModel, maxEpochs, target, x, y);
+    const Result adamw = Run("adamw", Optimizers::AdamW(0.003, 0.0001), initialModel, maxEpochs, target, x, y);
+    std::remove(initialModel.c_str());
+
+    // The adaptive optimizers should all converge, and Adam should get there in fewer epochs than plain SGD
+    const bool passed = momentum.converged && rmsprop.converged && adam.converged && adamw.converged
+                     && (!sgd.converged || adam.epochs < sgd.epochs);
+    std::cout << "optimizer comparison " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <algorithm>
+#include <sstream>
+#include <iostream>
+
+#ifndef NN_ENABLE_PROFILING
+#error "The profiler bench must be built with -DNN_ENABLE_PROFILING"
+#endif
+
+namespace
+{
+    /// Synthetic regression dataset, y = sin(sum of x) with inputs drawn uniformly from [-1, 1]
+    void MakeDataset(int rows, int inputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(1));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double sum = 0;
+            for (double& value : x[r]) { value = distribution(generator); sum += value; }
+            y[r][0] = std::sin(sum);
+        }
+    }
+
+    /// Trains for a few epochs, silencing the loss that Train() reports every epoch, and returns the samples per second
+    double Train(NeuralNetwork& network)
+    {
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        network.Train();
+        std::cout.rdbuf(original);
+        return network.GetThroughputStats().totalSamplesPerSecond;
+    }
+
+    double Median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+}
+
+int main()
+{
+    const int rows = 20000, batchSize = 32, epochs = 3;
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(rows, 32, x, y);
+
+    NeuralNetwork network({128, 64}, ActivationFunctions::tanh, LossFunctions::mse, epochs, 0.001);
+    network.SetBatchSize(batchSize);
+    network.Initialize(x, y);
+
+    // Runs with and without the profiler alternate, so that both see the same drift of the machine, and the medians are
+    // compared. The profile reported below is that of the last run.
+    const int runs = 5;
+    const double maxOverhead = 0.1;
+    std::vector<double> unprofiledRuns, profiledRuns;
+    for (int run = 0 ; run < runs ; run++)
+    {
+        network.EnableProfiling(false);
+        unprofiledRuns.push_back(Train(network));
+        network.EnableProfiling(true, true);
+        profiledRuns.push_back(Train(network));
+    }
+    const double unprofiled = Median(unprofiledRuns), profiled = Median(profiledRuns);
+    const double overhead = unprofiled / profiled - 1;
+    const Profiler::Report report = network.GetProfile();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "samples/s, median of " << runs << " runs\tunprofiled " << unprofiled << "\tprofiled " << profiled << "\toverhead "
+              << overhead * 100 << "% (limit " << maxOverhead * 100 << "%)" << std::endl;
+    std::cout << "profile\t" << report.samples << " samples in " << report.seconds << " s\t" << report.samplesPerSecond
+              << " samples/s\t" << report.flopsPerSecond * 1e-9 << " GFLOP/s" << std::endl;
+
+    const Profiler::Phase phases[] = {Profiler::Phase::DataLoading, Profiler::Phase::Forward, Profiler::Phase::Loss,
+                                      Profiler::Phase::Backward, Profiler::Phase::WeightUpdate};
+    for (Profiler::Phase phase : phases)
+    {
+        const Profiler::Counters& counters = report.Get(phase);
+        std::cout << "phase\t" << std::setw(14) << Profiler::GetPhaseName(phase) << "\tcalls " << std::setw(8) << counters.calls
+                  << "\t" << counters.seconds * 1e3 << " ms\t" << (report.seconds > 0 ? counters.seconds / report.seconds * 100 : 0) << "%" << std::endl;
+    }
+    // The forward scope of a layer also covers its activation function, which is not counted in its operations, so its
+    // rate is that of the whole phase rather than of the matrix product
+    std::cout << "layer rates are GFLOP/s of the matrix products per second of the phase, forward including the activation" << std::endl;
+    for (size_t l = 1 ; l < report.layers.size() ; l++)
+    {
+        std::cout << "layer " << l;
+        for (Profiler::Phase phase : {Profiler::Phase::Forward, Profiler::Phase::Backward, Profiler::Phase::WeightUpdate})
+        {
+            const Profiler::Counters& counters = report.layers[l][static_cast<int>(phase)];
+            std::cout << "\t" << Profiler::GetPhaseName(phase) << " " << counters.seconds * 1e3 << " ms "
+                      << (counters.seconds > 0 ? counters.flops / counters.seconds * 1e-9 : 0) << " GFLOP/s";
+        }
+        std::cout << std::endl;
+    }
+
+    network.WriteProfileTrace("profiler_bench_trace.json");
+    std::cout << "wrote profiler_bench_trace.json" << std::endl;
+    return overhead < maxOverhead ? 0 : 1;
+}
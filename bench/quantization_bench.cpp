@@ -0,0 +1,89 @@
+#include "../src/network.h"
+#include "../src/quantization.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    /// Synthetic classification dataset with four classes, decided by the signs of two random projections of the inputs
+    void MakeDataset(int rows, int inputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(2024);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        std::vector<double> first(inputs), second(inputs);
+        for (int k = 0 ; k < inputs ; k++)
+        {
+            first[k] = distribution(generator);
+            second[k] = distribution(generator);
+        }
+
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(4, 0));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double a = 0, b = 0;
+            for (int k = 0 ; k < inputs ; k++)
+            {
+                x[r][k] = distribution(generator);
+                a += first[k] * x[r][k];
+                b += second[k] * x[r][k];
+            }
+            y[r][(a > 0 ? 1 : 0) + (b > 0 ? 2 : 0)] = 1;
+        }
+    }
+
+    /// Measures rows per second of a model predicting batches of a fixed size
+    template<typename Model>
+    double MeasureRowsPerSecond(const Model& model, const std::vector<double>& inputs, int numInputs, int numOutputs, int batchRows)
+    {
+        using Clock = std::chrono::steady_clock;
+        std::vector<double> outputs(static_cast<size_t>(batchRows) * numOutputs);
+        const int batches = static_cast<int>(inputs.size() / numInputs / batchRows);
+
+        long rows = 0;
+        auto start = Clock::now();
+        double elapsed = 0;
+        while (elapsed < 0.5)
+        {
+            for (int b = 0 ; b < batches ; b++)
+            {
+                model.PredictBatch(Span<const double>(inputs.data() + static_cast<size_t>(b) * batchRows * numInputs, static_cast<size_t>(batchRows) * numInputs), outputs);
+            }
+            rows += static_cast<long>(batches) * batchRows;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        return rows / elapsed;
+    }
+}
+
+int main()
+{
+    const int numInputs = 64;
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(4096, numInputs, x, y);
+    std::vector<double> inputs;
+    for (const auto& row : x)
+    {
+        inputs.insert(inputs.end(), row.begin(), row.end());
+    }
+
+    // Throughput does not depend on how well the model is trained, so the weights are left as initialized
+    NeuralNetwork network({256, 256}, ActivationFunctions::relu, LossFunctions::mse);
+    network.SetSeed(99);
+    network.Initialize(x, y);
+    InMemoryDataSource calibration(x, y);
+    QuantizedNetwork::Options options;
+    options.granularity = QuantizedNetwork::Granularity::PerChannel;
+    QuantizedNetwork quantized(network, calibration, options);
+
+    std::cout << "64-256-256-4\tweights\tdouble=" << (quantized.GetWeightBytes() * sizeof(double)) << " bytes\tint8="
+              << quantized.GetWeightBytes() << " bytes" << std::endl;
+    for (int batchRows : {1, 16, 256})
+    {
+        const double full = MeasureRowsPerSecond(network, inputs, numInputs, 4, batchRows);
+        const double integer = MeasureRowsPerSecond(quantized, inputs, numInputs, 4, batchRows);
+        std::cout << "batch=" << batchRows << "\tdouble " << full << " rows/s\tint8 " << integer << " rows/s\tspeedup " << integer / full << "x" << std::endl;
+    }
+    return 0;
+}
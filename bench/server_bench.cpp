@@ -0,0 +1,123 @@
+#include "../src/network.h"
+#include "../src/inference_server.h"
+
+#include <cstdio>
+#include <random>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    constexpr int NumInputs = 32;
+    constexpr int NumOutputs = 4;
+    const char* const ModelPath = "server_bench.nnm";
+    const char* const SocketPath = "server_bench.sock";
+
+    /// Saves a 32-512-512-4 network with random weights, which the servers load as the tools would
+    void SaveModel()
+    {
+        std::mt19937 generator(9);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        std::vector<std::vector<double>> x(256, std::vector<double>(NumInputs)), y(256, std::vector<double>(NumOutputs));
+        for (size_t r = 0 ; r < x.size() ; r++)
+        {
+            for (double& value : x[r]) { value = distribution(generator); }
+            for (double& value : y[r]) { value = distribution(generator); }
+        }
+        NeuralNetwork network({512, 512}, ActivationFunctions::tanh, LossFunctions::mse);
+        network.SetSeed(4);
+        network.Initialize(x, y);
+        network.Save(ModelPath);
+    }
+
+    /// Random rows of inputs
+    std::vector<double> MakeInputs(int rows, int seed)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        std::vector<double> inputs(static_cast<size_t>(rows) * NumInputs);
+        for (double& value : inputs)
+        {
+            value = distribution(generator);
+        }
+        return inputs;
+    }
+
+    /// Requests per second of a server under a closed loop of single-row requests from several connections, with the
+    /// server's report of the measured period
+    double Throughput(const char* name, int maxBatchRows, int maxWaitMicroseconds, int connections, InferenceServer::Report& report)
+    {
+        InferenceServer::Options options;
+        options.endpoint.socketPath = SocketPath;
+        options.maxBatchRows = maxBatchRows;
+        options.maxWaitMicroseconds = maxWaitMicroseconds;
+        InferenceServer server(NeuralNetwork::Load(ModelPath), options);
+        server.Start();
+
+        std::atomic<int> phase(0);
+        std::atomic<long> requests(0);
+        std::atomic<long> failures(0);
+        auto client = [&](int seed)
+        {
+            try
+            {
+                InferenceClient connection(server.GetEndpoint());
+                const std::vector<double> inputs = MakeInputs(1, seed);
+                std::vector<double> outputs(NumOutputs);
+                while (phase != 2)
+                {
+                    connection.Predict(inputs, outputs);
+                    if (phase == 1)
+                    {
+                        requests++;
+                    }
+                }
+            }
+            catch (const std::exception&)
+            {
+                failures++;
+            }
+        };
+        std::vector<std::thread> clients;
+        for (int c = 0 ; c < connections ; c++)
+        {
+            clients.emplace_back(client, c + 1);
+        }
+
+        // Every connection is up and busy before the measurement starts
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        server.ClearReport();
+        phase = 1;
+        const auto start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(800));
+        const long measured = requests;
+        report = server.GetReport();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        phase = 2;
+        for (std::thread& thread : clients)
+        {
+            thread.join();
+        }
+        server.Stop();
+
+        const double perSecond = failures ? 0 : measured / seconds;
+        std::cout << std::fixed << std::setprecision(0) << name << "\trequests per second " << perSecond << std::endl;
+        InferenceServer::WriteReport(report, std::cout);
+        return perSecond;
+    }
+}
+
+int main()
+{
+    SaveModel();
+
+    // Concurrent single-row requests, run one at a time or batched. The speedup depends on the number of cores.
+    const int connections = 16;
+    InferenceServer::Report unbatched, batched;
+    const double single = Throughput("32-512-512-4, 16 connections, batches of 1\t\t", 1, 0, connections, unbatched);
+    const double dynamic = Throughput("32-512-512-4, 16 connections, up to 16 rows or 500 us", 16, 500, connections, batched);
+    std::cout << std::fixed << std::setprecision(2) << "speedup from batching " << dynamic / single << "x" << std::endl;
+
+    std::remove(ModelPath);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "../src/network.h"
+#include "../src/static_network.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    using ActivationFunctions::Accuracy;
+    using ActivationFunctions::ActivationType;
+
+    /// Random rows of inputs and targets, only used to size and initialize the dynamic networks
+    void MakeDataset(int rows, int inputs, int outputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(5);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(outputs));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            for (double& value : x[r]) { value = distribution(generator); }
+            for (double& value : y[r]) { value = distribution(generator); }
+        }
+    }
+
+    /// Nanoseconds per row of a prediction function called one row at a time over a set of rows
+    template<typename Function>
+    double NanosecondsPerRow(int rows, Function predict)
+    {
+        long calls = 0;
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0;
+        do
+        {
+            for (int r = 0 ; r < rows ; r++, calls++)
+            {
+                predict(r);
+            }
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        while (seconds < 0.2);
+        return 1e9 * seconds / calls;
+    }
+
+    /// Builds a dynamic network with the topology of a static one and compares the time per row of both
+    template<typename T, typename Static>
+    void Compare(const char* name, std::vector<int> hidden, std::vector<ActivationType> activations, Accuracy accuracy = Accuracy::Exact)
+    {
+        std::vector<std::vector<double>> x, y;
+        MakeDataset(1024, Static::NumInputs, Static::NumOutputs, x, y);
+        BasicNeuralNetwork<T> network(hidden, Activation(activations[0], accuracy), LossFunctions::mse);
+        network.SetSeed(11);
+        network.Initialize(x, y);
+        for (size_t i = 1 ; i < hidden.size() ; i++)
+        {
+            network.ChangeHiddenLayerActivationFunction(Activation(activations[i], accuracy), static_cast<int>(i) + 1);
+        }
+        const Static model(network);
+
+        const int rows = static_cast<int>(x.size());
+        std::vector<T> inputs(static_cast<size_t>(rows) * Static::NumInputs);
+        for (int r = 0 ; r < rows ; r++)
+        {
+            std::copy(x[r].begin(), x[r].end(), inputs.begin() + static_cast<size_t>(r) * Static::NumInputs);
+        }
+
+        T output[Static::NumOutputs];
+        volatile T sink = 0;
+        const double dynamicTime = NanosecondsPerRow(rows, [&](int r)
+        {
+            network.Predict(inputs.data() + static_cast<size_t>(r) * Static::NumInputs, output);
+            sink = output[0];
+        });
+        const double staticTime = NanosecondsPerRow(rows, [&](int r)
+        {
+            model.Predict(inputs.data() + static_cast<size_t>(r) * Static::NumInputs, output);
+            sink = output[0];
+        });
+
+        std::cout << std::setw(22) << std::left << name << std::right << std::fixed << std::setprecision(1)
+                  << "\tns per row dynamic " << dynamicTime << "\tstatic " << staticTime << "\t" << dynamicTime / staticTime << "x" << std::endl;
+    }
+}
+
+int main()
+{
+    using Small = StaticNetwork<double, 4, StaticLayer<8, ActivationType::Relu>, StaticLayer<1>>;
+    using Medium = StaticNetwork<double, 16, StaticLayer<32, ActivationType::Tanh>, StaticLayer<16, ActivationType::Relu>, StaticLayer<4>>;
+    using MediumFast = StaticNetwork<double, 16, StaticLayer<32, ActivationType::Tanh, Accuracy::Fast>, StaticLayer<16, ActivationType::Relu>, StaticLayer<4>>;
+    using Wide = StaticNetwork<float, 8, StaticLayer<64, ActivationType::Relu>, StaticLayer<64, ActivationType::Relu>, StaticLayer<10>>;
+    using Smooth = StaticNetwork<float, 16, StaticLayer<32, ActivationType::Silu>, StaticLayer<3>>;
+    Compare<double, Small>("4-8-1 relu", {8}, {ActivationType::Relu});
+    Compare<double, Medium>("16-32-16-4 tanh relu", {32, 16}, {ActivationType::Tanh, ActivationType::Relu});
+    Compare<double, MediumFast>("16-32-16-4 fast tanh", {32, 16}, {ActivationType::Tanh, ActivationType::Relu}, Accuracy::Fast);
+    Compare<float, Wide>("8-64-64-10 relu", {64, 64}, {ActivationType::Relu, ActivationType::Relu});
+    Compare<float, Smooth>("16-32-3 silu", {32}, {ActivationType::Silu});
+    return 0;
+}
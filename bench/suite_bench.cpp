@@ -0,0 +1,278 @@
+#include "benchmark.h"
+#include "../src/network.h"
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+    /// Fills a buffer with values drawn uniformly from [-1, 1]
+    template<typename T>
+    std::vector<T> RandomValues(size_t count, unsigned seed = 42)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        std::vector<T> values(count);
+        for (T& value : values)
+        {
+            value = static_cast<T>(distribution(generator));
+        }
+        return values;
+    }
+
+    /// Layer of the given width with random weights, as used by the forward and backward benchmarks
+    Layer RandomLayer(int width)
+    {
+        Layer layer(width, width, ActivationFunctions::tanh);
+        const std::vector<double> parameters = RandomValues<double>(layer.GetNumWeights() + layer.GetNumBiases());
+        std::copy(parameters.begin(), parameters.begin() + layer.GetNumWeights(), layer.GetWeights());
+        std::copy(parameters.begin() + layer.GetNumWeights(), parameters.end(), layer.GetBiases());
+        return layer;
+    }
+
+    /// Regression dataset of any size that generates each row from its index instead of storing it, y = sin(sum of x).
+    /// Rows are the same on every pass, so epochs over tens of millions of rows are measured without holding them in memory.
+    class SyntheticDataSource : public DataSource
+    {
+        public:
+            SyntheticDataSource(long inputNumRows, int inputNumInputs) : numRows(inputNumRows), numInputs(inputNumInputs), nextRow(0) {}
+
+            int GetNumInputs() const override { return numInputs; }
+            int GetNumOutputs() const override { return 1; }
+            long GetNumRows() const override { return numRows; }
+            void Reset() override { nextRow = 0; }
+
+            int ReadBatch(int maxRows, double* inputs, double* outputs) override
+            {
+                const int rows = static_cast<int>(std::min<long>(maxRows, numRows - nextRow));
+                for (int r = 0 ; r < rows ; r++, nextRow++)
+                {
+                    // SplitMix64 of the row index and column, mapped to [-1, 1)
+                    double sum = 0;
+                    for (int k = 0 ; k < numInputs ; k++)
+                    {
+                        uint64_t z = static_cast<uint64_t>(nextRow) * numInputs + k + 0x9e3779b97f4a7c15ULL;
+                        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                        z ^= z >> 31;
+                        inputs[static_cast<size_t>(r) * numInputs + k] = static_cast<double>(z >> 11) * 0x1.0p-52 - 1;
+                        sum += inputs[static_cast<size_t>(r) * numInputs + k];
+                    }
+                    outputs[r] = std::sin(sum);
+                }
+                return rows;
+            }
+
+        private:
+            long numRows;
+            int numInputs;
+            long nextRow;
+    };
+
+    const char* ActivationName(ActivationFunctions::ActivationType type)
+    {
+        switch (type)
+        {
+            case ActivationFunctions::ActivationType::Binary:   return "binary";
+            case ActivationFunctions::ActivationType::Linear:   return "linear";
+            case ActivationFunctions::ActivationType::Sigmoid:  return "sigmoid";
+            case ActivationFunctions::ActivationType::Tanh:     return "tanh";
+            case ActivationFunctions::ActivationType::Relu:     return "relu";
+            case ActivationFunctions::ActivationType::LRelu:    return "lrelu";
+            case ActivationFunctions::ActivationType::Elu:      return "elu";
+            case ActivationFunctions::ActivationType::Softplus: return "softplus";
+            case ActivationFunctions::ActivationType::Gelu:     return "gelu";
+            case ActivationFunctions::ActivationType::Silu:     return "silu";
+            default:                                            return "custom";
+        }
+    }
+
+    // Micro-benchmarks of the numeric kernels, each reporting the floating point operations per second it reaches
+
+    template<typename T, typename Accumulator>
+    void BM_Dot(Benchmark::State& state)
+    {
+        const int n = static_cast<int>(state.Range(0));
+        const std::vector<T> x = RandomValues<T>(n, 1), y = RandomValues<T>(n, 2);
+        for (auto _ : state)
+        {
+            Benchmark::DoNotOptimize(Kernels::Dot<T, Accumulator>(n, x.data(), y.data()));
+        }
+        state.SetBytesProcessed(2.0 * n * sizeof(T) * state.Iterations());
+        state.counters["FLOPS"] = Benchmark::Counter(2.0 * n * state.Iterations(), Benchmark::Counter::IsRate);
+    }
+
+    template<typename T, typename Accumulator>
+    void BM_Gemv(Benchmark::State& state)
+    {
+        const int n = static_cast<int>(state.Range(0));
+        const std::vector<T> a = RandomValues<T>(static_cast<size_t>(n) * n, 1), x = RandomValues<T>(n, 2);
+        std::vector<T> y(n);
+        for (auto _ : state)
+        {
+            Kernels::Gemv<T, Accumulator>(false, n, n, 1, a.data(), n, x.data(), 0, y.data());
+            Benchmark::DoNotOptimize(y.data());
+        }
+        state.counters["FLOPS"] = Benchmark::Counter(2.0 * n * n * state.Iterations(), Benchmark::Counter::IsRate);
+    }
+
+    template<typename T, typename Accumulator>
+    void BM_Gemm(Benchmark::State& state)
+    {
+        const int n = static_cast<int>(state.Range(0));
+        const std::vector<T> a = RandomValues<T>(static_cast<size_t>(n) * n, 1), b = RandomValues<T>(static_cast<size_t>(n) * n, 2);
+        std::vector<T> c(static_cast<size_t>(n) * n);
+        for (auto _ : state)
+        {
+            Kernels::Gemm<T, Accumulator>(false, true, n, n, n, 1, a.data(), n, b.data(), n, 0, c.data(), n);
+            Benchmark::DoNotOptimize(c.data());
+        }
+        state.counters["FLOPS"] = Benchmark::Counter(2.0 * n * n * n * state.Iterations(), Benchmark::Counter::IsRate);
+    }
+
+    /// Activation function and its derivative over a buffer, with the activation type as the first argument and whether the
+    /// fast approximations are used as the third
+    template<typename T>
+    void BM_Activation(Benchmark::State& state)
+    {
+        const auto type = static_cast<ActivationFunctions::ActivationType>(state.Range(0));
+        const size_t count = state.Range(1);
+        const auto accuracy = state.Range(2) ? ActivationFunctions::Accuracy::Fast : ActivationFunctions::Accuracy::Exact;
+        const Activation activation(type, accuracy);
+        std::vector<T> inputs = RandomValues<T>(count), outputs(count), derivatives(count);
+        for (T& value : inputs)
+        {
+            value *= 3;
+        }
+        for (auto _ : state)
+        {
+            activation.ApplyWithDerivative(inputs.data(), count, outputs.data(), derivatives.data());
+            Benchmark::DoNotOptimize(outputs.data());
+        }
+        state.SetItemsProcessed(static_cast<double>(count) * state.Iterations());
+        state.SetLabel(std::string(ActivationName(type)) + (state.Range(2) ? " fast" : ""));
+    }
+
+    // Single training steps of one tanh layer of each width for a batch of rows, as run by NeuralNetwork::Forward() and
+    // NeuralNetwork::BackPropogate() for every layer
+
+    void BM_LayerForward(Benchmark::State& state)
+    {
+        const int width = static_cast<int>(state.Range(0)), rows = static_cast<int>(state.Range(1));
+        const Layer layer = RandomLayer(width);
+        const std::vector<double> inputs = RandomValues<double>(static_cast<size_t>(rows) * width);
+        Arena arena;
+        arena.Reserve(LayerBuffers::GetSize(layer, rows));
+        LayerBuffers buffers;
+        buffers.Allocate(layer, rows, arena);
+        for (auto _ : state)
+        {
+            layer.Forward(inputs.data(), rows, buffers.preActivations.data(), buffers.outputs.data(), buffers.derivatives.data());
+            Benchmark::DoNotOptimize(buffers.outputs.data());
+        }
+        state.SetItemsProcessed(static_cast<double>(rows) * state.Iterations());
+    }
+
+    void BM_LayerBackPropogate(Benchmark::State& state)
+    {
+        const int width = static_cast<int>(state.Range(0)), rows = static_cast<int>(state.Range(1));
+        const Layer layer = RandomLayer(width);
+        const std::vector<double> inputs = RandomValues<double>(static_cast<size_t>(rows) * width);
+        const std::vector<double> deltas = RandomValues<double>(static_cast<size_t>(rows) * width, 7);
+        std::vector<double> inputDeltas(static_cast<size_t>(rows) * width);
+        Arena arena;
+        arena.Reserve(LayerBuffers::GetSize(layer, rows));
+        LayerBuffers buffers;
+        buffers.Allocate(layer, rows, arena);
+        for (auto _ : state)
+        {
+            layer.Backward(deltas.data(), rows, inputDeltas.data());
+            layer.ComputeGradients(deltas.data(), inputs.data(), rows, buffers.weightGradients.data(), buffers.biasGradients.data());
+            Benchmark::DoNotOptimize(inputDeltas.data());
+            Benchmark::DoNotOptimize(buffers.weightGradients.data());
+        }
+        state.SetItemsProcessed(static_cast<double>(rows) * state.Iterations());
+    }
+
+    // Macro-benchmarks of whole networks
+
+    /// One training epoch over a synthetic dataset with the given number of rows, streamed through Train(DataSource&)
+    void BM_TrainEpoch(Benchmark::State& state)
+    {
+        const long rows = state.Range(0);
+        SyntheticDataSource source(rows, 16);
+        NeuralNetwork network({32, 32}, ActivationFunctions::tanh, LossFunctions::mse, 1, 0.001);
+        network.SetBatchSize(64);
+        network.Initialize(source);
+
+        // Train() reports every epoch on std::cout, which would drown out the results
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        for (auto _ : state)
+        {
+            network.Train(source);
+        }
+        std::cout.rdbuf(original);
+        state.SetItemsProcessed(static_cast<double>(rows) * state.Iterations());
+    }
+
+    /// Distribution of the latency of single PredictBatch() calls of the given number of rows
+    void BM_PredictLatency(Benchmark::State& state)
+    {
+        using Clock = std::chrono::steady_clock;
+        const int rows = static_cast<int>(state.Range(0));
+        SyntheticDataSource source(1, 16);
+        NeuralNetwork network({64, 64}, ActivationFunctions::tanh, LossFunctions::mse, 1, 0.001);
+        network.Initialize(source);
+        const std::vector<double> inputs = RandomValues<double>(static_cast<size_t>(rows) * 16);
+        std::vector<double> outputs(rows);
+
+        std::vector<double> latencies;
+        latencies.reserve(std::min<long>(state.Iterations(), 10000000));
+        for (auto _ : state)
+        {
+            const auto start = Clock::now();
+            network.PredictBatch(inputs, outputs);
+            const auto stop = Clock::now();
+            if (latencies.size() < latencies.capacity())
+            {
+                latencies.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+            }
+        }
+        state.SetItemsProcessed(static_cast<double>(rows) * state.Iterations());
+
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double fraction) { return latencies[static_cast<size_t>(fraction * (latencies.size() - 1))]; };
+        state.counters["p50_ns"] = percentile(0.5);
+        state.counters["p90_ns"] = percentile(0.9);
+        state.counters["p99_ns"] = percentile(0.99);
+        state.counters["p999_ns"] = percentile(0.999);
+        state.counters["max_ns"] = latencies.back();
+    }
+}
+
+NN_BENCHMARK(BM_Dot<double, double>)->Arg(64)->Arg(1024)->Arg(16384);
+NN_BENCHMARK(BM_Dot<float, float>)->Arg(64)->Arg(1024)->Arg(16384);
+NN_BENCHMARK(BM_Gemv<double, double>)->Arg(64)->Arg(256)->Arg(1024);
+NN_BENCHMARK(BM_Gemv<float, float>)->Arg(64)->Arg(256)->Arg(1024);
+NN_BENCHMARK(BM_Gemm<double, double>)->Arg(64)->Arg(256)->Arg(512);
+NN_BENCHMARK(BM_Gemm<float, float>)->Arg(64)->Arg(256)->Arg(512);
+NN_BENCHMARK(BM_Gemm<float, double>)->Arg(64)->Arg(256)->Arg(512);
+NN_BENCHMARK(BM_Activation<double>)->Args({1, 4096, 0})->Args({2, 4096, 0})->Args({3, 4096, 0})->Args({4, 4096, 0})->Args({5, 4096, 0})->Args({6, 4096, 0})->Args({7, 4096, 0})->Args({8, 4096, 0})->Args({9, 4096, 0})
+    ->Args({2, 4096, 1})->Args({3, 4096, 1})->Args({6, 4096, 1})->Args({7, 4096, 1})->Args({8, 4096, 1})->Args({9, 4096, 1});
+NN_BENCHMARK(BM_Activation<float>)->Args({1, 4096, 0})->Args({2, 4096, 0})->Args({3, 4096, 0})->Args({4, 4096, 0})->Args({5, 4096, 0})->Args({6, 4096, 0})->Args({7, 4096, 0})->Args({8, 4096, 0})->Args({9, 4096, 0})
+    ->Args({2, 4096, 1})->Args({3, 4096, 1})->Args({6, 4096, 1})->Args({7, 4096, 1})->Args({8, 4096, 1})->Args({9, 4096, 1});
+NN_BENCHMARK(BM_LayerForward)->Args({16, 32})->Args({64, 32})->Args({256, 32})->Args({1024, 32});
+NN_BENCHMARK(BM_LayerBackPropogate)->Args({16, 32})->Args({64, 32})->Args({256, 32})->Args({1024, 32});
+NN_BENCHMARK(BM_TrainEpoch)->Range(1000, 10000000, 10)->Iterations(1)->Unit("ms");
+NN_BENCHMARK(BM_PredictLatency)->Arg(1)->Arg(16)->Arg(256)->Unit("us");
+
+int main(int argc, char** argv)
+{
+    Benchmark::AddCustomContext("instruction_set", Kernels::GetInstructionSetName(Kernels::GetInstructionSet()));
+    return Benchmark::RunSpecifiedBenchmarks(argc, argv);
+}
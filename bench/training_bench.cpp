@@ -0,0 +1,154 @@
+#include "../src/network.h"
+#include "../src/data_pipeline.h"
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <thread>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    /// Synthetic regression dataset, y = sin(sum of x) with inputs drawn uniformly from [-1, 1]
+    void MakeDataset(int rows, int inputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(1));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double sum = 0;
+            for (double& value : x[r]) { value = distribution(generator); sum += value; }
+            y[r][0] = std::sin(sum);
+        }
+    }
+
+    /// Trains for three epochs and prints the throughput, which it returns in samples per second
+    double Run(const char* name, NeuralNetwork::TrainingMode mode, int threads, int batchSize,
+             const std::vector<std::vector<double>>& x, const std::vector<std::vector<double>>& y, DataSource* source = nullptr)
+    {
+        NeuralNetwork network({64, 64}, ActivationFunctions::tanh, LossFunctions::mse, 3, 0.001);
+        network.SetTrainingMode(mode);
+        network.SetNumThreads(threads);
+        network.SetBatchSize(batchSize);
+        network.Initialize(x, y);
+
+        // Train() reports every epoch on std::cout, which would drown out the results
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        if (source)
+        {
+            network.Train(*source);
+        }
+        else
+        {
+            network.Train();
+        }
+        std::cout.rdbuf(original);
+
+        const NeuralNetwork::ThroughputStats& stats = network.GetThroughputStats();
+        std::cout << name << "\tthreads=" << threads << "\tbatch=" << batchSize << "\t" << stats.totalSamplesPerSecond << " samples/s\tper thread:";
+        for (double perThread : stats.samplesPerSecond)
+        {
+            std::cout << " " << perThread;
+        }
+        std::cout << std::endl;
+        return stats.totalSamplesPerSecond;
+    }
+
+    /// Checks that a shuffling pipeline visits every row exactly once per epoch, in a different order each epoch
+    bool VerifyShuffle(DataSource& source, const char* name)
+    {
+        DataPipeline::Options options;
+        options.batchRows = 100;
+        options.shuffleWindowRows = 1000;
+        options.seed = 42;
+        DataPipeline pipeline(source, options);
+
+        const long numRows = source.GetNumRows();
+        std::vector<double> inputs(static_cast<size_t>(options.batchRows) * source.GetNumInputs());
+        std::vector<double> outputs(options.batchRows * source.GetNumOutputs());
+        std::vector<double> previousOrder;
+        for (int epoch = 0 ; epoch < 3 ; epoch++)
+        {
+            std::vector<double> order;
+            pipeline.Reset();
+            for (int rows = pipeline.ReadBatch(options.batchRows, inputs.data(), outputs.data()) ; rows > 0 ;
+                 rows = pipeline.ReadBatch(options.batchRows, inputs.data(), outputs.data()))
+            {
+                order.insert(order.end(), outputs.begin(), outputs.begin() + rows);
+            }
+
+            // The targets are all distinct, so sorting them shows whether every row came through exactly once
+            std::vector<double> sorted = order;
+            std::sort(sorted.begin(), sorted.end());
+            if (static_cast<long>(order.size()) != numRows || std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end() || order == previousOrder)
+            {
+                std::cout << name << " shuffle FAILED in epoch " << epoch << std::endl;
+                return false;
+            }
+            previousOrder = order;
+        }
+        std::cout << name << " shuffle ok" << std::endl;
+        return true;
+    }
+}
+
+int main()
+{
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(20000, 32, x, y);
+
+    // Throughput against the number of threads, as a speedup over one thread and the fraction of linear scaling reached.
+    // Threads beyond the cores of the machine can only take turns, so the sweep stops there, except that it always
+    // includes two threads to show what synchronising them costs.
+    const int cores = std::max(1u, std::thread::hardware_concurrency());
+    const int maxThreads = std::max(2, cores);
+    double single[3] = {0, 0, 0};
+    for (int threads = 1 ; threads <= maxThreads ; threads *= 2)
+    {
+        const double samplesPerSecond[3] =
+        {
+            Run("synchronous", NeuralNetwork::TrainingMode::Synchronous, threads, 1, x, y),
+            Run("synchronous", NeuralNetwork::TrainingMode::Synchronous, threads, 64, x, y),
+            Run("hogwild", NeuralNetwork::TrainingMode::Hogwild, threads, 1, x, y)
+        };
+        const char* names[3] = {"synchronous batch=1", "synchronous batch=64", "hogwild batch=1"};
+        for (int k = 0 ; k < 3 ; k++)
+        {
+            if (threads == 1)
+            {
+                single[k] = samplesPerSecond[k];
+            }
+            const double speedup = samplesPerSecond[k] / single[k];
+            std::cout << std::fixed << std::setprecision(2) << "scaling\t" << names[k] << "\tthreads=" << threads << " of " << cores
+                      << " cores\tspeedup=" << speedup << "x\tefficiency=" << std::setprecision(0) << 100 * speedup / threads << "%"
+                      << std::defaultfloat << std::setprecision(6) << std::endl;
+        }
+    }
+
+    // Compare streaming from a binary file directly against streaming it through the prefetching pipeline
+    InMemoryDataSource memory(x, y);
+    BinaryDataWriter::Convert(memory, "training_bench.nnd");
+    BinaryDataSource file("training_bench.nnd");
+    if (!VerifyShuffle(memory, "in-memory") || !VerifyShuffle(file, "binary"))
+    {
+        return 1;
+    }
+
+    Run("binary file", NeuralNetwork::TrainingMode::Synchronous, 1, 64, x, y, &file);
+    DataPipeline::Options options;
+    options.batchRows = 64;
+    DataPipeline::ComputeNormalization(file, options.inputMean, options.inputStdDev);
+    DataPipeline pipeline(file, options);
+    Run("pipelined", NeuralNetwork::TrainingMode::Synchronous, 1, 64, x, y, &pipeline);
+    const DataPipeline::Metrics metrics = pipeline.GetMetrics();
+    std::cout << "pipeline\tqueue depth=" << metrics.averageQueueDepth << "\ttrainer stalled=" << metrics.consumerStallSeconds
+              << "s\tproducer stalled=" << metrics.producerStallSeconds << "s" << std::endl;
+    std::remove("training_bench.nnd");
+
+    return 0;
+}
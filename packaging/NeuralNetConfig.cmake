@@ -0,0 +1,33 @@
+# Package file installed by "make install", for find_package(NeuralNet). Defines the imported targets
+# NeuralNet::neuralnet_static and NeuralNet::neuralnet_shared, and NeuralNet::neuralnet, which is the shared library unless
+# NeuralNet_USE_STATIC is set. Headers are included as <neuralnet/network.h>.
+include(CMakeFindDependencyMacro)
+find_dependency(Threads)
+
+get_filename_component(_neuralnet_prefix "${CMAKE_CURRENT_LIST_DIR}/../../.." ABSOLUTE)
+
+if(NOT TARGET NeuralNet::neuralnet_static)
+    add_library(NeuralNet::neuralnet_static STATIC IMPORTED)
+    set_target_properties(NeuralNet::neuralnet_static PROPERTIES
+        IMPORTED_LOCATION "${_neuralnet_prefix}/lib/libneuralnet.a"
+        INTERFACE_INCLUDE_DIRECTORIES "${_neuralnet_prefix}/include"
+        INTERFACE_COMPILE_FEATURES cxx_std_17
+        INTERFACE_LINK_LIBRARIES Threads::Threads)
+
+    add_library(NeuralNet::neuralnet_shared SHARED IMPORTED)
+    set_target_properties(NeuralNet::neuralnet_shared PROPERTIES
+        IMPORTED_LOCATION "${_neuralnet_prefix}/lib/libneuralnet.so"
+        IMPORTED_SONAME "libneuralnet.so.1"
+        INTERFACE_INCLUDE_DIRECTORIES "${_neuralnet_prefix}/include"
+        INTERFACE_COMPILE_FEATURES cxx_std_17
+        INTERFACE_LINK_LIBRARIES Threads::Threads)
+
+    add_library(NeuralNet::neuralnet INTERFACE IMPORTED)
+    if(NeuralNet_USE_STATIC)
+        set_target_properties(NeuralNet::neuralnet PROPERTIES INTERFACE_LINK_LIBRARIES NeuralNet::neuralnet_static)
+    else()
+        set_target_properties(NeuralNet::neuralnet PROPERTIES INTERFACE_LINK_LIBRARIES NeuralNet::neuralnet_shared)
+    endif()
+endif()
+
+unset(_neuralnet_prefix)
@@ -0,0 +1,131 @@
+#include "arena.h"
+
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#define NN_HAS_HUGE_PAGES 1
+#endif
+
+namespace
+{
+    /// Transparent huge pages are 2 MB on x86-64 and most other Linux targets
+    constexpr size_t HugePageSize = 2 << 20;
+}
+
+Arena::Arena()
+             :
+             memory(nullptr),
+             capacity(0),
+             used(0),
+             mapped(false)
+{
+}
+
+Arena::~Arena()
+{
+    Release();
+}
+
+Arena::Arena(Arena&& other) noexcept
+             :
+             memory(std::exchange(other.memory, nullptr)),
+             capacity(std::exchange(other.capacity, 0)),
+             used(std::exchange(other.used, 0)),
+             mapped(std::exchange(other.mapped, false))
+{
+}
+
+Arena& Arena::operator=(Arena&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        memory = std::exchange(other.memory, nullptr);
+        capacity = std::exchange(other.capacity, 0);
+        used = std::exchange(other.used, 0);
+        mapped = std::exchange(other.mapped, false);
+    }
+    return *this;
+}
+
+void Arena::Reserve(size_t bytes, bool hugePages)
+{
+    used = 0;
+#ifdef NN_HAS_HUGE_PAGES
+    hugePages = hugePages && bytes >= HugePageSize;
+#else
+    hugePages = false;
+#endif
+    if (bytes <= capacity && hugePages == mapped)
+    {
+        return;
+    }
+
+    Release();
+    if (bytes == 0)
+    {
+        return;
+    }
+#ifdef NN_HAS_HUGE_PAGES
+    if (hugePages)
+    {
+        // Whole huge pages are mapped, and the kernel backs them with huge pages where it can. Mappings are page aligned,
+        // which covers Alignment.
+        const size_t size = (bytes + HugePageSize - 1) / HugePageSize * HugePageSize;
+        void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED)
+        {
+            throw(std::bad_alloc());
+        }
+        madvise(mapping, size, MADV_HUGEPAGE);
+        memory = static_cast<char*>(mapping);
+        capacity = size;
+        mapped = true;
+        return;
+    }
+#endif
+    const size_t size = GetSize<char>(bytes);
+    memory = static_cast<char*>(::operator new(size, std::align_val_t(Alignment)));
+    capacity = size;
+}
+
+void Arena::Clear()
+{
+    used = 0;
+}
+
+size_t Arena::GetCapacity() const
+{
+    return this->capacity;
+}
+
+size_t Arena::GetUsed() const
+{
+    return this->used;
+}
+
+bool Arena::UsesHugePages() const
+{
+    return this->mapped;
+}
+
+void Arena::Release()
+{
+#ifdef NN_HAS_HUGE_PAGES
+    if (mapped)
+    {
+        munmap(memory, capacity);
+    }
+    else
+#endif
+    if (memory)
+    {
+        ::operator delete(memory, std::align_val_t(Alignment));
+    }
+    memory = nullptr;
+    capacity = 0;
+    used = 0;
+    mapped = false;
+}
@@ -0,0 +1,90 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+
+#include "span.h"
+
+class Arena
+{
+    public:
+        /// Every allocation starts on a boundary of this many bytes, a cache line and the width of an AVX-512 register
+        static constexpr size_t Alignment = 64;
+
+        /// @class Single aligned block of memory that buffers are carved out of one after another. Nothing is freed on its
+        ///        own: the whole arena is reused by Clear() or Reserve(), so once it is large enough handing out buffers never
+        ///        touches the heap. Callers plan the total size with GetSize() before allocating.
+        Arena();
+
+        /// @brief Releases the block
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        Arena(Arena&& other) noexcept;
+        Arena& operator=(Arena&& other) noexcept;
+
+        /// @brief       Returns the number of bytes that an allocation of count values takes up in an arena, including the
+        ///              padding up to the next aligned boundary
+        /// @param count The number of values
+        /// @return      The size in bytes
+        template<typename T>
+        static size_t GetSize(size_t count)
+        {
+            return (count * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+        }
+
+        /// @brief           Makes room for at least the given number of bytes and releases every allocation made so far. The
+        ///                  block is only replaced when it is too small or its kind of memory changes.
+        /// @param bytes     The number of bytes that will be allocated, as planned with GetSize()
+        /// @param hugePages Whether the block should be backed by transparent huge pages, which saves TLB misses when the
+        ///                  buffers span many pages. Only used on Linux, and ignored for blocks smaller than a huge page.
+        void Reserve(size_t bytes, bool hugePages = false);
+
+        /// @brief Releases every allocation, keeping the block for the next ones
+        void Clear();
+
+        /// @brief       Hands out the next count values of the block, zero-initialized and aligned to Alignment. Throws if
+        ///              the block has no room left, which means the caller planned a smaller size than it allocates.
+        /// @param count The number of values
+        /// @return      View of the values, which stays valid until the next Clear() or Reserve()
+        template<typename T>
+        Span<T> Allocate(size_t count)
+        {
+            const size_t size = GetSize<T>(count);
+            if (size > capacity - used)
+            {
+                throw(std::logic_error("Arena is too small for this allocation, reserve the planned size first"));
+            }
+            T* values = reinterpret_cast<T*>(memory + used);
+            used += size;
+            std::fill(values, values + count, T());
+            return Span<T>(values, count);
+        }
+
+        /// @brief  Get the size of the block
+        /// @return The number of bytes that can be allocated in total
+        size_t GetCapacity() const;
+
+        /// @brief  Get the number of bytes handed out since the last Clear() or Reserve(), including padding
+        /// @return The number of bytes used
+        size_t GetUsed() const;
+
+        /// @brief  Checks if the block was mapped with huge pages requested
+        /// @return Boolean value representing if huge pages are used
+        bool UsesHugePages() const;
+
+    private:
+        /// @brief Frees the block, leaving the arena empty
+        void Release();
+
+        char* memory;
+        size_t capacity;
+        size_t used;
+        /// Whether the block was mapped directly rather than taken from the heap
+        bool mapped;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,335 @@
+#include "checkpoint.h"
+#include "model_file.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define NN_HAS_FSYNC 1
+#endif
+
+namespace
+{
+    constexpr char FilePrefix[] = "checkpoint-";
+    constexpr char FileExtension[] = ".nnc";
+    constexpr char TemporaryExtension[] = ".tmp";
+
+    /// Returns the step in the name of a checkpoint file, or -1 if the name is not one of a checkpoint
+    long ParseStep(const std::string& name)
+    {
+        const size_t prefix = sizeof(FilePrefix) - 1;
+        const size_t extension = sizeof(FileExtension) - 1;
+        if (name.size() <= prefix + extension || name.compare(0, prefix, FilePrefix) != 0
+            || name.compare(name.size() - extension, extension, FileExtension) != 0)
+        {
+            return -1;
+        }
+
+        long step = 0;
+        for (size_t i = prefix ; i < name.size() - extension ; i++)
+        {
+            if (name[i] < '0' || name[i] > '9')
+            {
+                return -1;
+            }
+            step = step * 10 + (name[i] - '0');
+        }
+        return step;
+    }
+}
+
+Checkpoint::Encoder::Encoder(std::vector<char>& inputBuffer)
+                            :
+                            buffer(inputBuffer)
+{
+    buffer.clear();
+}
+
+void Checkpoint::Encoder::WriteString(const std::string& value)
+{
+    WriteArray(value.data(), value.size());
+}
+
+void Checkpoint::Encoder::WriteBytes(const void* data, size_t bytes)
+{
+    const char* input = static_cast<const char*>(data);
+    buffer.insert(buffer.end(), input, input + bytes);
+}
+
+Checkpoint::Decoder::Decoder(const std::vector<char>& inputBuffer, const std::string& inputPath)
+                            :
+                            buffer(inputBuffer),
+                            path(inputPath),
+                            position(0)
+{
+}
+
+size_t Checkpoint::Decoder::ReadCount()
+{
+    const uint64_t count = Read<uint64_t>();
+    if (count > buffer.size() - position)
+    {
+        throw(std::runtime_error(path + " is truncated or corrupt"));
+    }
+    return static_cast<size_t>(count);
+}
+
+std::string Checkpoint::Decoder::ReadString()
+{
+    std::string value(ReadCount(), '\0');
+    ReadValues(&value[0], value.size());
+    return value;
+}
+
+void Checkpoint::Decoder::ReadBytes(void* data, size_t bytes)
+{
+    if (bytes > buffer.size() - position)
+    {
+        throw(std::runtime_error(path + " is truncated or corrupt"));
+    }
+    if (bytes)
+    {
+        std::memcpy(data, buffer.data() + position, bytes);
+    }
+    position += bytes;
+}
+
+std::vector<char> Checkpoint::ReadFile(const std::string& path, long& step)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        throw(std::runtime_error("Unable to open " + path));
+    }
+    const uint64_t size = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    Header header;
+    if (size < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        throw(std::runtime_error(path + " is too small to be a checkpoint"));
+    }
+    if (std::memcmp(header.magic, Magic, sizeof(header.magic)) != 0)
+    {
+        throw(std::runtime_error(path + " is not a checkpoint"));
+    }
+    if (header.version != Version || header.byteOrderMark != ByteOrderMark)
+    {
+        throw(std::runtime_error(path + " was written with an unsupported version or byte order"));
+    }
+    if (header.payloadSize != size - sizeof(header))
+    {
+        throw(std::runtime_error(path + " is truncated or corrupt"));
+    }
+
+    std::vector<char> payload(header.payloadSize);
+    if (!file.read(payload.data(), payload.size()))
+    {
+        throw(std::runtime_error("Unable to read " + path));
+    }
+    if (ModelFile::Checksum(payload.data(), payload.size()) != header.checksum)
+    {
+        throw(std::runtime_error(path + " failed its checksum"));
+    }
+    step = static_cast<long>(header.step);
+    return payload;
+}
+
+std::vector<std::string> Checkpoint::ListFiles(const std::string& directory)
+{
+    std::vector<std::pair<long, std::string>> files;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory))
+    {
+        const long step = ParseStep(entry.path().filename().string());
+        if (step >= 0 && entry.is_regular_file())
+        {
+            files.emplace_back(step, entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<std::string> paths;
+    for (const auto& file : files)
+    {
+        paths.push_back(file.second);
+    }
+    return paths;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& inputDirectory, int inputKeep)
+                                   :
+                                   directory(inputDirectory),
+                                   keep(inputKeep),
+                                   queuedSteps{-1, -1},
+                                   acquired(-1),
+                                   nextFill(0),
+                                   nextWrite(0),
+                                   stallSeconds(0),
+                                   stopping(false)
+{
+    if (keep < 1)
+    {
+        throw(std::invalid_argument("At least one checkpoint must be kept"));
+    }
+    std::filesystem::create_directories(directory);
+
+    // Temporary files are only left behind by a crash part way through a write, and are never complete
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory))
+    {
+        const std::string name = entry.path().filename().string();
+        const size_t extension = sizeof(TemporaryExtension) - 1;
+        if (name.size() > extension && name.compare(name.size() - extension, extension, TemporaryExtension) == 0
+            && ParseStep(name.substr(0, name.size() - extension)) >= 0)
+        {
+            std::filesystem::remove(entry.path());
+        }
+    }
+
+    writer = std::thread(&CheckpointWriter::WriterLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    writer.join();
+}
+
+std::vector<char>& CheckpointWriter::AcquireBuffer()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (acquired >= 0)
+    {
+        throw(std::logic_error("The last checkpoint buffer has not been submitted"));
+    }
+    if (queuedSteps[nextFill] >= 0)
+    {
+        auto start = std::chrono::steady_clock::now();
+        changed.wait(lock, [this] { return queuedSteps[nextFill] < 0; });
+        stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    RethrowError();
+
+    acquired = nextFill;
+    return buffers[acquired];
+}
+
+void CheckpointWriter::Submit(long step)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (acquired < 0)
+        {
+            throw(std::logic_error("No checkpoint buffer has been acquired"));
+        }
+        queuedSteps[acquired] = step;
+        nextFill = 1 - acquired;
+        acquired = -1;
+    }
+    changed.notify_all();
+}
+
+void CheckpointWriter::Flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return queuedSteps[0] < 0 && queuedSteps[1] < 0; });
+    RethrowError();
+}
+
+double CheckpointWriter::GetStallSeconds() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stallSeconds;
+}
+
+void CheckpointWriter::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        // Queued checkpoints are still written when stopping, so that destroying the writer never loses one
+        changed.wait(lock, [this] { return stopping || queuedSteps[nextWrite] >= 0; });
+        if (queuedSteps[nextWrite] < 0)
+        {
+            return;
+        }
+
+        const int index = nextWrite;
+        const long step = queuedSteps[index];
+        lock.unlock();
+        try
+        {
+            WriteFile(buffers[index], step);
+        }
+        catch (...)
+        {
+            lock.lock();
+            error = error ? error : std::current_exception();
+            lock.unlock();
+        }
+        lock.lock();
+
+        queuedSteps[index] = -1;
+        nextWrite = 1 - index;
+        changed.notify_all();
+    }
+}
+
+void CheckpointWriter::WriteFile(const std::vector<char>& payload, long step)
+{
+    Checkpoint::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, Checkpoint::Magic, sizeof(header.magic));
+    header.version = Checkpoint::Version;
+    header.byteOrderMark = Checkpoint::ByteOrderMark;
+    header.step = step;
+    header.payloadSize = payload.size();
+    header.checksum = ModelFile::Checksum(payload.data(), payload.size());
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s%012ld%s", FilePrefix, step, FileExtension);
+    const std::string path = (std::filesystem::path(directory) / name).string();
+    const std::string temporaryPath = path + TemporaryExtension;
+
+    // The file only gets its final name once every byte of it is on disk
+    std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+    if (!file)
+    {
+        throw(std::runtime_error("Unable to open " + temporaryPath + " for writing"));
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1
+                && (payload.empty() || std::fwrite(payload.data(), payload.size(), 1, file) == 1)
+                && std::fflush(file) == 0;
+#ifdef NN_HAS_FSYNC
+    written = written && fsync(fileno(file)) == 0;
+#endif
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+        throw(std::runtime_error("Unable to write " + path));
+    }
+
+    const std::vector<std::string> files = Checkpoint::ListFiles(directory);
+    for (size_t i = keep ; i < files.size() ; i++)
+    {
+        std::remove(files[i].c_str());
+    }
+}
+
+void CheckpointWriter::RethrowError()
+{
+    if (error)
+    {
+        std::exception_ptr raised = error;
+        error = nullptr;
+        std::rethrow_exception(raised);
+    }
+}
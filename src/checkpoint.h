@@ -0,0 +1,214 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <exception>
+#include <type_traits>
+#include <condition_variable>
+
+namespace Checkpoint
+{
+    /// @brief Binary checkpoint file layout, all values little-endian as written by the host:
+    ///
+    ///        Header   fixed 40 byte header described below
+    ///        payload  the training state, as a sequence of fixed-width numbers and length-prefixed arrays of numbers
+    ///                 written by an Encoder and read back in the same order by a Decoder. Structures are written field by
+    ///                 field, so that the payload holds no padding and does not depend on the platform.
+    ///
+    ///        The checksum covers the payload. Files are written under a temporary name and renamed into place once they
+    ///        are complete, so a file with the final name is never partially written.
+
+    constexpr char Magic[8] = {'N', 'N', 'C', 'K', 'P', 'T', '\0', '\0'};
+    constexpr uint32_t Version = 2;
+    constexpr uint32_t ByteOrderMark = 0x01020304;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint64_t step;
+        uint64_t payloadSize;
+        uint64_t checksum;
+    };
+
+    static_assert(sizeof(Header) == 40, "Checkpoint header must be 40 bytes");
+
+    class Encoder
+    {
+        public:
+            /// @class        Appends values to a payload buffer. The buffer is cleared first but keeps its capacity, so
+            ///               encoding into the same buffer again does not allocate once it is large enough.
+            /// @param buffer The buffer to write to
+            explicit Encoder(std::vector<char>& buffer);
+
+            /// @brief       Appends one number
+            /// @param value The value
+            template<typename V>
+            void Write(const V& value)
+            {
+                static_assert(std::is_arithmetic<V>::value, "Only numbers can be written to a checkpoint");
+                WriteBytes(&value, sizeof(V));
+            }
+
+            /// @brief        Appends the number of values and then the values
+            /// @param values Pointer to the first value
+            /// @param count  The number of values
+            template<typename V>
+            void WriteArray(const V* values, size_t count)
+            {
+                static_assert(std::is_arithmetic<V>::value, "Only numbers can be written to a checkpoint");
+                Write<uint64_t>(count);
+                WriteBytes(values, count * sizeof(V));
+            }
+
+            /// @brief       Appends a string as an array of characters
+            /// @param value The string
+            void WriteString(const std::string& value);
+
+        private:
+            void WriteBytes(const void* data, size_t bytes);
+
+            std::vector<char>& buffer;
+    };
+
+    class Decoder
+    {
+        public:
+            /// @class        Reads values back out of a payload in the order they were encoded, throwing if it runs out
+            /// @param buffer The payload
+            /// @param path   Path of the file the payload was read from, for error messages
+            Decoder(const std::vector<char>& buffer, const std::string& path);
+
+            /// @brief  Reads one number
+            /// @return The value
+            template<typename V>
+            V Read()
+            {
+                static_assert(std::is_arithmetic<V>::value, "Only numbers can be read from a checkpoint");
+                V value;
+                ReadBytes(&value, sizeof(V));
+                return value;
+            }
+
+            /// @brief  Reads the number of values of an array written by Encoder::WriteArray(), leaving its values to be
+            ///         read by ReadValues()
+            /// @return The number of values
+            size_t ReadCount();
+
+            /// @brief        Reads the values of an array whose count has already been read
+            /// @param values Pointer to where the values are written
+            /// @param count  The number of values
+            template<typename V>
+            void ReadValues(V* values, size_t count)
+            {
+                static_assert(std::is_arithmetic<V>::value, "Only numbers can be read from a checkpoint");
+                ReadBytes(values, count * sizeof(V));
+            }
+
+            /// @brief  Reads a whole array written by Encoder::WriteArray()
+            /// @return The values
+            template<typename V>
+            std::vector<V> ReadArray()
+            {
+                std::vector<V> values(ReadCount());
+                ReadValues(values.data(), values.size());
+                return values;
+            }
+
+            /// @brief  Reads a string written by Encoder::WriteString()
+            /// @return The string
+            std::string ReadString();
+
+        private:
+            void ReadBytes(void* data, size_t bytes);
+
+            const std::vector<char>& buffer;
+            const std::string& path;
+            size_t position;
+    };
+
+    /// @brief      Reads a checkpoint file and verifies its header and checksum
+    /// @param path Path of the file
+    /// @param step Set to the step the checkpoint was taken at
+    /// @return     The payload
+    std::vector<char> ReadFile(const std::string& path, long& step);
+
+    /// @brief           Lists the checkpoint files in a directory, newest first
+    /// @param directory The directory to search
+    /// @return          Paths of the files, ordered by the step they were taken at, starting with the latest
+    std::vector<std::string> ListFiles(const std::string& directory);
+}
+
+class CheckpointWriter
+{
+    public:
+        /// @class           Writes checkpoints to a directory on a background thread, so that training only stalls for the
+        ///                  copy of its state into memory and not for the disk. Two payload buffers are double buffered
+        ///                  between the trainer and the writer thread. Each file is written and flushed under a temporary
+        ///                  name and then atomically renamed to checkpoint-<step>.nnc, after which all but the newest files
+        ///                  are removed, so a crash at any point leaves the previous checkpoints intact.
+        /// @param directory Directory to write the checkpoints to, created if it does not exist
+        /// @param keep      The number of checkpoints to keep
+        CheckpointWriter(const std::string& directory, int keep);
+
+        /// @brief Finishes writing any pending checkpoint and joins the writer thread
+        ~CheckpointWriter();
+
+        CheckpointWriter(const CheckpointWriter&) = delete;
+        CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+        /// @brief  Returns the buffer to encode the next checkpoint into, waiting only if both buffers are still queued or
+        ///         being written. Rethrows any error raised while writing an earlier checkpoint.
+        /// @return The buffer, which must be passed to Submit() before the next call
+        std::vector<char>& AcquireBuffer();
+
+        /// @brief      Queues the buffer returned by AcquireBuffer() to be written in the background
+        /// @param step The step the checkpoint was taken at, which names the file
+        void Submit(long step);
+
+        /// @brief Waits until every queued checkpoint is on disk, rethrowing any error raised while writing them
+        void Flush();
+
+        /// @brief  Get the total time the trainer spent waiting for a free buffer, which is time training stalled on disk
+        /// @return The time in seconds
+        double GetStallSeconds() const;
+
+    private:
+        /// @brief Main loop of the writer thread, writing queued buffers until stopped
+        void WriterLoop();
+
+        /// @brief         Writes one checkpoint file and removes the oldest files beyond the number to keep
+        /// @param payload The encoded training state
+        /// @param step    The step the checkpoint was taken at
+        void WriteFile(const std::vector<char>& payload, long step);
+
+        /// @brief Rethrows the first error raised by the writer thread, if there was one
+        void RethrowError();
+
+        std::string directory;
+        int keep;
+        std::vector<char> buffers[2];
+        /// Step of the queued buffer, or -1 while the buffer is free
+        long queuedSteps[2];
+        /// Buffer handed out by AcquireBuffer(), or -1 if none is. Buffers are filled and written alternately, so that
+        /// checkpoints reach the disk in the order they were taken.
+        int acquired;
+        int nextFill;
+        int nextWrite;
+        double stallSeconds;
+
+        mutable std::mutex mutex;
+        std::condition_variable changed;
+        bool stopping;
+        std::exception_ptr error;
+        std::thread writer;
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,429 @@
+#include "data_pipeline.h"
+
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+
+namespace
+{
+    double SecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+DataPipeline::DataPipeline(DataSource& inputSource, const Options& inputOptions)
+             :
+             source(inputSource),
+             options(inputOptions),
+             numInputs(inputSource.GetNumInputs()),
+             numOutputs(inputSource.GetNumOutputs()),
+             firstEpoch(0),
+             headPosition(0),
+             started(false),
+             epochStarted(false),
+             head(0),
+             tail(0),
+             ready(0),
+             stopping(false),
+             queueDepthSum(0),
+             queueDepthSamples(0)
+{
+    if (options.batchRows <= 0 || options.queueDepth <= 0 || options.shuffleWindowRows <= 0)
+    {
+        throw(std::invalid_argument("Pipeline batch rows, queue depth and shuffle window must be positive"));
+    }
+    if (!options.inputMean.empty() || !options.inputStdDev.empty())
+    {
+        if (options.inputMean.size() != static_cast<size_t>(numInputs) || options.inputStdDev.size() != static_cast<size_t>(numInputs))
+        {
+            throw(std::invalid_argument("Normalization mean and standard deviation must have one value per input"));
+        }
+        for (double deviation : options.inputStdDev)
+        {
+            if (deviation == 0)
+            {
+                throw(std::invalid_argument("Normalization standard deviation must not be zero"));
+            }
+            inputScale.push_back(1 / deviation);
+        }
+    }
+
+    // Every batch is allocated up front so that producing and consuming never allocate
+    ring.resize(options.queueDepth);
+    for (Batch& slot : ring)
+    {
+        slot.inputs.assign(static_cast<size_t>(options.batchRows) * numInputs, 0);
+        slot.outputs.assign(static_cast<size_t>(options.batchRows) * numOutputs, 0);
+    }
+}
+
+DataPipeline::~DataPipeline()
+{
+    StopProducer();
+}
+
+int DataPipeline::GetNumInputs() const
+{
+    return numInputs;
+}
+
+int DataPipeline::GetNumOutputs() const
+{
+    return numOutputs;
+}
+
+long DataPipeline::GetNumRows() const
+{
+    return source.GetNumRows();
+}
+
+void DataPipeline::Reset()
+{
+    if (!started)
+    {
+        started = true;
+        producer = std::thread(&DataPipeline::ProducerLoop, this);
+        return;
+    }
+    if (!epochStarted)
+    {
+        return;
+    }
+
+    // The producer is already working on the next epoch, so skip whatever is left of this one up to its marker
+    bool endOfEpoch = false;
+    while (!endOfEpoch)
+    {
+        endOfEpoch = AcquireReadySlot().endOfEpoch;
+        ReleaseReadySlot();
+    }
+    headPosition = 0;
+    epochStarted = false;
+}
+
+void DataPipeline::SetEpoch(long epoch)
+{
+    if (started)
+    {
+        // Batches already queued belong to the old order, so the producer starts over from an empty ring
+        StopProducer();
+        head = tail = ready = 0;
+        stopping = false;
+        error = nullptr;
+        headPosition = 0;
+        started = false;
+        epochStarted = false;
+    }
+    firstEpoch = static_cast<uint64_t>(epoch);
+}
+
+int DataPipeline::ReadBatch(int maxRows, double* inputs, double* outputs)
+{
+    if (!started)
+    {
+        Reset();
+    }
+    epochStarted = true;
+
+    int rows = 0;
+    while (rows < maxRows)
+    {
+        Batch& slot = AcquireReadySlot();
+        if (slot.endOfEpoch)
+        {
+            // The marker stays at the head of the queue until Reset() moves on to the next epoch
+            break;
+        }
+
+        const int count = std::min(maxRows - rows, slot.rows - headPosition);
+        std::copy(slot.inputs.begin() + static_cast<size_t>(headPosition) * numInputs,
+                  slot.inputs.begin() + static_cast<size_t>(headPosition + count) * numInputs,
+                  inputs + static_cast<size_t>(rows) * numInputs);
+        std::copy(slot.outputs.begin() + static_cast<size_t>(headPosition) * numOutputs,
+                  slot.outputs.begin() + static_cast<size_t>(headPosition + count) * numOutputs,
+                  outputs + static_cast<size_t>(rows) * numOutputs);
+        rows += count;
+        headPosition += count;
+
+        if (headPosition == slot.rows)
+        {
+            headPosition = 0;
+            ReleaseReadySlot();
+        }
+    }
+    return rows;
+}
+
+DataPipeline::Metrics DataPipeline::GetMetrics() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Metrics snapshot = metrics;
+    snapshot.averageQueueDepth = queueDepthSamples ? queueDepthSum / queueDepthSamples : 0;
+    return snapshot;
+}
+
+void DataPipeline::ComputeNormalization(DataSource& source, std::vector<double>& mean, std::vector<double>& stdDev)
+{
+    const int inputs = source.GetNumInputs();
+    const int batchRows = 4096;
+    std::vector<double> batchInputs(static_cast<size_t>(batchRows) * inputs);
+    std::vector<double> batchOutputs(static_cast<size_t>(batchRows) * source.GetNumOutputs());
+
+    // Welford's running update keeps the variance accurate for columns with a large mean
+    mean.assign(inputs, 0);
+    std::vector<double> squares(inputs, 0);
+    long count = 0;
+    source.Reset();
+    for (int rows = source.ReadBatch(batchRows, batchInputs.data(), batchOutputs.data()) ; rows > 0 ;
+         rows = source.ReadBatch(batchRows, batchInputs.data(), batchOutputs.data()))
+    {
+        for (int r = 0 ; r < rows ; r++)
+        {
+            count++;
+            const double* row = batchInputs.data() + static_cast<size_t>(r) * inputs;
+            for (int c = 0 ; c < inputs ; c++)
+            {
+                const double difference = row[c] - mean[c];
+                mean[c] += difference / count;
+                squares[c] += difference * (row[c] - mean[c]);
+            }
+        }
+    }
+    source.Reset();
+
+    stdDev.assign(inputs, 1);
+    for (int c = 0 ; c < inputs && count > 0 ; c++)
+    {
+        const double deviation = std::sqrt(squares[c] / count);
+        stdDev[c] = deviation > 0 ? deviation : 1;
+    }
+}
+
+void DataPipeline::StopProducer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    slotFree.notify_all();
+    if (producer.joinable())
+    {
+        producer.join();
+    }
+}
+
+void DataPipeline::ProducerLoop()
+{
+    try
+    {
+        for (uint64_t epoch = firstEpoch ; ProduceEpoch(epoch) ; epoch++)
+        {
+        }
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+    }
+    slotReady.notify_all();
+}
+
+bool DataPipeline::ProduceEpoch(uint64_t epoch)
+{
+    source.Reset();
+    std::seed_seq seed{static_cast<uint32_t>(options.seed), static_cast<uint32_t>(options.seed >> 32),
+                       static_cast<uint32_t>(epoch), static_cast<uint32_t>(epoch >> 32)};
+    std::mt19937_64 generator(seed);
+    const long numRows = source.GetNumRows();
+
+    if (source.SupportsRandomAccess() && numRows >= 0)
+    {
+        // Random access sources are gathered straight into the batches following a permutation of every row
+        permutation.resize(numRows);
+        std::iota(permutation.begin(), permutation.end(), 0L);
+        if (options.shuffle)
+        {
+            std::shuffle(permutation.begin(), permutation.end(), generator);
+        }
+        for (long start = 0 ; start < numRows ; start += options.batchRows)
+        {
+            Batch* slot = AcquireFreeSlot();
+            if (!slot)
+            {
+                return false;
+            }
+            slot->rows = static_cast<int>(std::min<long>(options.batchRows, numRows - start));
+            slot->endOfEpoch = false;
+            source.ReadRows(permutation.data() + start, slot->rows, slot->inputs.data(), slot->outputs.data());
+            Normalise(*slot);
+            PublishSlot();
+        }
+    }
+    else if (!options.shuffle)
+    {
+        while (true)
+        {
+            Batch* slot = AcquireFreeSlot();
+            if (!slot)
+            {
+                return false;
+            }
+            slot->rows = source.ReadBatch(options.batchRows, slot->inputs.data(), slot->outputs.data());
+            if (slot->rows == 0)
+            {
+                // The slot that found the end of the data becomes the end of epoch marker
+                slot->endOfEpoch = true;
+                PublishSlot();
+                return true;
+            }
+            slot->endOfEpoch = false;
+            Normalise(*slot);
+            PublishSlot();
+        }
+    }
+    else
+    {
+        // Streaming sources are read one window at a time and each window is shuffled on its own
+        const int windowCapacity = numRows >= 0 ? static_cast<int>(std::min<long>(options.shuffleWindowRows, std::max(numRows, 1L)))
+                                                : options.shuffleWindowRows;
+        windowInputs.resize(static_cast<size_t>(windowCapacity) * numInputs);
+        windowOutputs.resize(static_cast<size_t>(windowCapacity) * numOutputs);
+        permutation.resize(windowCapacity);
+
+        while (true)
+        {
+            int windowRows = 0;
+            int rows = 0;
+            do
+            {
+                rows = source.ReadBatch(windowCapacity - windowRows,
+                                        windowInputs.data() + static_cast<size_t>(windowRows) * numInputs,
+                                        windowOutputs.data() + static_cast<size_t>(windowRows) * numOutputs);
+                windowRows += rows;
+            } while (rows > 0 && windowRows < windowCapacity);
+
+            if (windowRows == 0)
+            {
+                break;
+            }
+
+            std::iota(permutation.begin(), permutation.begin() + windowRows, 0L);
+            std::shuffle(permutation.begin(), permutation.begin() + windowRows, generator);
+            for (int start = 0 ; start < windowRows ; start += options.batchRows)
+            {
+                Batch* slot = AcquireFreeSlot();
+                if (!slot)
+                {
+                    return false;
+                }
+                slot->rows = std::min(options.batchRows, windowRows - start);
+                slot->endOfEpoch = false;
+                for (int r = 0 ; r < slot->rows ; r++)
+                {
+                    const size_t row = permutation[start + r];
+                    std::copy(windowInputs.begin() + row * numInputs, windowInputs.begin() + (row + 1) * numInputs,
+                              slot->inputs.begin() + static_cast<size_t>(r) * numInputs);
+                    std::copy(windowOutputs.begin() + row * numOutputs, windowOutputs.begin() + (row + 1) * numOutputs,
+                              slot->outputs.begin() + static_cast<size_t>(r) * numOutputs);
+                }
+                Normalise(*slot);
+                PublishSlot();
+            }
+
+            if (rows == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    Batch* marker = AcquireFreeSlot();
+    if (!marker)
+    {
+        return false;
+    }
+    marker->rows = 0;
+    marker->endOfEpoch = true;
+    PublishSlot();
+    return true;
+}
+
+DataPipeline::Batch* DataPipeline::AcquireFreeSlot()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (ready == ring.size() && !stopping)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        slotFree.wait(lock, [this] { return ready < ring.size() || stopping; });
+        metrics.producerStallSeconds += SecondsSince(start);
+    }
+    return stopping ? nullptr : &ring[tail];
+}
+
+void DataPipeline::PublishSlot()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!ring[tail].endOfEpoch)
+        {
+            metrics.batchesProduced++;
+        }
+        tail = (tail + 1) % ring.size();
+        ready++;
+    }
+    slotReady.notify_one();
+}
+
+void DataPipeline::Normalise(Batch& slot) const
+{
+    if (inputScale.empty())
+    {
+        return;
+    }
+    for (int r = 0 ; r < slot.rows ; r++)
+    {
+        double* row = slot.inputs.data() + static_cast<size_t>(r) * numInputs;
+        for (int c = 0 ; c < numInputs ; c++)
+        {
+            row[c] = (row[c] - options.inputMean[c]) * inputScale[c];
+        }
+    }
+}
+
+DataPipeline::Batch& DataPipeline::AcquireReadySlot()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (headPosition == 0)
+    {
+        queueDepthSum += ready;
+        queueDepthSamples++;
+    }
+    if (ready == 0 && !error)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        slotReady.wait(lock, [this] { return ready > 0 || error; });
+        metrics.consumerStallSeconds += SecondsSince(start);
+    }
+    if (ready == 0)
+    {
+        std::rethrow_exception(error);
+    }
+    return ring[head];
+}
+
+void DataPipeline::ReleaseReadySlot()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!ring[head].endOfEpoch)
+        {
+            metrics.batchesConsumed++;
+        }
+        head = (head + 1) % ring.size();
+        ready--;
+    }
+    slotFree.notify_one();
+}
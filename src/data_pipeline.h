@@ -0,0 +1,161 @@
+#ifndef DATA_PIPELINE_H
+#define DATA_PIPELINE_H
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <exception>
+#include <condition_variable>
+
+#include "dataset.h"
+
+class DataPipeline : public DataSource
+{
+    public:
+        /// @brief Settings for a data pipeline
+        struct Options
+        {
+            /// Number of rows in each prefetched batch
+            int batchRows = 256;
+            /// Number of preallocated batches in the ring buffer between the producer thread and the trainer
+            int queueDepth = 4;
+            /// Whether rows are visited in a different seeded random order every epoch
+            bool shuffle = true;
+            /// Seed of the shuffle, where epoch e is shuffled with a generator seeded from (seed, e)
+            uint64_t seed = 0;
+            /// Sources without random access are shuffled within windows of this many rows
+            int shuffleWindowRows = 65536;
+            /// When not empty, every input column c is normalised as (x - inputMean[c]) / inputStdDev[c]
+            std::vector<double> inputMean;
+            std::vector<double> inputStdDev;
+        };
+
+        /// @brief Counters describing how well the pipeline keeps up with training
+        struct Metrics
+        {
+            long batchesProduced = 0;
+            long batchesConsumed = 0;
+            /// Mean number of ready batches in the queue when the trainer asked for one, near zero means I/O bound
+            double averageQueueDepth = 0;
+            /// Total time the trainer spent waiting for the producer, which is time training was I/O bound
+            double consumerStallSeconds = 0;
+            /// Total time the producer spent waiting for a free batch, which is time training was compute bound
+            double producerStallSeconds = 0;
+        };
+
+        /// @class         Pipeline stage between a data source and NeuralNetwork::Train(). A producer thread reads, shuffles and
+        ///                normalises upcoming batches into a bounded ring of preallocated batches while the current batch is
+        ///                being trained on, and keeps going across epoch boundaries. The pipeline is itself a data source, so it
+        ///                can be passed anywhere a source is expected. Random access sources get a full permutation per epoch,
+        ///                other sources are shuffled within windows of Options::shuffleWindowRows rows.
+        /// @param source  The source to read from, which must outlive the pipeline and not be used by anything else meanwhile
+        /// @param options Settings for the pipeline
+        DataPipeline(DataSource& source, const Options& options);
+
+        /// @brief Stops and joins the producer thread
+        ~DataPipeline() override;
+
+        DataPipeline(const DataPipeline&) = delete;
+        DataPipeline& operator=(const DataPipeline&) = delete;
+
+        int GetNumInputs() const override;
+        int GetNumOutputs() const override;
+        long GetNumRows() const override;
+
+        /// @brief Moves on to the next epoch, discarding whatever is left of the current one. The producer thread is started
+        ///        by the first call, so nothing is read before training begins.
+        void Reset() override;
+
+        /// @brief       Starts the shuffle at a later epoch, so that it continues the order of a run being resumed. A
+        ///              producer thread that has already started is stopped, its queued batches are dropped, and the
+        ///              next read starts it again at the new epoch.
+        /// @param epoch The number of epochs already trained on
+        void SetEpoch(long epoch) override;
+
+        int ReadBatch(int maxRows, double* inputs, double* outputs) override;
+
+        /// @brief  Returns a snapshot of the pipeline counters, which may be called while training
+        /// @return The counters
+        Metrics GetMetrics() const;
+
+        /// @brief         Calculates the mean and standard deviation of every input column in one pass over a source, for use
+        ///                as Options::inputMean and Options::inputStdDev. Columns with no variance get a deviation of one.
+        /// @param source  The source to read, which is rewound before and after
+        /// @param mean    Set to the mean of every input column
+        /// @param stdDev  Set to the standard deviation of every input column
+        static void ComputeNormalization(DataSource& source, std::vector<double>& mean, std::vector<double>& stdDev);
+
+    private:
+        /// @brief One preallocated slot of the ring buffer, holding a batch or an end-of-epoch marker
+        struct Batch
+        {
+            std::vector<double> inputs;
+            std::vector<double> outputs;
+            int rows = 0;
+            bool endOfEpoch = false;
+        };
+
+        /// @brief Asks the producer thread to stop, and waits for it to finish
+        void StopProducer();
+
+        /// @brief Main loop of the producer thread, producing epoch after epoch until stopped
+        void ProducerLoop();
+
+        /// @brief  Produces every batch of one epoch
+        /// @param  epoch Index of the epoch, used to seed the shuffle
+        /// @return False if the pipeline was stopped
+        bool ProduceEpoch(uint64_t epoch);
+
+        /// @brief  Waits for a free slot in the ring buffer
+        /// @return The free slot, or nullptr if the pipeline was stopped
+        Batch* AcquireFreeSlot();
+
+        /// @brief Hands a filled slot over to the consumer
+        void PublishSlot();
+
+        /// @brief      Normalises the inputs of a batch in place
+        /// @param slot The batch to normalise
+        void Normalise(Batch& slot) const;
+
+        /// @brief  Waits for the next ready slot, rethrowing any error raised by the producer
+        /// @return The ready slot at the head of the ring buffer
+        Batch& AcquireReadySlot();
+
+        /// @brief Returns the slot at the head of the ring buffer to the producer
+        void ReleaseReadySlot();
+
+        DataSource& source;
+        Options options;
+        int numInputs;
+        int numOutputs;
+        std::vector<double> inputScale;
+        std::vector<Batch> ring;
+
+        /// Producer side state, only touched by the producer thread
+        std::vector<long> permutation;
+        std::vector<double> windowInputs;
+        std::vector<double> windowOutputs;
+
+        /// Consumer side state, only touched by the training thread
+        uint64_t firstEpoch;
+        int headPosition;
+        bool started;
+        bool epochStarted;
+
+        /// State shared between both threads, guarded by the mutex
+        mutable std::mutex mutex;
+        std::condition_variable slotReady;
+        std::condition_variable slotFree;
+        size_t head;
+        size_t tail;
+        size_t ready;
+        bool stopping;
+        std::exception_ptr error;
+        Metrics metrics;
+        double queueDepthSum;
+        long queueDepthSamples;
+        std::thread producer;
+};
+
+#endif // DATA_PIPELINE_H
@@ -0,0 +1,532 @@
+#include "dataset.h"
+
+#include <cstring>
+#include <algorithm>
+#include <charconv>
+
+namespace
+{
+    /// Size of each chunk read from a CSV file, lines longer than this grow the buffer
+    constexpr size_t CsvChunkSize = 1 << 20;
+
+    bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t';
+    }
+}
+
+constexpr char BinaryDataSource::Magic[8];
+constexpr uint32_t BinaryDataSource::Version;
+
+InMemoryDataSource::InMemoryDataSource(const std::vector<std::vector<double>>& xData, const std::vector<std::vector<double>>& yData)
+                                       :
+                                       numInputs(0),
+                                       numOutputs(0),
+                                       numRows(xData.size()),
+                                       nextRow(0)
+{
+    if (xData.empty() || xData.size() != yData.size())
+    {
+        throw(std::invalid_argument("Dataset must not be empty and must have one output row per input row"));
+    }
+
+    numInputs = xData[0].size();
+    numOutputs = yData[0].size();
+    inputValues.reserve(static_cast<size_t>(numRows) * numInputs);
+    outputValues.reserve(static_cast<size_t>(numRows) * numOutputs);
+    for (long r = 0 ; r < numRows ; r++)
+    {
+        if (xData[r].size() != static_cast<size_t>(numInputs) || yData[r].size() != static_cast<size_t>(numOutputs))
+        {
+            throw(std::invalid_argument("Every row of the dataset must have the same number of values"));
+        }
+        inputValues.insert(inputValues.end(), xData[r].begin(), xData[r].end());
+        outputValues.insert(outputValues.end(), yData[r].begin(), yData[r].end());
+    }
+}
+
+int InMemoryDataSource::GetNumInputs() const
+{
+    return this->numInputs;
+}
+
+int InMemoryDataSource::GetNumOutputs() const
+{
+    return this->numOutputs;
+}
+
+long InMemoryDataSource::GetNumRows() const
+{
+    return this->numRows;
+}
+
+bool InMemoryDataSource::SupportsRandomAccess() const
+{
+    return true;
+}
+
+void InMemoryDataSource::ReadRows(const long* rowIndices, int count, double* inputs, double* outputs)
+{
+    for (int r = 0 ; r < count ; r++)
+    {
+        if (rowIndices[r] < 0 || rowIndices[r] >= numRows)
+        {
+            throw(std::invalid_argument("Row index is out of bounds"));
+        }
+        std::copy(GetInputs(rowIndices[r]), GetInputs(rowIndices[r]) + numInputs, inputs + static_cast<size_t>(r) * numInputs);
+        std::copy(GetOutputs(rowIndices[r]), GetOutputs(rowIndices[r]) + numOutputs, outputs + static_cast<size_t>(r) * numOutputs);
+    }
+}
+
+void InMemoryDataSource::Reset()
+{
+    this->nextRow = 0;
+}
+
+int InMemoryDataSource::ReadBatch(int maxRows, double* inputs, double* outputs)
+{
+    const int rows = std::min<long>(maxRows, numRows - nextRow);
+    std::copy(GetInputs(nextRow), GetInputs(nextRow) + static_cast<size_t>(rows) * numInputs, inputs);
+    std::copy(GetOutputs(nextRow), GetOutputs(nextRow) + static_cast<size_t>(rows) * numOutputs, outputs);
+    nextRow += rows;
+    return rows;
+}
+
+const double* InMemoryDataSource::GetInputs(long row) const
+{
+    return inputValues.data() + static_cast<size_t>(row) * numInputs;
+}
+
+const double* InMemoryDataSource::GetOutputs(long row) const
+{
+    return outputValues.data() + static_cast<size_t>(row) * numOutputs;
+}
+
+CsvDataSource::CsvDataSource(const std::string& path, int numOutputs, bool hasHeader, char delimiter)
+                             :
+                             path(path),
+                             file(nullptr),
+                             hasHeader(hasHeader),
+                             delimiter(delimiter),
+                             numInputs(0),
+                             numOutputs(numOutputs),
+                             lineNumber(0),
+                             buffer(CsvChunkSize),
+                             bufferStart(0),
+                             bufferEnd(0),
+                             endOfFile(false)
+{
+    if (numOutputs < 1)
+    {
+        throw(std::invalid_argument("A CSV dataset must have at least one output column"));
+    }
+
+    file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        throw(std::runtime_error("Unable to open " + path));
+    }
+
+    // Count the columns of the first row to find the number of inputs. The destructor does not run when the constructor
+    // throws, so the file is closed here.
+    try
+    {
+        Reset();
+        const char* line;
+        const char* end;
+        if (!NextLine(line, end))
+        {
+            throw(std::runtime_error(path + " does not contain any rows"));
+        }
+        const int columns = ParseLine(line, end, nullptr, -1);
+        if (columns <= numOutputs)
+        {
+            throw(std::runtime_error(path + " must have more columns than outputs"));
+        }
+        numInputs = columns - numOutputs;
+        rowValues.resize(columns);
+        Reset();
+    }
+    catch (...)
+    {
+        std::fclose(file);
+        throw;
+    }
+}
+
+CsvDataSource::~CsvDataSource()
+{
+    if (file)
+    {
+        std::fclose(file);
+    }
+}
+
+int CsvDataSource::GetNumInputs() const
+{
+    return this->numInputs;
+}
+
+int CsvDataSource::GetNumOutputs() const
+{
+    return this->numOutputs;
+}
+
+void CsvDataSource::Reset()
+{
+    std::rewind(file);
+    bufferStart = 0;
+    bufferEnd = 0;
+    endOfFile = false;
+    lineNumber = 0;
+
+    if (hasHeader)
+    {
+        const char* line;
+        const char* end;
+        NextLine(line, end);
+    }
+}
+
+int CsvDataSource::ReadBatch(int maxRows, double* inputs, double* outputs)
+{
+    const char* line;
+    const char* end;
+    int rows = 0;
+    while (rows < maxRows && NextLine(line, end))
+    {
+        ParseLine(line, end, rowValues.data(), numInputs + numOutputs);
+        std::copy(rowValues.begin(), rowValues.begin() + numInputs, inputs + static_cast<size_t>(rows) * numInputs);
+        std::copy(rowValues.begin() + numInputs, rowValues.end(), outputs + static_cast<size_t>(rows) * numOutputs);
+        rows++;
+    }
+    return rows;
+}
+
+bool CsvDataSource::NextLine(const char*& line, const char*& end)
+{
+    while (true)
+    {
+        // Look for a complete line in the data already buffered
+        char* start = buffer.data() + bufferStart;
+        char* newline = static_cast<char*>(std::memchr(start, '\n', bufferEnd - bufferStart));
+        if (newline || (endOfFile && bufferStart < bufferEnd))
+        {
+            char* lineEnd = newline ? newline : buffer.data() + bufferEnd;
+            bufferStart = newline ? (newline - buffer.data()) + 1 : bufferEnd;
+            lineNumber++;
+
+            if (lineEnd > start && lineEnd[-1] == '\r')
+            {
+                lineEnd--;
+            }
+            const char* first = start;
+            while (first < lineEnd && IsSpace(*first)) { first++; }
+            if (first == lineEnd)
+            {
+                continue;
+            }
+
+            line = start;
+            end = lineEnd;
+            return true;
+        }
+        if (endOfFile)
+        {
+            return false;
+        }
+
+        // Move the partial line to the front of the buffer, growing it if the line fills the whole buffer, and read more
+        const size_t remaining = bufferEnd - bufferStart;
+        std::memmove(buffer.data(), buffer.data() + bufferStart, remaining);
+        if (remaining == buffer.size())
+        {
+            buffer.resize(buffer.size() * 2);
+        }
+        bufferStart = 0;
+        bufferEnd = remaining + std::fread(buffer.data() + remaining, 1, buffer.size() - remaining, file);
+        if (bufferEnd < buffer.size())
+        {
+            endOfFile = true;
+        }
+    }
+}
+
+int CsvDataSource::ParseLine(const char* line, const char* end, double* values, int count)
+{
+    int column = 0;
+    const char* position = line;
+    while (true)
+    {
+        while (position < end && IsSpace(*position)) { position++; }
+
+        double value;
+        std::from_chars_result result = std::from_chars(position, end, value);
+        if (result.ec != std::errc())
+        {
+            throw(std::runtime_error(path + " line " + std::to_string(lineNumber) + " column " + std::to_string(column + 1) + " is not a number"));
+        }
+        if (count >= 0)
+        {
+            if (column >= count)
+            {
+                throw(std::runtime_error(path + " line " + std::to_string(lineNumber) + " has too many columns"));
+            }
+            values[column] = value;
+        }
+        column++;
+
+        position = result.ptr;
+        while (position < end && IsSpace(*position)) { position++; }
+        if (position == end)
+        {
+            break;
+        }
+        if (*position != delimiter)
+        {
+            throw(std::runtime_error(path + " line " + std::to_string(lineNumber) + " has an unexpected character"));
+        }
+        position++;
+    }
+
+    if (count >= 0 && column != count)
+    {
+        throw(std::runtime_error(path + " line " + std::to_string(lineNumber) + " has too few columns"));
+    }
+    return column;
+}
+
+BinaryDataSource::BinaryDataSource(const std::string& path)
+                                   :
+                                   path(path),
+                                   file(nullptr),
+                                   rowsRead(0),
+                                   groupRows(0),
+                                   groupPosition(0)
+{
+    file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        throw(std::runtime_error("Unable to open " + path));
+    }
+
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+    {
+        std::fclose(file);
+        throw(std::runtime_error(path + " is not a binary dataset file"));
+    }
+    if (header.version != Version || !header.numInputs || !header.numOutputs || !header.rowsPerGroup)
+    {
+        std::fclose(file);
+        throw(std::runtime_error(path + " has an unsupported version or an invalid header"));
+    }
+
+    group.resize(static_cast<size_t>(header.rowsPerGroup) * (header.numInputs + header.numOutputs));
+}
+
+BinaryDataSource::~BinaryDataSource()
+{
+    if (file)
+    {
+        std::fclose(file);
+    }
+}
+
+int BinaryDataSource::GetNumInputs() const
+{
+    return header.numInputs;
+}
+
+int BinaryDataSource::GetNumOutputs() const
+{
+    return header.numOutputs;
+}
+
+long BinaryDataSource::GetNumRows() const
+{
+    return header.numRows;
+}
+
+void BinaryDataSource::Reset()
+{
+    std::fseek(file, sizeof(header), SEEK_SET);
+    rowsRead = 0;
+    groupRows = 0;
+    groupPosition = 0;
+}
+
+int BinaryDataSource::ReadBatch(int maxRows, double* inputs, double* outputs)
+{
+    const int numInputs = header.numInputs;
+    const int numOutputs = header.numOutputs;
+    int rows = 0;
+    while (rows < maxRows)
+    {
+        if (groupPosition == groupRows && !ReadGroup())
+        {
+            break;
+        }
+
+        // Gather the columns of the group back into rows
+        const int count = std::min(maxRows - rows, groupRows - groupPosition);
+        for (int c = 0 ; c < numInputs ; c++)
+        {
+            const double* column = group.data() + static_cast<size_t>(c) * groupRows + groupPosition;
+            for (int r = 0 ; r < count ; r++)
+            {
+                inputs[static_cast<size_t>(rows + r) * numInputs + c] = column[r];
+            }
+        }
+        for (int c = 0 ; c < numOutputs ; c++)
+        {
+            const double* column = group.data() + static_cast<size_t>(numInputs + c) * groupRows + groupPosition;
+            for (int r = 0 ; r < count ; r++)
+            {
+                outputs[static_cast<size_t>(rows + r) * numOutputs + c] = column[r];
+            }
+        }
+
+        groupPosition += count;
+        rows += count;
+    }
+    return rows;
+}
+
+bool BinaryDataSource::ReadGroup()
+{
+    const long remaining = static_cast<long>(header.numRows) - rowsRead;
+    if (remaining <= 0)
+    {
+        return false;
+    }
+
+    groupRows = std::min<long>(header.rowsPerGroup, remaining);
+    groupPosition = 0;
+    const size_t values = static_cast<size_t>(groupRows) * (header.numInputs + header.numOutputs);
+    if (std::fread(group.data(), sizeof(double), values, file) != values)
+    {
+        throw(std::runtime_error(path + " is truncated"));
+    }
+    rowsRead += groupRows;
+    return true;
+}
+
+BinaryDataWriter::BinaryDataWriter(const std::string& path, int numInputs, int numOutputs, int rowsPerGroup)
+                                   :
+                                   file(nullptr),
+                                   groupRows(0)
+{
+    if (numInputs < 1 || numOutputs < 1 || rowsPerGroup < 1)
+    {
+        throw(std::invalid_argument("Binary datasets need at least one input, one output and one row per group"));
+    }
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        throw(std::runtime_error("Unable to open " + path + " for writing"));
+    }
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BinaryDataSource::Magic, sizeof(header.magic));
+    header.version = BinaryDataSource::Version;
+    header.numInputs = numInputs;
+    header.numOutputs = numOutputs;
+    header.rowsPerGroup = rowsPerGroup;
+    group.resize(static_cast<size_t>(rowsPerGroup) * (numInputs + numOutputs));
+
+    // The header is rewritten with the final row count when the file is closed
+    std::fwrite(&header, sizeof(header), 1, file);
+}
+
+BinaryDataWriter::~BinaryDataWriter()
+{
+    try
+    {
+        Close();
+    }
+    catch (...)
+    {
+    }
+}
+
+void BinaryDataWriter::WriteRow(const double* inputs, const double* outputs)
+{
+    if (!file)
+    {
+        throw(std::logic_error("Binary dataset writer is closed"));
+    }
+
+    // Rows are scattered into column-major order within the group
+    const size_t stride = header.rowsPerGroup;
+    for (uint32_t c = 0 ; c < header.numInputs ; c++)
+    {
+        group[c * stride + groupRows] = inputs[c];
+    }
+    for (uint32_t c = 0 ; c < header.numOutputs ; c++)
+    {
+        group[(header.numInputs + c) * stride + groupRows] = outputs[c];
+    }
+
+    header.numRows++;
+    if (++groupRows == static_cast<int>(header.rowsPerGroup))
+    {
+        FlushGroup();
+    }
+}
+
+void BinaryDataWriter::Close()
+{
+    if (!file)
+    {
+        return;
+    }
+
+    FlushGroup();
+    std::fseek(file, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, file);
+    const bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    file = nullptr;
+    if (failed)
+    {
+        throw(std::runtime_error("Unable to write binary dataset"));
+    }
+}
+
+void BinaryDataWriter::Convert(DataSource& source, const std::string& path, int batchRows)
+{
+    const int numInputs = source.GetNumInputs();
+    const int numOutputs = source.GetNumOutputs();
+    std::vector<double> inputs(static_cast<size_t>(batchRows) * numInputs);
+    std::vector<double> outputs(static_cast<size_t>(batchRows) * numOutputs);
+    BinaryDataWriter writer(path, numInputs, numOutputs);
+
+    source.Reset();
+    int rows;
+    while ((rows = source.ReadBatch(batchRows, inputs.data(), outputs.data())) > 0)
+    {
+        for (int r = 0 ; r < rows ; r++)
+        {
+            writer.WriteRow(inputs.data() + static_cast<size_t>(r) * numInputs, outputs.data() + static_cast<size_t>(r) * numOutputs);
+        }
+    }
+    writer.Close();
+}
+
+void BinaryDataWriter::FlushGroup()
+{
+    if (!groupRows)
+    {
+        return;
+    }
+
+    // A partial last group is compacted so that its columns are stored back to back
+    const size_t stride = header.rowsPerGroup;
+    const uint32_t columns = header.numInputs + header.numOutputs;
+    for (uint32_t c = 0 ; c < columns ; c++)
+    {
+        std::fwrite(group.data() + c * stride, sizeof(double), groupRows, file);
+    }
+    groupRows = 0;
+}
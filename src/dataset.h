@@ -0,0 +1,234 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <stdexcept>
+
+class DataSource
+{
+    public:
+        /// @class Interface for anything that can feed rows of training data to a neural network. Rows are streamed in order
+        ///        in batches, so a source only needs to hold the rows of the batch currently being read.
+        virtual ~DataSource() = default;
+
+        /// @brief  Get the number of input values in each row
+        /// @return The number of inputs
+        virtual int GetNumInputs() const = 0;
+
+        /// @brief  Get the number of output values in each row
+        /// @return The number of outputs
+        virtual int GetNumOutputs() const = 0;
+
+        /// @brief  Get the total number of rows, if it is known without reading the whole source
+        /// @return The number of rows, or -1 if it is unknown
+        virtual long GetNumRows() const { return -1; }
+
+        /// @brief  Checks if rows can be read in any order with ReadRows(), which allows a full shuffle of every epoch
+        /// @return Boolean value representing if the source supports random access
+        virtual bool SupportsRandomAccess() const { return false; }
+
+        /// @brief            Reads a set of rows by index, only available when SupportsRandomAccess() is true
+        /// @param rowIndices Pointer to the indices of the rows to read
+        /// @param count      The number of rows to read
+        /// @param inputs     Pointer to a row-major count x GetNumInputs() matrix that the inputs are written to
+        /// @param outputs    Pointer to a row-major count x GetNumOutputs() matrix that the outputs are written to
+        virtual void ReadRows([[maybe_unused]] const long* rowIndices, [[maybe_unused]] int count, [[maybe_unused]] double* inputs,
+                              [[maybe_unused]] double* outputs)
+        {
+            throw(std::logic_error("This data source does not support random access"));
+        }
+
+        /// @brief Rewinds the source so that the next batch starts from the first row
+        virtual void Reset() = 0;
+
+        /// @brief       Skips the order of a number of epochs, for sources that visit their rows in a different order every
+        ///              epoch, so that a resumed run reads the same rows as the run it continues. Takes effect from the
+        ///              next call to Reset(). Does nothing by default.
+        /// @param epoch The number of epochs already trained on
+        virtual void SetEpoch([[maybe_unused]] long epoch) {}
+
+        /// @brief         Reads the next batch of rows
+        /// @param maxRows The maximum number of rows to read
+        /// @param inputs  Pointer to a row-major maxRows x GetNumInputs() matrix that the inputs are written to
+        /// @param outputs Pointer to a row-major maxRows x GetNumOutputs() matrix that the outputs are written to
+        /// @return        The number of rows read, which is zero once every row has been read
+        virtual int ReadBatch(int maxRows, double* inputs, double* outputs) = 0;
+};
+
+class InMemoryDataSource : public DataSource
+{
+    public:
+        /// @class       Data source holding a whole dataset in memory as two contiguous row-major matrices
+        /// @param xData Vector containing vectors with all of the input data, each of the same length
+        /// @param yData Vector containing vectors with all of the output data, with one row per input row
+        InMemoryDataSource(const std::vector<std::vector<double>>& xData, const std::vector<std::vector<double>>& yData);
+
+        int GetNumInputs() const override;
+        int GetNumOutputs() const override;
+        long GetNumRows() const override;
+        bool SupportsRandomAccess() const override;
+        void ReadRows(const long* rowIndices, int count, double* inputs, double* outputs) override;
+        void Reset() override;
+        int ReadBatch(int maxRows, double* inputs, double* outputs) override;
+
+        /// @brief     Returns a pointer to the inputs of one row, which are followed by the inputs of the rows after it
+        /// @param row Index of the row
+        /// @return    Pointer to the first input of the row
+        const double* GetInputs(long row) const;
+
+        /// @brief     Returns a pointer to the outputs of one row, which are followed by the outputs of the rows after it
+        /// @param row Index of the row
+        /// @return    Pointer to the first output of the row
+        const double* GetOutputs(long row) const;
+
+    private:
+        int numInputs;
+        int numOutputs;
+        long numRows;
+        long nextRow;
+        std::vector<double> inputValues;
+        std::vector<double> outputValues;
+};
+
+class CsvDataSource : public DataSource
+{
+    public:
+        /// @class            Streams rows from a CSV file (for example one exported from a spreadsheet) in fixed-size chunks, so
+        ///                   that files much larger than memory can be trained on. Every row must have the same number of
+        ///                   numeric columns, with the outputs in the last columns.
+        /// @param path       Path of the CSV file
+        /// @param numOutputs The number of columns at the end of each row that hold output values
+        /// @param hasHeader  Whether the first line holds column names and should be skipped
+        /// @param delimiter  Character separating the columns
+        CsvDataSource(const std::string& path, int numOutputs, bool hasHeader = false, char delimiter = ',');
+        ~CsvDataSource() override;
+
+        CsvDataSource(const CsvDataSource&) = delete;
+        CsvDataSource& operator=(const CsvDataSource&) = delete;
+
+        int GetNumInputs() const override;
+        int GetNumOutputs() const override;
+        void Reset() override;
+        int ReadBatch(int maxRows, double* inputs, double* outputs) override;
+
+    private:
+        /// @brief  Returns the next non-empty line in the file, refilling the chunk buffer as needed
+        /// @param  line  Set to the first character of the line
+        /// @param  end   Set to one past the last character of the line, excluding the line ending
+        /// @return False once the end of the file has been reached
+        bool NextLine(const char*& line, const char*& end);
+
+        /// @brief         Parses the numeric columns of one line
+        /// @param line    First character of the line
+        /// @param end     One past the last character of the line
+        /// @param values  Pointer to where the values are written, in column order
+        /// @param count   The number of values that should be parsed, or -1 to count the columns instead
+        /// @return        The number of values in the line
+        int ParseLine(const char* line, const char* end, double* values, int count);
+
+        std::string path;
+        std::FILE* file;
+        bool hasHeader;
+        char delimiter;
+        int numInputs;
+        int numOutputs;
+        long lineNumber;
+        std::vector<char> buffer;
+        size_t bufferStart;
+        size_t bufferEnd;
+        bool endOfFile;
+        std::vector<double> rowValues;
+};
+
+class BinaryDataSource : public DataSource
+{
+    public:
+        /// @class      Streams rows from the compact binary columnar format written by BinaryDataWriter. Rows are stored in
+        ///             groups, and within a group each column is stored contiguously, so a whole group is read with a single
+        ///             read call and only one group is held in memory at a time.
+        /// @param path Path of the binary dataset file
+        BinaryDataSource(const std::string& path);
+        ~BinaryDataSource() override;
+
+        BinaryDataSource(const BinaryDataSource&) = delete;
+        BinaryDataSource& operator=(const BinaryDataSource&) = delete;
+
+        int GetNumInputs() const override;
+        int GetNumOutputs() const override;
+        long GetNumRows() const override;
+        void Reset() override;
+        int ReadBatch(int maxRows, double* inputs, double* outputs) override;
+
+        /// @brief Binary dataset file header, followed by the row groups
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t numInputs;
+            uint32_t numOutputs;
+            uint32_t rowsPerGroup;
+            uint64_t numRows;
+        };
+
+        static constexpr char Magic[8] = {'N', 'N', 'D', 'A', 'T', 'A', '\0', '\0'};
+        static constexpr uint32_t Version = 1;
+
+    private:
+        /// @brief  Reads the next row group into the group buffer
+        /// @return False once every group has been read
+        bool ReadGroup();
+
+        std::string path;
+        std::FILE* file;
+        Header header;
+        long rowsRead;
+        std::vector<double> group;
+        int groupRows;
+        int groupPosition;
+};
+
+class BinaryDataWriter
+{
+    public:
+        /// @class              Writes rows to a file in the binary columnar format read by BinaryDataSource, buffering one
+        ///                     row group at a time
+        /// @param path         Path of the file to write
+        /// @param numInputs    The number of input values in each row
+        /// @param numOutputs   The number of output values in each row
+        /// @param rowsPerGroup The number of rows stored in each group
+        BinaryDataWriter(const std::string& path, int numInputs, int numOutputs, int rowsPerGroup = 4096);
+
+        /// @brief Flushes the last group and closes the file, see Close()
+        ~BinaryDataWriter();
+
+        BinaryDataWriter(const BinaryDataWriter&) = delete;
+        BinaryDataWriter& operator=(const BinaryDataWriter&) = delete;
+
+        /// @brief         Appends one row to the file
+        /// @param inputs  Pointer to the input values of the row
+        /// @param outputs Pointer to the output values of the row
+        void WriteRow(const double* inputs, const double* outputs);
+
+        /// @brief Flushes the last group, writes the final row count to the header and closes the file
+        void Close();
+
+        /// @brief           Converts every row of a data source to a binary dataset file
+        /// @param source    The data source to read from, which is read from its first row
+        /// @param path      Path of the file to write
+        /// @param batchRows The number of rows read from the source at a time
+        static void Convert(DataSource& source, const std::string& path, int batchRows = 4096);
+
+    private:
+        /// @brief Writes the buffered rows as one group
+        void FlushGroup();
+
+        std::FILE* file;
+        BinaryDataSource::Header header;
+        std::vector<double> group;
+        int groupRows;
+};
+
+#endif // DATASET_H
@@ -0,0 +1,695 @@
+#include "inference_server.h"
+
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#define NN_HAS_SOCKETS 1
+#endif
+
+namespace
+{
+    /// @brief Index of the highest set bit of a non-zero value
+    int HighestBit(uint64_t value)
+    {
+        int bit = 0;
+        while (value >>= 1)
+        {
+            bit++;
+        }
+        return bit;
+    }
+
+#ifdef NN_HAS_SOCKETS
+#ifdef MSG_NOSIGNAL
+    constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int SendFlags = 0;
+#endif
+
+    /// @brief  Reads exactly the given number of bytes, retrying after signals and partial reads
+    /// @return Whether every byte was read, false if the connection was closed or failed first
+    bool ReadFully(int descriptor, void* data, size_t bytes)
+    {
+        char* position = static_cast<char*>(data);
+        while (bytes > 0)
+        {
+            const ssize_t received = recv(descriptor, position, bytes, 0);
+            if (received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (received <= 0)
+            {
+                return false;
+            }
+            position += received;
+            bytes -= received;
+        }
+        return true;
+    }
+
+    /// @brief  Writes a header and a payload with as few system calls as possible, so that a small response leaves in one
+    ///         packet even with Nagle's algorithm disabled. Never raises SIGPIPE where the platform allows it.
+    /// @return Whether every byte was written
+    bool WriteFully(int descriptor, const void* header, size_t headerBytes, const void* payload, size_t payloadBytes)
+    {
+        iovec vectors[2] = {{const_cast<void*>(header), headerBytes}, {const_cast<void*>(payload), payloadBytes}};
+        iovec* next = vectors;
+        int count = payloadBytes ? 2 : 1;
+        while (count > 0)
+        {
+            msghdr message = {};
+            message.msg_iov = next;
+            message.msg_iovlen = count;
+            ssize_t sent = sendmsg(descriptor, &message, SendFlags);
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (sent <= 0)
+            {
+                return false;
+            }
+            while (count > 0 && static_cast<size_t>(sent) >= next->iov_len)
+            {
+                sent -= next->iov_len;
+                next++;
+                count--;
+            }
+            if (count > 0)
+            {
+                next->iov_base = static_cast<char*>(next->iov_base) + sent;
+                next->iov_len -= sent;
+            }
+        }
+        return true;
+    }
+
+    /// @brief Fills in the address of an endpoint, a Unix domain socket or a port on 127.0.0.1
+    socklen_t MakeAddress(const InferenceProtocol::Endpoint& endpoint, sockaddr_storage& storage)
+    {
+        std::memset(&storage, 0, sizeof(storage));
+        if (!endpoint.socketPath.empty())
+        {
+            sockaddr_un& address = reinterpret_cast<sockaddr_un&>(storage);
+            if (endpoint.socketPath.size() >= sizeof(address.sun_path))
+            {
+                throw(std::invalid_argument("Socket path is too long: " + endpoint.socketPath));
+            }
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, endpoint.socketPath.c_str(), endpoint.socketPath.size() + 1);
+            return sizeof(sockaddr_un);
+        }
+
+        if (endpoint.port < 0 || endpoint.port > 65535)
+        {
+            throw(std::invalid_argument("Port must be in [0, 65535]"));
+        }
+        sockaddr_in& address = reinterpret_cast<sockaddr_in&>(storage);
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(endpoint.port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return sizeof(sockaddr_in);
+    }
+
+    /// @brief Disables Nagle's algorithm on TCP sockets, which would otherwise hold small responses back
+    void SetNoDelay(int descriptor, const InferenceProtocol::Endpoint& endpoint)
+    {
+        if (endpoint.socketPath.empty())
+        {
+            const int enable = 1;
+            setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+    }
+#endif
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    Clear();
+}
+
+void LatencyHistogram::Record(uint64_t nanoseconds)
+{
+    buckets[GetBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    uint64_t longest = max.load(std::memory_order_relaxed);
+    while (nanoseconds > longest && !max.compare_exchange_weak(longest, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t LatencyHistogram::GetCount() const
+{
+    return count.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetPercentile(double fraction) const
+{
+    const uint64_t total = GetCount();
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    // The value of the bucket holding the rank'th smallest duration, never beyond the longest duration recorded
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::min(1.0, std::max(0.0, fraction)) * total)));
+    uint64_t seen = 0;
+    for (int b = 0 ; b < NumBuckets ; b++)
+    {
+        seen += buckets[b].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+            return std::min(GetBucketValue(b), GetMax());
+        }
+    }
+    return GetMax();
+}
+
+uint64_t LatencyHistogram::GetMax() const
+{
+    return max.load(std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Clear()
+{
+    for (std::atomic<uint64_t>& bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::GetBucket(uint64_t value)
+{
+    // Values below 2^SubBucketBits have a bucket each, larger ones keep their top SubBucketBits bits
+    constexpr int Half = 1 << (SubBucketBits - 1);
+    if (value < (uint64_t(1) << SubBucketBits))
+    {
+        return static_cast<int>(value);
+    }
+    const int shift = HighestBit(value) - (SubBucketBits - 1);
+    return Half * shift + static_cast<int>(value >> shift);
+}
+
+uint64_t LatencyHistogram::GetBucketValue(int bucket)
+{
+    constexpr int Half = 1 << (SubBucketBits - 1);
+    if (bucket < (1 << SubBucketBits))
+    {
+        return bucket;
+    }
+    const int shift = bucket / Half - 1;
+    const uint64_t lowest = static_cast<uint64_t>(bucket - Half * shift) << shift;
+    return lowest + ((uint64_t(1) << shift) >> 1);
+}
+
+InferenceServer::InferenceServer(NeuralNetwork inputNetwork, const Options& inputOptions)
+                                 :
+                                 network(std::move(inputNetwork)),
+                                 options(inputOptions),
+                                 listener(-1),
+                                 stopping(false),
+                                 running(false),
+                                 queuedRows(0)
+{
+    if (network.GetNumLayers() < 2)
+    {
+        throw(std::invalid_argument("The network to serve must be initialized"));
+    }
+    if (options.maxBatchRows < 1 || options.numWorkers < 1 || options.maxRequestRows < 1 || options.maxWaitMicroseconds < 0)
+    {
+        throw(std::invalid_argument("The batch size, worker count and request size must be positive and the wait not negative"));
+    }
+    numInputs = network.GetLayer(0).GetNumNeurons();
+    numOutputs = network.GetLayer(network.GetNumLayers() - 1).GetNumNeurons();
+    ClearReport();
+}
+
+InferenceServer::~InferenceServer()
+{
+    Stop();
+}
+
+void InferenceServer::Start()
+{
+#ifdef NN_HAS_SOCKETS
+    if (running)
+    {
+        throw(std::logic_error("Server is already running"));
+    }
+
+    sockaddr_storage address;
+    const socklen_t length = MakeAddress(options.endpoint, address);
+    listener = socket(address.ss_family, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        throw(std::runtime_error(std::string("Unable to create a socket: ") + std::strerror(errno)));
+    }
+    if (!options.endpoint.socketPath.empty())
+    {
+        // A socket file left behind by a server that did not stop cleanly would make bind fail
+        unlink(options.endpoint.socketPath.c_str());
+    }
+    else
+    {
+        const int enable = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    }
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), length) != 0 || listen(listener, SOMAXCONN) != 0)
+    {
+        const std::string error = std::strerror(errno);
+        close(listener);
+        listener = -1;
+        throw(std::runtime_error("Unable to listen on " + (options.endpoint.socketPath.empty() ? "port " + std::to_string(options.endpoint.port)
+                                                                                                 : options.endpoint.socketPath) + ": " + error));
+    }
+    if (options.endpoint.socketPath.empty())
+    {
+        socklen_t boundLength = sizeof(address);
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &boundLength);
+        options.endpoint.port = ntohs(reinterpret_cast<sockaddr_in&>(address).sin_port);
+    }
+
+    stopping = false;
+    running = true;
+    acceptor = std::thread(&InferenceServer::AcceptLoop, this);
+    for (int w = 0 ; w < options.numWorkers ; w++)
+    {
+        workers.emplace_back(&InferenceServer::WorkLoop, this);
+    }
+#else
+    throw(std::runtime_error("The inference server is not supported on this platform"));
+#endif
+}
+
+void InferenceServer::Stop()
+{
+#ifdef NN_HAS_SOCKETS
+    if (!running)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueChanged.notify_all();
+    acceptor.join();
+
+    // Shutting the connections down wakes their readers, while the descriptors stay open until the last queued request
+    // that refers to them is gone
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        for (const std::shared_ptr<Connection>& connection : connections)
+        {
+            shutdown(connection->descriptor, SHUT_RDWR);
+        }
+    }
+    for (const std::shared_ptr<Connection>& connection : connections)
+    {
+        connection->reader.join();
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+    connections.clear();
+    queue.clear();
+    queuedRows = 0;
+
+    close(listener);
+    listener = -1;
+    if (!options.endpoint.socketPath.empty())
+    {
+        unlink(options.endpoint.socketPath.c_str());
+    }
+    running = false;
+#endif
+}
+
+InferenceProtocol::Endpoint InferenceServer::GetEndpoint() const
+{
+    return this->options.endpoint;
+}
+
+InferenceServer::Report InferenceServer::GetReport() const
+{
+    Report report;
+    report.requests = requests;
+    report.rows = rows;
+    report.batches = batches;
+    report.rejected = rejected;
+    report.meanBatchRows = report.batches ? static_cast<double>(report.rows) / report.batches : 0;
+    report.p50 = latency.GetPercentile(0.5) / 1e3;
+    report.p90 = latency.GetPercentile(0.9) / 1e3;
+    report.p99 = latency.GetPercentile(0.99) / 1e3;
+    report.p999 = latency.GetPercentile(0.999) / 1e3;
+    report.max = latency.GetMax() / 1e3;
+    for (size_t b = 0 ; b < batchRows.size() ; b++)
+    {
+        if (batchRows[b])
+        {
+            report.batchRows.resize(b + 1, 0);
+            report.batchRows[b] = batchRows[b];
+        }
+    }
+    return report;
+}
+
+void InferenceServer::ClearReport()
+{
+    latency.Clear();
+    requests = 0;
+    rows = 0;
+    batches = 0;
+    rejected = 0;
+    for (std::atomic<long>& count : batchRows)
+    {
+        count = 0;
+    }
+}
+
+void InferenceServer::WriteReport(const Report& report, std::ostream& output)
+{
+    const std::ios_base::fmtflags flags = output.flags();
+    output << "requests " << report.requests << " (" << report.rejected << " rejected)\trows " << report.rows << "\tbatches "
+           << report.batches << "\tmean batch " << std::fixed << std::setprecision(1) << report.meanBatchRows << " rows" << std::endl;
+    output << "latency (us)\tp50 " << report.p50 << "\tp90 " << report.p90 << "\tp99 " << report.p99 << "\tp99.9 "
+           << report.p999 << "\tmax " << report.max << std::endl;
+    output << "batch rows";
+    for (size_t b = 0 ; b < report.batchRows.size() ; b++)
+    {
+        const long lowest = 1L << b, highest = (2L << b) - 1;
+        output << "\t" << lowest;
+        if (highest > lowest)
+        {
+            output << "-" << highest;
+        }
+        output << ": " << report.batchRows[b] << " (" << (report.batches ? 100.0 * report.batchRows[b] / report.batches : 0) << "%)";
+    }
+    output << std::endl;
+    output.flags(flags);
+}
+
+void InferenceServer::AcceptLoop()
+{
+#ifdef NN_HAS_SOCKETS
+    // Wake up regularly to notice Stop(), since closing a listening socket does not interrupt accept everywhere
+    pollfd listening = {listener, POLLIN, 0};
+    while (!stopping)
+    {
+        if (poll(&listening, 1, 100) <= 0)
+        {
+            continue;
+        }
+        const int descriptor = accept(listener, nullptr, nullptr);
+        if (descriptor < 0)
+        {
+            continue;
+        }
+        SetNoDelay(descriptor, options.endpoint);
+
+        InferenceProtocol::Hello hello = {};
+        std::memcpy(hello.magic, InferenceProtocol::HelloMagic, sizeof(hello.magic));
+        hello.version = InferenceProtocol::Version;
+        hello.numInputs = numInputs;
+        hello.numOutputs = numOutputs;
+        hello.maxRequestRows = options.maxRequestRows;
+
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>();
+        connection->descriptor = descriptor;
+        if (!WriteFully(descriptor, &hello, sizeof(hello), nullptr, 0))
+        {
+            continue;
+        }
+
+        // Connections whose clients have gone are forgotten here, so that a long running server does not collect them
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        for (auto c = connections.begin() ; c != connections.end() ; )
+        {
+            if ((*c)->finished)
+            {
+                (*c)->reader.join();
+                c = connections.erase(c);
+            }
+            else
+            {
+                ++c;
+            }
+        }
+        connection->reader = std::thread(&InferenceServer::ReadLoop, this, connection);
+        connections.push_back(connection);
+    }
+#endif
+}
+
+void InferenceServer::ReadLoop(std::shared_ptr<Connection> connection)
+{
+#ifdef NN_HAS_SOCKETS
+    InferenceProtocol::RequestHeader header;
+    while (!stopping && ReadFully(connection->descriptor, &header, sizeof(header)))
+    {
+        if (header.magic != InferenceProtocol::RequestMagic || header.rows > static_cast<uint32_t>(options.maxRequestRows))
+        {
+            // The rest of the stream cannot be trusted, so the connection is closed after the error
+            rejected++;
+            Respond(*connection, InferenceProtocol::BadRequest, header.id, Span<const double>());
+            break;
+        }
+        if (header.rows == 0)
+        {
+            rejected++;
+            Respond(*connection, InferenceProtocol::BadRequest, header.id, Span<const double>());
+            continue;
+        }
+
+        Request request;
+        request.connection = connection;
+        request.id = header.id;
+        request.rows = header.rows;
+        request.inputs.resize(static_cast<size_t>(header.rows) * numInputs);
+        if (!ReadFully(connection->descriptor, request.inputs.data(), request.inputs.size() * sizeof(double)))
+        {
+            break;
+        }
+        request.received = Clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queuedRows += request.rows;
+            queue.push_back(std::move(request));
+        }
+        queueChanged.notify_all();
+    }
+
+    // Let the client see the connection close, even though the descriptor stays open until the reader is reaped
+    shutdown(connection->descriptor, SHUT_RDWR);
+    connection->finished = true;
+#endif
+}
+
+void InferenceServer::WorkLoop()
+{
+    const std::chrono::microseconds maxWait(options.maxWaitMicroseconds);
+    std::vector<Request> batch;
+    std::vector<double> inputs, outputs;
+    while (true)
+    {
+        int batchRowCount = 0;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueChanged.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+
+            // Hold the oldest request back until enough rows have arrived to fill a batch or it has waited long enough.
+            // Another worker may take the queue in the meantime, in which case this one goes back to waiting.
+            const Clock::time_point deadline = queue.front().received + maxWait;
+            queueChanged.wait_until(lock, deadline, [this]() { return stopping || queue.empty() || queuedRows >= options.maxBatchRows; });
+            if (stopping)
+            {
+                return;
+            }
+
+            // Requests are taken in order, and a request never waits behind one that arrived after it
+            while (!queue.empty() && (batch.empty() || batchRowCount + queue.front().rows <= options.maxBatchRows))
+            {
+                batchRowCount += queue.front().rows;
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+            queuedRows -= batchRowCount;
+        }
+        if (batch.empty())
+        {
+            continue;
+        }
+        queueChanged.notify_all();
+
+        inputs.resize(static_cast<size_t>(batchRowCount) * numInputs);
+        outputs.resize(static_cast<size_t>(batchRowCount) * numOutputs);
+        size_t offset = 0;
+        for (const Request& request : batch)
+        {
+            std::copy(request.inputs.begin(), request.inputs.end(), inputs.begin() + offset);
+            offset += request.inputs.size();
+        }
+
+        InferenceProtocol::Status status = InferenceProtocol::Ok;
+        try
+        {
+            network.PredictBatch(inputs, outputs);
+        }
+        catch (const std::exception&)
+        {
+            status = InferenceProtocol::ServerError;
+        }
+
+        offset = 0;
+        for (const Request& request : batch)
+        {
+            const size_t count = static_cast<size_t>(request.rows) * numOutputs;
+            Respond(*request.connection, status, request.id, Span<const double>(outputs.data() + offset, count));
+            offset += count;
+            latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - request.received).count());
+        }
+
+        requests += batch.size();
+        rows += batchRowCount;
+        batches++;
+        batchRows[HighestBit(batchRowCount)]++;
+        if (status != InferenceProtocol::Ok)
+        {
+            rejected += batch.size();
+        }
+        batch.clear();
+    }
+}
+
+bool InferenceServer::Respond(Connection& connection, InferenceProtocol::Status status, uint64_t id, Span<const double> outputs)
+{
+#ifdef NN_HAS_SOCKETS
+    InferenceProtocol::ResponseHeader header = {InferenceProtocol::ResponseMagic, status, id};
+    const size_t payloadBytes = (status == InferenceProtocol::Ok) ? outputs.size() * sizeof(double) : 0;
+    std::lock_guard<std::mutex> lock(connection.writeMutex);
+    return WriteFully(connection.descriptor, &header, sizeof(header), outputs.data(), payloadBytes);
+#else
+    return false;
+#endif
+}
+
+InferenceServer::Connection::~Connection()
+{
+#ifdef NN_HAS_SOCKETS
+    if (descriptor >= 0)
+    {
+        close(descriptor);
+    }
+#endif
+}
+
+InferenceClient::InferenceClient(const InferenceProtocol::Endpoint& endpoint)
+                                 :
+                                 descriptor(-1),
+                                 hello(),
+                                 nextId(1)
+{
+#ifdef NN_HAS_SOCKETS
+    sockaddr_storage address;
+    const socklen_t length = MakeAddress(endpoint, address);
+    descriptor = socket(address.ss_family, SOCK_STREAM, 0);
+    if (descriptor < 0 || connect(descriptor, reinterpret_cast<sockaddr*>(&address), length) != 0)
+    {
+        const std::string error = std::strerror(errno);
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+        throw(std::runtime_error("Unable to connect to the inference server: " + error));
+    }
+    SetNoDelay(descriptor, endpoint);
+
+    if (!ReadFully(descriptor, &hello, sizeof(hello)) || std::memcmp(hello.magic, InferenceProtocol::HelloMagic, sizeof(hello.magic)) != 0
+     || hello.version != InferenceProtocol::Version)
+    {
+        close(descriptor);
+        throw(std::runtime_error("The server did not identify itself as a compatible inference server"));
+    }
+#else
+    throw(std::runtime_error("The inference client is not supported on this platform"));
+#endif
+}
+
+InferenceClient::~InferenceClient()
+{
+#ifdef NN_HAS_SOCKETS
+    if (descriptor >= 0)
+    {
+        close(descriptor);
+    }
+#endif
+}
+
+void InferenceClient::Predict(Span<const double> inputs, Span<double> outputs)
+{
+#ifdef NN_HAS_SOCKETS
+    const size_t rows = inputs.size() / hello.numInputs;
+    if (inputs.size() % hello.numInputs || rows == 0 || outputs.size() != rows * hello.numOutputs)
+    {
+        throw(std::invalid_argument("Input and output sizes must match the served model for the same number of rows"));
+    }
+    if (rows > hello.maxRequestRows)
+    {
+        throw(std::invalid_argument("The server accepts at most " + std::to_string(hello.maxRequestRows) + " rows per request"));
+    }
+
+    const InferenceProtocol::RequestHeader request = {InferenceProtocol::RequestMagic, static_cast<uint32_t>(rows), nextId++};
+    InferenceProtocol::ResponseHeader response;
+    if (!WriteFully(descriptor, &request, sizeof(request), inputs.data(), inputs.size() * sizeof(double))
+     || !ReadFully(descriptor, &response, sizeof(response)) || response.magic != InferenceProtocol::ResponseMagic || response.id != request.id)
+    {
+        throw(std::runtime_error("Lost the connection to the inference server"));
+    }
+    if (response.status != InferenceProtocol::Ok)
+    {
+        throw(std::runtime_error("The inference server rejected the request with status " + std::to_string(response.status)));
+    }
+    if (!ReadFully(descriptor, outputs.data(), outputs.size() * sizeof(double)))
+    {
+        throw(std::runtime_error("Lost the connection to the inference server"));
+    }
+#endif
+}
+
+int InferenceClient::GetNumInputs() const
+{
+    return this->hello.numInputs;
+}
+
+int InferenceClient::GetNumOutputs() const
+{
+    return this->hello.numOutputs;
+}
+
+int InferenceClient::GetMaxRequestRows() const
+{
+    return this->hello.maxRequestRows;
+}
@@ -0,0 +1,321 @@
+#ifndef INFERENCE_SERVER_H
+#define INFERENCE_SERVER_H
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <condition_variable>
+
+#include "span.h"
+#include "network.h"
+
+namespace InferenceProtocol
+{
+    /// @brief Binary protocol spoken over a Unix domain socket or a loopback TCP connection, all values little-endian as
+    ///        written by the host:
+    ///
+    ///        Hello          sent by the server as soon as a client connects, describing the model it serves
+    ///        RequestHeader  sent by the client, followed by rows * numInputs doubles, one row after another
+    ///        ResponseHeader sent by the server for every request, followed by rows * numOutputs doubles when the status
+    ///                       is Ok. Responses carry the id of their request, and a client that sends several requests
+    ///                       before reading may receive the responses in a different order.
+    ///
+    ///        A request with an unknown magic value, or with more rows than the server accepts, closes the connection
+    ///        after an error response.
+
+    constexpr char HelloMagic[8] = {'N', 'N', 'S', 'E', 'R', 'V', 'E', '\0'};
+    constexpr uint32_t Version = 1;
+    constexpr uint32_t RequestMagic = 0x5251524e;
+    constexpr uint32_t ResponseMagic = 0x5053524e;
+
+    enum Status : uint32_t
+    {
+        Ok = 0,
+        /// The request had no rows, too many rows or an unknown magic value
+        BadRequest = 1,
+        /// The model failed to run, for example because the server is shutting down
+        ServerError = 2
+    };
+
+    struct Hello
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t numInputs;
+        uint32_t numOutputs;
+        /// Largest number of rows accepted in one request
+        uint32_t maxRequestRows;
+    };
+
+    struct RequestHeader
+    {
+        uint32_t magic;
+        uint32_t rows;
+        uint64_t id;
+    };
+
+    struct ResponseHeader
+    {
+        uint32_t magic;
+        uint32_t status;
+        uint64_t id;
+    };
+
+    static_assert(sizeof(Hello) == 24, "Hello message must be 24 bytes");
+    static_assert(sizeof(RequestHeader) == 16, "Request header must be 16 bytes");
+    static_assert(sizeof(ResponseHeader) == 16, "Response header must be 16 bytes");
+
+    /// @brief Where a server listens, either a Unix domain socket or a TCP port on the loopback interface
+    struct Endpoint
+    {
+        /// Path of the Unix domain socket, used when it is not empty
+        std::string socketPath;
+        /// TCP port on 127.0.0.1, where 0 lets the server pick a free port, see InferenceServer::GetEndpoint()
+        int port = 0;
+    };
+}
+
+class LatencyHistogram
+{
+    public:
+        /// @class Histogram of durations with buckets whose width grows with their value, so that every recorded value is
+        ///        known to within about 3% over the whole range of a 64-bit count of nanoseconds. Recording is a single
+        ///        atomic increment, so any number of threads can record at once without locking or allocating.
+        LatencyHistogram();
+
+        /// @brief             Adds one duration
+        /// @param nanoseconds The duration
+        void Record(uint64_t nanoseconds);
+
+        /// @brief  Get the number of durations recorded
+        /// @return The count
+        uint64_t GetCount() const;
+
+        /// @brief          Returns the duration that a fraction of the recorded durations do not exceed, to within the width
+        ///                 of its bucket
+        /// @param fraction The fraction, for example 0.99 for the 99th percentile
+        /// @return         The duration in nanoseconds, or 0 if nothing was recorded
+        uint64_t GetPercentile(double fraction) const;
+
+        /// @brief  Get the longest duration recorded
+        /// @return The duration in nanoseconds
+        uint64_t GetMax() const;
+
+        /// @brief Forgets every recorded duration
+        void Clear();
+
+    private:
+        /// Values below 2^SubBucketBits each get a bucket, larger ones are split into 2^(SubBucketBits - 1) buckets per power of two
+        static constexpr int SubBucketBits = 6;
+        static constexpr int NumBuckets = (64 - SubBucketBits + 2) << (SubBucketBits - 1);
+
+        /// @brief       Returns the bucket a value is counted in
+        /// @param value The value
+        /// @return      Index of the bucket
+        static int GetBucket(uint64_t value);
+
+        /// @brief        Returns the middle of the values counted in a bucket
+        /// @param bucket Index of the bucket
+        /// @return       The value
+        static uint64_t GetBucketValue(int bucket);
+
+        std::array<std::atomic<uint64_t>, NumBuckets> buckets;
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> max;
+};
+
+class InferenceServer
+{
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /// @brief Listening address and batching policy of a server
+        struct Options
+        {
+            InferenceProtocol::Endpoint endpoint;
+            /// Most rows run through the network together. A request with more rows than this runs in a batch of its own.
+            int maxBatchRows = 64;
+            /// Longest time the oldest waiting request is held back for more requests to join its batch. Zero runs every
+            /// batch as soon as a worker is free, which still batches whatever arrived while the workers were busy. When
+            /// fewer rows than maxBatchRows are usually in flight, every batch waits this long, so keep maxBatchRows to
+            /// about the number of clients.
+            int maxWaitMicroseconds = 200;
+            /// Number of threads running batches
+            int numWorkers = 1;
+            /// Most rows accepted in a single request
+            int maxRequestRows = 4096;
+        };
+
+        /// @brief Everything recorded since the server started or the statistics were last cleared
+        struct Report
+        {
+            long requests = 0;
+            long rows = 0;
+            long batches = 0;
+            /// Requests answered with an error status
+            long rejected = 0;
+            double meanBatchRows = 0;
+            /// Time from a request being read to its response being written, in microseconds
+            double p50 = 0;
+            double p90 = 0;
+            double p99 = 0;
+            double p999 = 0;
+            double max = 0;
+            /// Number of batches of 1, 2-3, 4-7, 8-15, ... rows, up to the largest size seen
+            std::vector<long> batchRows;
+        };
+
+        /// @class          Serves predictions of a trained network over a local socket. Connections are read on their own
+        ///                 threads, which queue every request. Worker threads take requests from the front of the queue and
+        ///                 run them through one batched forward pass, as soon as they add up to maxBatchRows rows or the
+        ///                 oldest of them has waited maxWaitMicroseconds, then write every response back. Call Start() to
+        ///                 begin serving.
+        /// @param network  The network to serve, such as one opened with NeuralNetwork::Load()
+        /// @param options  The listening address and batching policy
+        InferenceServer(NeuralNetwork network, const Options& options);
+
+        /// @brief Stops the server if it is still running
+        ~InferenceServer();
+
+        InferenceServer(const InferenceServer&) = delete;
+        InferenceServer& operator=(const InferenceServer&) = delete;
+
+        /// @brief Binds the socket and starts the threads. Throws if the address is in use or cannot be bound.
+        void Start();
+
+        /// @brief Closes the socket and every connection, and waits for the threads to finish. Requests that are still
+        ///        queued are dropped.
+        void Stop();
+
+        /// @brief  Returns the address the server listens on, with the port it was given when it was started with port 0
+        /// @return The endpoint
+        InferenceProtocol::Endpoint GetEndpoint() const;
+
+        /// @brief  Collects the request, latency and batch size statistics
+        /// @return The report
+        Report GetReport() const;
+
+        /// @brief Forgets the statistics, for example between the warm-up and the measurement of a benchmark
+        void ClearReport();
+
+        /// @brief        Writes a report as a few lines of text
+        /// @param report The report
+        /// @param output The stream to write to
+        static void WriteReport(const Report& report, std::ostream& output);
+
+    private:
+        /// @brief One client, whose responses may be written by any worker
+        struct Connection
+        {
+            /// Closes the socket, once neither its reader nor any queued request refers to it
+            ~Connection();
+
+            int descriptor = -1;
+            std::mutex writeMutex;
+            std::thread reader;
+            std::atomic<bool> finished{false};
+        };
+
+        /// @brief A request waiting to be batched
+        struct Request
+        {
+            std::shared_ptr<Connection> connection;
+            uint64_t id = 0;
+            int rows = 0;
+            std::vector<double> inputs;
+            Clock::time_point received;
+        };
+
+        /// @brief Accepts connections until the server stops, starting a reader for each
+        void AcceptLoop();
+
+        /// @brief            Reads requests from one connection and queues them, until the client disconnects or the server stops
+        /// @param connection The connection
+        void ReadLoop(std::shared_ptr<Connection> connection);
+
+        /// @brief Takes batches from the queue and runs them until the server stops
+        void WorkLoop();
+
+        /// @brief            Writes a response, serialised with every other write to the same connection
+        /// @param connection The connection
+        /// @param status     Status of the response
+        /// @param id         Id of the request
+        /// @param outputs    The outputs, only written when the status is Ok
+        /// @return           Whether the whole response was written
+        bool Respond(Connection& connection, InferenceProtocol::Status status, uint64_t id, Span<const double> outputs);
+
+        NeuralNetwork network;
+        Options options;
+        int numInputs;
+        int numOutputs;
+
+        int listener;
+        std::atomic<bool> stopping;
+        bool running;
+        std::thread acceptor;
+        std::vector<std::thread> workers;
+        std::mutex connectionsMutex;
+        std::vector<std::shared_ptr<Connection>> connections;
+
+        /// Requests waiting for a worker, and the sum of their rows
+        std::mutex queueMutex;
+        std::condition_variable queueChanged;
+        std::deque<Request> queue;
+        long queuedRows;
+
+        /// Statistics, updated by the workers without locking
+        LatencyHistogram latency;
+        std::atomic<long> requests;
+        std::atomic<long> rows;
+        std::atomic<long> batches;
+        std::atomic<long> rejected;
+        std::array<std::atomic<long>, 32> batchRows;
+};
+
+class InferenceClient
+{
+    public:
+        /// @class          Blocking client of an InferenceServer, which sends one request at a time and waits for its response
+        /// @param endpoint The address the server listens on
+        explicit InferenceClient(const InferenceProtocol::Endpoint& endpoint);
+
+        /// @brief Closes the connection
+        ~InferenceClient();
+
+        InferenceClient(const InferenceClient&) = delete;
+        InferenceClient& operator=(const InferenceClient&) = delete;
+
+        /// @brief         Predicts the outputs of a batch of rows. Throws if the server rejects the request or the connection
+        ///                is lost.
+        /// @param inputs  Row-major rows x GetNumInputs() inputs
+        /// @param outputs Row-major rows x GetNumOutputs() values that the predictions are written to
+        void Predict(Span<const double> inputs, Span<double> outputs);
+
+        /// @brief  Get the number of inputs of the served model
+        /// @return The number of inputs
+        int GetNumInputs() const;
+
+        /// @brief  Get the number of outputs of the served model
+        /// @return The number of outputs
+        int GetNumOutputs() const;
+
+        /// @brief  Get the largest number of rows the server accepts in one request
+        /// @return The number of rows
+        int GetMaxRequestRows() const;
+
+    private:
+        int descriptor;
+        InferenceProtocol::Hello hello;
+        uint64_t nextId;
+};
+
+#endif // INFERENCE_SERVER_H
@@ -0,0 +1,137 @@
+#include "initializer.h"
+
+#include <cmath>
+
+namespace
+{
+    constexpr double Pi = 3.14159265358979323846;
+    constexpr uint64_t Gamma = 0x9e3779b97f4a7c15ULL;
+
+    /// The SplitMix64 output function, a bijective mix of all 64 bits
+    uint64_t Mix(uint64_t value)
+    {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+}
+
+RandomGenerator::RandomGenerator(uint64_t seed, uint64_t stream)
+                                :
+                                key(Mix(seed + Mix(stream + Gamma)))
+{
+}
+
+uint64_t RandomGenerator::Bits(uint64_t counter) const
+{
+    // Position n of a SplitMix64 sequence is the mix of its starting state plus n + 1 increments
+    return Mix(key + (counter + 1) * Gamma);
+}
+
+double RandomGenerator::Uniform(uint64_t counter) const
+{
+    return (Bits(counter) >> 11) * 0x1.0p-53;
+}
+
+double RandomGenerator::Normal(uint64_t counter) const
+{
+    // The first uniform is moved to (0, 1] so that its logarithm is finite
+    const double radius = std::sqrt(-2 * std::log(1 - Uniform(2 * counter)));
+    return radius * std::cos(2 * Pi * Uniform(2 * counter + 1));
+}
+
+Initializer::Initializer(Distribution inputDistribution, Scaling inputScaling, double inputScale)
+                        :
+                        distribution(inputDistribution),
+                        scaling(inputScaling),
+                        scale(inputScale)
+{
+    if (!(scale >= 0))
+    {
+        throw(std::invalid_argument("Initializer scale must not be negative"));
+    }
+}
+
+double Initializer::GetStdDev(int numInputs, int numNeurons) const
+{
+    switch (scaling)
+    {
+        case Scaling::FanAverage:
+            return scale / std::sqrt(0.5 * (numInputs + numNeurons));
+        case Scaling::FanIn:
+            return scale / std::sqrt(static_cast<double>(numInputs));
+        default:
+            // A uniform distribution on [-a, a] has a standard deviation of a / sqrt(3)
+            return distribution == Distribution::Uniform ? scale / std::sqrt(3.0) : scale;
+    }
+}
+
+template<typename T>
+void Initializer::Generate(const RandomGenerator& generator, size_t first, size_t count, int numInputs, int numNeurons, T* weights) const
+{
+    const double stdDev = GetStdDev(numInputs, numNeurons);
+    if (distribution == Distribution::Normal)
+    {
+        for (size_t i = 0 ; i < count ; i++)
+        {
+            weights[i] = static_cast<T>(stdDev * generator.Normal(first + i));
+        }
+        return;
+    }
+
+    const double limit = stdDev * std::sqrt(3.0);
+    for (size_t i = 0 ; i < count ; i++)
+    {
+        weights[i] = static_cast<T>(limit * (2 * generator.Uniform(first + i) - 1));
+    }
+}
+
+Initializer Initializers::XavierUniform(double gain)
+{
+    return Initializer(Initializer::Distribution::Uniform, Initializer::Scaling::FanAverage, gain);
+}
+
+Initializer Initializers::XavierNormal(double gain)
+{
+    return Initializer(Initializer::Distribution::Normal, Initializer::Scaling::FanAverage, gain);
+}
+
+Initializer Initializers::HeUniform()
+{
+    return Initializer(Initializer::Distribution::Uniform, Initializer::Scaling::FanIn, std::sqrt(2.0));
+}
+
+Initializer Initializers::HeNormal()
+{
+    return Initializer(Initializer::Distribution::Normal, Initializer::Scaling::FanIn, std::sqrt(2.0));
+}
+
+Initializer Initializers::Uniform(double limit)
+{
+    return Initializer(Initializer::Distribution::Uniform, Initializer::Scaling::Constant, limit);
+}
+
+Initializer Initializers::Normal(double stdDev)
+{
+    return Initializer(Initializer::Distribution::Normal, Initializer::Scaling::Constant, stdDev);
+}
+
+Initializer Initializers::ForActivation(ActivationFunctions::ActivationType type)
+{
+    switch (type)
+    {
+        case ActivationFunctions::ActivationType::Relu:
+        case ActivationFunctions::ActivationType::LRelu:
+        case ActivationFunctions::ActivationType::Elu:
+        case ActivationFunctions::ActivationType::Softplus:
+        case ActivationFunctions::ActivationType::Gelu:
+        case ActivationFunctions::ActivationType::Silu:
+            return HeNormal();
+        default:
+            return XavierUniform();
+    }
+}
+
+// Supported precisions
+template void Initializer::Generate<double>(const RandomGenerator&, size_t, size_t, int, int, double*) const;
+template void Initializer::Generate<float>(const RandomGenerator&, size_t, size_t, int, int, float*) const;
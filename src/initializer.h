@@ -0,0 +1,127 @@
+#ifndef INITIALIZER_H
+#define INITIALIZER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+#include "support_functions.h"
+
+class RandomGenerator
+{
+    public:
+        /// @class        Counter-based random number generator. Every value is a SplitMix64 hash of the seed, the stream and
+        ///               the position of the value, so any value can be computed directly without generating the ones
+        ///               before it. Disjoint ranges of positions can therefore be filled on different threads with the same
+        ///               result as filling them in order, and each stream is an independent sequence for the same seed.
+        /// @param seed   The seed
+        /// @param stream Index of the sequence, such as the index of the layer being initialized
+        RandomGenerator(uint64_t seed, uint64_t stream = 0);
+
+        /// @brief         Returns 64 random bits
+        /// @param counter Position of the value in the sequence
+        /// @return        The bits
+        uint64_t Bits(uint64_t counter) const;
+
+        /// @brief         Returns a value drawn uniformly from [0, 1)
+        /// @param counter Position of the value in the sequence
+        /// @return        The value
+        double Uniform(uint64_t counter) const;
+
+        /// @brief         Returns a value drawn from the standard normal distribution, made from the uniform values at
+        ///                positions 2 * counter and 2 * counter + 1 with the Box-Muller transform
+        /// @param counter Position of the value in the sequence
+        /// @return        The value
+        double Normal(uint64_t counter) const;
+
+    private:
+        uint64_t key;
+};
+
+class Initializer
+{
+    public:
+        /// @brief Distribution the weights are drawn from, centred on zero
+        enum class Distribution
+        {
+            Uniform,
+            Normal
+        };
+
+        /// @brief How the spread of the distribution depends on the size of the layer
+        enum class Scaling
+        {
+            /// The scale is the limit of the uniform distribution or the standard deviation of the normal distribution
+            Constant,
+            /// The standard deviation is scale / sqrt(fan), with fan the mean of the number of inputs and neurons (Xavier)
+            FanAverage,
+            /// The standard deviation is scale / sqrt(fan), with fan the number of inputs (He)
+            FanIn
+        };
+
+        /// @class              Scheme for drawing the initial weights of a layer. Biases always start at zero. See
+        ///                     Initializers for the common schemes.
+        /// @param distribution The distribution the weights are drawn from
+        /// @param scaling      How the spread of the distribution depends on the size of the layer
+        /// @param scale        The spread for Scaling::Constant, otherwise the gain the standard deviation is multiplied by
+        Initializer(Distribution distribution, Scaling scaling, double scale);
+
+        /// @brief            Get the standard deviation of the weights of a layer
+        /// @param numInputs  The number of inputs of the layer
+        /// @param numNeurons The number of neurons of the layer
+        /// @return           The standard deviation
+        double GetStdDev(int numInputs, int numNeurons) const;
+
+        /// @brief            Draws a range of the weights of a layer. Weight i is always drawn from position i of the
+        ///                   generator, so the range can be any part of the layer.
+        /// @param generator  The generator, with a stream of its own for the layer
+        /// @param first      Index of the first weight of the range within the layer
+        /// @param count      The number of weights in the range
+        /// @param numInputs  The number of inputs of the layer
+        /// @param numNeurons The number of neurons of the layer
+        /// @param weights    Pointer to where the weights of the range are written
+        template<typename T>
+        void Generate(const RandomGenerator& generator, size_t first, size_t count, int numInputs, int numNeurons, T* weights) const;
+
+    private:
+        Distribution distribution;
+        Scaling scaling;
+        double scale;
+};
+
+namespace Initializers
+{
+    /// @brief Namespace holding the common initialization schemes. When a layer is not given one, the network picks one
+    ///        with ForActivation().
+
+    /// @brief      Xavier (Glorot) initialization, which keeps the variance of activations and gradients roughly constant
+    ///             through layers with symmetric activations such as tanh and sigmoid
+    /// @param gain Factor the standard deviation is multiplied by
+    /// @return     The initializer
+    Initializer XavierUniform(double gain = 1);
+    Initializer XavierNormal(double gain = 1);
+
+    /// @brief  He (Kaiming) initialization, which compensates for the half of the inputs that rectified activations
+    ///         such as relu zero out
+    /// @return The initializer
+    Initializer HeUniform();
+    Initializer HeNormal();
+
+    /// @brief       Draws every weight uniformly from [-limit, limit], whatever the size of the layer
+    /// @param limit The largest magnitude of a weight
+    /// @return      The initializer
+    Initializer Uniform(double limit = 0.05);
+
+    /// @brief        Draws every weight from a normal distribution, whatever the size of the layer
+    /// @param stdDev The standard deviation of the weights
+    /// @return       The initializer
+    Initializer Normal(double stdDev = 0.05);
+
+    /// @brief      Returns the scheme suited to an activation function: He for the rectified activations and their smooth
+    ///             variants (relu, leaky relu, elu, softplus, gelu and silu) and Xavier for every other activation
+    /// @param type The activation type of the layer
+    /// @return     The initializer
+    Initializer ForActivation(ActivationFunctions::ActivationType type);
+}
+
+#endif // INITIALIZER_H
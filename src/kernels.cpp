@@ -0,0 +1,1762 @@
+#include "kernels.h"
+
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NN_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    /// Register tile computed by every micro-kernel, MR rows of C by NR columns
+    constexpr int MR = 4;
+
+    /// Cache blocking, a KC x NC block of B is packed to stay in the last level cache while MC x KC blocks of A stay in L2
+    constexpr int MC = 64;
+    constexpr int KC = 256;
+    constexpr int NC = 512;
+
+    /// Micro-kernel contract: C[MR x NR] += Ap * Bp, where Ap is kc panels of MR values and Bp is kc panels of NR values
+    template<typename T, typename Accumulator>
+    struct KernelTable
+    {
+        Kernels::InstructionSet set;
+        int nr;
+        void (*microKernel)(int kc, const T* ap, const T* bp, T* c, int ldc);
+        Accumulator (*dot)(int n, const T* x, const T* y);
+        void (*axpy)(int n, T alpha, const T* x, T* y);
+    };
+
+    /// Widest NR of any micro-kernel, which sizes the scratch tile used at matrix edges
+    constexpr int MaxNR = 32;
+
+    // Portable scalar implementations, shared by every precision
+
+    template<typename T, typename Accumulator>
+    void MicroKernelScalar(int kc, const T* ap, const T* bp, T* c, int ldc)
+    {
+        Accumulator acc[MR][4] = {};
+        for (int p = 0 ; p < kc ; p++, ap += MR, bp += 4)
+        {
+            for (int i = 0 ; i < MR ; i++)
+            {
+                for (int j = 0 ; j < 4 ; j++)
+                {
+                    acc[i][j] += static_cast<Accumulator>(ap[i]) * bp[j];
+                }
+            }
+        }
+        for (int i = 0 ; i < MR ; i++)
+        {
+            for (int j = 0 ; j < 4 ; j++)
+            {
+                c[i * ldc + j] += static_cast<T>(acc[i][j]);
+            }
+        }
+    }
+
+    template<typename T, typename Accumulator>
+    Accumulator DotScalar(int n, const T* x, const T* y)
+    {
+        Accumulator sum[4] = {};
+        int i = 0;
+        for ( ; i + 4 <= n ; i += 4)
+        {
+            sum[0] += static_cast<Accumulator>(x[i]) * y[i];
+            sum[1] += static_cast<Accumulator>(x[i + 1]) * y[i + 1];
+            sum[2] += static_cast<Accumulator>(x[i + 2]) * y[i + 2];
+            sum[3] += static_cast<Accumulator>(x[i + 3]) * y[i + 3];
+        }
+        for ( ; i < n ; i++)
+        {
+            sum[0] += static_cast<Accumulator>(x[i]) * y[i];
+        }
+        return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    }
+
+    template<typename T>
+    void AxpyScalar(int n, T alpha, const T* x, T* y)
+    {
+        for (int i = 0 ; i < n ; i++)
+        {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    /// Largest value QuantizedGemm() accepts in A, and so the largest value Quantize() produces
+    constexpr float QuantizedLimit = 127;
+
+    void QuantizeScalar(int n, const float* x, float inverseScale, float zeroPoint, uint8_t* q)
+    {
+        for (int i = 0 ; i < n ; i++)
+        {
+            const float value = std::max(0.0f, std::min(QuantizedLimit, x[i] * inverseScale + zeroPoint));
+            q[i] = static_cast<uint8_t>(std::nearbyint(value));
+        }
+    }
+
+    /// Quantized kernel contract: c[j] = sum over p < k of a[p] * b[j * ldb + p] for j < n, one row of C = A * B^T
+    using QuantizedRowKernel = void (*)(int n, int k, const uint8_t* a, const int8_t* b, int ldb, int32_t* c);
+
+    /// Rows of B multiplied against every row of A before moving on, sized so that the block stays in the L1 cache
+    constexpr int QuantizedBlockBytes = 32768;
+
+    void QuantizedRowScalar(int n, int k, const uint8_t* a, const int8_t* b, int ldb, int32_t* c)
+    {
+        for (int j = 0 ; j < n ; j++)
+        {
+            const int8_t* row = b + static_cast<size_t>(j) * ldb;
+            int32_t sum = 0;
+            for (int p = 0 ; p < k ; p++)
+            {
+                sum += static_cast<int32_t>(a[p]) * row[p];
+            }
+            c[j] = sum;
+        }
+    }
+
+    /// Fused optimizer steps of one precision, see Kernels::SgdStep(), MomentumStep(), RmsPropStep() and AdamStep()
+    template<typename T>
+    struct OptimizerTable
+    {
+        void (*sgd)(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients);
+        void (*momentum)(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* velocity);
+        void (*rmsProp)(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* second);
+        void (*adam)(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* first, T* second);
+    };
+
+    template<typename T>
+    void SgdStepScalar(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients)
+    {
+        for (int i = 0 ; i < n ; i++)
+        {
+            const T gradient = step.gradientScale * gradients[i] + step.l2 * parameters[i];
+            parameters[i] -= step.learningRate * (gradient + step.decay * parameters[i]);
+        }
+    }
+
+    template<typename T>
+    void MomentumStepScalar(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* velocity)
+    {
+        for (int i = 0 ; i < n ; i++)
+        {
+            const T gradient = step.gradientScale * gradients[i] + step.l2 * parameters[i];
+            velocity[i] = step.beta1 * velocity[i] + gradient;
+            parameters[i] -= step.learningRate * (velocity[i] + step.decay * parameters[i]);
+        }
+    }
+
+    template<typename T>
+    void RmsPropStepScalar(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* second)
+    {
+        const T secondWeight = 1 - step.beta2;
+        for (int i = 0 ; i < n ; i++)
+        {
+            const T gradient = step.gradientScale * gradients[i] + step.l2 * parameters[i];
+            second[i] = step.beta2 * second[i] + secondWeight * gradient * gradient;
+            const T direction = gradient / (std::sqrt(second[i]) + step.epsilon);
+            parameters[i] -= step.learningRate * (direction + step.decay * parameters[i]);
+        }
+    }
+
+    template<typename T>
+    void AdamStepScalar(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* first, T* second)
+    {
+        const T firstWeight = 1 - step.beta1;
+        const T secondWeight = 1 - step.beta2;
+        for (int i = 0 ; i < n ; i++)
+        {
+            const T gradient = step.gradientScale * gradients[i] + step.l2 * parameters[i];
+            first[i] = step.beta1 * first[i] + firstWeight * gradient;
+            second[i] = step.beta2 * second[i] + secondWeight * gradient * gradient;
+            const T direction = step.firstCorrection * first[i] / (std::sqrt(step.secondCorrection * second[i]) + step.epsilon);
+            parameters[i] -= step.learningRate * (direction + step.decay * parameters[i]);
+        }
+    }
+
+    /// Constants of the approximations behind Kernels::ApproximateActivation(), for each precision
+    template<typename T>
+    struct Approximation;
+
+    template<>
+    struct Approximation<double>
+    {
+        static constexpr double Log2e = 1.4426950408889634;
+        /// 1.5 * 2^52, adding it rounds a double to the nearest integer and leaves that integer in the low mantissa bits
+        static constexpr double Shifter = 6755399441055744.0;
+        /// ln 2 split into a part with few mantissa bits, so that n * Ln2High is exact, and the rest
+        static constexpr double Ln2High = 6.93145751953125e-1;
+        static constexpr double Ln2Low = 1.42860682030941723212e-6;
+        /// Range of exp that neither overflows nor takes the exponent out of the normal range
+        static constexpr double ExpMin = -708;
+        static constexpr double ExpMax = 709;
+        /// Taylor coefficients of exp(r), lowest degree first
+        static constexpr int ExpTerms = 12;
+        static constexpr double Exp[ExpTerms] = {1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+                                                 1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800};
+        /// Coefficients of log1p(t) = s * sum of 2 / (2k + 1) * s^2k, with s = t / (2 + t) <= 1/3 for t in [0, 1]
+        static constexpr int LogTerms = 14;
+        static constexpr double Log[LogTerms] = {2.0, 2.0 / 3, 2.0 / 5, 2.0 / 7, 2.0 / 9, 2.0 / 11, 2.0 / 13, 2.0 / 15,
+                                                 2.0 / 17, 2.0 / 19, 2.0 / 21, 2.0 / 23, 2.0 / 25, 2.0 / 27};
+    };
+
+    template<>
+    struct Approximation<float>
+    {
+        static constexpr float Log2e = 1.44269504f;
+        static constexpr float Shifter = 12582912.0f;
+        static constexpr float Ln2High = 0.693359375f;
+        static constexpr float Ln2Low = -2.12194440e-4f;
+        static constexpr float ExpMin = -87;
+        static constexpr float ExpMax = 88;
+        static constexpr int ExpTerms = 7;
+        static constexpr float Exp[ExpTerms] = {1.0f, 1.0f, 1.0f / 2, 1.0f / 6, 1.0f / 24, 1.0f / 120, 1.0f / 720};
+        static constexpr int LogTerms = 8;
+        static constexpr float Log[LogTerms] = {2.0f, 2.0f / 3, 2.0f / 5, 2.0f / 7, 2.0f / 9, 2.0f / 11, 2.0f / 13, 2.0f / 15};
+    };
+
+    /// Abramowitz and Stegun 7.1.26, erf(z) = 1 - t * (a1 + t * (a2 + ...)) * exp(-z^2) with t = 1 / (1 + p * z) for z >= 0
+    constexpr double ErfP = 0.3275911;
+    constexpr double Erf[5] = {0.254829592, -0.284496736, 1.421413741, -1.453152027, 1.061405429};
+    constexpr double InvSqrt2 = 0.70710678118654752440;
+    constexpr double InvSqrt2Pi = 0.39894228040143267794;
+
+    /// Scalar stand-ins for the vector operations, so that the approximations are written once for every instruction set.
+    /// Min() and Max() return their second argument when either is NaN, like minpd and maxpd, so that NaN propagates
+    /// through Min(limit, x) and Max(limit, x).
+    template<typename T>
+    struct ScalarOperations
+    {
+        using Scalar = T;
+        using Vector = T;
+        static constexpr int Width = 1;
+        static inline Vector Set(T x) { return x; }
+        static inline Vector Load(const T* p) { return *p; }
+        static inline void Store(T* p, Vector x) { *p = x; }
+        static inline Vector Add(Vector x, Vector y) { return x + y; }
+        static inline Vector Sub(Vector x, Vector y) { return x - y; }
+        static inline Vector Mul(Vector x, Vector y) { return x * y; }
+        static inline Vector Div(Vector x, Vector y) { return x / y; }
+        static inline Vector MulAdd(Vector x, Vector y, Vector z) { return x * y + z; }
+        static inline Vector NegMulAdd(Vector x, Vector y, Vector z) { return z - x * y; }
+        static inline Vector Min(Vector x, Vector y) { return (x < y) ? x : y; }
+        static inline Vector Max(Vector x, Vector y) { return (x > y) ? x : y; }
+        /// x where a > b, otherwise y
+        static inline Vector Select(Vector a, Vector b, Vector x, Vector y) { return (a > b) ? x : y; }
+        /// 2^n from n + Approximation<T>::Shifter, by moving the integer in its low mantissa bits into the exponent field
+        static inline Vector Pow2(Vector shifted)
+        {
+            using Bits = std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t>;
+            constexpr int MantissaBits = sizeof(T) == 8 ? 52 : 23;
+            constexpr Bits Bias = sizeof(T) == 8 ? 1023 : 127;
+            Bits bits;
+            std::memcpy(&bits, &shifted, sizeof(bits));
+            bits = (bits + Bias) << MantissaBits;
+            T result;
+            std::memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+    };
+
+    /// Smooth activation functions for one instruction set, whose target attribute is given as Target. Each function computes
+    /// the value and derivative of a whole vector of inputs from a single exponential. Everything is inlined into Run(), the
+    /// one function compiled for the target, and the last few values go through a padded vector rather than a scalar loop so
+    /// that every value of a buffer is computed the same way.
+#define NN_ACTIVATION_APPROXIMATIONS(Name, Target)                                                                          \
+    struct Name                                                                                                             \
+    {                                                                                                                       \
+        template<typename V, typename Vector = typename V::Vector, typename C = Approximation<typename V::Scalar>>          \
+        Target __attribute__((always_inline)) static inline Vector Exp(Vector x)                                            \
+        {                                                                                                                   \
+            x = V::Min(V::Set(C::ExpMax), V::Max(V::Set(C::ExpMin), x));                                                    \
+            const Vector shifted = V::MulAdd(x, V::Set(C::Log2e), V::Set(C::Shifter));                                      \
+            const Vector n = V::Sub(shifted, V::Set(C::Shifter));                                                           \
+            const Vector r = V::NegMulAdd(n, V::Set(C::Ln2Low), V::NegMulAdd(n, V::Set(C::Ln2High), x));                    \
+            Vector p = V::Set(C::Exp[C::ExpTerms - 1]);                                                                     \
+            for (int i = C::ExpTerms - 2 ; i >= 0 ; i--)                                                                    \
+            {                                                                                                               \
+                p = V::MulAdd(p, r, V::Set(C::Exp[i]));                                                                     \
+            }                                                                                                               \
+            return V::Mul(p, V::Pow2(shifted));                                                                             \
+        }                                                                                                                   \
+                                                                                                                            \
+        /** log1p(t) for t in [0, 1] */                                                                                     \
+        template<typename V, typename Vector = typename V::Vector, typename C = Approximation<typename V::Scalar>>          \
+        Target __attribute__((always_inline)) static inline Vector Log1p(Vector t)                                          \
+        {                                                                                                                   \
+            const Vector s = V::Div(t, V::Add(V::Set(2), t));                                                               \
+            const Vector s2 = V::Mul(s, s);                                                                                 \
+            Vector p = V::Set(C::Log[C::LogTerms - 1]);                                                                     \
+            for (int i = C::LogTerms - 2 ; i >= 0 ; i--)                                                                    \
+            {                                                                                                               \
+                p = V::MulAdd(p, s2, V::Set(C::Log[i]));                                                                    \
+            }                                                                                                               \
+            return V::Mul(s, p);                                                                                            \
+        }                                                                                                                   \
+                                                                                                                            \
+        template<typename V, Kernels::SmoothFunction Function, typename Vector = typename V::Vector>                        \
+        Target __attribute__((always_inline)) static inline void Evaluate(Vector x, Vector& y, Vector& dy)                  \
+        {                                                                                                                   \
+            const Vector zero = V::Set(0), one = V::Set(1);                                                                 \
+            const Vector magnitude = V::Max(x, V::Sub(zero, x));                                                            \
+            if constexpr (Function == Kernels::SmoothFunction::Sigmoid)                                                     \
+            {                                                                                                               \
+                /* e / (1 + e)^2 = y^2 * e avoids the cancellation in y * (1 - y) */                                        \
+                const Vector e = Exp<V>(V::Sub(zero, x));                                                                   \
+                y = V::Div(one, V::Add(one, e));                                                                            \
+                dy = V::Mul(V::Mul(y, y), e);                                                                               \
+            }                                                                                                               \
+            else if constexpr (Function == Kernels::SmoothFunction::Tanh)                                                   \
+            {                                                                                                               \
+                /* tanh(|x|) = (1 - t) / (1 + t) with t = exp(-2|x|), and 1 - tanh^2 = 4t / (1 + t)^2 */                    \
+                const Vector t = Exp<V>(V::Mul(V::Set(-2), magnitude));                                                     \
+                const Vector u = V::Div(one, V::Add(one, t));                                                               \
+                const Vector m = V::Mul(V::Sub(one, t), u);                                                                 \
+                y = V::Select(zero, x, V::Sub(zero, m), m);                                                                 \
+                dy = V::Mul(V::Mul(V::Set(4), t), V::Mul(u, u));                                                            \
+            }                                                                                                               \
+            else if constexpr (Function == Kernels::SmoothFunction::Elu)                                                    \
+            {                                                                                                               \
+                const Vector e = Exp<V>(V::Min(zero, x));                                                                   \
+                y = V::Select(x, zero, x, V::Sub(e, one));                                                                  \
+                dy = V::Select(x, zero, one, e);                                                                            \
+            }                                                                                                               \
+            else if constexpr (Function == Kernels::SmoothFunction::Softplus)                                               \
+            {                                                                                                               \
+                /* log(1 + exp(x)) = max(x, 0) + log1p(t) and sigmoid(x) = 1 / (1 + t) or t / (1 + t), t = exp(-|x|) */     \
+                const Vector t = Exp<V>(V::Sub(zero, magnitude));                                                           \
+                const Vector u = V::Div(one, V::Add(one, t));                                                               \
+                y = V::Add(V::Max(zero, x), Log1p<V>(t));                                                                   \
+                dy = V::Select(x, zero, u, V::Mul(t, u));                                                                   \
+            }                                                                                                               \
+            else if constexpr (Function == Kernels::SmoothFunction::Gelu)                                                   \
+            {                                                                                                               \
+                /* x * Phi(x), where the upper tail of Phi is erfc(|x| / sqrt 2) / 2, and Phi(x) + x * phi(x) */            \
+                const Vector t = V::Div(one, V::MulAdd(V::Set(ErfP * InvSqrt2), magnitude, one));                           \
+                Vector p = V::Set(Erf[4]);                                                                                  \
+                for (int i = 3 ; i >= 0 ; i--)                                                                              \
+                {                                                                                                           \
+                    p = V::MulAdd(p, t, V::Set(Erf[i]));                                                                    \
+                }                                                                                                           \
+                const Vector e = Exp<V>(V::Mul(V::Set(-0.5), V::Mul(x, x)));                                                \
+                const Vector tail = V::Mul(V::Mul(V::Set(0.5), t), V::Mul(p, e));                                           \
+                const Vector phi = V::Select(zero, x, tail, V::Sub(one, tail));                                             \
+                y = V::Mul(x, phi);                                                                                         \
+                dy = V::MulAdd(V::Mul(x, e), V::Set(InvSqrt2Pi), phi);                                                      \
+            }                                                                                                               \
+            else                                                                                                            \
+            {                                                                                                               \
+                /* x * sigmoid(x), whose derivative is sigmoid(x) + y * (1 - sigmoid(x)), with 1 - sigmoid(x) = e * s */    \
+                const Vector e = Exp<V>(V::Sub(zero, x));                                                                   \
+                const Vector s = V::Div(one, V::Add(one, e));                                                               \
+                y = V::Mul(x, s);                                                                                           \
+                dy = V::MulAdd(y, V::Mul(e, s), s);                                                                         \
+            }                                                                                                               \
+        }                                                                                                                   \
+                                                                                                                            \
+        template<typename V, Kernels::SmoothFunction Function, typename T = typename V::Scalar, typename Vector = typename V::Vector> \
+        Target __attribute__((always_inline)) static inline void Sweep(size_t n, const T* inputs, T* outputs, T* derivatives) \
+        {                                                                                                                   \
+            size_t i = 0;                                                                                                   \
+            for ( ; i + V::Width <= n ; i += V::Width)                                                                      \
+            {                                                                                                               \
+                Vector y, dy;                                                                                               \
+                Evaluate<V, Function>(V::Load(inputs + i), y, dy);                                                          \
+                if (outputs) { V::Store(outputs + i, y); }                                                                  \
+                if (derivatives) { V::Store(derivatives + i, dy); }                                                         \
+            }                                                                                                               \
+            if (i < n)                                                                                                      \
+            {                                                                                                               \
+                T x[V::Width] = {}, values[V::Width], slopes[V::Width];                                                     \
+                std::copy(inputs + i, inputs + n, x);                                                                       \
+                Vector y, dy;                                                                                               \
+                Evaluate<V, Function>(V::Load(x), y, dy);                                                                   \
+                V::Store(values, y);                                                                                        \
+                V::Store(slopes, dy);                                                                                       \
+                if (outputs) { std::copy(values, values + (n - i), outputs + i); }                                          \
+                if (derivatives) { std::copy(slopes, slopes + (n - i), derivatives + i); }                                  \
+            }                                                                                                               \
+        }                                                                                                                   \
+                                                                                                                            \
+        template<typename V, typename T = typename V::Scalar>                                                               \
+        Target static void Run(Kernels::SmoothFunction function, size_t n, const T* inputs, T* outputs, T* derivatives)    \
+        {                                                                                                                   \
+            switch (function)                                                                                               \
+            {                                                                                                               \
+                case Kernels::SmoothFunction::Sigmoid:  Sweep<V, Kernels::SmoothFunction::Sigmoid>(n, inputs, outputs, derivatives);  break; \
+                case Kernels::SmoothFunction::Tanh:     Sweep<V, Kernels::SmoothFunction::Tanh>(n, inputs, outputs, derivatives);     break; \
+                case Kernels::SmoothFunction::Elu:      Sweep<V, Kernels::SmoothFunction::Elu>(n, inputs, outputs, derivatives);      break; \
+                case Kernels::SmoothFunction::Softplus: Sweep<V, Kernels::SmoothFunction::Softplus>(n, inputs, outputs, derivatives); break; \
+                case Kernels::SmoothFunction::Gelu:     Sweep<V, Kernels::SmoothFunction::Gelu>(n, inputs, outputs, derivatives);     break; \
+                case Kernels::SmoothFunction::Silu:     Sweep<V, Kernels::SmoothFunction::Silu>(n, inputs, outputs, derivatives);     break; \
+            }                                                                                                               \
+        }                                                                                                                   \
+    };
+
+    NN_ACTIVATION_APPROXIMATIONS(ScalarApproximations, )
+
+    /// Smooth activation sweep of one precision, see Kernels::ApproximateActivation()
+    template<typename T>
+    using ActivationKernel = void (*)(Kernels::SmoothFunction function, size_t n, const T* inputs, T* outputs, T* derivatives);
+
+#ifdef NN_KERNELS_X86
+
+    // AVX2 + FMA implementations, 4 x 8 register tile held in 8 ymm accumulators
+
+    __attribute__((target("avx2,fma")))
+    void MicroKernelAvx2(int kc, const double* ap, const double* bp, double* c, int ldc)
+    {
+        __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+        __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+        __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+        __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+
+        for (int p = 0 ; p < kc ; p++, ap += MR, bp += 8)
+        {
+            __m256d b0 = _mm256_loadu_pd(bp);
+            __m256d b1 = _mm256_loadu_pd(bp + 4);
+            __m256d a;
+            a = _mm256_broadcast_sd(ap);     c00 = _mm256_fmadd_pd(a, b0, c00); c01 = _mm256_fmadd_pd(a, b1, c01);
+            a = _mm256_broadcast_sd(ap + 1); c10 = _mm256_fmadd_pd(a, b0, c10); c11 = _mm256_fmadd_pd(a, b1, c11);
+            a = _mm256_broadcast_sd(ap + 2); c20 = _mm256_fmadd_pd(a, b0, c20); c21 = _mm256_fmadd_pd(a, b1, c21);
+            a = _mm256_broadcast_sd(ap + 3); c30 = _mm256_fmadd_pd(a, b0, c30); c31 = _mm256_fmadd_pd(a, b1, c31);
+        }
+
+        double* c0 = c;
+        double* c1 = c + ldc;
+        double* c2 = c + 2 * ldc;
+        double* c3 = c + 3 * ldc;
+        _mm256_storeu_pd(c0, _mm256_add_pd(_mm256_loadu_pd(c0), c00)); _mm256_storeu_pd(c0 + 4, _mm256_add_pd(_mm256_loadu_pd(c0 + 4), c01));
+        _mm256_storeu_pd(c1, _mm256_add_pd(_mm256_loadu_pd(c1), c10)); _mm256_storeu_pd(c1 + 4, _mm256_add_pd(_mm256_loadu_pd(c1 + 4), c11));
+        _mm256_storeu_pd(c2, _mm256_add_pd(_mm256_loadu_pd(c2), c20)); _mm256_storeu_pd(c2 + 4, _mm256_add_pd(_mm256_loadu_pd(c2 + 4), c21));
+        _mm256_storeu_pd(c3, _mm256_add_pd(_mm256_loadu_pd(c3), c30)); _mm256_storeu_pd(c3 + 4, _mm256_add_pd(_mm256_loadu_pd(c3 + 4), c31));
+    }
+
+    __attribute__((target("avx2,fma")))
+    double DotAvx2(int n, const double* x, const double* y)
+    {
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        int i = 0;
+        for ( ; i + 8 <= n ; i += 8)
+        {
+            s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), s0);
+            s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), s1);
+        }
+        for ( ; i + 4 <= n ; i += 4)
+        {
+            s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), s0);
+        }
+
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(s0, s1));
+        double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for ( ; i < n ; i++)
+        {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+
+    __attribute__((target("avx2,fma")))
+    void AxpyAvx2(int n, double alpha, const double* x, double* y)
+    {
+        __m256d a = _mm256_set1_pd(alpha);
+        int i = 0;
+        for ( ; i + 4 <= n ; i += 4)
+        {
+            _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        }
+        for ( ; i < n ; i++)
+        {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    // Single precision AVX2, 4 x 16 register tile in 8 ymm accumulators of 8 floats each
+
+    __attribute__((target("avx2,fma")))
+    void MicroKernelAvx2(int kc, const float* ap, const float* bp, float* c, int ldc)
+    {
+        __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+        __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+        __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+        __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+
+        for (int p = 0 ; p < kc ; p++, ap += MR, bp += 16)
+        {
+            __m256 b0 = _mm256_loadu_ps(bp);
+            __m256 b1 = _mm256_loadu_ps(bp + 8);
+            __m256 a;
+            a = _mm256_broadcast_ss(ap);     c00 = _mm256_fmadd_ps(a, b0, c00); c01 = _mm256_fmadd_ps(a, b1, c01);
+            a = _mm256_broadcast_ss(ap + 1); c10 = _mm256_fmadd_ps(a, b0, c10); c11 = _mm256_fmadd_ps(a, b1, c11);
+            a = _mm256_broadcast_ss(ap + 2); c20 = _mm256_fmadd_ps(a, b0, c20); c21 = _mm256_fmadd_ps(a, b1, c21);
+            a = _mm256_broadcast_ss(ap + 3); c30 = _mm256_fmadd_ps(a, b0, c30); c31 = _mm256_fmadd_ps(a, b1, c31);
+        }
+
+        float* c0 = c;
+        float* c1 = c + ldc;
+        float* c2 = c + 2 * ldc;
+        float* c3 = c + 3 * ldc;
+        _mm256_storeu_ps(c0, _mm256_add_ps(_mm256_loadu_ps(c0), c00)); _mm256_storeu_ps(c0 + 8, _mm256_add_ps(_mm256_loadu_ps(c0 + 8), c01));
+        _mm256_storeu_ps(c1, _mm256_add_ps(_mm256_loadu_ps(c1), c10)); _mm256_storeu_ps(c1 + 8, _mm256_add_ps(_mm256_loadu_ps(c1 + 8), c11));
+        _mm256_storeu_ps(c2, _mm256_add_ps(_mm256_loadu_ps(c2), c20)); _mm256_storeu_ps(c2 + 8, _mm256_add_ps(_mm256_loadu_ps(c2 + 8), c21));
+        _mm256_storeu_ps(c3, _mm256_add_ps(_mm256_loadu_ps(c3), c30)); _mm256_storeu_ps(c3 + 8, _mm256_add_ps(_mm256_loadu_ps(c3 + 8), c31));
+    }
+
+    __attribute__((target("avx2,fma")))
+    float DotAvx2(int n, const float* x, const float* y)
+    {
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+        int i = 0;
+        for ( ; i + 16 <= n ; i += 16)
+        {
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+            s1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), s1);
+        }
+        for ( ; i + 8 <= n ; i += 8)
+        {
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+        }
+
+        float lanes[8];
+        _mm256_storeu_ps(lanes, _mm256_add_ps(s0, s1));
+        float sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+        for ( ; i < n ; i++)
+        {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+
+    __attribute__((target("avx2,fma")))
+    void AxpyAvx2(int n, float alpha, const float* x, float* y)
+    {
+        __m256 a = _mm256_set1_ps(alpha);
+        int i = 0;
+        for ( ; i + 8 <= n ; i += 8)
+        {
+            _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        }
+        for ( ; i < n ; i++)
+        {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    // Mixed precision AVX2, float panels widened to double on load into a 4 x 8 tile of double accumulators
+
+    /// Adds four double accumulators to four floats of C
+    __attribute__((target("avx2,fma"), always_inline))
+    inline void AddMixedAvx2(float* c, __m256d acc)
+    {
+        _mm_storeu_ps(c, _mm256_cvtpd_ps(_mm256_add_pd(_mm256_cvtps_pd(_mm_loadu_ps(c)), acc)));
+    }
+
+    __attribute__((target("avx2,fma")))
+    void MicroKernelMixedAvx2(int kc, const float* ap, const float* bp, float* c, int ldc)
+    {
+        __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+        __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+        __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+        __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+
+        for (int p = 0 ; p < kc ; p++, ap += MR, bp += 8)
+        {
+            __m256d b0 = _mm256_cvtps_pd(_mm_loadu_ps(bp));
+            __m256d b1 = _mm256_cvtps_pd(_mm_loadu_ps(bp + 4));
+            __m256d a;
+            a = _mm256_set1_pd(ap[0]); c00 = _mm256_fmadd_pd(a, b0, c00); c01 = _mm256_fmadd_pd(a, b1, c01);
+            a = _mm256_set1_pd(ap[1]); c10 = _mm256_fmadd_pd(a, b0, c10); c11 = _mm256_fmadd_pd(a, b1, c11);
+            a = _mm256_set1_pd(ap[2]); c20 = _mm256_fmadd_pd(a, b0, c20); c21 = _mm256_fmadd_pd(a, b1, c21);
+            a = _mm256_set1_pd(ap[3]); c30 = _mm256_fmadd_pd(a, b0, c30); c31 = _mm256_fmadd_pd(a, b1, c31);
+        }
+
+        AddMixedAvx2(c, c00);           AddMixedAvx2(c + 4, c01);
+        AddMixedAvx2(c + ldc, c10);     AddMixedAvx2(c + ldc + 4, c11);
+        AddMixedAvx2(c + 2 * ldc, c20); AddMixedAvx2(c + 2 * ldc + 4, c21);
+        AddMixedAvx2(c + 3 * ldc, c30); AddMixedAvx2(c + 3 * ldc + 4, c31);
+    }
+
+    __attribute__((target("avx2,fma")))
+    double DotMixedAvx2(int n, const float* x, const float* y)
+    {
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        int i = 0;
+        for ( ; i + 8 <= n ; i += 8)
+        {
+            s0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(x + i)), _mm256_cvtps_pd(_mm_loadu_ps(y + i)), s0);
+            s1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(x + i + 4)), _mm256_cvtps_pd(_mm_loadu_ps(y + i + 4)), s1);
+        }
+
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(s0, s1));
+        double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for ( ; i < n ; i++)
+        {
+            sum += static_cast<double>(x[i]) * y[i];
+        }
+        return sum;
+    }
+
+    // AVX-512 implementations, 4 x 16 register tile held in 8 zmm accumulators
+
+    __attribute__((target("avx512f")))
+    void MicroKernelAvx512(int kc, const double* ap, const double* bp, double* c, int ldc)
+    {
+        __m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd();
+        __m512d c10 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+        __m512d c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+        __m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd();
+
+        for (int p = 0 ; p < kc ; p++, ap += MR, bp += 16)
+        {
+            __m512d b0 = _mm512_loadu_pd(bp);
+            __m512d b1 = _mm512_loadu_pd(bp + 8);
+            __m512d a;
+            a = _mm512_set1_pd(ap[0]); c00 = _mm512_fmadd_pd(a, b0, c00); c01 = _mm512_fmadd_pd(a, b1, c01);
+            a = _mm512_set1_pd(ap[1]); c10 = _mm512_fmadd_pd(a, b0, c10); c11 = _mm512_fmadd_pd(a, b1, c11);
+            a = _mm512_set1_pd(ap[2]); c20 = _mm512_fmadd_pd(a, b0, c20); c21 = _mm512_fmadd_pd(a, b1, c21);
+            a = _mm512_set1_pd(ap[3]); c30 = _mm512_fmadd_pd(a, b0, c30); c31 = _mm512_fmadd_pd(a, b1, c31);
+        }
+
+        double* c0 = c;
+        double* c1 = c + ldc;
+        double* c2 = c + 2 * ldc;
+        double* c3 = c + 3 * ldc;
+        _mm512_storeu_pd(c0, _mm512_add_pd(_mm512_loadu_pd(c0), c00)); _mm512_storeu_pd(c0 + 8, _mm512_add_pd(_mm512_loadu_pd(c0 + 8), c01));
+        _mm512_storeu_pd(c1, _mm512_add_pd(_mm512_loadu_pd(c1), c10)); _mm512_storeu_pd(c1 + 8, _mm512_add_pd(_mm512_loadu_pd(c1 + 8), c11));
+        _mm512_storeu_pd(c2, _mm512_add_pd(_mm512_loadu_pd(c2), c20)); _mm512_storeu_pd(c2 + 8, _mm512_add_pd(_mm512_loadu_pd(c2 + 8), c21));
+        _mm512_storeu_pd(c3, _mm512_add_pd(_mm512_loadu_pd(c3), c30)); _mm512_storeu_pd(c3 + 8, _mm512_add_pd(_mm512_loadu_pd(c3 + 8), c31));
+    }
+
+    __attribute__((target("avx512f")))
+    double DotAvx512(int n, const double* x, const double* y)
+    {
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        int i = 0;
+        for ( ; i + 16 <= n ; i += 16)
+        {
+            s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), s0);
+            s1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), s1);
+        }
+        if (i < n)
+        {
+            // Masked loads handle the remainder without a scalar tail
+            __mmask8 mask = (n - i >= 8) ? 0xFF : static_cast<__mmask8>((1u << (n - i)) - 1);
+            s0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), s0);
+            i += 8;
+            if (i < n)
+            {
+                mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+                s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), s1);
+            }
+        }
+        return _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+    }
+
+    __attribute__((target("avx512f")))
+    void AxpyAvx512(int n, double alpha, const double* x, double* y)
+    {
+        __m512d a = _mm512_set1_pd(alpha);
+        int i = 0;
+        for ( ; i + 8 <= n ; i += 8)
+        {
+            _mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+        }
+        if (i < n)
+        {
+            __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+            __m512d result = _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i));
+            _mm512_mask_storeu_pd(y + i, mask, result);
+        }
+    }
+
+    // Single precision AVX-512, 4 x 32 register tile in 8 zmm accumulators of 16 floats each
+
+    __attribute__((target("avx512f")))
+    void MicroKernelAvx512(int kc, const float* ap, const float* bp, float* c, int ldc)
+    {
+        __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+        __m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+        __m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+        __m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+
+        for (int p = 0 ; p < kc ; p++, ap += MR, bp += 32)
+        {
+            __m512 b0 = _mm512_loadu_ps(bp);
+            __m512 b1 = _mm512_loadu_ps(bp + 16);
+            __m512 a;
+            a = _mm512_set1_ps(ap[0]); c00 = _mm512_fmadd_ps(a, b0, c00); c01 = _mm512_fmadd_ps(a, b1, c01);
+            a = _mm512_set1_ps(ap[1]); c10 = _mm512_fmadd_ps(a, b0, c10); c11 = _mm512_fmadd_ps(a, b1, c11);
+            a = _mm512_set1_ps(ap[2]); c20 = _mm512_fmadd_ps(a, b0, c20); c21 = _mm512_fmadd_ps(a, b1, c21);
+            a = _mm512_set1_ps(ap[3]); c30 = _mm512_fmadd_ps(a, b0, c30); c31 = _mm512_fmadd_ps(a, b1, c31);
+        }
+
+        float* c0 = c;
+        float* c1 = c + ldc;
+        float* c2 = c + 2 * ldc;
+        float* c3 = c + 3 * ldc;
+        _mm512_storeu_ps(c0, _mm512_add_ps(_mm512_loadu_ps(c0), c00)); _mm512_storeu_ps(c0 + 16, _mm512_add_ps(_mm512_loadu_ps(c0 + 16), c01));
+        _mm512_storeu_ps(c1, _mm512_add_ps(_mm512_loadu_ps(c1), c10)); _mm512_storeu_ps(c1 + 16, _mm512_add_ps(_mm512_loadu_ps(c1 + 16), c11));
+        _mm512_storeu_ps(c2, _mm512_add_ps(_mm512_loadu_ps(c2), c20)); _mm512_storeu_ps(c2 + 16, _mm512_add_ps(_mm512_loadu_ps(c2 + 16), c21));
+        _mm512_storeu_ps(c3, _mm512_add_ps(_mm512_loadu_ps(c3), c30)); _mm512_storeu_ps(c3 + 16, _mm512_add_ps(_mm512_loadu_ps(c3 + 16), c31));
+    }
+
+    __attribute__((target("avx512f")))
+    float DotAvx512(int n, const float* x, const float* y)
+    {
+        __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+        int i = 0;
+        for ( ; i + 32 <= n ; i += 32)
+        {
+            s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), s0);
+            s1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), s1);
+        }
+        for ( ; i < n ; i += 16)
+        {
+            __mmask16 mask = (n - i >= 16) ? 0xFFFF : static_cast<__mmask16>((1u << (n - i)) - 1);
+            s0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), s0);
+        }
+        return _mm512_reduce_add_ps(_mm512_add_ps(s0, s1));
+    }
+
+    __attribute__((target("avx512f")))
+    void AxpyAvx512(int n, float alpha, const float* x, float* y)
+    {
+        __m512 a = _mm512_set1_ps(alpha);
+        int i = 0;
+        for ( ; i + 16 <= n ; i += 16)
+        {
+            _mm512_storeu_ps(y + i, _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+        }
+        if (i < n)
+        {
+            __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+            __m512 result = _mm512_fmadd_ps(a, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i));
+            _mm512_mask_storeu_ps(y + i, mask, result);
+        }
+    }
+
+    // Mixed precision AVX-512, float panels widened to double on load into a 4 x 16 tile of double accumulators
+
+    /// Adds eight double accumulators to eight floats of C
+    __attribute__((target("avx512f"), always_inline))
+    inline void AddMixedAvx512(float* c, __m512d acc)
+    {
+        _mm256_storeu_ps(c, _mm512_cvtpd_ps(_mm512_add_pd(_mm512_cvtps_pd(_mm256_loadu_ps(c)), acc)));
+    }
+
+    __attribute__((target("avx512f")))
+    void MicroKernelMixedAvx512(int kc, const float* ap, const float* bp, float* c, int ldc)
+    {
+        __m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd();
+        __m512d c10 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+        __m512d c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+        __m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd();
+
+        for (int p = 0 ; p < kc ; p++, ap += MR, bp += 16)
+        {
+            __m512d b0 = _mm512_cvtps_pd(_mm256_loadu_ps(bp));
+            __m512d b1 = _mm512_cvtps_pd(_mm256_loadu_ps(bp + 8));
+            __m512d a;
+            a = _mm512_set1_pd(ap[0]); c00 = _mm512_fmadd_pd(a, b0, c00); c01 = _mm512_fmadd_pd(a, b1, c01);
+            a = _mm512_set1_pd(ap[1]); c10 = _mm512_fmadd_pd(a, b0, c10); c11 = _mm512_fmadd_pd(a, b1, c11);
+            a = _mm512_set1_pd(ap[2]); c20 = _mm512_fmadd_pd(a, b0, c20); c21 = _mm512_fmadd_pd(a, b1, c21);
+            a = _mm512_set1_pd(ap[3]); c30 = _mm512_fmadd_pd(a, b0, c30); c31 = _mm512_fmadd_pd(a, b1, c31);
+        }
+
+        AddMixedAvx512(c, c00);           AddMixedAvx512(c + 8, c01);
+        AddMixedAvx512(c + ldc, c10);     AddMixedAvx512(c + ldc + 8, c11);
+        AddMixedAvx512(c + 2 * ldc, c20); AddMixedAvx512(c + 2 * ldc + 8, c21);
+        AddMixedAvx512(c + 3 * ldc, c30); AddMixedAvx512(c + 3 * ldc + 8, c31);
+    }
+
+    __attribute__((target("avx512f")))
+    double DotMixedAvx512(int n, const float* x, const float* y)
+    {
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        int i = 0;
+        for ( ; i + 16 <= n ; i += 16)
+        {
+            s0 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(x + i)), _mm512_cvtps_pd(_mm256_loadu_ps(y + i)), s0);
+            s1 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(x + i + 8)), _mm512_cvtps_pd(_mm256_loadu_ps(y + i + 8)), s1);
+        }
+        for ( ; i < n ; i += 8)
+        {
+            const __mmask16 mask = (n - i >= 8) ? 0xFF : static_cast<__mmask16>((1u << (n - i)) - 1);
+            __m512d left = _mm512_cvtps_pd(_mm512_castps512_ps256(_mm512_maskz_loadu_ps(mask, x + i)));
+            __m512d right = _mm512_cvtps_pd(_mm512_castps512_ps256(_mm512_maskz_loadu_ps(mask, y + i)));
+            s0 = _mm512_fmadd_pd(left, right, s0);
+        }
+        return _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+    }
+
+    // Quantized kernels, four rows of B at a time against one row of A
+
+    __attribute__((target("avx2"), always_inline))
+    inline __m256i MultiplyAddAvx2(__m256i a, const int8_t* b, __m256i ones, __m256i sum)
+    {
+        // maddubs sums adjacent u8 x s8 products into 16 bits, which cannot saturate while A stays below 128, and madd
+        // then sums adjacent pairs of those into 32 bits
+        __m256i pairs = _mm256_maddubs_epi16(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)));
+        return _mm256_add_epi32(sum, _mm256_madd_epi16(pairs, ones));
+    }
+
+    __attribute__((target("avx2"), always_inline))
+    inline int32_t HorizontalSumAvx2(__m256i v)
+    {
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(sum);
+    }
+
+    __attribute__((target("avx2")))
+    void QuantizedRowAvx2(int n, int k, const uint8_t* a, const int8_t* b, int ldb, int32_t* c)
+    {
+        const __m256i ones = _mm256_set1_epi16(1);
+        const int k32 = k & ~31;
+        int j = 0;
+        for ( ; j + 4 <= n ; j += 4)
+        {
+            const int8_t* b0 = b + static_cast<size_t>(j) * ldb;
+            const int8_t* b1 = b0 + ldb;
+            const int8_t* b2 = b1 + ldb;
+            const int8_t* b3 = b2 + ldb;
+            __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+            __m256i s2 = _mm256_setzero_si256(), s3 = _mm256_setzero_si256();
+            for (int p = 0 ; p < k32 ; p += 32)
+            {
+                __m256i av = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p));
+                s0 = MultiplyAddAvx2(av, b0 + p, ones, s0);
+                s1 = MultiplyAddAvx2(av, b1 + p, ones, s1);
+                s2 = MultiplyAddAvx2(av, b2 + p, ones, s2);
+                s3 = MultiplyAddAvx2(av, b3 + p, ones, s3);
+            }
+
+            int32_t t0 = HorizontalSumAvx2(s0), t1 = HorizontalSumAvx2(s1);
+            int32_t t2 = HorizontalSumAvx2(s2), t3 = HorizontalSumAvx2(s3);
+            for (int p = k32 ; p < k ; p++)
+            {
+                t0 += a[p] * b0[p];
+                t1 += a[p] * b1[p];
+                t2 += a[p] * b2[p];
+                t3 += a[p] * b3[p];
+            }
+            c[j] = t0;
+            c[j + 1] = t1;
+            c[j + 2] = t2;
+            c[j + 3] = t3;
+        }
+        for ( ; j < n ; j++)
+        {
+            const int8_t* row = b + static_cast<size_t>(j) * ldb;
+            __m256i sum = _mm256_setzero_si256();
+            for (int p = 0 ; p < k32 ; p += 32)
+            {
+                sum = MultiplyAddAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p)), row + p, ones, sum);
+            }
+            int32_t total = HorizontalSumAvx2(sum);
+            for (int p = k32 ; p < k ; p++)
+            {
+                total += a[p] * row[p];
+            }
+            c[j] = total;
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void QuantizeAvx2(int n, const float* x, float inverseScale, float zeroPoint, uint8_t* q)
+    {
+        // Values are clamped while still floats, so that nothing is out of range when cvtps rounds them (halfway cases to
+        // even, like nearbyint), and the integers are then narrowed to bytes. The multiply and add are kept separate so
+        // that every instruction set rounds exactly like the scalar code.
+        const __m256 scale = _mm256_set1_ps(inverseScale), zero = _mm256_set1_ps(zeroPoint);
+        const __m256 low = _mm256_setzero_ps(), high = _mm256_set1_ps(QuantizedLimit);
+        int i = 0;
+        for ( ; i + 8 <= n ; i += 8)
+        {
+            __m256 value = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(x + i), scale), zero);
+            __m256i integers = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(value, low), high));
+            __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(q + i), _mm_packus_epi16(words, words));
+        }
+        QuantizeScalar(n - i, x + i, inverseScale, zeroPoint, q + i);
+    }
+
+    __attribute__((target("avx512f")))
+    void QuantizeAvx512(int n, const float* x, float inverseScale, float zeroPoint, uint8_t* q)
+    {
+        const __m512 scale = _mm512_set1_ps(inverseScale), zero = _mm512_set1_ps(zeroPoint);
+        const __m512 low = _mm512_setzero_ps(), high = _mm512_set1_ps(QuantizedLimit);
+        int i = 0;
+        for ( ; i + 16 <= n ; i += 16)
+        {
+            __m512 value = _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(x + i), scale), zero);
+            __m512i integers = _mm512_cvtps_epi32(_mm512_min_ps(_mm512_max_ps(value, low), high));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(q + i), _mm512_cvtepi32_epi8(integers));
+        }
+        QuantizeScalar(n - i, x + i, inverseScale, zeroPoint, q + i);
+    }
+
+    __attribute__((target("avx512f,avx512bw,avx512vnni")))
+    void QuantizedRowVnni(int n, int k, const uint8_t* a, const int8_t* b, int ldb, int32_t* c)
+    {
+        // vpdpbusd sums groups of four u8 x s8 products straight into 32 bits, the tail is handled with masked loads
+        const int k64 = k & ~63;
+        const __mmask64 tail = (k > k64) ? (~0ULL >> (64 - (k - k64))) : 0;
+        int j = 0;
+        for ( ; j + 4 <= n ; j += 4)
+        {
+            const int8_t* b0 = b + static_cast<size_t>(j) * ldb;
+            const int8_t* b1 = b0 + ldb;
+            const int8_t* b2 = b1 + ldb;
+            const int8_t* b3 = b2 + ldb;
+            __m512i s0 = _mm512_setzero_si512(), s1 = _mm512_setzero_si512();
+            __m512i s2 = _mm512_setzero_si512(), s3 = _mm512_setzero_si512();
+            for (int p = 0 ; p < k64 ; p += 64)
+            {
+                __m512i av = _mm512_loadu_si512(a + p);
+                s0 = _mm512_dpbusd_epi32(s0, av, _mm512_loadu_si512(b0 + p));
+                s1 = _mm512_dpbusd_epi32(s1, av, _mm512_loadu_si512(b1 + p));
+                s2 = _mm512_dpbusd_epi32(s2, av, _mm512_loadu_si512(b2 + p));
+                s3 = _mm512_dpbusd_epi32(s3, av, _mm512_loadu_si512(b3 + p));
+            }
+            if (tail)
+            {
+                __m512i av = _mm512_maskz_loadu_epi8(tail, a + k64);
+                s0 = _mm512_dpbusd_epi32(s0, av, _mm512_maskz_loadu_epi8(tail, b0 + k64));
+                s1 = _mm512_dpbusd_epi32(s1, av, _mm512_maskz_loadu_epi8(tail, b1 + k64));
+                s2 = _mm512_dpbusd_epi32(s2, av, _mm512_maskz_loadu_epi8(tail, b2 + k64));
+                s3 = _mm512_dpbusd_epi32(s3, av, _mm512_maskz_loadu_epi8(tail, b3 + k64));
+            }
+            c[j] = _mm512_reduce_add_epi32(s0);
+            c[j + 1] = _mm512_reduce_add_epi32(s1);
+            c[j + 2] = _mm512_reduce_add_epi32(s2);
+            c[j + 3] = _mm512_reduce_add_epi32(s3);
+        }
+        for ( ; j < n ; j++)
+        {
+            const int8_t* row = b + static_cast<size_t>(j) * ldb;
+            __m512i sum = _mm512_setzero_si512();
+            for (int p = 0 ; p < k64 ; p += 64)
+            {
+                sum = _mm512_dpbusd_epi32(sum, _mm512_loadu_si512(a + p), _mm512_loadu_si512(row + p));
+            }
+            if (tail)
+            {
+                sum = _mm512_dpbusd_epi32(sum, _mm512_maskz_loadu_epi8(tail, a + k64), _mm512_maskz_loadu_epi8(tail, row + k64));
+            }
+            c[j] = _mm512_reduce_add_epi32(sum);
+        }
+    }
+
+    // Optimizer steps. Each instruction set has one loop per optimizer, written against the vector operations below so that
+    // it serves both precisions, and leaves the last few elements to the scalar step.
+
+    struct Avx2Double
+    {
+        using Scalar = double;
+        using Vector = __m256d;
+        static constexpr int Width = 4;
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Set(double x) { return _mm256_set1_pd(x); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Load(const double* p) { return _mm256_loadu_pd(p); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline void Store(double* p, Vector x) { _mm256_storeu_pd(p, x); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Add(Vector x, Vector y) { return _mm256_add_pd(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Mul(Vector x, Vector y) { return _mm256_mul_pd(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Div(Vector x, Vector y) { return _mm256_div_pd(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Sqrt(Vector x) { return _mm256_sqrt_pd(x); }
+        /// x * y + z
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector MulAdd(Vector x, Vector y, Vector z) { return _mm256_fmadd_pd(x, y, z); }
+        /// z - x * y
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector NegMulAdd(Vector x, Vector y, Vector z) { return _mm256_fnmadd_pd(x, y, z); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Sub(Vector x, Vector y) { return _mm256_sub_pd(x, y); }
+        /// See ScalarOperations for these three
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Min(Vector x, Vector y) { return _mm256_min_pd(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Max(Vector x, Vector y) { return _mm256_max_pd(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Select(Vector a, Vector b, Vector x, Vector y) { return _mm256_blendv_pd(y, x, _mm256_cmp_pd(a, b, _CMP_GT_OQ)); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Pow2(Vector shifted) { return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(_mm256_castpd_si256(shifted), _mm256_set1_epi64x(1023)), 52)); }
+    };
+
+    struct Avx2Float
+    {
+        using Scalar = float;
+        using Vector = __m256;
+        static constexpr int Width = 8;
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Set(float x) { return _mm256_set1_ps(x); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Load(const float* p) { return _mm256_loadu_ps(p); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline void Store(float* p, Vector x) { _mm256_storeu_ps(p, x); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Add(Vector x, Vector y) { return _mm256_add_ps(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Mul(Vector x, Vector y) { return _mm256_mul_ps(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Div(Vector x, Vector y) { return _mm256_div_ps(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Sqrt(Vector x) { return _mm256_sqrt_ps(x); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector MulAdd(Vector x, Vector y, Vector z) { return _mm256_fmadd_ps(x, y, z); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector NegMulAdd(Vector x, Vector y, Vector z) { return _mm256_fnmadd_ps(x, y, z); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Sub(Vector x, Vector y) { return _mm256_sub_ps(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Min(Vector x, Vector y) { return _mm256_min_ps(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Max(Vector x, Vector y) { return _mm256_max_ps(x, y); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Select(Vector a, Vector b, Vector x, Vector y) { return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+        __attribute__((target("avx2,fma"), always_inline)) static inline Vector Pow2(Vector shifted) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_castps_si256(shifted), _mm256_set1_epi32(127)), 23)); }
+    };
+
+    struct Avx512Double
+    {
+        using Scalar = double;
+        using Vector = __m512d;
+        static constexpr int Width = 8;
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Set(double x) { return _mm512_set1_pd(x); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Load(const double* p) { return _mm512_loadu_pd(p); }
+        __attribute__((target("avx512f"), always_inline)) static inline void Store(double* p, Vector x) { _mm512_storeu_pd(p, x); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Add(Vector x, Vector y) { return _mm512_add_pd(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Mul(Vector x, Vector y) { return _mm512_mul_pd(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Div(Vector x, Vector y) { return _mm512_div_pd(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Sqrt(Vector x) { return _mm512_sqrt_pd(x); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector MulAdd(Vector x, Vector y, Vector z) { return _mm512_fmadd_pd(x, y, z); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector NegMulAdd(Vector x, Vector y, Vector z) { return _mm512_fnmadd_pd(x, y, z); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Sub(Vector x, Vector y) { return _mm512_sub_pd(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Min(Vector x, Vector y) { return _mm512_min_pd(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Max(Vector x, Vector y) { return _mm512_max_pd(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Select(Vector a, Vector b, Vector x, Vector y) { return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ), y, x); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Pow2(Vector shifted) { return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_add_epi64(_mm512_castpd_si512(shifted), _mm512_set1_epi64(1023)), 52)); }
+    };
+
+    struct Avx512Float
+    {
+        using Scalar = float;
+        using Vector = __m512;
+        static constexpr int Width = 16;
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Set(float x) { return _mm512_set1_ps(x); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Load(const float* p) { return _mm512_loadu_ps(p); }
+        __attribute__((target("avx512f"), always_inline)) static inline void Store(float* p, Vector x) { _mm512_storeu_ps(p, x); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Add(Vector x, Vector y) { return _mm512_add_ps(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Mul(Vector x, Vector y) { return _mm512_mul_ps(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Div(Vector x, Vector y) { return _mm512_div_ps(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Sqrt(Vector x) { return _mm512_sqrt_ps(x); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector MulAdd(Vector x, Vector y, Vector z) { return _mm512_fmadd_ps(x, y, z); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector NegMulAdd(Vector x, Vector y, Vector z) { return _mm512_fnmadd_ps(x, y, z); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Sub(Vector x, Vector y) { return _mm512_sub_ps(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Min(Vector x, Vector y) { return _mm512_min_ps(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Max(Vector x, Vector y) { return _mm512_max_ps(x, y); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Select(Vector a, Vector b, Vector x, Vector y) { return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a, b, _CMP_GT_OQ), y, x); }
+        __attribute__((target("avx512f"), always_inline)) static inline Vector Pow2(Vector shifted) { return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_castps_si512(shifted), _mm512_set1_epi32(127)), 23)); }
+    };
+
+    /// Loop bodies shared by both instruction sets, which each wrap them in a function compiled for their target. Inlined
+    /// into those wrappers, the vector operations are compiled for the wrapper's target.
+#define NN_SGD_STEP_LOOP                                                                                                    \
+        const Vector rate = V::Set(step.learningRate), scale = V::Set(step.gradientScale);                                 \
+        const Vector l2 = V::Set(step.l2), decay = V::Set(step.decay);                                                      \
+        int i = 0;                                                                                                          \
+        for ( ; i + V::Width <= n ; i += V::Width)                                                                          \
+        {                                                                                                                   \
+            const Vector parameter = V::Load(parameters + i);                                                               \
+            const Vector gradient = V::MulAdd(scale, V::Load(gradients + i), V::Mul(l2, parameter));                        \
+            V::Store(parameters + i, V::NegMulAdd(rate, V::MulAdd(decay, parameter, gradient), parameter));                 \
+        }                                                                                                                   \
+        SgdStepScalar(n - i, step, parameters + i, gradients + i);
+
+#define NN_MOMENTUM_STEP_LOOP                                                                                               \
+        const Vector rate = V::Set(step.learningRate), scale = V::Set(step.gradientScale);                                 \
+        const Vector l2 = V::Set(step.l2), decay = V::Set(step.decay), momentum = V::Set(step.beta1);                       \
+        int i = 0;                                                                                                          \
+        for ( ; i + V::Width <= n ; i += V::Width)                                                                          \
+        {                                                                                                                   \
+            const Vector parameter = V::Load(parameters + i);                                                               \
+            const Vector gradient = V::MulAdd(scale, V::Load(gradients + i), V::Mul(l2, parameter));                        \
+            const Vector updated = V::MulAdd(momentum, V::Load(velocity + i), gradient);                                    \
+            V::Store(velocity + i, updated);                                                                                \
+            V::Store(parameters + i, V::NegMulAdd(rate, V::MulAdd(decay, parameter, updated), parameter));                  \
+        }                                                                                                                   \
+        MomentumStepScalar(n - i, step, parameters + i, gradients + i, velocity + i);
+
+#define NN_RMSPROP_STEP_LOOP                                                                                                \
+        const Vector rate = V::Set(step.learningRate), scale = V::Set(step.gradientScale);                                 \
+        const Vector l2 = V::Set(step.l2), decay = V::Set(step.decay), epsilon = V::Set(step.epsilon);                      \
+        const Vector beta2 = V::Set(step.beta2), secondWeight = V::Set(1 - step.beta2);                                     \
+        int i = 0;                                                                                                          \
+        for ( ; i + V::Width <= n ; i += V::Width)                                                                          \
+        {                                                                                                                   \
+            const Vector parameter = V::Load(parameters + i);                                                               \
+            const Vector gradient = V::MulAdd(scale, V::Load(gradients + i), V::Mul(l2, parameter));                        \
+            const Vector v = V::MulAdd(beta2, V::Load(second + i), V::Mul(V::Mul(secondWeight, gradient), gradient));       \
+            V::Store(second + i, v);                                                                                        \
+            const Vector direction = V::Div(gradient, V::Add(V::Sqrt(v), epsilon));                                        \
+            V::Store(parameters + i, V::NegMulAdd(rate, V::MulAdd(decay, parameter, direction), parameter));                \
+        }                                                                                                                   \
+        RmsPropStepScalar(n - i, step, parameters + i, gradients + i, second + i);
+
+#define NN_ADAM_STEP_LOOP                                                                                                   \
+        const Vector rate = V::Set(step.learningRate), scale = V::Set(step.gradientScale);                                 \
+        const Vector l2 = V::Set(step.l2), decay = V::Set(step.decay), epsilon = V::Set(step.epsilon);                      \
+        const Vector beta1 = V::Set(step.beta1), beta2 = V::Set(step.beta2);                                                \
+        const Vector firstWeight = V::Set(1 - step.beta1), secondWeight = V::Set(1 - step.beta2);                           \
+        const Vector firstCorrection = V::Set(step.firstCorrection), secondCorrection = V::Set(step.secondCorrection);      \
+        int i = 0;                                                                                                          \
+        for ( ; i + V::Width <= n ; i += V::Width)                                                                          \
+        {                                                                                                                   \
+            const Vector parameter = V::Load(parameters + i);                                                               \
+            const Vector gradient = V::MulAdd(scale, V::Load(gradients + i), V::Mul(l2, parameter));                        \
+            const Vector m = V::MulAdd(beta1, V::Load(first + i), V::Mul(firstWeight, gradient));                           \
+            const Vector v = V::MulAdd(beta2, V::Load(second + i), V::Mul(V::Mul(secondWeight, gradient), gradient));       \
+            V::Store(first + i, m);                                                                                         \
+            V::Store(second + i, v);                                                                                        \
+            const Vector direction = V::Div(V::Mul(firstCorrection, m), V::Add(V::Sqrt(V::Mul(secondCorrection, v)), epsilon)); \
+            V::Store(parameters + i, V::NegMulAdd(rate, V::MulAdd(decay, parameter, direction), parameter));                \
+        }                                                                                                                   \
+        AdamStepScalar(n - i, step, parameters + i, gradients + i, first + i, second + i);
+
+    template<typename V, typename T = typename V::Scalar, typename Vector = typename V::Vector>
+    __attribute__((target("avx2,fma")))
+    void SgdStepAvx2(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients)
+    {
+        NN_SGD_STEP_LOOP
+    }
+
+    template<typename V, typename T = typename V::Scalar, typename Vector = typename V::Vector>
+    __attribute__((target("avx2,fma")))
+    void MomentumStepAvx2(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* velocity)
+    {
+        NN_MOMENTUM_STEP_LOOP
+    }
+
+    template<typename V, typename T = typename V::Scalar, typename Vector = typename V::Vector>
+    __attribute__((target("avx2,fma")))
+    void RmsPropStepAvx2(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* second)
+    {
+        NN_RMSPROP_STEP_LOOP
+    }
+
+    template<typename V, typename T = typename V::Scalar, typename Vector = typename V::Vector>
+    __attribute__((target("avx2,fma")))
+    void AdamStepAvx2(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* first, T* second)
+    {
+        NN_ADAM_STEP_LOOP
+    }
+
+    template<typename V, typename T = typename V::Scalar, typename Vector = typename V::Vector>
+    __attribute__((target("avx512f")))
+    void SgdStepAvx512(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients)
+    {
+        NN_SGD_STEP_LOOP
+    }
+
+    template<typename V, typename T = typename V::Scalar, typename Vector = typename V::Vector>
+    __attribute__((target("avx512f")))
+    void MomentumStepAvx512(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* velocity)
+    {
+        NN_MOMENTUM_STEP_LOOP
+    }
+
+    template<typename V, typename T = typename V::Scalar, typename Vector = typename V::Vector>
+    __attribute__((target("avx512f")))
+    void RmsPropStepAvx512(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* second)
+    {
+        NN_RMSPROP_STEP_LOOP
+    }
+
+    template<typename V, typename T = typename V::Scalar, typename Vector = typename V::Vector>
+    __attribute__((target("avx512f")))
+    void AdamStepAvx512(int n, const Kernels::StepParameters<T>& step, T* parameters, const T* gradients, T* first, T* second)
+    {
+        NN_ADAM_STEP_LOOP
+    }
+
+#undef NN_SGD_STEP_LOOP
+#undef NN_MOMENTUM_STEP_LOOP
+#undef NN_RMSPROP_STEP_LOOP
+#undef NN_ADAM_STEP_LOOP
+
+    NN_ACTIVATION_APPROXIMATIONS(Avx2Approximations, __attribute__((target("avx2,fma"))))
+    NN_ACTIVATION_APPROXIMATIONS(Avx512Approximations, __attribute__((target("avx512f"))))
+
+    /// The vector operations of each instruction set for a precision
+    template<typename T>
+    using Avx2Operations = std::conditional_t<std::is_same<T, double>::value, Avx2Double, Avx2Float>;
+    template<typename T>
+    using Avx512Operations = std::conditional_t<std::is_same<T, double>::value, Avx512Double, Avx512Float>;
+
+#endif // NN_KERNELS_X86
+
+#undef NN_ACTIVATION_APPROXIMATIONS
+
+    const KernelTable<double, double> scalarTable = {Kernels::InstructionSet::Scalar, 4, MicroKernelScalar<double, double>, DotScalar<double, double>, AxpyScalar<double>};
+    const KernelTable<float, float> scalarFloatTable = {Kernels::InstructionSet::Scalar, 4, MicroKernelScalar<float, float>, DotScalar<float, float>, AxpyScalar<float>};
+    const KernelTable<float, double> scalarMixedTable = {Kernels::InstructionSet::Scalar, 4, MicroKernelScalar<float, double>, DotScalar<float, double>, AxpyScalar<float>};
+#ifdef NN_KERNELS_X86
+    const KernelTable<double, double> avx2Table = {Kernels::InstructionSet::Avx2, 8, MicroKernelAvx2, DotAvx2, AxpyAvx2};
+    const KernelTable<float, float> avx2FloatTable = {Kernels::InstructionSet::Avx2, 16, MicroKernelAvx2, DotAvx2, AxpyAvx2};
+    const KernelTable<float, double> avx2MixedTable = {Kernels::InstructionSet::Avx2, 8, MicroKernelMixedAvx2, DotMixedAvx2, AxpyAvx2};
+    const KernelTable<double, double> avx512Table = {Kernels::InstructionSet::Avx512, 16, MicroKernelAvx512, DotAvx512, AxpyAvx512};
+    const KernelTable<float, float> avx512FloatTable = {Kernels::InstructionSet::Avx512, 32, MicroKernelAvx512, DotAvx512, AxpyAvx512};
+    const KernelTable<float, double> avx512MixedTable = {Kernels::InstructionSet::Avx512, 16, MicroKernelMixedAvx512, DotMixedAvx512, AxpyAvx512};
+#endif
+
+    const OptimizerTable<double> scalarOptimizerTable = {SgdStepScalar<double>, MomentumStepScalar<double>, RmsPropStepScalar<double>, AdamStepScalar<double>};
+    const OptimizerTable<float> scalarFloatOptimizerTable = {SgdStepScalar<float>, MomentumStepScalar<float>, RmsPropStepScalar<float>, AdamStepScalar<float>};
+#ifdef NN_KERNELS_X86
+    const OptimizerTable<double> avx2OptimizerTable = {SgdStepAvx2<Avx2Double>, MomentumStepAvx2<Avx2Double>, RmsPropStepAvx2<Avx2Double>, AdamStepAvx2<Avx2Double>};
+    const OptimizerTable<float> avx2FloatOptimizerTable = {SgdStepAvx2<Avx2Float>, MomentumStepAvx2<Avx2Float>, RmsPropStepAvx2<Avx2Float>, AdamStepAvx2<Avx2Float>};
+    const OptimizerTable<double> avx512OptimizerTable = {SgdStepAvx512<Avx512Double>, MomentumStepAvx512<Avx512Double>, RmsPropStepAvx512<Avx512Double>, AdamStepAvx512<Avx512Double>};
+    const OptimizerTable<float> avx512FloatOptimizerTable = {SgdStepAvx512<Avx512Float>, MomentumStepAvx512<Avx512Float>, RmsPropStepAvx512<Avx512Float>, AdamStepAvx512<Avx512Float>};
+#endif
+
+    /// Picks the table of one precision for an instruction set
+    template<typename T, typename Accumulator>
+    const KernelTable<T, Accumulator>* SelectTable(Kernels::InstructionSet set,
+                                                   const KernelTable<T, Accumulator>* scalar,
+                                                   const KernelTable<T, Accumulator>* avx2,
+                                                   const KernelTable<T, Accumulator>* avx512)
+    {
+        switch (set)
+        {
+            case Kernels::InstructionSet::Avx512: return avx512;
+            case Kernels::InstructionSet::Avx2:   return avx2;
+            default:                              return scalar;
+        }
+    }
+
+    Kernels::InstructionSet& ActiveSet()
+    {
+        static Kernels::InstructionSet set = Kernels::DetectInstructionSet();
+        return set;
+    }
+
+    template<typename T, typename Accumulator>
+    const KernelTable<T, Accumulator>* ActiveTable();
+
+#ifdef NN_KERNELS_X86
+    template<>
+    const KernelTable<double, double>* ActiveTable()
+    {
+        return SelectTable(ActiveSet(), &scalarTable, &avx2Table, &avx512Table);
+    }
+
+    template<>
+    const KernelTable<float, float>* ActiveTable()
+    {
+        return SelectTable(ActiveSet(), &scalarFloatTable, &avx2FloatTable, &avx512FloatTable);
+    }
+
+    template<>
+    const KernelTable<float, double>* ActiveTable()
+    {
+        return SelectTable(ActiveSet(), &scalarMixedTable, &avx2MixedTable, &avx512MixedTable);
+    }
+#else
+    template<>
+    const KernelTable<double, double>* ActiveTable()
+    {
+        return &scalarTable;
+    }
+
+    template<>
+    const KernelTable<float, float>* ActiveTable()
+    {
+        return &scalarFloatTable;
+    }
+
+    template<>
+    const KernelTable<float, double>* ActiveTable()
+    {
+        return &scalarMixedTable;
+    }
+#endif
+
+    template<typename T>
+    const OptimizerTable<T>* ActiveOptimizerTable();
+
+    template<>
+    const OptimizerTable<double>* ActiveOptimizerTable()
+    {
+#ifdef NN_KERNELS_X86
+        switch (ActiveSet())
+        {
+            case Kernels::InstructionSet::Avx512: return &avx512OptimizerTable;
+            case Kernels::InstructionSet::Avx2:   return &avx2OptimizerTable;
+            default:                              break;
+        }
+#endif
+        return &scalarOptimizerTable;
+    }
+
+    template<>
+    const OptimizerTable<float>* ActiveOptimizerTable()
+    {
+#ifdef NN_KERNELS_X86
+        switch (ActiveSet())
+        {
+            case Kernels::InstructionSet::Avx512: return &avx512FloatOptimizerTable;
+            case Kernels::InstructionSet::Avx2:   return &avx2FloatOptimizerTable;
+            default:                              break;
+        }
+#endif
+        return &scalarFloatOptimizerTable;
+    }
+
+    template<typename T>
+    ActivationKernel<T> ActiveActivationKernel()
+    {
+#ifdef NN_KERNELS_X86
+        switch (ActiveSet())
+        {
+            case Kernels::InstructionSet::Avx512: return Avx512Approximations::Run<Avx512Operations<T>>;
+            case Kernels::InstructionSet::Avx2:   return Avx2Approximations::Run<Avx2Operations<T>>;
+            default:                              break;
+        }
+#endif
+        return ScalarApproximations::Run<ScalarOperations<T>>;
+    }
+
+    /// Picks the quantized kernel for the active instruction set, using VNNI where the CPU has it
+    QuantizedRowKernel ActiveQuantizedKernel()
+    {
+#ifdef NN_KERNELS_X86
+        switch (ActiveSet())
+        {
+            case Kernels::InstructionSet::Avx512:
+                if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni"))
+                {
+                    return QuantizedRowVnni;
+                }
+                return QuantizedRowAvx2;
+            case Kernels::InstructionSet::Avx2:
+                return QuantizedRowAvx2;
+            default:
+                break;
+        }
+#endif
+        return QuantizedRowScalar;
+    }
+
+    /// Picks the quantization routine for the active instruction set
+    using QuantizeKernel = void (*)(int n, const float* x, float inverseScale, float zeroPoint, uint8_t* q);
+    QuantizeKernel ActiveQuantizeKernel()
+    {
+#ifdef NN_KERNELS_X86
+        switch (ActiveSet())
+        {
+            case Kernels::InstructionSet::Avx512: return QuantizeAvx512;
+            case Kernels::InstructionSet::Avx2:   return QuantizeAvx2;
+            default:                              break;
+        }
+#endif
+        return QuantizeScalar;
+    }
+
+    /// Packs op(A)[rows x kc] into panels of MR rows, scaled by alpha and zero padded to a multiple of MR
+    template<typename T>
+    void PackA(bool transA, const T* a, int lda, int rows, int kc, T alpha, T* packed)
+    {
+        for (int i0 = 0 ; i0 < rows ; i0 += MR)
+        {
+            const int mr = std::min(MR, rows - i0);
+            for (int p = 0 ; p < kc ; p++)
+            {
+                for (int i = 0 ; i < MR ; i++)
+                {
+                    T value = 0;
+                    if (i < mr)
+                    {
+                        value = transA ? a[static_cast<size_t>(p) * lda + i0 + i] : a[static_cast<size_t>(i0 + i) * lda + p];
+                    }
+                    *packed++ = alpha * value;
+                }
+            }
+        }
+    }
+
+    /// Packs op(B)[kc x cols] into panels of nr columns, zero padded to a multiple of nr
+    template<typename T>
+    void PackB(bool transB, const T* b, int ldb, int kc, int cols, int nr, T* packed)
+    {
+        for (int j0 = 0 ; j0 < cols ; j0 += nr)
+        {
+            const int ncols = std::min(nr, cols - j0);
+            for (int p = 0 ; p < kc ; p++)
+            {
+                for (int j = 0 ; j < nr ; j++)
+                {
+                    T value = 0;
+                    if (j < ncols)
+                    {
+                        value = transB ? b[static_cast<size_t>(j0 + j) * ldb + p] : b[static_cast<size_t>(p) * ldb + j0 + j];
+                    }
+                    *packed++ = value;
+                }
+            }
+        }
+    }
+
+    template<typename T>
+    void ScaleMatrix(int m, int n, T beta, T* c, int ldc)
+    {
+        if (beta == 1)
+        {
+            return;
+        }
+        for (int i = 0 ; i < m ; i++)
+        {
+            T* row = c + static_cast<size_t>(i) * ldc;
+            if (beta == 0)
+            {
+                std::fill(row, row + n, T(0));
+            }
+            else
+            {
+                for (int j = 0 ; j < n ; j++)
+                {
+                    row[j] *= beta;
+                }
+            }
+        }
+    }
+}
+
+Kernels::InstructionSet Kernels::DetectInstructionSet()
+{
+#ifdef NN_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return InstructionSet::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return InstructionSet::Avx2;
+    }
+#endif
+    return InstructionSet::Scalar;
+}
+
+Kernels::InstructionSet Kernels::GetInstructionSet()
+{
+    return ActiveSet();
+}
+
+void Kernels::SetInstructionSet(InstructionSet set)
+{
+    if (static_cast<int>(set) > static_cast<int>(DetectInstructionSet()))
+    {
+        throw(std::invalid_argument("Instruction set is not supported by this CPU"));
+    }
+    ActiveSet() = set;
+}
+
+const char* Kernels::GetInstructionSetName(InstructionSet set)
+{
+    switch (set)
+    {
+        case InstructionSet::Avx512: return "avx512";
+        case InstructionSet::Avx2:   return "avx2";
+        default:                     return "scalar";
+    }
+}
+
+template<typename T, typename Accumulator>
+void Kernels::Gemm(bool transA, bool transB, int m, int n, int k,
+                   typename NonDeduced<T>::Type alpha, const T* a, int lda, const T* b, int ldb,
+                   typename NonDeduced<T>::Type beta, T* c, int ldc)
+{
+    if (m <= 0 || n <= 0)
+    {
+        return;
+    }
+
+    ScaleMatrix(m, n, beta, c, ldc);
+    if (k <= 0 || alpha == 0)
+    {
+        return;
+    }
+
+    // Degenerate shapes are memory bound and are better served by the vector kernels than by packing
+    if (m == 1)
+    {
+        // The single row of C is op(A) * op(B), i.e. op(B)^T times the single row or column of A
+        if (transA)
+        {
+            for (int p = 0 ; p < k ; p++)
+            {
+                T value = alpha * a[static_cast<size_t>(p) * lda];
+                if (transB) { for (int j = 0 ; j < n ; j++) { c[j] += value * b[static_cast<size_t>(j) * ldb + p]; } }
+                else        { Axpy(n, value, b + static_cast<size_t>(p) * ldb, c); }
+            }
+        }
+        else
+        {
+            Gemv<T, Accumulator>(!transB, transB ? n : k, transB ? k : n, alpha, b, ldb, a, 1, c);
+        }
+        return;
+    }
+    if (k == 1 && !transB)
+    {
+        // Column of A times a contiguous row of B, an outer product
+        for (int i = 0 ; i < m ; i++)
+        {
+            Axpy(n, alpha * (transA ? a[i] : a[static_cast<size_t>(i) * lda]), b, c + static_cast<size_t>(i) * ldc);
+        }
+        return;
+    }
+
+    const KernelTable<T, Accumulator>* table = ActiveTable<T, Accumulator>();
+    const int nr = table->nr;
+
+    // Packing buffers are reused across calls so that steady-state multiplies do not allocate
+    thread_local std::vector<T> packedA;
+    thread_local std::vector<T> packedB;
+    packedA.resize(static_cast<size_t>(MC + MR) * KC);
+    packedB.resize(static_cast<size_t>(NC + nr) * KC);
+    T edge[MR * MaxNR];
+
+    for (int jc = 0 ; jc < n ; jc += NC)
+    {
+        const int nc = std::min(NC, n - jc);
+        for (int pc = 0 ; pc < k ; pc += KC)
+        {
+            const int kc = std::min(KC, k - pc);
+            const T* bBlock = transB ? b + static_cast<size_t>(jc) * ldb + pc : b + static_cast<size_t>(pc) * ldb + jc;
+            PackB(transB, bBlock, ldb, kc, nc, nr, packedB.data());
+
+            for (int ic = 0 ; ic < m ; ic += MC)
+            {
+                const int mc = std::min(MC, m - ic);
+                const T* aBlock = transA ? a + static_cast<size_t>(pc) * lda + ic : a + static_cast<size_t>(ic) * lda + pc;
+                PackA(transA, aBlock, lda, mc, kc, static_cast<T>(alpha), packedA.data());
+
+                for (int jr = 0 ; jr < nc ; jr += nr)
+                {
+                    const int ncols = std::min(nr, nc - jr);
+                    const T* bp = packedB.data() + static_cast<size_t>(jr / nr) * nr * kc;
+                    for (int ir = 0 ; ir < mc ; ir += MR)
+                    {
+                        const int mrows = std::min(MR, mc - ir);
+                        const T* ap = packedA.data() + static_cast<size_t>(ir / MR) * MR * kc;
+                        T* cTile = c + static_cast<size_t>(ic + ir) * ldc + jc + jr;
+
+                        if (mrows == MR && ncols == nr)
+                        {
+                            table->microKernel(kc, ap, bp, cTile, ldc);
+                        }
+                        else
+                        {
+                            // Partial tiles at the matrix edges go through a scratch tile
+                            std::fill(edge, edge + MR * nr, T(0));
+                            table->microKernel(kc, ap, bp, edge, nr);
+                            for (int i = 0 ; i < mrows ; i++)
+                            {
+                                for (int j = 0 ; j < ncols ; j++)
+                                {
+                                    cTile[static_cast<size_t>(i) * ldc + j] += edge[i * nr + j];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<typename T, typename Accumulator>
+void Kernels::Gemv(bool transA, int m, int n, typename NonDeduced<T>::Type alpha, const T* a, int lda, const T* x,
+                   typename NonDeduced<T>::Type beta, T* y)
+{
+    const KernelTable<T, Accumulator>* table = ActiveTable<T, Accumulator>();
+    const int outputs = transA ? n : m;
+    ScaleMatrix(1, outputs, beta, y, outputs);
+    if (alpha == 0)
+    {
+        return;
+    }
+
+    if (transA)
+    {
+        // y += alpha * A^T x is a sum of the rows of A scaled by x
+        for (int i = 0 ; i < m ; i++)
+        {
+            table->axpy(n, alpha * x[i], a + static_cast<size_t>(i) * lda, y);
+        }
+    }
+    else
+    {
+        for (int i = 0 ; i < m ; i++)
+        {
+            y[i] += static_cast<T>(alpha * table->dot(n, a + static_cast<size_t>(i) * lda, x));
+        }
+    }
+}
+
+template<typename T>
+void Kernels::Ger(int m, int n, typename NonDeduced<T>::Type alpha, const T* x, const T* y, T* a, int lda)
+{
+    const KernelTable<T, T>* table = ActiveTable<T, T>();
+    for (int i = 0 ; i < m ; i++)
+    {
+        table->axpy(n, alpha * x[i], y, a + static_cast<size_t>(i) * lda);
+    }
+}
+
+template<typename T, typename Accumulator>
+Accumulator Kernels::Dot(int n, const T* x, const T* y)
+{
+    return ActiveTable<T, Accumulator>()->dot(n, x, y);
+}
+
+template<typename T>
+void Kernels::Axpy(int n, typename NonDeduced<T>::Type alpha, const T* x, T* y)
+{
+    ActiveTable<T, T>()->axpy(n, alpha, x, y);
+}
+
+void Kernels::QuantizedGemm(int m, int n, int k, const uint8_t* a, int lda, const int8_t* b, int ldb, int32_t* c, int ldc)
+{
+    const QuantizedRowKernel kernel = ActiveQuantizedKernel();
+
+    // Every row of A is run against one L1 sized block of rows of B before moving on to the next block
+    const int blockRows = std::max(4, QuantizedBlockBytes / std::max(k, 1) / 4 * 4);
+    for (int j0 = 0 ; j0 < n ; j0 += blockRows)
+    {
+        const int rows = std::min(blockRows, n - j0);
+        for (int i = 0 ; i < m ; i++)
+        {
+            kernel(rows, k, a + static_cast<size_t>(i) * lda, b + static_cast<size_t>(j0) * ldb, ldb, c + static_cast<size_t>(i) * ldc + j0);
+        }
+    }
+}
+
+void Kernels::Quantize(int n, const float* x, float scale, int zeroPoint, uint8_t* q)
+{
+    ActiveQuantizeKernel()(n, x, 1.0f / scale, static_cast<float>(zeroPoint), q);
+}
+
+template<typename T>
+void Kernels::SgdStep(int n, const StepParameters<T>& step, T* parameters, const T* gradients)
+{
+    ActiveOptimizerTable<T>()->sgd(n, step, parameters, gradients);
+}
+
+template<typename T>
+void Kernels::MomentumStep(int n, const StepParameters<T>& step, T* parameters, const T* gradients, T* velocity)
+{
+    ActiveOptimizerTable<T>()->momentum(n, step, parameters, gradients, velocity);
+}
+
+template<typename T>
+void Kernels::RmsPropStep(int n, const StepParameters<T>& step, T* parameters, const T* gradients, T* second)
+{
+    ActiveOptimizerTable<T>()->rmsProp(n, step, parameters, gradients, second);
+}
+
+template<typename T>
+void Kernels::AdamStep(int n, const StepParameters<T>& step, T* parameters, const T* gradients, T* first, T* second)
+{
+    ActiveOptimizerTable<T>()->adam(n, step, parameters, gradients, first, second);
+}
+
+template<typename T>
+void Kernels::ApproximateActivation(SmoothFunction function, size_t n, const T* inputs, T* outputs, T* derivatives)
+{
+    ActiveActivationKernel<T>()(function, n, inputs, outputs, derivatives);
+}
+
+template<typename T>
+void Kernels::Reference::Gemm(bool transA, bool transB, int m, int n, int k,
+                              typename NonDeduced<T>::Type alpha, const T* a, int lda, const T* b, int ldb,
+                              typename NonDeduced<T>::Type beta, T* c, int ldc)
+{
+    for (int i = 0 ; i < m ; i++)
+    {
+        for (int j = 0 ; j < n ; j++)
+        {
+            double sum = 0;
+            for (int p = 0 ; p < k ; p++)
+            {
+                double left = transA ? a[static_cast<size_t>(p) * lda + i] : a[static_cast<size_t>(i) * lda + p];
+                double right = transB ? b[static_cast<size_t>(j) * ldb + p] : b[static_cast<size_t>(p) * ldb + j];
+                sum += left * right;
+            }
+            T& out = c[static_cast<size_t>(i) * ldc + j];
+            out = static_cast<T>(alpha * sum + (beta == 0 ? 0 : beta * static_cast<double>(out)));
+        }
+    }
+}
+
+template<typename T>
+void Kernels::Reference::Gemv(bool transA, int m, int n, typename NonDeduced<T>::Type alpha, const T* a, int lda, const T* x,
+                              typename NonDeduced<T>::Type beta, T* y)
+{
+    const int outputs = transA ? n : m;
+    const int inputs = transA ? m : n;
+    for (int i = 0 ; i < outputs ; i++)
+    {
+        double sum = 0;
+        for (int p = 0 ; p < inputs ; p++)
+        {
+            sum += static_cast<double>(transA ? a[static_cast<size_t>(p) * lda + i] : a[static_cast<size_t>(i) * lda + p]) * x[p];
+        }
+        y[i] = static_cast<T>(alpha * sum + (beta == 0 ? 0 : beta * static_cast<double>(y[i])));
+    }
+}
+
+template<typename T>
+void Kernels::Reference::Ger(int m, int n, typename NonDeduced<T>::Type alpha, const T* x, const T* y, T* a, int lda)
+{
+    for (int i = 0 ; i < m ; i++)
+    {
+        for (int j = 0 ; j < n ; j++)
+        {
+            a[static_cast<size_t>(i) * lda + j] += alpha * x[i] * y[j];
+        }
+    }
+}
+
+void Kernels::Reference::QuantizedGemm(int m, int n, int k, const uint8_t* a, int lda, const int8_t* b, int ldb, int32_t* c, int ldc)
+{
+    for (int i = 0 ; i < m ; i++)
+    {
+        for (int j = 0 ; j < n ; j++)
+        {
+            int32_t sum = 0;
+            for (int p = 0 ; p < k ; p++)
+            {
+                sum += static_cast<int32_t>(a[static_cast<size_t>(i) * lda + p]) * b[static_cast<size_t>(j) * ldb + p];
+            }
+            c[static_cast<size_t>(i) * ldc + j] = sum;
+        }
+    }
+}
+
+// Supported precisions
+template void Kernels::Gemm<double, double>(bool, bool, int, int, int, double, const double*, int, const double*, int, double, double*, int);
+template void Kernels::Gemm<float, float>(bool, bool, int, int, int, float, const float*, int, const float*, int, float, float*, int);
+template void Kernels::Gemm<float, double>(bool, bool, int, int, int, float, const float*, int, const float*, int, float, float*, int);
+template void Kernels::Gemv<double, double>(bool, int, int, double, const double*, int, const double*, double, double*);
+template void Kernels::Gemv<float, float>(bool, int, int, float, const float*, int, const float*, float, float*);
+template void Kernels::Gemv<float, double>(bool, int, int, float, const float*, int, const float*, float, float*);
+template void Kernels::Ger<double>(int, int, double, const double*, const double*, double*, int);
+template void Kernels::Ger<float>(int, int, float, const float*, const float*, float*, int);
+template double Kernels::Dot<double, double>(int, const double*, const double*);
+template float Kernels::Dot<float, float>(int, const float*, const float*);
+template double Kernels::Dot<float, double>(int, const float*, const float*);
+template void Kernels::Axpy<double>(int, double, const double*, double*);
+template void Kernels::Axpy<float>(int, float, const float*, float*);
+template void Kernels::SgdStep<double>(int, const StepParameters<double>&, double*, const double*);
+template void Kernels::SgdStep<float>(int, const StepParameters<float>&, float*, const float*);
+template void Kernels::MomentumStep<double>(int, const StepParameters<double>&, double*, const double*, double*);
+template void Kernels::MomentumStep<float>(int, const StepParameters<float>&, float*, const float*, float*);
+template void Kernels::RmsPropStep<double>(int, const StepParameters<double>&, double*, const double*, double*);
+template void Kernels::RmsPropStep<float>(int, const StepParameters<float>&, float*, const float*, float*);
+template void Kernels::AdamStep<double>(int, const StepParameters<double>&, double*, const double*, double*, double*);
+template void Kernels::AdamStep<float>(int, const StepParameters<float>&, float*, const float*, float*, float*);
+template void Kernels::ApproximateActivation<double>(SmoothFunction, size_t, const double*, double*, double*);
+template void Kernels::ApproximateActivation<float>(SmoothFunction, size_t, const float*, float*, float*);
+template void Kernels::Reference::Gemm<double>(bool, bool, int, int, int, double, const double*, int, const double*, int, double, double*, int);
+template void Kernels::Reference::Gemm<float>(bool, bool, int, int, int, float, const float*, int, const float*, int, float, float*, int);
+template void Kernels::Reference::Gemv<double>(bool, int, int, double, const double*, int, const double*, double, double*);
+template void Kernels::Reference::Gemv<float>(bool, int, int, float, const float*, int, const float*, float, float*);
+template void Kernels::Reference::Ger<double>(int, int, double, const double*, const double*, double*, int);
+template void Kernels::Reference::Ger<float>(int, int, float, const float*, const float*, float*, int);
@@ -0,0 +1,189 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace Kernels
+{
+    /// @brief Namespace holding the dense linear algebra routines used by the forward and backward passes. All matrices are
+    ///        row-major, with the leading dimension giving the distance between the starts of consecutive rows. Every routine
+    ///        has a portable scalar implementation and, on x86, AVX2 and AVX-512 implementations that are selected at runtime
+    ///        from the features reported by the CPU.
+
+    enum class InstructionSet
+    {
+        Scalar,
+        Avx2,
+        Avx512
+    };
+
+    /// @brief  Returns the widest instruction set supported by the CPU this process is running on
+    /// @return The detected instruction set
+    InstructionSet DetectInstructionSet();
+
+    /// @brief  Returns the instruction set currently used by the kernels, which defaults to DetectInstructionSet()
+    /// @return The active instruction set
+    InstructionSet GetInstructionSet();
+
+    /// @brief     Forces the kernels to use a specific instruction set, mainly for benchmarking and verification. Throws if
+    ///            the CPU does not support it.
+    /// @param set The instruction set that should be used
+    void SetInstructionSet(InstructionSet set);
+
+    /// @brief     Returns a printable name for an instruction set
+    /// @param set The instruction set
+    /// @return    Name of the instruction set
+    const char* GetInstructionSetName(InstructionSet set);
+
+    /// @brief Makes a parameter take its type from the other arguments of a call, so that literals such as 1 can be passed
+    ///        for alpha and beta
+    template<typename T>
+    struct NonDeduced
+    {
+        using Type = T;
+    };
+
+    /// @brief Every routine below works on matrices of double or float. Routines that sum products also take the type of
+    ///        their accumulators, so that float data can be multiplied with double accumulators (mixed precision). The
+    ///        supported combinations are <double, double>, <float, float> and <float, double>.
+
+    /// @brief        General matrix-matrix multiply, C = alpha * op(A) * op(B) + beta * C, where op(X) is X or X^T.
+    ///               op(A) is m x k, op(B) is k x n and C is m x n. When beta is zero C does not need to be initialized.
+    ///               Mixed precision accumulates each block of KC products in double before adding it to C.
+    /// @param transA Whether A should be transposed
+    /// @param transB Whether B should be transposed
+    template<typename T, typename Accumulator = T>
+    void Gemm(bool transA, bool transB, int m, int n, int k,
+              typename NonDeduced<T>::Type alpha, const T* a, int lda, const T* b, int ldb,
+              typename NonDeduced<T>::Type beta, T* c, int ldc);
+
+    /// @brief        General matrix-vector multiply, y = alpha * op(A) * x + beta * y, where A is m x n. When beta is zero
+    ///               y does not need to be initialized.
+    /// @param transA Whether A should be transposed, in which case x has m elements and y has n, otherwise the reverse
+    template<typename T, typename Accumulator = T>
+    void Gemv(bool transA, int m, int n, typename NonDeduced<T>::Type alpha, const T* a, int lda, const T* x,
+              typename NonDeduced<T>::Type beta, T* y);
+
+    /// @brief Rank-one (outer product) update, A += alpha * x * y^T, where A is m x n, x has m elements and y has n
+    template<typename T>
+    void Ger(int m, int n, typename NonDeduced<T>::Type alpha, const T* x, const T* y, T* a, int lda);
+
+    /// @brief  Dot product of two vectors of n elements
+    /// @return The dot product
+    template<typename T, typename Accumulator = T>
+    Accumulator Dot(int n, const T* x, const T* y);
+
+    /// @brief Scaled vector addition, y += alpha * x
+    template<typename T>
+    void Axpy(int n, typename NonDeduced<T>::Type alpha, const T* x, T* y);
+
+    /// @brief     Integer matrix multiply for quantized inference, C = A * B^T, where A is an m x k matrix of unsigned 8-bit
+    ///            values, B is an n x k matrix of signed 8-bit values and C is the m x n matrix of their 32-bit sums. The
+    ///            AVX2 kernel adds pairs of products in 16 bits before widening them, so every value of A must lie in [0, 127]
+    ///            for the sums to be exact. On AVX-512 CPUs with VNNI the products are accumulated with vpdpbusd instead.
+    /// @param lda Distance between the starts of consecutive rows of A, in bytes
+    /// @param ldb Distance between the starts of consecutive rows of B, in bytes
+    /// @param ldc Distance between the starts of consecutive rows of C, in elements
+    void QuantizedGemm(int m, int n, int k, const uint8_t* a, int lda, const int8_t* b, int ldb, int32_t* c, int ldc);
+
+    /// @brief            Quantizes values for QuantizedGemm(), q = clamp(round(x / scale) + zeroPoint, 0, 127), rounding
+    ///                   halfway cases to even
+    /// @param scale      The real value of one quantization step
+    /// @param zeroPoint  The quantized value that represents zero
+    void Quantize(int n, const float* x, float scale, int zeroPoint, uint8_t* q);
+
+    /// @brief Hyperparameters of one fused optimizer step. Every step reads each parameter and its gradient once, forms the
+    ///        regularised gradient g = gradientScale * gradient + l2 * parameter, updates the optimizer state in place and
+    ///        writes the new parameter, all in a single pass.
+    template<typename T>
+    struct StepParameters
+    {
+        T learningRate = 0;
+        /// Multiplies every gradient, for example by 1 / rows to average gradients summed over a batch
+        T gradientScale = 1;
+        /// L2 penalty, added to the gradient before it reaches the optimizer state
+        T l2 = 0;
+        /// Decoupled weight decay (AdamW), subtracts learningRate * decay * parameter alongside the step
+        T decay = 0;
+        /// Momentum, or the decay rate of the first moment of Adam
+        T beta1 = 0;
+        /// Decay rate of the second moment of RMSProp and Adam
+        T beta2 = 0;
+        /// Added to the root of the second moment so that the step stays finite
+        T epsilon = 0;
+        /// Bias corrections of the moments of Adam, 1 / (1 - beta^t), or 1 for none
+        T firstCorrection = 1;
+        T secondCorrection = 1;
+    };
+
+    /// @brief Stochastic gradient descent, parameter -= learningRate * (g + decay * parameter)
+    template<typename T>
+    void SgdStep(int n, const StepParameters<T>& step, T* parameters, const T* gradients);
+
+    /// @brief Momentum, velocity = beta1 * velocity + g, then parameter -= learningRate * (velocity + decay * parameter)
+    template<typename T>
+    void MomentumStep(int n, const StepParameters<T>& step, T* parameters, const T* gradients, T* velocity);
+
+    /// @brief RMSProp, second = beta2 * second + (1 - beta2) * g^2, then
+    ///        parameter -= learningRate * (g / (sqrt(second) + epsilon) + decay * parameter)
+    template<typename T>
+    void RmsPropStep(int n, const StepParameters<T>& step, T* parameters, const T* gradients, T* second);
+
+    /// @brief Adam, first = beta1 * first + (1 - beta1) * g and second = beta2 * second + (1 - beta2) * g^2, then
+    ///        parameter -= learningRate * (firstCorrection * first / (sqrt(secondCorrection * second) + epsilon) + decay * parameter)
+    template<typename T>
+    void AdamStep(int n, const StepParameters<T>& step, T* parameters, const T* gradients, T* first, T* second);
+
+    /// @brief Smooth activation functions with vectorised approximations, evaluated from a polynomial approximation of exp
+    ///        instead of libm. Largest errors over the whole real line, absolute below 1 and relative above, as measured by
+    ///        activation_test against long double:
+    ///
+    ///        function   value (float)   value (double)  derivative (float)  derivative (double)
+    ///        sigmoid    1.2e-7          4e-15           1.2e-7              2e-15
+    ///        tanh       2.4e-7          6e-15           3e-7                6e-15
+    ///        elu        2e-7            8e-15           2e-7                8e-15
+    ///        softplus   2.4e-7          6e-15           1.2e-7              4e-15
+    ///        gelu       3e-7            3e-7            3e-7                1e-7
+    ///        silu       2e-7            4e-15           2e-7                4e-15
+    ///
+    ///        exp is a Taylor polynomial of degree 6 (float) or 11 (double) on [-ln 2 / 2, ln 2 / 2] after the usual range
+    ///        reduction, with its argument clamped to [-87, 88] (float) or [-708, 709] (double) so that it never overflows.
+    ///        gelu uses the Abramowitz and Stegun 7.1.26 approximation of erf, whose error of 1.5e-7 does not improve in
+    ///        double. NaN inputs give NaN.
+    enum class SmoothFunction
+    {
+        Sigmoid,
+        Tanh,
+        Elu,
+        Softplus,
+        Gelu,
+        Silu
+    };
+
+    /// @brief             Evaluates a smooth activation function and its derivative for n values. The derivative is
+    ///                    computed alongside the value from the same exponential rather than being evaluated again.
+    /// @param outputs     Pointer to where the function values are written, which may be the same as inputs, or nullptr
+    /// @param derivatives Pointer to where the derivatives are written, which may be the same as inputs, or nullptr
+    template<typename T>
+    void ApproximateActivation(SmoothFunction function, size_t n, const T* inputs, T* outputs, T* derivatives);
+
+    namespace Reference
+    {
+        /// @brief Straightforward triple-loop implementations with the same semantics as the routines above, accumulating in
+        ///        double, used to verify the optimized kernels.
+        template<typename T>
+        void Gemm(bool transA, bool transB, int m, int n, int k,
+                  typename NonDeduced<T>::Type alpha, const T* a, int lda, const T* b, int ldb,
+                  typename NonDeduced<T>::Type beta, T* c, int ldc);
+        template<typename T>
+        void Gemv(bool transA, int m, int n, typename NonDeduced<T>::Type alpha, const T* a, int lda, const T* x,
+                  typename NonDeduced<T>::Type beta, T* y);
+        template<typename T>
+        void Ger(int m, int n, typename NonDeduced<T>::Type alpha, const T* x, const T* y, T* a, int lda);
+        void QuantizedGemm(int m, int n, int k, const uint8_t* a, int lda, const int8_t* b, int ldb, int32_t* c, int ldc);
+    }
+}
+
+#endif // KERNELS_H
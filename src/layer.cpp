@@ -0,0 +1,249 @@
+#include "layer.h"
+
+template<typename T, typename Accumulator>
+BasicLayer<T, Accumulator>::BasicLayer()
+             :
+             numInputs(0),
+             numNeurons(0),
+             activation(ActivationFunctions::linear),
+             weights(nullptr),
+             biases(nullptr)
+{
+}
+
+template<typename T, typename Accumulator>
+BasicLayer<T, Accumulator>::BasicLayer(int inputNumInputs, int inputNumNeurons, Activation inputFunction)
+             :
+             numInputs(inputNumInputs),
+             numNeurons(inputNumNeurons),
+             activation(inputFunction),
+             weights(nullptr),
+             biases(nullptr)
+{
+    if (inputNumInputs < 0 || inputNumNeurons < 0)
+    {
+        throw(std::invalid_argument("Layer dimensions must not be negative"));
+    }
+
+    // Weights and biases share one allocation, with the biases directly after the weight matrix
+    parameters.assign(GetNumWeights() + GetNumBiases(), 0);
+    this->weights = parameters.data();
+    this->biases = weights + GetNumWeights();
+}
+
+template<typename T, typename Accumulator>
+BasicLayer<T, Accumulator>::BasicLayer(int inputNumInputs, int inputNumNeurons, Activation inputFunction, T* externalWeights, T* externalBiases)
+             :
+             numInputs(inputNumInputs),
+             numNeurons(inputNumNeurons),
+             activation(inputFunction),
+             weights(externalWeights),
+             biases(externalBiases)
+{
+    if (inputNumInputs < 0 || inputNumNeurons < 0)
+    {
+        throw(std::invalid_argument("Layer dimensions must not be negative"));
+    }
+}
+
+template<typename T, typename Accumulator>
+BasicLayer<T, Accumulator>::BasicLayer(const BasicLayer& other)
+             :
+             numInputs(other.numInputs),
+             numNeurons(other.numNeurons),
+             activation(other.activation)
+{
+    // Copies always own their parameters, even when the original views external memory
+    parameters.assign(other.weights, other.weights + other.GetNumWeights());
+    parameters.insert(parameters.end(), other.biases, other.biases + other.GetNumBiases());
+    this->weights = parameters.data();
+    this->biases = weights + GetNumWeights();
+}
+
+template<typename T, typename Accumulator>
+BasicLayer<T, Accumulator>& BasicLayer<T, Accumulator>::operator=(const BasicLayer& other)
+{
+    if (this != &other)
+    {
+        *this = BasicLayer(other);
+    }
+    return *this;
+}
+
+template<typename T, typename Accumulator>
+void BasicLayer<T, Accumulator>::Forward(const T* inputs, int rows, T* outputs) const
+{
+    // Start every output row from the biases, add inputs * W^T on top and then apply the activation function
+    for (int r = 0 ; r < rows ; r++)
+    {
+        std::copy(biases, biases + numNeurons, outputs + static_cast<size_t>(r) * numNeurons);
+    }
+    Kernels::Gemm<T, Accumulator>(false, true, rows, numNeurons, numInputs, 1, inputs, numInputs, weights, numInputs, 1, outputs, numNeurons);
+    activation.Apply(outputs, static_cast<size_t>(rows) * numNeurons);
+}
+
+template<typename T, typename Accumulator>
+void BasicLayer<T, Accumulator>::Forward(const T* inputs, int rows, T* preActivations, T* outputs, T* derivatives) const
+{
+    for (int r = 0 ; r < rows ; r++)
+    {
+        std::copy(biases, biases + numNeurons, preActivations + static_cast<size_t>(r) * numNeurons);
+    }
+    Kernels::Gemm<T, Accumulator>(false, true, rows, numNeurons, numInputs, 1, inputs, numInputs, weights, numInputs, 1, preActivations, numNeurons);
+
+    // The activation and its derivative come out of the same sweep over z
+    activation.ApplyWithDerivative(preActivations, static_cast<size_t>(rows) * numNeurons, outputs, derivatives);
+}
+
+template<typename T, typename Accumulator>
+void BasicLayer<T, Accumulator>::Backward(const T* deltas, int rows, T* inputDeltas) const
+{
+    // W is numNeurons x numInputs, so deltas * W maps the error terms of every row back onto the inputs of the layer
+    Kernels::Gemm<T, Accumulator>(false, false, rows, numInputs, numNeurons, 1, deltas, numNeurons, weights, numInputs, 0, inputDeltas, numInputs);
+}
+
+template<typename T, typename Accumulator>
+void BasicLayer<T, Accumulator>::ComputeGradients(const T* deltas, const T* inputs, int rows, T* weightGradients, T* biasGradients) const
+{
+    // The weight gradient of the batch is deltas^T * inputs and the bias gradient is the sum of the delta rows
+    Kernels::Gemm<T, Accumulator>(true, false, numNeurons, numInputs, rows, 1, deltas, numNeurons, inputs, numInputs, 0, weightGradients, numInputs);
+    std::fill(biasGradients, biasGradients + numNeurons, T(0));
+    for (int r = 0 ; r < rows ; r++)
+    {
+        Kernels::Axpy(numNeurons, 1, deltas + static_cast<size_t>(r) * numNeurons, biasGradients);
+    }
+}
+
+template<typename T, typename Accumulator>
+T* BasicLayer<T, Accumulator>::GetWeights()
+{
+    return weights;
+}
+
+template<typename T, typename Accumulator>
+const T* BasicLayer<T, Accumulator>::GetWeights() const
+{
+    return weights;
+}
+
+template<typename T, typename Accumulator>
+T* BasicLayer<T, Accumulator>::GetBiases()
+{
+    return biases;
+}
+
+template<typename T, typename Accumulator>
+const T* BasicLayer<T, Accumulator>::GetBiases() const
+{
+    return biases;
+}
+
+template<typename T, typename Accumulator>
+int BasicLayer<T, Accumulator>::GetNumInputs() const
+{
+    return this->numInputs;
+}
+
+template<typename T, typename Accumulator>
+int BasicLayer<T, Accumulator>::GetNumNeurons() const
+{
+    return this->numNeurons;
+}
+
+template<typename T, typename Accumulator>
+size_t BasicLayer<T, Accumulator>::GetNumWeights() const
+{
+    return static_cast<size_t>(numInputs) * numNeurons;
+}
+
+template<typename T, typename Accumulator>
+size_t BasicLayer<T, Accumulator>::GetNumBiases() const
+{
+    return numInputs ? numNeurons : 0;
+}
+
+template<typename T, typename Accumulator>
+bool BasicLayer<T, Accumulator>::IsExternal() const
+{
+    return weights != parameters.data() && GetNumWeights() > 0;
+}
+
+template<typename T, typename Accumulator>
+void BasicLayer<T, Accumulator>::SetActivationFunction(Activation inputFunction)
+{
+    this->activation = inputFunction;
+}
+
+template<typename T, typename Accumulator>
+const Activation& BasicLayer<T, Accumulator>::GetActivationFunction() const
+{
+    return this->activation;
+}
+
+template<typename T, typename Accumulator>
+Neuron BasicLayer<T, Accumulator>::GetNeuron(int index) const
+{
+    if (index < 0 || index >= numNeurons)
+    {
+        throw(std::invalid_argument("Neuron index is out of bounds"));
+    }
+
+    // Input layers have no weights, so they are represented as pass-through neurons
+    Neuron neuron({1}, 0, ActivationFunctions::linear);
+    if (numInputs)
+    {
+        const T* row = weights + static_cast<size_t>(index) * numInputs;
+        neuron = Neuron(std::vector<double>(row, row + numInputs), biases[index], activation);
+    }
+    return neuron;
+}
+
+template<typename T, typename Accumulator>
+void BasicLayer<T, Accumulator>::SetNeuron(int index, Neuron neuron)
+{
+    if (index < 0 || index >= numNeurons)
+    {
+        throw(std::invalid_argument("Neuron index is out of bounds"));
+    }
+    if (neuron.GetNumWeights() != numInputs)
+    {
+        throw(std::invalid_argument("Neuron weights vector length must match the number of layer inputs."));
+    }
+
+    std::vector<double> neuronWeights = neuron.GetWeights();
+    std::copy(neuronWeights.begin(), neuronWeights.end(), weights + static_cast<size_t>(index) * numInputs);
+    biases[index] = neuron.GetBias();
+}
+
+template<typename T>
+template<typename Accumulator>
+size_t BasicLayerBuffers<T>::GetSize(const BasicLayer<T, Accumulator>& layer, int batchRows)
+{
+    const size_t activations = static_cast<size_t>(batchRows) * layer.GetNumNeurons();
+    return 4 * Arena::GetSize<T>(activations) + Arena::GetSize<T>(layer.GetNumWeights()) + Arena::GetSize<T>(layer.GetNumBiases());
+}
+
+template<typename T>
+template<typename Accumulator>
+void BasicLayerBuffers<T>::Allocate(const BasicLayer<T, Accumulator>& layer, int batchRows, Arena& arena)
+{
+    const size_t activations = static_cast<size_t>(batchRows) * layer.GetNumNeurons();
+    preActivations = arena.Allocate<T>(activations);
+    outputs = arena.Allocate<T>(activations);
+    derivatives = arena.Allocate<T>(activations);
+    deltas = arena.Allocate<T>(activations);
+    weightGradients = arena.Allocate<T>(layer.GetNumWeights());
+    biasGradients = arena.Allocate<T>(layer.GetNumBiases());
+}
+
+template class BasicLayer<double>;
+template class BasicLayer<float>;
+template class BasicLayer<float, double>;
+template struct BasicLayerBuffers<double>;
+template struct BasicLayerBuffers<float>;
+template size_t BasicLayerBuffers<double>::GetSize(const BasicLayer<double>& layer, int batchRows);
+template size_t BasicLayerBuffers<float>::GetSize(const BasicLayer<float>& layer, int batchRows);
+template size_t BasicLayerBuffers<float>::GetSize(const BasicLayer<float, double>& layer, int batchRows);
+template void BasicLayerBuffers<double>::Allocate(const BasicLayer<double>& layer, int batchRows, Arena& arena);
+template void BasicLayerBuffers<float>::Allocate(const BasicLayer<float>& layer, int batchRows, Arena& arena);
+template void BasicLayerBuffers<float>::Allocate(const BasicLayer<float, double>& layer, int batchRows, Arena& arena);
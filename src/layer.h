@@ -0,0 +1,173 @@
+#ifndef LAYER_H
+#define LAYER_H
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+
+#include "span.h"
+#include "arena.h"
+#include "neuron.h"
+#include "kernels.h"
+#include "support_functions.h"
+
+/// @brief Dense layer templated on the type its weights and activations are stored in, T, and the type its matrix
+///        products accumulate in, Accumulator. Supported combinations are <double>, <float> and <float, double>.
+template<typename T, typename Accumulator = T>
+class BasicLayer
+{
+    public:
+        /// @brief Create an empty layer, which must be setup later to be used
+        BasicLayer();
+
+        /// @class                 Dense layer that stores the weights of all of its neurons in a single contiguous row-major
+        ///                        matrix (one row per neuron, one column per input), alongside a bias vector. A layer with
+        ///                        no inputs acts as an input layer.
+        /// @param inputNumInputs  The number of inputs feeding each neuron in this layer
+        /// @param inputNumNeurons The number of neurons in this layer
+        /// @param inputFunction   The activation function that should be used by all neurons in this layer
+        BasicLayer(int inputNumInputs, int inputNumNeurons, Activation inputFunction = ActivationFunctions::linear);
+
+        /// @brief                 Create a layer that uses weights and biases stored elsewhere, such as in a memory mapped model
+        ///                        file, instead of owning them. The memory must outlive the layer.
+        /// @param inputNumInputs  The number of inputs feeding each neuron in this layer
+        /// @param inputNumNeurons The number of neurons in this layer
+        /// @param inputFunction   The activation function that should be used by all neurons in this layer
+        /// @param externalWeights Pointer to the row-major numNeurons x numInputs weight matrix
+        /// @param externalBiases  Pointer to the numNeurons biases
+        BasicLayer(int inputNumInputs, int inputNumNeurons, Activation inputFunction, T* externalWeights, T* externalBiases);
+
+        /// @brief       Copies a layer. The copy always owns its weights and biases, even if the original views external memory.
+        /// @param other The layer to copy
+        BasicLayer(const BasicLayer& other);
+        BasicLayer& operator=(const BasicLayer& other);
+        BasicLayer(BasicLayer&& other) = default;
+        BasicLayer& operator=(BasicLayer&& other) = default;
+
+        /// @brief         Calculates the output of every neuron in the layer for a batch of rows as f(inputs * W^T + b)
+        /// @param inputs  Pointer to a row-major rows x numInputs matrix of values that should be fed to this layer
+        /// @param rows    The number of rows in the batch
+        /// @param outputs Pointer to a row-major rows x numNeurons matrix that the outputs are written to
+        void Forward(const T* inputs, int rows, T* outputs) const;
+
+        /// @brief                Training version of Forward() that also keeps what backpropagation needs, so that nothing has
+        ///                       to be recomputed on the way back
+        /// @param inputs         Pointer to a row-major rows x numInputs matrix of values that should be fed to this layer
+        /// @param rows           The number of rows in the batch
+        /// @param preActivations Pointer to a row-major rows x numNeurons matrix that z = inputs * W^T + b is written to
+        /// @param outputs        Pointer to a row-major rows x numNeurons matrix that the outputs f(z) are written to
+        /// @param derivatives    Pointer to a row-major rows x numNeurons matrix that the derivatives f'(z) are written to
+        void Forward(const T* inputs, int rows, T* preActivations, T* outputs, T* derivatives) const;
+
+        /// @brief             Propagates error terms back through the weights of this layer, inputDeltas = deltas * W. The
+        ///                    result still has to be multiplied by the activation derivatives of the layer before this one.
+        /// @param deltas      Pointer to a row-major rows x numNeurons matrix of error terms of this layer
+        /// @param rows        The number of rows in the batch
+        /// @param inputDeltas Pointer to a row-major rows x numInputs matrix that the propagated error terms are written to
+        void Backward(const T* deltas, int rows, T* inputDeltas) const;
+
+        /// @brief                 Calculates the gradients of this layer for a batch of rows, dW = deltas^T * inputs and
+        ///                        db = the column sums of deltas
+        /// @param deltas          Pointer to a row-major rows x numNeurons matrix of error terms
+        /// @param inputs          Pointer to a row-major rows x numInputs matrix of values that were fed to this layer
+        /// @param rows            The number of rows in the batch
+        /// @param weightGradients Pointer to the numNeurons x numInputs weight gradients that are written to
+        /// @param biasGradients   Pointer to the numNeurons bias gradients that are written to
+        void ComputeGradients(const T* deltas, const T* inputs, int rows, T* weightGradients, T* biasGradients) const;
+
+        /// @brief  Returns a pointer to the row-major weight matrix, which has GetNumNeurons() rows and GetNumInputs() columns
+        /// @return Pointer to the first weight
+        T* GetWeights();
+        const T* GetWeights() const;
+
+        /// @brief  Returns a pointer to the bias of each neuron
+        /// @return Pointer to the first bias
+        T* GetBiases();
+        const T* GetBiases() const;
+
+        /// @brief  Get the number of inputs feeding each neuron in this layer
+        /// @return The number of inputs
+        int GetNumInputs() const;
+
+        /// @brief  Get the number of neurons in this layer
+        /// @return The number of neurons
+        int GetNumNeurons() const;
+
+        /// @brief  Get the number of weights in this layer, numNeurons * numInputs
+        /// @return The number of weights
+        size_t GetNumWeights() const;
+
+        /// @brief  Get the number of biases in this layer, which is zero for input layers
+        /// @return The number of biases
+        size_t GetNumBiases() const;
+
+        /// @brief  Checks if this layer views weights and biases stored outside of the layer
+        /// @return Boolean value representing if the parameters are external
+        bool IsExternal() const;
+
+        /// @brief          Initialize or change the activation function used by every neuron in this layer
+        /// @param function The activation function that should be used by this layer
+        void SetActivationFunction(Activation inputFunction);
+
+        /// @brief  Returns the activation function used by every neuron in this layer
+        /// @return The activation function
+        const Activation& GetActivationFunction() const;
+
+        /// @brief       Builds a standalone neuron holding a copy of the weights, bias and activation function of one neuron
+        ///              in this layer. Provided for compatibility with code written against the Neuron class.
+        /// @param index Index of the neuron within this layer
+        /// @return      Copy of the neuron
+        Neuron GetNeuron(int index) const;
+
+        /// @brief        Overwrites the weights and bias of one neuron in this layer with the ones held by a standalone neuron
+        /// @param index  Index of the neuron within this layer
+        /// @param neuron Neuron to copy the weights and bias from, which must have GetNumInputs() weights
+        void SetNeuron(int index, Neuron neuron);
+
+    private:
+        /// Basic layer attributes
+        int numInputs;
+        int numNeurons;
+        Activation activation;
+
+        /// Contiguous storage, weights are stored row-major with one row per neuron. The pointers refer either to the
+        /// owned parameters vector or to external memory.
+        std::vector<T> parameters;
+        T* weights;
+        T* biases;
+};
+
+template<typename T>
+struct BasicLayerBuffers
+{
+    /// @brief           Per-thread working memory for one layer, holding the pre-activations, activations, activation
+    ///                  derivatives and error terms of a batch (each row-major, one row per batch row), as kept by the forward
+    ///                  pass for backpropagation, along with gradients that match the shape of
+    ///                  the layer parameters. Keeping these apart from the Layer lets several threads run the
+    ///                  same layer on different rows at once. The buffers are views of an Arena, planned with GetSize().
+    /// @param layer     The layer these buffers are used with
+    /// @param batchRows The maximum number of rows that will be passed through the layer at once
+    /// @return          The number of bytes Allocate() takes from an arena
+    template<typename Accumulator>
+    static size_t GetSize(const BasicLayer<T, Accumulator>& layer, int batchRows);
+
+    /// @brief           Points every buffer at zeroed memory of the arena, sized for a layer and a number of rows
+    /// @param layer     The layer these buffers are used with
+    /// @param batchRows The maximum number of rows that will be passed through the layer at once
+    /// @param arena     The arena the buffers are taken from, which must outlive them
+    template<typename Accumulator>
+    void Allocate(const BasicLayer<T, Accumulator>& layer, int batchRows, Arena& arena);
+
+    Span<T> preActivations;
+    Span<T> outputs;
+    Span<T> derivatives;
+    Span<T> deltas;
+    Span<T> weightGradients;
+    Span<T> biasGradients;
+};
+
+using Layer = BasicLayer<double>;
+using LayerBuffers = BasicLayerBuffers<double>;
+
+#endif // LAYER_H
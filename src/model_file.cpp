@@ -0,0 +1,89 @@
+#include "model_file.h"
+
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define NN_HAS_MMAP 1
+#endif
+
+uint64_t ModelFile::AlignUp(uint64_t value)
+{
+    return (value + Alignment - 1) / Alignment * Alignment;
+}
+
+uint64_t ModelFile::Checksum(const void* data, size_t bytes, uint64_t seed)
+{
+    const uint64_t prime = 0x100000001b3ULL;
+    const unsigned char* input = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+
+    size_t i = 0;
+    for ( ; i + 8 <= bytes ; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, input + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for ( ; i < bytes ; i++)
+    {
+        hash = (hash ^ input[i]) * prime;
+    }
+    return hash;
+}
+
+MappedFile::MappedFile(const std::string& path)
+                       :
+                       data(nullptr),
+                       size(0)
+{
+#ifdef NN_HAS_MMAP
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        throw(std::runtime_error("Unable to open " + path));
+    }
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || status.st_size <= 0)
+    {
+        close(descriptor);
+        throw(std::runtime_error("Unable to read the size of " + path));
+    }
+    size = status.st_size;
+
+    // A private writable mapping lets a loaded model be trained further without touching the file
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED)
+    {
+        throw(std::runtime_error("Unable to map " + path));
+    }
+    data = static_cast<char*>(mapping);
+#else
+    throw(std::runtime_error("Memory mapped files are not supported on this platform"));
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef NN_HAS_MMAP
+    if (data)
+    {
+        munmap(data, size);
+    }
+#endif
+}
+
+char* MappedFile::GetData() const
+{
+    return this->data;
+}
+
+size_t MappedFile::GetSize() const
+{
+    return this->size;
+}
@@ -0,0 +1,94 @@
+#ifndef MODEL_FILE_H
+#define MODEL_FILE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+namespace ModelFile
+{
+    /// @brief Binary model file layout, all values little-endian as written by the host:
+    ///
+    ///        Header        fixed 64 byte header described below
+    ///        LayerRecord[] one record per layer, starting with the input layer
+    ///        parameters    every layer's row-major weight matrix followed by its biases, each block starting on an
+    ///                      Alignment byte boundary so that a memory mapped file can be used in place by the SIMD kernels
+    ///                      and stored as float or double, with the size of one value in Header::scalarSize
+    ///
+    ///        The checksum covers the layer records and everything from parameterOffset to the end of the file.
+
+    constexpr char Magic[8] = {'N', 'N', 'M', 'O', 'D', 'E', 'L', '\0'};
+    constexpr uint32_t Version = 1;
+    constexpr uint32_t ByteOrderMark = 0x01020304;
+    constexpr uint64_t Alignment = 64;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint32_t scalarSize;
+        uint32_t numLayers;
+        uint32_t lossType;
+        uint32_t reserved;
+        uint64_t parameterOffset;
+        uint64_t fileSize;
+        uint64_t checksum;
+        uint64_t padding;
+    };
+
+    struct LayerRecord
+    {
+        uint32_t numInputs;
+        uint32_t numNeurons;
+        uint32_t activationType;
+        uint32_t reserved;
+        uint64_t weightOffset;
+        uint64_t biasOffset;
+    };
+
+    static_assert(sizeof(Header) == 64, "Model file header must be 64 bytes");
+    static_assert(sizeof(LayerRecord) == 32, "Model file layer records must be 32 bytes");
+
+    /// @brief       Rounds an offset up to the next multiple of Alignment
+    /// @param value The offset to round
+    /// @return      The aligned offset
+    uint64_t AlignUp(uint64_t value);
+
+    /// @brief       64-bit FNV-1a style checksum, consuming eight bytes per step
+    /// @param data  Pointer to the bytes that should be hashed
+    /// @param bytes The number of bytes to hash
+    /// @param seed  Checksum of the preceding bytes, so that discontiguous regions can be chained
+    /// @return      The checksum
+    uint64_t Checksum(const void* data, size_t bytes, uint64_t seed = 0xcbf29ce484222325ULL);
+}
+
+class MappedFile
+{
+    public:
+        /// @class      Read-only view of a whole file mapped into memory. The mapping is private and copy-on-write, so pages
+        ///             are shared with every other process mapping the same file until they are written to.
+        /// @param path Path of the file to map
+        MappedFile(const std::string& path);
+
+        /// @brief Unmaps the file
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /// @brief  Returns a pointer to the first byte of the file
+        /// @return Pointer to the mapped file
+        char* GetData() const;
+
+        /// @brief  Get the size of the file
+        /// @return The number of bytes in the file
+        size_t GetSize() const;
+
+    private:
+        char* data;
+        size_t size;
+};
+
+#endif // MODEL_FILE_H
@@ -1,55 +1,114 @@
 #include "network.h"
 
-NeuralNetwork::NeuralNetwork(std::vector<int> neuronsPerLayer,
-                             std::function<double(double)> inputFunction,
-                             std::function<double(std::vector<double>, std::vector<double>)> inputErrorFunction,
-                             int inputEpochs,
-                             double inputLearningRate,
-                             double inputCutoff)
-                             :
-                             actFunction(inputFunction),
-                             errorFunction(inputErrorFunction),
-                             learningRate(inputLearningRate),
-                             epochs(inputEpochs),
-                             cutoff(inputCutoff),
-                             initialized(false),
-                             outputActFunction(ActivationFunctions::linear)
-{
-    // Resize the layers vector so that it can hold the input and output layers
-    layers.resize(neuronsPerLayer.size() + 2);
-    numLayers = layers.size();
-
-    // Resize each of the individual layers
-    for (int i = 0 ; i < neuronsPerLayer.size() ; i++)
-    {
-        layers[i + 1].resize(neuronsPerLayer[i]);
+#include <filesystem>
+#include <thread>
+
+namespace
+{
+    /// Copies parameters stored in a model file as float or double, according to the scalar size in its header
+    template<typename T>
+    void ConvertParameters(const char* source, uint32_t scalarSize, size_t count, T* destination)
+    {
+        if (scalarSize == sizeof(float))
+        {
+            const float* values = reinterpret_cast<const float*>(source);
+            std::copy(values, values + count, destination);
+        }
+        else
+        {
+            const double* values = reinterpret_cast<const double*>(source);
+            std::copy(values, values + count, destination);
+        }
+    }
+
+    /// Scratch buffer of the calling thread for the inference path, which only grows when a larger batch than before is seen
+    template<typename T>
+    Span<T> ThreadScratch(size_t size)
+    {
+        thread_local std::vector<T> scratch;
+        if (scratch.size() < size)
+        {
+            scratch.resize(size);
+        }
+        return scratch;
+    }
+}
+
+template<typename T, typename Accumulator>
+BasicNeuralNetwork<T, Accumulator>::BasicNeuralNetwork(std::vector<int> neuronsPerLayer,
+                                                       Activation inputFunction,
+                                                       std::function<double(std::vector<double>, std::vector<double>)> inputErrorFunction,
+                                                       int inputEpochs,
+                                                       double inputLearningRate,
+                                                       double inputCutoff)
+                                                       :
+                                                       epochs(inputEpochs),
+                                                       batchSize(1),
+                                                       numThreads(1),
+                                                       trainingMode(TrainingMode::Synchronous),
+                                                       cutoff(inputCutoff),
+                                                       hugePages(false),
+                                                       optimizer(new Optimizers::Sgd(inputLearningRate)),
+                                                       optimizerStep(0),
+                                                       baseLearningRate(inputLearningRate),
+                                                       trainedEpochs(0),
+                                                       validationSplit(0),
+                                                       validationInterval(1),
+                                                       patience(0),
+                                                       minDelta(0),
+                                                       restoreBestWeights(true),
+                                                       trainedSteps(0),
+                                                       resuming(false),
+                                                       checkpointInterval(0),
+                                                       seed((static_cast<uint64_t>(std::random_device()()) << 32) | std::random_device()()),
+                                                       actFunction(inputFunction),
+                                                       outputActFunction(ActivationFunctions::linear),
+                                                       errorFunction(inputErrorFunction),
+                                                       lossType(LossFunctions::GetLossType(inputErrorFunction)),
+                                                       initialized(false)
+{
+    // Record the size of every layer, the input and output sizes are only known once the network is initialized
+    layerSizes.resize(neuronsPerLayer.size() + 2);
+    numLayers = layerSizes.size();
+
+    for (size_t i = 0 ; i < neuronsPerLayer.size() ; i++)
+    {
+        layerSizes[i + 1] = neuronsPerLayer[i];
     }
+    layers.resize(numLayers);
+    initializers.resize(numLayers);
 
     // Get the function derivatives
     errorFunctionDerivative = LossFunctions::GetDerivativeFunctionName(errorFunction);
 }
 
-void NeuralNetwork::ChangeHiddenLayerActivationFunction(std::function<double(double)> inputFunction, int layerIndex)
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::ChangeHiddenLayerActivationFunction(Activation inputFunction, int layerIndex)
 {
     if (!initialized)
     {
         throw(std::logic_error("The activation function for hidden layers can only be changed after initialization"));
     }
     
-    for (Neuron& neuron : layers[layerIndex])
+    if (layerIndex <= 0 || layerIndex >= numLayers - 1)
     {
-        neuron.SetActivationFunction(inputFunction);
+        throw(std::invalid_argument("Layer index does not refer to a hidden layer"));
     }
+
+    layers[layerIndex].SetActivationFunction(inputFunction);
 }
 
-void NeuralNetwork::SetOutputActivationFunction(std::function<double(double)> inputFunction)
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetOutputActivationFunction(Activation inputFunction)
 {
+    if (LossFunctions::TakesLogits(lossType) && inputFunction.GetType() != ActivationFunctions::ActivationType::Linear)
+    {
+        throw(std::logic_error("Losses that take logits apply their own softmax or sigmoid, so the output layer must be linear"));
+    }
+
     if (initialized)
     {
-        for (Neuron& neuron : layers.back())
-        {
-            neuron.SetActivationFunction(inputFunction);
-        }
+        layers.back().SetActivationFunction(inputFunction);
     }
     else
     {
@@ -57,153 +116,1304 @@ void NeuralNetwork::SetOutputActivationFunction(std::function<double(double)> in
     }
 }
 
-void NeuralNetwork::Initialize(std::vector<std::vector<double>> xDataInput, std::vector<std::vector<double>> yDataInput)
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetLossDerivative(std::function<double(double, double)> derivative)
+{
+    if (lossType != LossFunctions::LossType::Custom)
+    {
+        throw(std::invalid_argument("Only custom loss functions take a derivative, the built-in ones have their own"));
+    }
+    if (!derivative)
+    {
+        throw(std::invalid_argument("The derivative of the loss function must not be empty"));
+    }
+    this->errorFunctionDerivative = derivative;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::Initialize(const std::vector<std::vector<double>>& xDataInput, const std::vector<std::vector<double>>& yDataInput)
 {
     if (!xDataInput.size() || !yDataInput.size())
     {
         throw(std::invalid_argument("Dataset must not be empty"));
         
     }
-    xData = xDataInput;
-    yData = yDataInput;
-    numInputs = xData[0].size();
-    numOutputs = yData[0].size();
+    if (validationSplit > 0)
+    {
+        // Hold out the last rows, which must leave at least one row on each side
+        const size_t heldOut = static_cast<size_t>(xDataInput.size() * validationSplit);
+        if (heldOut == 0 || heldOut >= xDataInput.size() || xDataInput.size() != yDataInput.size())
+        {
+            throw(std::invalid_argument("Validation split must leave at least one training and one validation row"));
+        }
+        const size_t trainingRows = xDataInput.size() - heldOut;
+        trainingData.reset(new InMemoryDataSource({xDataInput.begin(), xDataInput.begin() + trainingRows},
+                                                  {yDataInput.begin(), yDataInput.begin() + trainingRows}));
+        SetValidationData({xDataInput.begin() + trainingRows, xDataInput.end()}, {yDataInput.begin() + trainingRows, yDataInput.end()});
+    }
+    else
+    {
+        trainingData.reset(new InMemoryDataSource(xDataInput, yDataInput));
+    }
+    Initialize(*trainingData);
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::Initialize(const DataSource& source)
+{
+    if (initialized && numInputs == source.GetNumInputs() && numOutputs == source.GetNumOutputs())
+    {
+        return;
+    }
+
+    numInputs = source.GetNumInputs();
+    numOutputs = source.GetNumOutputs();
+    layerSizes.front() = numInputs;
+    layerSizes.back() = numOutputs;
     SetupInputLayer();
     SetupHiddenLayers();
     SetupOutputLayer();
+
     this->initialized = true;
+    SetBatchSize(batchSize);
+    InitializeWeights();
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetSeed(uint64_t inputSeed)
+{
+    seed = inputSeed;
+}
+
+template<typename T, typename Accumulator>
+uint64_t BasicNeuralNetwork<T, Accumulator>::GetSeed() const
+{
+    return this->seed;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetWeightInitializer(const Initializer& initializer)
+{
+    std::fill(initializers.begin(), initializers.end(), initializer);
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetWeightInitializer(const Initializer& initializer, int layerIndex)
+{
+    if (layerIndex < 1 || layerIndex >= numLayers)
+    {
+        throw(std::out_of_range("Layer index must refer to a hidden layer or the output layer"));
+    }
+    initializers[layerIndex] = initializer;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetEpochs(int epochs)
+{
+    if (epochs < 0)
+    {
+        throw(std::invalid_argument("Number of epochs must not be negative"));
+    }
+    this->epochs = epochs;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetBatchSize(int rows)
+{
+    if (rows < 1)
+    {
+        throw(std::invalid_argument("Batch size must be at least one"));
+    }
+
+    this->batchSize = rows;
+    if (initialized)
+    {
+        AllocateWorkspaces();
+    }
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetNumThreads(int threads)
+{
+    if (threads < 1)
+    {
+        throw(std::invalid_argument("Number of threads must be at least one"));
+    }
+
+    this->numThreads = threads;
+    if (initialized)
+    {
+        AllocateWorkspaces();
+    }
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetHugePages(bool enable)
+{
+    this->hugePages = enable;
+    if (initialized)
+    {
+        AllocateWorkspaces();
+    }
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetTrainingMode(TrainingMode mode)
+{
+    this->trainingMode = mode;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetOptimizer(const Optimizer& inputOptimizer)
+{
+    optimizer = inputOptimizer.Clone();
+    optimizer->Reset();
+    baseLearningRate = optimizer->GetLearningRate();
+}
+
+template<typename T, typename Accumulator>
+Optimizer& BasicNeuralNetwork<T, Accumulator>::GetOptimizer()
+{
+    return *optimizer;
+}
+
+template<typename T, typename Accumulator>
+const Optimizer& BasicNeuralNetwork<T, Accumulator>::GetOptimizer() const
+{
+    return *optimizer;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetValidationData(const std::vector<std::vector<double>>& xData, const std::vector<std::vector<double>>& yData)
+{
+    if (!xData.size() || !yData.size())
+    {
+        throw(std::invalid_argument("Validation data must not be empty"));
+    }
+    validationData.reset(new InMemoryDataSource(xData, yData));
+
+    // The inference path works in T, so the inputs are converted once rather than on every evaluation
+    const size_t count = static_cast<size_t>(validationData->GetNumRows()) * validationData->GetNumInputs();
+    const double* inputs = validationData->GetInputs(0);
+    validationInputs.assign(inputs, inputs + count);
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetValidationSplit(double fraction)
+{
+    if (!(fraction >= 0 && fraction < 1))
+    {
+        throw(std::invalid_argument("Validation split must be in [0, 1)"));
+    }
+    validationSplit = fraction;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetValidationInterval(int epochs)
+{
+    if (epochs < 1)
+    {
+        throw(std::invalid_argument("Validation interval must be at least one epoch"));
+    }
+    validationInterval = epochs;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetEarlyStopping(int inputPatience, double inputMinDelta, bool inputRestoreBestWeights)
+{
+    if (inputPatience < 0 || inputMinDelta < 0)
+    {
+        throw(std::invalid_argument("Early stopping patience and minimum improvement must not be negative"));
+    }
+    patience = inputPatience;
+    minDelta = inputMinDelta;
+    restoreBestWeights = inputRestoreBestWeights;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetLearningRateSchedule(const LearningRateSchedule& inputSchedule)
+{
+    schedule = inputSchedule.Clone();
+    baseLearningRate = optimizer->GetLearningRate();
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::RemoveLearningRateSchedule()
+{
+    schedule.reset();
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetCheckpointing(const std::string& directory, long everySteps, int keep)
+{
+    if (everySteps < 1)
+    {
+        throw(std::invalid_argument("Checkpoints must be at least one step apart"));
+    }
+    checkpointWriter.reset();
+    checkpointWriter.reset(new CheckpointWriter(directory, keep));
+    checkpointInterval = everySteps;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::DisableCheckpointing()
+{
+    if (checkpointWriter)
+    {
+        checkpointWriter->Flush();
+        checkpointWriter.reset();
+    }
+}
+
+template<typename T, typename Accumulator>
+typename BasicNeuralNetwork<T, Accumulator>::ResumePoint BasicNeuralNetwork<T, Accumulator>::Resume(const std::string& path)
+{
+    if (!initialized)
+    {
+        throw(std::logic_error("Neural net is not initialized."));
+    }
+
+    ResumePoint point;
+    std::string file = path;
+    std::vector<char> payload;
+    long step = 0;
+    if (std::filesystem::is_directory(path))
+    {
+        // Use the latest checkpoint that reads back intact, falling back past any that were damaged
+        for (const std::string& candidate : Checkpoint::ListFiles(path))
+        {
+            try
+            {
+                payload = Checkpoint::ReadFile(candidate, step);
+                file = candidate;
+                break;
+            }
+            catch (const std::runtime_error& error)
+            {
+                point.skipped.push_back(error.what());
+            }
+        }
+        if (file == path)
+        {
+            throw(std::runtime_error("No intact checkpoint found in " + path));
+        }
+    }
+    else
+    {
+        payload = Checkpoint::ReadFile(path, step);
+    }
+
+    // Everything the network has to match comes first, so that nothing is changed if the checkpoint is rejected
+    Checkpoint::Decoder decoder(payload, file);
+    bool matches = decoder.Read<uint32_t>() == sizeof(T) && decoder.ReadCount() == layerSizes.size();
+    for (size_t i = 0 ; matches && i < layerSizes.size() ; i++)
+    {
+        matches = decoder.Read<int32_t>() == layerSizes[i];
+    }
+    if (!matches)
+    {
+        throw(std::invalid_argument(file + " was written by a network with a different topology or precision"));
+    }
+    if (decoder.ReadString() != optimizer->GetName() || decoder.ReadString() != (schedule ? schedule->GetName() : ""))
+    {
+        throw(std::invalid_argument(file + " was written with a different optimizer or learning rate schedule"));
+    }
+
+    for (int i = 1 ; i < numLayers ; i++)
+    {
+        decoder.ReadCount();
+        decoder.ReadValues(layers[i].GetWeights(), layers[i].GetNumWeights());
+        decoder.ReadCount();
+        decoder.ReadValues(layers[i].GetBiases(), layers[i].GetNumBiases());
+    }
+    InitializeOptimizer();
+    optimizer->LoadState(decoder);
+    if (schedule)
+    {
+        schedule->LoadState(decoder);
+    }
+
+    baseLearningRate = decoder.Read<double>();
+    trainedEpochs = decoder.Read<int32_t>();
+    trainedSteps = decoder.Read<int64_t>();
+    run.epoch = decoder.Read<int32_t>();
+    run.epochRows = decoder.Read<int64_t>();
+    run.bestLoss = decoder.Read<double>();
+    run.improvedLoss = decoder.Read<double>();
+    run.bestEpoch = decoder.Read<int32_t>();
+    run.waits = decoder.Read<int32_t>();
+
+    // The losses so far are summed per thread, and only add up in the same order when the thread count is the same
+    const size_t numLosses = decoder.Read<uint64_t>();
+    for (Workspace& workspace : workspaces)
+    {
+        workspace.loss = 0;
+    }
+    for (size_t t = 0 ; t < numLosses ; t++)
+    {
+        workspaces[numLosses == workspaces.size() ? t : 0].loss += decoder.Read<double>();
+    }
+
+    history.resize(decoder.ReadCount());
+    for (EpochStats& stats : history)
+    {
+        stats.epoch = decoder.Read<int32_t>();
+        stats.trainingLoss = decoder.Read<double>();
+        stats.validationLoss = decoder.Read<double>();
+        stats.learningRate = decoder.Read<double>();
+    }
+    bestParameters.resize(decoder.Read<uint64_t>());
+    for (std::vector<T>& parameters : bestParameters)
+    {
+        parameters = decoder.ReadArray<T>();
+    }
+    resuming = true;
+
+    point.file = file;
+    point.step = step;
+    point.epoch = run.epoch;
+    point.epochRows = run.epochRows;
+    return point;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::WriteCheckpoint()
+{
+    Checkpoint::Encoder encoder(checkpointWriter->AcquireBuffer());
+    // Every value is written with a fixed width, so that the payload is the same on every platform and holds no padding
+    encoder.Write<uint32_t>(sizeof(T));
+    encoder.Write<uint64_t>(layerSizes.size());
+    for (int size : layerSizes)
+    {
+        encoder.Write<int32_t>(size);
+    }
+    encoder.WriteString(optimizer->GetName());
+    encoder.WriteString(schedule ? schedule->GetName() : "");
+
+    for (int i = 1 ; i < numLayers ; i++)
+    {
+        encoder.WriteArray(layers[i].GetWeights(), layers[i].GetNumWeights());
+        encoder.WriteArray(layers[i].GetBiases(), layers[i].GetNumBiases());
+    }
+    optimizer->SaveState(encoder);
+    if (schedule)
+    {
+        schedule->SaveState(encoder);
+    }
+
+    encoder.Write(baseLearningRate);
+    encoder.Write<int32_t>(trainedEpochs);
+    encoder.Write<int64_t>(trainedSteps);
+    encoder.Write<int32_t>(run.epoch);
+    encoder.Write<int64_t>(run.epochRows);
+    encoder.Write<double>(run.bestLoss);
+    encoder.Write<double>(run.improvedLoss);
+    encoder.Write<int32_t>(run.bestEpoch);
+    encoder.Write<int32_t>(run.waits);
+    encoder.Write<uint64_t>(workspaces.size());
+    for (const Workspace& workspace : workspaces)
+    {
+        encoder.Write(workspace.loss);
+    }
+    encoder.Write<uint64_t>(history.size());
+    for (const EpochStats& stats : history)
+    {
+        encoder.Write<int32_t>(stats.epoch);
+        encoder.Write<double>(stats.trainingLoss);
+        encoder.Write<double>(stats.validationLoss);
+        encoder.Write<double>(stats.learningRate);
+    }
+    encoder.Write<uint64_t>(bestParameters.size());
+    for (const std::vector<T>& parameters : bestParameters)
+    {
+        encoder.WriteArray(parameters.data(), parameters.size());
+    }
+    checkpointWriter->Submit(trainedSteps);
+}
+
+template<typename T, typename Accumulator>
+const std::vector<typename BasicNeuralNetwork<T, Accumulator>::EpochStats>& BasicNeuralNetwork<T, Accumulator>::GetHistory() const
+{
+    return history;
 }
 
-void NeuralNetwork::SetupInputLayer()
+template<typename T, typename Accumulator>
+const typename BasicNeuralNetwork<T, Accumulator>::ThroughputStats& BasicNeuralNetwork<T, Accumulator>::GetThroughputStats() const
 {
-    Neuron unweightedNeuron({1}, 0, ActivationFunctions::linear);
-    std::vector<Neuron> inputLayer(numInputs, unweightedNeuron);
-    layers[0] = inputLayer;
+    return this->throughputStats;
 }
 
-void NeuralNetwork::SetupHiddenLayers()
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::AllocateWorkspaces()
 {
-    int layerSize;
-    double bias;
+    if (!threadPool || threadPool->GetNumThreads() != numThreads)
+    {
+        threadPool.reset(new ThreadPool(numThreads));
+    }
 
-    for (int i = 1 ; i < layers.size() - 1 ; i++)
+    // Every thread gets buffers large enough for its share of a full batch, all of them from one arena
+    const int shardRows = (batchSize + numThreads - 1) / numThreads;
+    size_t bytes = 0;
+    for (int i = 0 ; i < numLayers ; i++)
     {
-        layerSize = layers[i].size();
-        std::vector<Neuron> currentLayer(layerSize);
-        layers[i] = currentLayer;
+        bytes += LayerBuffers::GetSize(layers[i], shardRows);
+    }
+    workspaceArena.Reserve(bytes * numThreads, hugePages);
 
-        for (int j = 0 ; j < layerSize ; j++)
+    workspaces.resize(numThreads);
+    for (int t = 0 ; t < numThreads ; t++)
+    {
+        Workspace& workspace = workspaces[t];
+        workspace.threadIndex = t;
+        workspace.layers.resize(numLayers);
+        for (int i = 0 ; i < numLayers ; i++)
         {
-            std::vector<double> weights(layers[i - 1].size());
-            for (auto& w : weights) { w =  GenerateRandomNumber(); }
-            bias = GenerateRandomNumber();
-            layers[i][j] = Neuron(weights, bias, actFunction);
+            workspace.layers[i].Allocate(layers[i], shardRows, workspaceArena);
         }
+        workspace.loss = 0;
+        workspace.rows = 0;
+    }
+
+    if (profiler)
+    {
+        profiler->Resize(numThreads, numLayers);
+    }
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::InitializeOptimizer()
+{
+    // Block 2 * (i - 1) holds the weights of layer i and the block after it the biases
+    optimizerBlocks.clear();
+    for (int i = 1 ; i < numLayers ; i++)
+    {
+        optimizerBlocks.push_back(layers[i].GetNumWeights());
+        optimizerBlocks.push_back(layers[i].GetNumBiases());
     }
+    optimizer->Initialize(optimizerBlocks, sizeof(T));
 }
 
-void NeuralNetwork::SetupOutputLayer()
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetupInputLayer()
 {
-    double bias;
-    std::vector<Neuron> outputLayer(numOutputs);
+    layers[0] = Layer(0, numInputs, ActivationFunctions::linear);
+}
 
-    for (int i = 0 ; i < numOutputs ; i++)
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetupHiddenLayers()
+{
+    for (int i = 1 ; i < numLayers - 1 ; i++)
     {
-        std::vector<double> weights(layers[numLayers - 2].size());
-        for (auto& w : weights) { w =  GenerateRandomNumber(); }
-        bias = GenerateRandomNumber();
-        outputLayer[i] = Neuron(weights, bias, outputActFunction);
+        layers[i] = Layer(layerSizes[i - 1], layerSizes[i], actFunction);
     }
-    layers.back() = outputLayer;
 }
 
-double NeuralNetwork::GenerateRandomNumber()
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SetupOutputLayer()
 {
-    // Setup and seed the random number generator
-    std::random_device seed;
-    std::mt19937 generator(seed());
-    std::uniform_int_distribution<int> distribution(-5, 5);
-    return distribution(generator);
+    layers.back() = Layer(layerSizes[numLayers - 2], numOutputs, outputActFunction);
 }
 
-void NeuralNetwork::Forward(int currentIndex)
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::InitializeWeights()
 {
-    // Set the inputs
-    for (int i = 0 ; i < layers[0].size() ; i++)
+    // Every weight is drawn from its own position of the stream of its layer, so each thread fills a contiguous slice of
+    // every layer and the weights are the same for any number of threads. Threads beyond the cores of the machine would
+    // only take turns, so they are not used either.
+    size_t numWeights = 0;
+    for (int i = 1 ; i < numLayers ; i++)
     {
-        layers[0][i].SetOutput(yData[currentIndex][i]);
+        numWeights += layers[i].GetNumWeights();
     }
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    const int fillThreads = static_cast<int>(std::min({numWeights / InitializeWeightsPerThread, cores, static_cast<size_t>(numThreads)}));
 
-    // Run through the neural network, calculating the output for each layer
-    for (int i = 1 ; i < layers.size() ; i++)
+    auto fill = [this](int threadIndex, int threads)
     {
-        for (int j = 0 ; j < layers[i].size() ; j++)
+        for (int i = 1 ; i < numLayers ; i++)
         {
-            layers[i][j].Forward(layers[i - 1]);
+            Layer& layer = layers[i];
+            const Initializer initializer = initializers[i] ? *initializers[i] : Initializers::ForActivation(layer.GetActivationFunction().GetType());
+            const size_t begin = layer.GetNumWeights() * threadIndex / threads;
+            const size_t end = layer.GetNumWeights() * (threadIndex + 1) / threads;
+            initializer.Generate(RandomGenerator(seed, i), begin, end - begin, layer.GetNumInputs(), layer.GetNumNeurons(), layer.GetWeights() + begin);
         }
+    };
+    if (fillThreads <= 1)
+    {
+        fill(0, 1);
+        return;
     }
+    threadPool->Run([&](int threadIndex)
+    {
+        if (threadIndex < fillThreads)
+        {
+            fill(threadIndex, fillThreads);
+        }
+    });
 }
 
-void NeuralNetwork::BackPropogate(int currentIndex)
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::TrainBatch(const double* inputs, const double* targets, int rows)
 {
-    // Update the weights and bias for all layers
-    double dEdO, dOdN, dNdW, outputErrors;
-    for (int i = numLayers - 1 ; i > 0 ; i--)
+    // Propogate contiguous shards of the batch on every thread
+    const int shardRows = (rows + numThreads - 1) / numThreads;
+    threadPool->Run([&](int threadIndex)
     {
-        for (int j = 0 ; j < layers[i].size() ; j++)
+        Workspace& workspace = workspaces[threadIndex];
+        const int shardStart = threadIndex * shardRows;
+        workspace.rows = std::max(0, std::min(shardRows, rows - shardStart));
+        if (workspace.rows)
         {
+            Forward(workspace, inputs + static_cast<size_t>(shardStart) * numInputs, workspace.rows);
+            BackPropogate(workspace, targets + static_cast<size_t>(shardStart) * numOutputs, workspace.rows);
+            workspace.samples += workspace.rows;
+        }
+    });
+
+    // Reduce the gradients and update the weights, each thread owning a slice of the parameters
+    optimizerStep = optimizer->BeginStep();
+    threadPool->Run([&](int threadIndex)
+    {
+        ApplyGradients(rows, threadIndex);
+    });
+}
 
-            // Calculate the output derivative with respect to the total net input (the derivative of the activation function)
-            dOdN = layers[i][j].Backward(layers[i - 1]);
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::TrainHogwild(const double* inputs, const double* targets, int rows)
+{
+    threadPool->Run([&](int threadIndex)
+    {
+        Workspace& workspace = workspaces[threadIndex];
+        const int partitionStart = static_cast<long>(rows) * threadIndex / numThreads;
+        const int partitionEnd = static_cast<long>(rows) * (threadIndex + 1) / numThreads;
+
+        for (int row = partitionStart ; row < partitionEnd ; row++)
+        {
+            Forward(workspace, inputs + static_cast<size_t>(row) * numInputs, 1);
+            BackPropogate(workspace, targets + static_cast<size_t>(row) * numOutputs, 1);
 
-            // If this is an output neuron, calculate the loss derivative directly, otherwise use the sum of output neuron's loss
-            if (i == numLayers - 1)
+            // Updates go straight to the shared weights without locking. Other threads may read a partially updated layer or
+            // overwrite a concurrent update to the same weight or optimizer state; as in Hogwild, these races are tolerated
+            // since each update is small and, for wide layers, rarely touches the same weights at the same time.
+            // Every row is a step of its own, counted by the one optimizer that all threads share. Its moments are also
+            // shared, so every update of every thread adds to them, and the global count of updates is the one their bias
+            // correction needs. The order in which threads draw their steps varies from run to run, like the races above.
+            const long step = optimizer->BeginStep();
+            for (int i = 1 ; i < numLayers ; i++)
             {
-                dEdO = errorFunctionDerivative(layers[i][j].GetLastOutput(), yData[currentIndex][j]);
-                outputErrors += dEdO * dOdN;
+                NN_PROFILE_SCOPE(profiler.get(), threadIndex, Profiler::Phase::WeightUpdate, i, 2.0 * (layers[i].GetNumWeights() + layers[i].GetNumBiases()));
+                const LayerBuffers& buffers = workspace.layers[i];
+                optimizer->Update(step, 2 * (i - 1), 0, buffers.weightGradients.size(), layers[i].GetWeights(), buffers.weightGradients.data(), 1);
+                optimizer->Update(step, 2 * (i - 1) + 1, 0, buffers.biasGradients.size(), layers[i].GetBiases(), buffers.biasGradients.data(), 1);
             }
-            else
+        }
+
+        workspace.rows = partitionEnd - partitionStart;
+        workspace.samples += workspace.rows;
+    });
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::Forward(Workspace& workspace, const double* inputs, int rows)
+{
+    // Set the inputs, one row of the input layer per row of the batch
+    std::copy(inputs, inputs + static_cast<size_t>(rows) * numInputs, workspace.layers[0].outputs.data());
+
+    // Run through the neural network, calculating the outputs for each layer from the outputs of the one before it
+    for (int i = 1 ; i < numLayers ; i++)
+    {
+        NN_PROFILE_SCOPE(profiler.get(), workspace.threadIndex, Profiler::Phase::Forward, i, 2.0 * rows * layers[i].GetNumWeights());
+        LayerBuffers& buffers = workspace.layers[i];
+        layers[i].Forward(workspace.layers[i - 1].outputs.data(), rows, buffers.preActivations.data(), buffers.outputs.data(), buffers.derivatives.data());
+    }
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::BackPropogate(Workspace& workspace, const double* targets, int rows)
+{
+    // The output error terms are the loss derivative times the activation derivative kept by the forward pass. Losses that
+    // take logits sit on a linear output layer, so their gradient with respect to the logits is already the error term.
+    LayerBuffers& outputBuffers = workspace.layers.back();
+    {
+        NN_PROFILE_SCOPE(profiler.get(), workspace.threadIndex, Profiler::Phase::Loss);
+        const size_t count = static_cast<size_t>(rows) * numOutputs;
+        if (lossType == LossFunctions::LossType::Custom)
+        {
+            for (size_t index = 0 ; index < count ; index++)
+            {
+                outputBuffers.deltas[index] = errorFunctionDerivative(outputBuffers.outputs[index], targets[index]) * outputBuffers.derivatives[index];
+            }
+            workspace.loss += ComputeLoss(outputBuffers.outputs.data(), targets, rows);
+        }
+        else
+        {
+            workspace.loss += LossFunctions::BatchLoss<T>(lossType, numOutputs, Span<const T>(outputBuffers.outputs.data(), count),
+                                                          Span<const double>(targets, count), Span<T>(outputBuffers.deltas.data(), count));
+            if (!LossFunctions::TakesLogits(lossType))
+            {
+                for (size_t index = 0 ; index < count ; index++)
+                {
+                    outputBuffers.deltas[index] *= outputBuffers.derivatives[index];
+                }
+            }
+        }
+    }
+
+    // Work back through the layers, computing the gradients of each and passing its error terms through W^T to the one before
+    for (int i = numLayers - 1 ; i > 0 ; i--)
+    {
+        NN_PROFILE_SCOPE(profiler.get(), workspace.threadIndex, Profiler::Phase::Backward, i, (i > 1 ? 4.0 : 2.0) * rows * layers[i].GetNumWeights());
+        LayerBuffers& buffers = workspace.layers[i];
+        LayerBuffers& previous = workspace.layers[i - 1];
+        layers[i].ComputeGradients(buffers.deltas.data(), previous.outputs.data(), rows, buffers.weightGradients.data(), buffers.biasGradients.data());
+
+        if (i > 1)
+        {
+            layers[i].Backward(buffers.deltas.data(), rows, previous.deltas.data());
+            const size_t count = static_cast<size_t>(rows) * layers[i - 1].GetNumNeurons();
+            for (size_t k = 0 ; k < count ; k++)
             {
-                dEdO = outputErrors * layers[i][j].Backward(layers[i - 1]);
+                previous.deltas[k] *= previous.derivatives[k];
             }
-            
-            // Update the bias
-            layers[i][j].UpdateBias(learningRate * dEdO * dOdN);
+        }
+    }
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::ApplyGradients(int rows, int threadIndex)
+{
+    for (int i = 1 ; i < numLayers ; i++)
+    {
+        const size_t numWeights = static_cast<size_t>(layers[i].GetNumNeurons()) * layers[i].GetNumInputs();
+        const size_t numBiases = layers[i].GetNumNeurons();
+        const size_t weightStart = numWeights * threadIndex / numThreads;
+        const size_t weightEnd = numWeights * (threadIndex + 1) / numThreads;
+        const size_t biasStart = numBiases * threadIndex / numThreads;
+        const size_t biasEnd = numBiases * (threadIndex + 1) / numThreads;
 
-            // Calculate the weight derivative for each weight and then update that specific weight
-            for (int k = 0 ; k < layers[i][j].GetNumWeights() ; k++)
-            {  
-                dNdW = layers[i - 1][k].GetLastOutput();
-                layers[i][j].UpdateOneWeight(learningRate * dEdO * dOdN * dNdW, k);
+        // Workspaces are always added in thread order, so the result does not depend on scheduling. The first workspace
+        // always holds rows, and the sum is kept in its gradients.
+        NN_PROFILE_SCOPE(profiler.get(), threadIndex, Profiler::Phase::WeightUpdate, i, 2.0 * numThreads * (weightEnd - weightStart + biasEnd - biasStart));
+        LayerBuffers& sum = workspaces.front().layers[i];
+        for (size_t t = 1 ; t < workspaces.size() ; t++)
+        {
+            if (!workspaces[t].rows)
+            {
+                continue;
             }
+            const LayerBuffers& buffers = workspaces[t].layers[i];
+            Kernels::Axpy(weightEnd - weightStart, 1, buffers.weightGradients.data() + weightStart, sum.weightGradients.data() + weightStart);
+            Kernels::Axpy(biasEnd - biasStart, 1, buffers.biasGradients.data() + biasStart, sum.biasGradients.data() + biasStart);
         }
+
+        const T scale = static_cast<T>(1.0 / rows);
+        optimizer->Update(optimizerStep, 2 * (i - 1), weightStart, weightEnd - weightStart, layers[i].GetWeights() + weightStart, sum.weightGradients.data() + weightStart, scale);
+        optimizer->Update(optimizerStep, 2 * (i - 1) + 1, biasStart, biasEnd - biasStart, layers[i].GetBiases() + biasStart, sum.biasGradients.data() + biasStart, scale);
     }
+}
 
-    // Calculate the final mean loss
-    epochErr = std::abs(outputErrors / yData[currentIndex].size());
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::Train()
+{
+    if (!trainingData)
+    {
+        throw(std::logic_error("Neural net has no training data, call Initialize() with a dataset first."));
+    }
+    Train(*trainingData);
 }
 
-void NeuralNetwork::Train()
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::Train(DataSource& source)
 {
     if (!initialized)
     {
         throw(std::logic_error("Neural net is not initialized."));
     }
+    if (source.GetNumInputs() != numInputs || source.GetNumOutputs() != numOutputs)
+    {
+        throw(std::invalid_argument("Data source does not match the number of network inputs and outputs"));
+    }
+    if (lossType == LossFunctions::LossType::Custom && !errorFunctionDerivative)
+    {
+        throw(std::invalid_argument("A custom loss function needs a derivative to train with, see SetLossDerivative()"));
+    }
+
+    // Rows are streamed from the source one batch (or, for Hogwild, one chunk shared by all threads) at a time
+    const int readRows = (trainingMode == TrainingMode::Hogwild) ? HogwildRowsPerThread * numThreads : batchSize;
+    batchInputs.resize(static_cast<size_t>(readRows) * numInputs);
+    batchOutputs.resize(static_cast<size_t>(readRows) * numOutputs);
+
+    if (validationData && (validationData->GetNumInputs() != numInputs || validationData->GetNumOutputs() != numOutputs))
+    {
+        throw(std::invalid_argument("Validation data does not match the number of network inputs and outputs"));
+    }
+
+    InitializeOptimizer();
+
+    for (Workspace& workspace : workspaces)
+    {
+        workspace.samples = 0;
+    }
+    if (!resuming)
+    {
+        history.clear();
+        run = RunState();
+    }
+    history.reserve(history.size() + std::max(0, epochs - run.epoch + 1));
+    auto startTime = std::chrono::steady_clock::now();
 
-    for (int epoch = 1 ; epoch <= epochs ; epoch++)
+    for ( ; run.epoch <= epochs ; run.epoch++)
     {
-        for (int currentIndex = 0 ; currentIndex < xData.size() ; currentIndex++)
+        const int epoch = run.epoch;
+        if (schedule)
         {
-            Forward(currentIndex);
-            BackPropogate(currentIndex);
+            optimizer->SetLearningRate(schedule->GetLearningRate(trainedEpochs, baseLearningRate));
         }
 
-        std::cout << "Epoch " << epoch << " Loss: " << epochErr << std::endl;
+        int rows;
+        if (resuming)
+        {
+            // Continue the epoch the checkpoint was taken in, reading past the rows that had already been trained on
+            source.SetEpoch(trainedEpochs);
+            source.Reset();
+            for (long skipped = 0 ; skipped < run.epochRows ; skipped += rows)
+            {
+                rows = ReadBatch(source, static_cast<int>(std::min<long>(readRows, run.epochRows - skipped)));
+                if (rows == 0)
+                {
+                    throw(std::runtime_error("Data source has fewer rows than the checkpoint being resumed had trained on"));
+                }
+            }
+            resuming = false;
+        }
+        else
+        {
+            for (Workspace& workspace : workspaces)
+            {
+                workspace.loss = 0;
+            }
+            source.Reset();
+            run.epochRows = 0;
+        }
+
+        while ((rows = ReadBatch(source, readRows)) > 0)
+        {
+            if (trainingMode == TrainingMode::Hogwild)
+            {
+                TrainHogwild(batchInputs.data(), batchOutputs.data(), rows);
+            }
+            else
+            {
+                TrainBatch(batchInputs.data(), batchOutputs.data(), rows);
+            }
+            run.epochRows += rows;
+            trainedSteps++;
+            if (checkpointWriter && trainedSteps % checkpointInterval == 0)
+            {
+                WriteCheckpoint();
+            }
+        }
+        trainedEpochs++;
+
+        // The training loss is the mean over every row of the epoch, summed over the threads in a fixed order
+        EpochStats stats;
+        stats.epoch = trainedEpochs;
+        stats.learningRate = optimizer->GetLearningRate();
+        for (const Workspace& workspace : workspaces)
+        {
+            stats.trainingLoss += workspace.loss;
+        }
+        stats.trainingLoss = run.epochRows ? stats.trainingLoss / run.epochRows : 0;
+        epochErr = stats.trainingLoss;
+
+        // The monitored loss is the validation loss when there is validation data, evaluated every few epochs and after the last
+        bool evaluated = true;
+        double monitoredLoss = epochErr;
+        if (validationData)
+        {
+            evaluated = epoch % validationInterval == 0 || epoch == epochs;
+            if (evaluated)
+            {
+                stats.validationLoss = Validate();
+                monitoredLoss = stats.validationLoss;
+            }
+        }
+        history.push_back(stats);
+
+        std::cout << "Epoch " << epoch << " Loss: " << epochErr;
+        if (validationData && evaluated)
+        {
+            std::cout << " Validation loss: " << stats.validationLoss;
+        }
+        std::cout << std::endl;
 
         if (epochErr <= cutoff)
         {
             std::cout << "Loss below cutoff level. Exiting early at epoch " << epoch << " with loss " << epochErr << "" << std::endl;
             break;
         }
+        if (!evaluated)
+        {
+            continue;
+        }
+
+        if (schedule)
+        {
+            schedule->Observe(monitoredLoss);
+        }
+        if (patience > 0)
+        {
+            // The lowest loss is always kept for restoring, but only improvements of at least minDelta reset the patience
+            if (monitoredLoss < run.bestLoss)
+            {
+                run.bestLoss = monitoredLoss;
+                run.bestEpoch = trainedEpochs;
+                if (restoreBestWeights)
+                {
+                    SaveBestParameters();
+                }
+            }
+            if (monitoredLoss < run.improvedLoss - minDelta)
+            {
+                run.improvedLoss = monitoredLoss;
+                run.waits = 0;
+            }
+            else if (++run.waits >= patience)
+            {
+                std::cout << "Loss has not improved for " << patience << " evaluations. Exiting early at epoch " << epoch << std::endl;
+                break;
+            }
+        }
+    }
+
+    if (patience > 0 && restoreBestWeights && run.bestEpoch && run.bestEpoch != trainedEpochs)
+    {
+        RestoreBestParameters();
+        std::cout << "Restored the weights of epoch " << run.bestEpoch << " with loss " << run.bestLoss << std::endl;
+    }
+    if (checkpointWriter)
+    {
+        checkpointWriter->Flush();
+    }
+
+    // Record the throughput of every thread over the whole run
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    throughputStats.samplesPerSecond.assign(numThreads, 0);
+    throughputStats.totalSamplesPerSecond = 0;
+    long samples = 0;
+    for (int t = 0 ; t < numThreads ; t++)
+    {
+        samples += workspaces[t].samples;
+        if (seconds > 0)
+        {
+            throughputStats.samplesPerSecond[t] = workspaces[t].samples / seconds;
+            throughputStats.totalSamplesPerSecond += throughputStats.samplesPerSecond[t];
+        }
+    }
+    if (profiler)
+    {
+        profiler->AddRun(samples, seconds);
+    }
+}
+
+template<typename T, typename Accumulator>
+double BasicNeuralNetwork<T, Accumulator>::ComputeLoss(const T* outputs, const double* targets, int rows) const
+{
+    const size_t count = static_cast<size_t>(rows) * numOutputs;
+    if (lossType != LossFunctions::LossType::Custom)
+    {
+        return LossFunctions::BatchLoss<T>(lossType, numOutputs, Span<const T>(outputs, count), Span<const double>(targets, count));
+    }
+
+    // Custom loss functions are only known through their function object, which is called once per row
+    double sum = 0;
+    std::vector<double> predicted(numOutputs), actual(numOutputs);
+    for (int r = 0 ; r < rows ; r++)
+    {
+        const size_t rowStart = static_cast<size_t>(r) * numOutputs;
+        std::copy(outputs + rowStart, outputs + rowStart + numOutputs, predicted.begin());
+        std::copy(targets + rowStart, targets + rowStart + numOutputs, actual.begin());
+        sum += errorFunction(predicted, actual);
+    }
+    return sum;
+}
+
+template<typename T, typename Accumulator>
+double BasicNeuralNetwork<T, Accumulator>::Validate()
+{
+    // Every thread predicts a contiguous part of the rows through the inference path and sums their losses, which are then
+    // added in thread order
+    const long rows = validationData->GetNumRows();
+    validationOutputs.resize(static_cast<size_t>(rows) * numOutputs);
+    validationLosses.assign(numThreads, 0);
+    threadPool->Run([&](int threadIndex)
+    {
+        const long end = rows * (threadIndex + 1) / numThreads;
+        for (long start = rows * threadIndex / numThreads ; start < end ; start += ValidationRowsPerCall)
+        {
+            const int count = static_cast<int>(std::min<long>(ValidationRowsPerCall, end - start));
+            T* outputs = validationOutputs.data() + static_cast<size_t>(start) * numOutputs;
+            PredictLogits(Span<const T>(validationInputs.data() + static_cast<size_t>(start) * numInputs, static_cast<size_t>(count) * numInputs),
+                          Span<T>(outputs, static_cast<size_t>(count) * numOutputs), ThreadScratch<T>(GetPredictScratchSize(count)));
+            validationLosses[threadIndex] += ComputeLoss(outputs, validationData->GetOutputs(start), count);
+        }
+    });
+
+    double sum = 0;
+    for (double loss : validationLosses)
+    {
+        sum += loss;
+    }
+    return sum / rows;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::SaveBestParameters()
+{
+    bestParameters.resize(2 * (numLayers - 1));
+    for (int i = 1 ; i < numLayers ; i++)
+    {
+        const Layer& layer = layers[i];
+        bestParameters[2 * (i - 1)].assign(layer.GetWeights(), layer.GetWeights() + layer.GetNumWeights());
+        bestParameters[2 * (i - 1) + 1].assign(layer.GetBiases(), layer.GetBiases() + layer.GetNumBiases());
+    }
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::RestoreBestParameters()
+{
+    for (int i = 1 ; i < numLayers ; i++)
+    {
+        std::copy(bestParameters[2 * (i - 1)].begin(), bestParameters[2 * (i - 1)].end(), layers[i].GetWeights());
+        std::copy(bestParameters[2 * (i - 1) + 1].begin(), bestParameters[2 * (i - 1) + 1].end(), layers[i].GetBiases());
+    }
+}
+
+template<typename T, typename Accumulator>
+int BasicNeuralNetwork<T, Accumulator>::ReadBatch(DataSource& source, int maxRows)
+{
+    // Data loading always happens on the calling thread, which is thread 0 of the pool
+    NN_PROFILE_SCOPE(profiler.get(), 0, Profiler::Phase::DataLoading);
+    return source.ReadBatch(maxRows, batchInputs.data(), batchOutputs.data());
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::EnableProfiling(bool enable, [[maybe_unused]] bool recordTrace)
+{
+#ifdef NN_ENABLE_PROFILING
+    profiler.reset(enable ? new Profiler(numThreads, numLayers, recordTrace) : nullptr);
+#else
+    if (enable)
+    {
+        throw(std::logic_error("Profiling is not available, the library was built without NN_ENABLE_PROFILING"));
+    }
+#endif
+}
+
+template<typename T, typename Accumulator>
+Profiler::Report BasicNeuralNetwork<T, Accumulator>::GetProfile() const
+{
+    if (!profiler)
+    {
+        throw(std::logic_error("Profiling is not enabled, call EnableProfiling() first"));
+    }
+    return profiler->GetReport();
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::WriteProfileTrace(const std::string& path) const
+{
+    if (!profiler)
+    {
+        throw(std::logic_error("Profiling is not enabled, call EnableProfiling() first"));
+    }
+    profiler->WriteChromeTrace(path);
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::Predict(const T* input, T* output) const
+{
+    PredictBatch(Span<const T>(input, numInputs), Span<T>(output, numOutputs));
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::PredictBatch(Span<const T> inputs, Span<T> outputs) const
+{
+    if (!initialized)
+    {
+        throw(std::logic_error("Neural net is not initialized."));
+    }
+
+    PredictBatch(inputs, outputs, ThreadScratch<T>(GetPredictScratchSize(inputs.size() / numInputs)));
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::PredictBatch(Span<const T> inputs, Span<T> outputs, Span<T> scratch) const
+{
+    PredictLogits(inputs, outputs, scratch);
+    LossFunctions::LogitsToProbabilities(lossType, numOutputs, outputs);
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::PredictLogits(Span<const T> inputs, Span<T> outputs, Span<T> scratch) const
+{
+    if (!initialized)
+    {
+        throw(std::logic_error("Neural net is not initialized."));
+    }
+
+    const int rows = inputs.size() / numInputs;
+    if (inputs.size() % numInputs || outputs.size() != static_cast<size_t>(rows) * numOutputs)
+    {
+        throw(std::invalid_argument("Input and output sizes must match the network for the same number of rows"));
+    }
+    if (scratch.size() < GetPredictScratchSize(rows))
+    {
+        throw(std::invalid_argument("Scratch buffer is too small for this batch"));
+    }
+
+    // Alternate between the two halves of the scratch buffer, with the last layer writing straight to the outputs
+    const size_t half = scratch.size() / 2;
+    const T* layerInputs = inputs.data();
+    for (int i = 1 ; i < numLayers ; i++)
+    {
+        T* layerOutputs = (i == numLayers - 1) ? outputs.data() : scratch.data() + (i % 2) * half;
+        layers[i].Forward(layerInputs, rows, layerOutputs);
+        layerInputs = layerOutputs;
+    }
+}
+
+template<typename T, typename Accumulator>
+size_t BasicNeuralNetwork<T, Accumulator>::GetPredictScratchSize(int rows) const
+{
+    int maxHiddenSize = 0;
+    for (int i = 1 ; i < numLayers - 1 ; i++)
+    {
+        maxHiddenSize = std::max(maxHiddenSize, layerSizes[i]);
+    }
+    return 2 * static_cast<size_t>(rows) * maxHiddenSize;
+}
+
+template<typename T, typename Accumulator>
+void BasicNeuralNetwork<T, Accumulator>::Save(const std::string& path) const
+{
+    if (!initialized)
+    {
+        throw(std::logic_error("Neural net is not initialized."));
+    }
+
+    const LossFunctions::LossType savedLossType = LossFunctions::GetLossType(errorFunction);
+    if (savedLossType == LossFunctions::LossType::Custom)
+    {
+        throw(std::logic_error("Only the built-in loss functions can be saved"));
+    }
+
+    // Lay out the layer records and give every weight matrix and bias vector an aligned offset
+    std::vector<ModelFile::LayerRecord> records(numLayers);
+    uint64_t offset = ModelFile::AlignUp(sizeof(ModelFile::Header) + records.size() * sizeof(ModelFile::LayerRecord));
+    const uint64_t parameterOffset = offset;
+    for (int i = 0 ; i < numLayers ; i++)
+    {
+        ModelFile::LayerRecord& record = records[i];
+        std::memset(&record, 0, sizeof(record));
+        record.numInputs = layers[i].GetNumInputs();
+        record.numNeurons = layers[i].GetNumNeurons();
+        record.activationType = static_cast<uint32_t>(layers[i].GetActivationFunction().GetType());
+        if (i > 0 && record.activationType == static_cast<uint32_t>(ActivationFunctions::ActivationType::Custom))
+        {
+            throw(std::logic_error("Only the built-in activation functions can be saved"));
+        }
+
+        record.weightOffset = offset;
+        offset = ModelFile::AlignUp(offset + layers[i].GetNumWeights() * sizeof(T));
+        record.biasOffset = offset;
+        offset = ModelFile::AlignUp(offset + layers[i].GetNumBiases() * sizeof(T));
+    }
+
+    // Build the parameter block in memory so that it can be checksummed and written in one go
+    std::vector<char> parameters(offset - parameterOffset, 0);
+    for (int i = 1 ; i < numLayers ; i++)
+    {
+        std::memcpy(parameters.data() + (records[i].weightOffset - parameterOffset), layers[i].GetWeights(), layers[i].GetNumWeights() * sizeof(T));
+        std::memcpy(parameters.data() + (records[i].biasOffset - parameterOffset), layers[i].GetBiases(), layers[i].GetNumBiases() * sizeof(T));
+    }
+
+    ModelFile::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, ModelFile::Magic, sizeof(header.magic));
+    header.version = ModelFile::Version;
+    header.byteOrderMark = ModelFile::ByteOrderMark;
+    header.scalarSize = sizeof(T);
+    header.numLayers = numLayers;
+    header.lossType = static_cast<uint32_t>(savedLossType);
+    header.parameterOffset = parameterOffset;
+    header.fileSize = offset;
+    header.checksum = ModelFile::Checksum(records.data(), records.size() * sizeof(ModelFile::LayerRecord));
+    header.checksum = ModelFile::Checksum(parameters.data(), parameters.size(), header.checksum);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        throw(std::runtime_error("Unable to open " + path + " for writing"));
+    }
+
+    std::vector<char> padding(parameterOffset - sizeof(header) - records.size() * sizeof(ModelFile::LayerRecord), 0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ModelFile::LayerRecord));
+    file.write(padding.data(), padding.size());
+    file.write(parameters.data(), parameters.size());
+    if (!file)
+    {
+        throw(std::runtime_error("Unable to write " + path));
+    }
+}
+
+template<typename T, typename Accumulator>
+BasicNeuralNetwork<T, Accumulator> BasicNeuralNetwork<T, Accumulator>::Load(const std::string& path, bool verifyChecksum)
+{
+    std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>(path);
+    char* data = mapping->GetData();
+    const size_t size = mapping->GetSize();
+
+    // Validate the header before trusting any of the offsets in the file
+    ModelFile::Header header;
+    if (size < sizeof(header))
+    {
+        throw(std::runtime_error(path + " is too small to be a model file"));
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, ModelFile::Magic, sizeof(header.magic)) != 0)
+    {
+        throw(std::runtime_error(path + " is not a model file"));
+    }
+    if (header.version != ModelFile::Version || header.byteOrderMark != ModelFile::ByteOrderMark
+        || (header.scalarSize != sizeof(float) && header.scalarSize != sizeof(double)))
+    {
+        throw(std::runtime_error(path + " was written with an unsupported version, byte order or precision"));
+    }
+    const uint64_t recordsEnd = sizeof(header) + static_cast<uint64_t>(header.numLayers) * sizeof(ModelFile::LayerRecord);
+    if (header.numLayers < 2 || header.fileSize != size || recordsEnd > header.parameterOffset || header.parameterOffset > size)
+    {
+        throw(std::runtime_error(path + " is truncated or corrupt"));
+    }
+
+    std::vector<ModelFile::LayerRecord> records(header.numLayers);
+    std::memcpy(records.data(), data + sizeof(header), records.size() * sizeof(ModelFile::LayerRecord));
+    if (verifyChecksum)
+    {
+        uint64_t checksum = ModelFile::Checksum(records.data(), records.size() * sizeof(ModelFile::LayerRecord));
+        checksum = ModelFile::Checksum(data + header.parameterOffset, size - header.parameterOffset, checksum);
+        if (checksum != header.checksum)
+        {
+            throw(std::runtime_error(path + " failed its checksum"));
+        }
+    }
+
+    // Whether count values starting at an offset lie inside the parameters, written so that no sum can overflow
+    auto fits = [&](uint64_t offset, uint64_t count)
+    {
+        return offset >= header.parameterOffset && offset <= size && count <= (size - offset) / header.scalarSize;
+    };
+    for (uint32_t i = 0 ; i < header.numLayers ; i++)
+    {
+        const ModelFile::LayerRecord& record = records[i];
+        const uint64_t numWeights = static_cast<uint64_t>(record.numInputs) * record.numNeurons;
+        const uint64_t numBiases = record.numInputs ? record.numNeurons : 0;
+        const bool chained = (i == 0) ? record.numInputs == 0 : record.numInputs == records[i - 1].numNeurons;
+        if (!chained || !record.numNeurons
+            || record.weightOffset % ModelFile::Alignment || record.biasOffset % ModelFile::Alignment
+            || !fits(record.weightOffset, numWeights) || !fits(record.biasOffset, numBiases))
+        {
+            throw(std::runtime_error(path + " has an invalid layer table"));
+        }
     }
-}
\ No newline at end of file
+
+    // Rebuild the network around the mapped weights, or around converted copies of them if they were saved as another type
+    const bool inPlace = header.scalarSize == sizeof(T);
+    std::vector<int> hiddenSizes;
+    for (uint32_t i = 1 ; i + 1 < header.numLayers ; i++)
+    {
+        hiddenSizes.push_back(records[i].numNeurons);
+    }
+    auto activation = [&](uint32_t i) { return Activation(static_cast<ActivationFunctions::ActivationType>(records[i].activationType)); };
+
+    BasicNeuralNetwork network(hiddenSizes, activation(1), LossFunctions::GetLossFunction(static_cast<LossFunctions::LossType>(header.lossType)));
+    network.numInputs = records.front().numNeurons;
+    network.numOutputs = records.back().numNeurons;
+    network.layerSizes.front() = network.numInputs;
+    network.layerSizes.back() = network.numOutputs;
+    network.outputActFunction = activation(header.numLayers - 1);
+    network.layers[0] = Layer(0, network.numInputs, ActivationFunctions::linear);
+    for (uint32_t i = 1 ; i < header.numLayers ; i++)
+    {
+        if (inPlace)
+        {
+            T* weights = reinterpret_cast<T*>(data + records[i].weightOffset);
+            T* biases = reinterpret_cast<T*>(data + records[i].biasOffset);
+            network.layers[i] = Layer(records[i].numInputs, records[i].numNeurons, activation(i), weights, biases);
+            continue;
+        }
+
+        Layer& layer = network.layers[i];
+        layer = Layer(records[i].numInputs, records[i].numNeurons, activation(i));
+        ConvertParameters(data + records[i].weightOffset, header.scalarSize, layer.GetNumWeights(), layer.GetWeights());
+        ConvertParameters(data + records[i].biasOffset, header.scalarSize, layer.GetNumBiases(), layer.GetBiases());
+    }
+
+    if (inPlace)
+    {
+        network.mappedModel = mapping;
+    }
+    network.initialized = true;
+    network.AllocateWorkspaces();
+    return network;
+}
+
+template<typename T, typename Accumulator>
+LossFunctions::LossType BasicNeuralNetwork<T, Accumulator>::GetLossType() const
+{
+    return this->lossType;
+}
+
+template<typename T, typename Accumulator>
+int BasicNeuralNetwork<T, Accumulator>::GetNumLayers() const
+{
+    return this->numLayers;
+}
+
+template<typename T, typename Accumulator>
+const typename BasicNeuralNetwork<T, Accumulator>::Layer& BasicNeuralNetwork<T, Accumulator>::GetLayer(int index) const
+{
+    if (!initialized)
+    {
+        throw(std::logic_error("Neural net is not initialized."));
+    }
+    if (index < 0 || index >= numLayers)
+    {
+        throw(std::invalid_argument("Layer index is out of bounds"));
+    }
+    return layers[index];
+}
+
+template<typename T, typename Accumulator>
+Neuron BasicNeuralNetwork<T, Accumulator>::GetNeuron(int layerIndex, int neuronIndex) const
+{
+    if (!initialized)
+    {
+        throw(std::logic_error("Neural net is not initialized."));
+    }
+    if (layerIndex < 0 || layerIndex >= numLayers)
+    {
+        throw(std::invalid_argument("Layer index is out of bounds"));
+    }
+
+    // The last output is taken from the first row the main thread propogated
+    Neuron neuron = layers[layerIndex].GetNeuron(neuronIndex);
+    neuron.SetOutput(workspaces[0].layers[layerIndex].outputs[neuronIndex]);
+    return neuron;
+}
+
+template class BasicNeuralNetwork<double>;
+template class BasicNeuralNetwork<float>;
+template class BasicNeuralNetwork<float, double>;
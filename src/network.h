@@ -3,85 +3,523 @@
 
 #include <iostream>
 #include <random>
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <limits>
+#include <optional>
+#include <algorithm>
 
-#include "neuron.h"
+#include "span.h"
+#include "layer.h"
+#include "dataset.h"
+#include "model_file.h"
+#include "profiler.h"
+#include "optimizer.h"
+#include "schedule.h"
+#include "checkpoint.h"
+#include "initializer.h"
+#include "thread_pool.h"
 
-class NeuralNetwork
+/// @brief Fully connected network templated on the type its weights and activations are stored in, T, and the type its
+///        matrix products accumulate in, Accumulator. Training data is always read as double and converted on the way in.
+///        Supported combinations are <double>, <float> and <float, double>, see the aliases after the class.
+template<typename T, typename Accumulator = T>
+class BasicNeuralNetwork
 {
     public:
+        using Layer = BasicLayer<T, Accumulator>;
+        using LayerBuffers = BasicLayerBuffers<T>;
+
+        /// @brief Ways in which Train() can spread work across threads
+        enum class TrainingMode
+        {
+            /// Batches are sharded across threads and the reduced gradients are applied once per batch (deterministic)
+            Synchronous,
+            /// Every thread trains on its own partition of the data one row at a time and applies its updates to the shared
+            /// weights immediately, without any locking (Hogwild). Faster, but not reproducible from run to run.
+            Hogwild
+        };
+
+        /// @brief Throughput counters collected during the last call to Train()
+        struct ThroughputStats
+        {
+            std::vector<double> samplesPerSecond;
+            double totalSamplesPerSecond = 0;
+        };
+
+        /// @brief Where Resume() picked training up
+        struct ResumePoint
+        {
+            /// Path of the checkpoint that was loaded, and the step it was taken at
+            std::string file;
+            long step = 0;
+            /// Epoch the next call to Train() continues, counting from one, and the number of its rows already trained on
+            int epoch = 1;
+            long epochRows = 0;
+            /// Newer checkpoints of the directory that could not be read, each with the reason it was skipped
+            std::vector<std::string> skipped;
+        };
+
+        /// @brief Losses and learning rate of one epoch of training
+        struct EpochStats
+        {
+            /// Index of the epoch, counting from one over every call to Train()
+            int epoch = 0;
+            /// Mean loss of the rows trained on during the epoch, each measured as it was trained on
+            double trainingLoss = 0;
+            /// Mean loss of the validation data at the end of the epoch, or NaN if it was not evaluated after this epoch
+            double validationLoss = std::numeric_limits<double>::quiet_NaN();
+            /// The learning rate the epoch was trained with
+            double learningRate = 0;
+        };
+
         /// @brief                   Neural network constructor that uses the neuron class for simple machine learning, and requires the
         ///                          user to input a single activation function that will be used by every neuron and every layer.
         /// @param neuronsPerLayer   Vector containing the number of neurons that should be in each layer of the network
         /// @param inputFunction     The activation function that should be used by all neurons
         /// @param errorFunction     The function that should be used to calculate loss by all neurons
         /// @param inputEpochs       The number of epochs to train for
-        /// @param inputLearningRate The factor that should be used when calculating gradient decent
-        /// @param inputCutoff       When loss falls below this point, the model will exit early. Defaults to never exiting early
-        NeuralNetwork(std::vector<int> neuronsPerLayer,
-                      std::function<double(double)> inputFunction,
-                      std::function<double(std::vector<double>, std::vector<double>)> inputErrorFunction,
-                      int epochs = 1000,
-                      double inputLearningRate = 0.01,
-                      double inputCutoff = 0.0);
+        /// @param inputLearningRate The learning rate of the default optimizer, plain stochastic gradient descent
+        /// @param inputCutoff       When the mean training loss of an epoch falls below this point, the model will exit early.
+        ///                          Defaults to never exiting early
+        BasicNeuralNetwork(std::vector<int> neuronsPerLayer,
+                           Activation inputFunction,
+                           std::function<double(std::vector<double>, std::vector<double>)> inputErrorFunction,
+                           int epochs = 1000,
+                           double inputLearningRate = 0.01,
+                           double inputCutoff = 0.0);
 
         /// @brief               Allows the user to set the activation function for all neurons in the output
-        ///                      layer. If not set, they default to linear.
+        ///                      layer. If not set, they default to linear. Throws if the loss takes logits, such as
+        ///                      LossFunctions::cross_entropy, which needs a linear output layer.
         /// @param inputFunction The activation function that should be used for all output neurons
-        void SetOutputActivationFunction(std::function<double(double)> inputFunction);
+        void SetOutputActivationFunction(Activation inputFunction);
+
+        /// @brief            Sets the derivative of a custom loss function with respect to each output, given the predicted
+        ///                   and the true value of that output. Networks with a custom loss can only be trained once it is
+        ///                   set, and throw if it is set for one of the built-in losses.
+        /// @param derivative The derivative of the loss function
+        void SetLossDerivative(std::function<double(double, double)> derivative);
         
         /// @brief               Allows the user to change the activation function for all neurons in a specific
         ///                      hidden layer. Can only be done after initialization.
         /// @param inputFunction The activation function that should be used for all neurons in this hidden layer
-        void ChangeHiddenLayerActivationFunction(std::function<double(double)> inputFunction, int layerIndex);
+        void ChangeHiddenLayerActivationFunction(Activation inputFunction, int layerIndex);
+
+        /// @brief      Sets the seed the initial weights are drawn from, so that the same seed always gives the same
+        ///             weights, whatever the number of threads. Defaults to a seed drawn from std::random_device when the
+        ///             network is constructed. Takes effect when Initialize() next generates the weights.
+        /// @param seed The seed
+        void SetSeed(uint64_t seed);
+
+        /// @brief  Returns the seed the initial weights are drawn from, for example to reproduce a run later
+        /// @return The seed
+        uint64_t GetSeed() const;
 
-        /// @brief       Initializes the neural network to for a specific dataset, ensuring layers are correctly setup
+        /// @brief             Sets the scheme the initial weights of every layer are drawn from, replacing the default, which
+        ///                    picks one per layer from its activation function, see Initializers::ForActivation(). Takes
+        ///                    effect when Initialize() next generates the weights.
+        /// @param initializer The initialization scheme, for example Initializers::HeNormal()
+        void SetWeightInitializer(const Initializer& initializer);
+
+        /// @brief             Sets the scheme the initial weights of one layer are drawn from
+        /// @param initializer The initialization scheme
+        /// @param layerIndex  Index of the layer, where 1 is the first hidden layer and GetNumLayers() - 1 the output layer
+        void SetWeightInitializer(const Initializer& initializer, int layerIndex);
+
+        /// @brief       Initializes the neural network to for a specific dataset, ensuring layers are correctly setup. If the
+        ///              network is already initialized (or was loaded from a file) for the same number of inputs and outputs,
+        ///              the existing weights are kept so that training continues from them. The dataset is copied once into
+        ///              contiguous storage and used by Train().
         /// @param xData Vector containing vectors with all of the input data
         /// @param yData Vector containing vectors with all of the output data that this model should predict
-        void Initialize(std::vector<std::vector<double>> xData, std::vector<std::vector<double>> yData);
+        void Initialize(const std::vector<std::vector<double>>& xData, const std::vector<std::vector<double>>& yData);
+
+        /// @brief        Initializes the neural network for the shape of a data source, without reading any of its rows. As with
+        ///               the other overload, existing weights are kept when the shape already matches.
+        /// @param source The data source that will be trained on
+        void Initialize(const DataSource& source);
+
+        /// @brief        Sets the number of epochs Train() runs for, for example to continue training a network opened with Load()
+        /// @param epochs The number of epochs to train for
+        void SetEpochs(int epochs);
+
+        /// @brief      Sets the number of rows that are propogated through the network together during training. Gradients
+        ///             are accumulated over a batch and the weights are updated once per batch with their mean. Defaults to 1.
+        /// @param rows The number of rows in each batch
+        void SetBatchSize(int rows);
+
+        /// @brief         Sets the number of threads used for data-parallel training. Each batch is split into contiguous shards
+        ///                that are propogated on separate threads with their own activation and gradient buffers, after which
+        ///                the gradients are reduced in a fixed order before updating the weights. For a fixed thread count the
+        ///                results are bit-identical from run to run. Use a batch size of at least the thread count. Defaults to 1.
+        /// @param threads The number of threads to train with
+        void SetNumThreads(int threads);
+
+        /// @brief        Backs the training workspaces with transparent huge pages, which saves TLB misses when the activations and
+        ///               gradients of every thread span many pages. Only has an effect on Linux and once the workspaces are
+        ///               at least 2 MB. Defaults to false.
+        /// @param enable Whether huge pages should be requested
+        void SetHugePages(bool enable);
 
-        /// @brief Runs through the neural network for all data in the set, back-propogates and then updates weights
+        /// @brief      Selects how Train() uses the threads set by SetNumThreads(). Defaults to TrainingMode::Synchronous.
+        /// @param mode The training mode to use
+        void SetTrainingMode(TrainingMode mode);
+
+        /// @brief           Replaces the optimizer that turns gradients into weight updates, which defaults to Optimizers::Sgd
+        ///                  with the learning rate given to the constructor. The network trains with its own copy, so one
+        ///                  optimizer can configure several networks. State such as velocities and moments is kept across
+        ///                  calls to Train(), and starts from zero when the optimizer is replaced or the topology changes.
+        /// @param optimizer The optimizer to train with, for example Optimizers::Adam(0.001)
+        void SetOptimizer(const Optimizer& optimizer);
+
+        /// @brief  Returns the optimizer the network trains with, for example to change its learning rate between calls to Train()
+        /// @return The optimizer
+        Optimizer& GetOptimizer();
+        const Optimizer& GetOptimizer() const;
+
+        /// @brief       Sets data that is held out from training and evaluated with the inference path, in parallel on the
+        ///              training threads, every SetValidationInterval() epochs. Its loss is reported alongside the training
+        ///              loss and drives early stopping and ReduceOnPlateau schedules in place of the training loss.
+        /// @param xData Vector containing vectors with all of the validation input data
+        /// @param yData Vector containing vectors with all of the validation output data
+        void SetValidationData(const std::vector<std::vector<double>>& xData, const std::vector<std::vector<double>>& yData);
+
+        /// @brief          Holds out the last fraction of the rows given to the next call to Initialize() with vectors and uses
+        ///                 them as validation data, see SetValidationData(). Rows are held out in order, so shuffle the data
+        ///                 first if it is sorted.
+        /// @param fraction Fraction of the rows to hold out, in [0, 1), where 0 turns the split off
+        void SetValidationSplit(double fraction);
+
+        /// @brief        Sets how often the validation data is evaluated. It is also always evaluated after the last epoch.
+        ///               Defaults to every epoch.
+        /// @param epochs The number of epochs between evaluations
+        void SetValidationInterval(int epochs);
+
+        /// @brief                    Stops training once the monitored loss, the validation loss if there is validation data
+        ///                           and the mean training loss of the epoch otherwise, has not improved for a number of
+        ///                           evaluations in a row within one call to Train()
+        /// @param patience           The number of evaluations without improvement to stop after, where 0 turns early
+        ///                           stopping off (the default)
+        /// @param minDelta           The amount the loss has to fall by to count as an improvement
+        /// @param restoreBestWeights Whether the weights of the evaluation with the lowest loss are restored when training ends
+        void SetEarlyStopping(int patience, double minDelta = 0, bool restoreBestWeights = true);
+
+        /// @brief          Sets the learning rate of the optimizer at the start of every epoch, relative to the learning rate
+        ///                 the optimizer has now, for example Schedules::Cosine(epochs). The network keeps its own copy.
+        /// @param schedule The schedule to follow
+        void SetLearningRateSchedule(const LearningRateSchedule& schedule);
+
+        /// @brief Stops following a learning rate schedule, leaving the optimizer at its current learning rate
+        void RemoveLearningRateSchedule();
+
+        /// @brief            Writes a checkpoint of the training state every few steps of Train(), holding the weights, the
+        ///                   optimizer and schedule state, the position within the epoch, the losses and early stopping
+        ///                   state so far and the history. The state is copied into memory on the training thread and written
+        ///                   to disk by a background thread while training continues, see CheckpointWriter.
+        /// @param directory  Directory to write the checkpoints to, created if it does not exist
+        /// @param everySteps The number of steps between checkpoints, where a step is one batch, or in TrainingMode::Hogwild
+        ///                   one chunk of rows shared by the threads
+        /// @param keep       The number of most recent checkpoints to keep
+        void SetCheckpointing(const std::string& directory, long everySteps, int keep = 3);
+
+        /// @brief Stops writing checkpoints, after waiting for any that are still being written
+        void DisableCheckpointing();
+
+        /// @brief      Loads a checkpoint written during Train(), so that the next call to Train() continues the interrupted
+        ///             call from the step the checkpoint was taken at. The network must be configured as it was when the
+        ///             checkpoint was written (topology, precision, optimizer type, schedule type, batch size, thread count
+        ///             and training data) before calling this. A Synchronous run continues bit-exactly, as if it had never
+        ///             stopped, provided the data source visits its rows in the same order. A DataPipeline is moved on to the
+        ///             shuffle of the epoch being resumed, even one that has already been read from, see DataSource::SetEpoch().
+        /// @param path Path of a checkpoint file, or of a checkpoint directory, in which case the latest checkpoint that
+        ///             passes its checksum is loaded
+        /// @return     The checkpoint loaded and the position training continues from
+        ResumePoint Resume(const std::string& path);
+
+        /// @brief  Returns the losses and learning rate of every epoch of the last call to Train()
+        /// @return One entry per epoch trained
+        const std::vector<EpochStats>& GetHistory() const;
+
+        /// @brief  Returns the number of rows each thread trained on per second of wall time during the last call to Train()
+        /// @return The throughput counters
+        const ThroughputStats& GetThroughputStats() const;
+
+        /// @brief Runs through the neural network for all data in the set one batch at a time, back-propogates and then updates weights
         void Train();
 
+        /// @brief        Trains on every row of a data source once per epoch, streaming one batch at a time so that only a
+        ///               single batch of the dataset is held in memory by the network. Wrap the source in a DataPipeline to
+        ///               shuffle it and to read the next batches in the background while the current one is trained on.
+        /// @param source The data source to train on, which must match the number of network inputs and outputs
+        void Train(DataSource& source);
+
+        /// @brief             Turns the training profiler on or off. While it is on, Train() records the wall time, call count
+        ///                    and estimated floating point operations of data loading, the loss and the forward, backward and
+        ///                    weight update passes of every layer, on every thread. Turning it on again starts a new profile.
+        ///                    The recording calls only exist when the library is built with NN_ENABLE_PROFILING defined, so
+        ///                    that they cost nothing otherwise, and without it this throws.
+        /// @param enable      Whether the profiler should be on
+        /// @param recordTrace Whether every timed region should also be kept for WriteProfileTrace()
+        void EnableProfiling(bool enable = true, bool recordTrace = false);
+
+        /// @brief  Returns what the profiler has recorded since it was turned on. Throws if it is off.
+        /// @return The profile, per phase and per layer
+        Profiler::Report GetProfile() const;
+
+        /// @brief      Writes the timeline recorded by the profiler as a Chrome trace event JSON file, for chrome://tracing or
+        ///             Perfetto. Throws if the profiler is off or was turned on without recordTrace.
+        /// @param path Path of the file to write
+        void WriteProfileTrace(const std::string& path) const;
+
+        /// @brief        Runs the trained network on a single row of new data. This is const and reentrant, so it can be called
+        ///               concurrently from many threads against one shared model, but not while the model is being trained.
+        ///               Intermediate results are kept in a thread-local buffer that is only allocated on a thread's first call.
+        ///               When the loss takes logits the outputs are the probabilities it models rather than the logits.
+        /// @param input  Pointer to the input values, one per input neuron
+        /// @param output Pointer to where the output values are written, one per output neuron
+        void Predict(const T* input, T* output) const;
+
+        /// @brief         Runs the trained network on a batch of rows of new data, with the same guarantees as Predict()
+        /// @param inputs  Row-major matrix of input values, whose size must be a multiple of the number of inputs
+        /// @param outputs Row-major matrix the output values are written to, with one row per input row
+        void PredictBatch(Span<const T> inputs, Span<T> outputs) const;
+
+        /// @brief         Runs the trained network on a batch of rows of new data using a caller-provided scratch buffer
+        ///                instead of a thread-local one, so that the call never allocates
+        /// @param inputs  Row-major matrix of input values, whose size must be a multiple of the number of inputs
+        /// @param outputs Row-major matrix the output values are written to, with one row per input row
+        /// @param scratch Buffer for intermediate results, of at least GetPredictScratchSize(rows) values
+        void PredictBatch(Span<const T> inputs, Span<T> outputs, Span<T> scratch) const;
+
+        /// @brief      Get the size of the scratch buffer needed to predict a batch of rows
+        /// @param rows The number of rows in the batch
+        /// @return     The number of values the scratch buffer must hold
+        size_t GetPredictScratchSize(int rows) const;
+
+        /// @brief      Saves the topology, activation functions, loss function, weights and biases of the network to a versioned
+        ///             binary model file that can be opened with Load(). The parameters are stored as T. Only the built-in
+        ///             activation and loss functions can be saved.
+        /// @param path Path of the file to write
+        void Save(const std::string& path) const;
+
+        /// @brief                Opens a model file written by Save(). The file is memory mapped and the weights are used in place
+        ///                       without copying, so loading is fast regardless of model size and every process that loads the
+        ///                       same file shares one page-cached copy of the weights. Training a loaded network only copies the
+        ///                       pages it modifies and never changes the file. A file saved at a different precision than T is
+        ///                       converted into weights owned by the network instead.
+        /// @param path           Path of the file to open
+        /// @param verifyChecksum Whether to verify the checksum of the file, which requires reading all of the weights once
+        /// @return               The loaded network, ready for Predict() or for Initialize() with new data
+        static BasicNeuralNetwork Load(const std::string& path, bool verifyChecksum = true);
+
+        /// @brief  Get the type of the loss function the network is trained with
+        /// @return The loss type
+        LossFunctions::LossType GetLossType() const;
+
+        /// @brief  Get the number of layers in the network, including the input and output layers
+        /// @return The number of layers
+        int GetNumLayers() const;
+
+        /// @brief       Returns one layer of the network, for tools that work on the trained weights directly
+        /// @param index Index of the layer, where 0 is the input layer
+        /// @return      The layer
+        const Layer& GetLayer(int index) const;
+
+        /// @brief             Returns a standalone copy of one neuron in the network, for compatibility with the Neuron class
+        /// @param layerIndex  Index of the layer, where 0 is the input layer
+        /// @param neuronIndex Index of the neuron within the layer
+        /// @return            Copy of the neuron
+        Neuron GetNeuron(int layerIndex, int neuronIndex) const;
+
     private:
         /// @brief        Creates the input layer, which has no bias and doesn't alter data
         void SetupInputLayer();
 
         /// @brief Creates all of the hidden layers and hidden neurons, and sets up the output vector to track
-        ///        data produced by these neurons during each run. Note that weights and biases are randomly
-        ///        generated during this initialization process.
+        ///        data produced by these neurons during each run
         void SetupHiddenLayers();
 
         /// @brief                Creates the output layer of the neural net
         void SetupOutputLayer();
 
-        /// @brief              A single run through of the neural network
-        /// @param currentIndex Row index of the data being trained on
-        void Forward(int currentIndex);
+        /// @brief Working memory owned by a single training thread
+        struct Workspace
+        {
+            std::vector<LayerBuffers> layers;
+            /// Sum of the losses of the rows trained on since the start of the epoch
+            double loss = 0;
+            int threadIndex = 0;
+            /// Rows the thread trained on in the last call of TrainBatch() or TrainHogwild(), and since Train() started
+            int rows = 0;
+            long samples = 0;
+        };
+
+        /// @brief Progress of the current call to Train(), which is saved in checkpoints so that Resume() can continue it
+        struct RunState
+        {
+            /// Epoch of the call being trained, counting from one, and the number of its rows trained on so far
+            int epoch = 1;
+            long epochRows = 0;
+            /// Lowest monitored loss and the epoch it was seen at, the last loss that reset the patience, and the number
+            /// of evaluations since then
+            double bestLoss = std::numeric_limits<double>::infinity();
+            double improvedLoss = std::numeric_limits<double>::infinity();
+            int bestEpoch = 0;
+            int waits = 0;
+        };
+
+        /// @brief Sizes the thread pool and one workspace per thread for the current batch size and thread count. The
+        ///        buffers of every workspace are planned together and taken from one arena, so training allocates nothing
+        ///        once they are set up.
+        void AllocateWorkspaces();
 
-        /// @brief  Propogates backward through the neural networks outputs, calculating the derivative at each point
-        /// @param currentIndex Row index of the yData that results should be compared with
-        void BackPropogate(int currentIndex);
+        /// @brief         Reads the next batch of rows from a data source into the batch buffers
+        /// @param source  The data source to read from
+        /// @param maxRows The maximum number of rows to read
+        /// @return        The number of rows read, which is zero once every row has been read
+        int ReadBatch(DataSource& source, int maxRows);
 
-        /// @brief  Generates a random number to be used when initializing biases and weights
-        /// @return Randomly generated number
-        double GenerateRandomNumber();
+        /// @brief         Trains on one batch, sharding its rows across the thread pool and then updating the weights
+        /// @param inputs  Row-major matrix of the input values of the batch
+        /// @param targets Row-major matrix of the output values that results should be compared with
+        /// @param rows    Number of rows in the batch
+        void TrainBatch(const double* inputs, const double* targets, int rows);
+
+        /// @brief         Trains on a chunk of rows in TrainingMode::Hogwild, where every thread trains on its own partition
+        /// @param inputs  Row-major matrix of the input values of the chunk
+        /// @param targets Row-major matrix of the output values that results should be compared with
+        /// @param rows    Number of rows in the chunk
+        void TrainHogwild(const double* inputs, const double* targets, int rows);
+
+        /// @brief           A single run through of the neural network for a batch of rows
+        /// @param workspace The workspace that the outputs of each layer are written to
+        /// @param inputs    Row-major matrix of the input values of the batch
+        /// @param rows      Number of rows in the batch
+        void Forward(Workspace& workspace, const double* inputs, int rows);
+
+        /// @brief           Propogates backward through the neural networks outputs for a batch of rows, reusing the activation
+        ///                  derivatives kept by the forward pass and passing the error terms of each layer back through its
+        ///                  weights, to calculate the gradients of every layer for the batch
+        /// @param workspace The workspace holding the results of the forward pass, where the gradients are written to
+        /// @param targets   Row-major matrix of the output values that results should be compared with
+        /// @param rows      Number of rows in the batch
+        void BackPropogate(Workspace& workspace, const double* targets, int rows);
+
+        /// @brief             Reduces the gradients of every workspace into the first in thread order and passes their mean to
+        ///                    the optimizer. Each thread handles its own contiguous slice of every layer's parameters.
+        /// @param rows        Total number of rows in the batch
+        /// @param threadIndex Index of the thread running this slice of the update
+        void ApplyGradients(int rows, int threadIndex);
+
+        /// @brief         Calculates the loss of a set of rows
+        /// @param outputs Row-major matrix of the values predicted by the network
+        /// @param targets Row-major matrix of the values that should have been predicted
+        /// @param rows    Number of rows
+        /// @return        The sum of the loss of each row
+        double ComputeLoss(const T* outputs, const double* targets, int rows) const;
+
+        /// @brief Runs the layers on a batch of rows with the checks of PredictBatch(), leaving the outputs of the last layer
+        ///        as they are, which are logits when the loss takes them
+        void PredictLogits(Span<const T> inputs, Span<T> outputs, Span<T> scratch) const;
+
+        /// @brief  Runs the network on the validation data, splitting the rows across the thread pool
+        /// @return The mean loss of the validation rows
+        double Validate();
+
+        /// @brief Copies the weights and biases of every layer into the best parameters, or back out of them
+        void SaveBestParameters();
+        void RestoreBestParameters();
+
+        /// @brief Copies the training state into a buffer of the checkpoint writer and queues it to be written
+        void WriteCheckpoint();
+
+        /// @brief Sizes the state of the optimizer for the weights and biases of every layer, keeping it if it already fits
+        void InitializeOptimizer();
+
+        /// @brief Draws the weights of every layer from its initializer, splitting each layer across the thread pool when
+        ///        there are enough weights to share out. The biases are left at zero.
+        void InitializeWeights();
+
+        /// Fewest weights each thread draws in InitializeWeights(), below which waking the pool costs more than it saves
+        static constexpr size_t InitializeWeightsPerThread = 1 << 18;
+
+        /// Number of rows each thread trains on between reads from the data source in TrainingMode::Hogwild
+        static constexpr int HogwildRowsPerThread = 1024;
+
+        /// Number of validation rows each thread predicts at a time, which bounds the size of its scratch buffer
+        static constexpr int ValidationRowsPerCall = 256;
 
         /// Attributes of the neural network
         int epochs;
         int numInputs;
         int numOutputs;
         int numLayers;
+        int batchSize;
+        int numThreads;
+        TrainingMode trainingMode;
+        ThroughputStats throughputStats;
         double cutoff;
         double epochErr;
-        double learningRate;
-        std::vector<std::vector<Neuron>> layers;
-        std::function<double(double)> actFunction;
-        std::function<double(double)> outputActFunction;
-        std::vector<std::vector<double>> xData;
-        std::vector<std::vector<double>> yData;
+        std::vector<int> layerSizes;
+        std::vector<Layer> layers;
+        std::vector<Workspace> workspaces;
+        /// Memory behind the buffers of every workspace, and whether it is backed by huge pages
+        Arena workspaceArena;
+        bool hugePages;
+        std::unique_ptr<ThreadPool> threadPool;
+        std::unique_ptr<Profiler> profiler;
+        std::unique_ptr<Optimizer> optimizer;
+        /// Step of the optimizer that the current batch is applied with
+        long optimizerStep;
+        std::unique_ptr<LearningRateSchedule> schedule;
+        /// Learning rate the schedule is relative to, and the number of epochs trained over every call to Train()
+        double baseLearningRate;
+        int trainedEpochs;
+        std::vector<EpochStats> history;
+        std::unique_ptr<InMemoryDataSource> validationData;
+        /// Validation inputs converted to T once, and the outputs (logits for losses that take them) and per thread losses of
+        /// the last evaluation
+        std::vector<T> validationInputs;
+        std::vector<T> validationOutputs;
+        std::vector<double> validationLosses;
+        double validationSplit;
+        int validationInterval;
+        int patience;
+        double minDelta;
+        bool restoreBestWeights;
+        /// Weights and biases of every layer at the best evaluation so far, two entries per layer after the input layer
+        std::vector<std::vector<T>> bestParameters;
+        /// Number of steps trained over every call to Train(), the progress of the current call and whether it is being
+        /// resumed from a checkpoint
+        long trainedSteps;
+        RunState run;
+        bool resuming;
+        std::unique_ptr<CheckpointWriter> checkpointWriter;
+        long checkpointInterval;
+        /// Seed of the initial weights, and the initializer of every layer that was given one
+        uint64_t seed;
+        std::vector<std::optional<Initializer>> initializers;
+        /// Size of every block of parameters given to the optimizer, kept so that checking them does not allocate
+        std::vector<size_t> optimizerBlocks;
+        std::shared_ptr<MappedFile> mappedModel;
+        Activation actFunction;
+        Activation outputActFunction;
+        std::unique_ptr<DataSource> trainingData;
+        std::vector<double> batchInputs;
+        std::vector<double> batchOutputs;
         std::function<double(double, double)> errorFunctionDerivative;
         std::function<double(std::vector<double>, std::vector<double>)> errorFunction;
+        LossFunctions::LossType lossType;
         bool initialized;
 };
 
+using NeuralNetwork = BasicNeuralNetwork<double>;
+using FloatNeuralNetwork = BasicNeuralNetwork<float>;
+/// Stores weights and activations as float, halving memory traffic, while every matrix product accumulates in double
+using MixedPrecisionNeuralNetwork = BasicNeuralNetwork<float, double>;
+
 #endif // NETWORK_H
\ No newline at end of file
@@ -8,28 +8,26 @@ Neuron::Neuron()
 {
 }
 
-Neuron::Neuron(std::function<double(double)> inputFunction)
+Neuron::Neuron(Activation inputFunction)
                :
                weights(nullWeights),
                bias(nullBias),
-               f(inputFunction), 
+               activation(inputFunction),
                state(false)
 {
-    this->df = ActivationFunctions::GetDerivativeFunctionName(f);
 }
 
-Neuron::Neuron(std::vector<double> inputWeights, double inputBias, std::function<double(double)> inputFunction)
+Neuron::Neuron(std::vector<double> inputWeights, double inputBias, Activation inputFunction)
                :
                weights(inputWeights),
                bias(inputBias),
-               f(inputFunction),
+               activation(inputFunction),
                state(true)
 {
     this->numInputs = weights.size();
-    this->df = ActivationFunctions::GetDerivativeFunctionName(f);
 }
 
-double Neuron::Forward(std::vector<Neuron> inputs)
+double Neuron::Forward(const std::vector<Neuron>& inputs)
 {
     // Verify the neuron is valid and has been initialized
     if (!state)
@@ -49,7 +47,7 @@ double Neuron::Forward(std::vector<Neuron> inputs)
     return this->lastOutput;
 }
 
-double Neuron::Backward(std::vector<Neuron> inputs)
+double Neuron::Backward(const std::vector<Neuron>& inputs)
 {
     // Verify the neuron is valid and has been initialized
     if (!state)
@@ -69,7 +67,7 @@ double Neuron::Backward(std::vector<Neuron> inputs)
     return output;
 }
 
-double Neuron::DotProduct(std::vector<Neuron> left, std::vector<double> right)
+double Neuron::DotProduct(const std::vector<Neuron>& left, const std::vector<double>& right)
 {
     double sum {0};
 
@@ -124,21 +122,20 @@ void Neuron::UpdateBias(double delta)
     this->bias -= delta;
 }
 
-void Neuron::SetActivationFunction(std::function<double(double)> inputFunction)
+void Neuron::SetActivationFunction(Activation inputFunction)
 {
-    this->f = inputFunction;
-    this->df = ActivationFunctions::GetDerivativeFunctionName(f);
+    this->activation = inputFunction;
     IsInitialized();
 }
 
 double Neuron::GetActivationFunctionValue(double input)
 {
-    return this->f(input);
+    return this->activation(input);
 }
 
 double Neuron::GetActivationFunctionDerivativeValue(double input)
 {
-    return this->df(input);
+    return this->activation.Derivative(input);
 }  
 
 bool Neuron::IsInitialized()
@@ -147,7 +144,7 @@ bool Neuron::IsInitialized()
     {
         return true;
     }
-    else if (weights == nullWeights || bias == nullBias || !f)
+    else if (weights == nullWeights || bias == nullBias)
     {
         this->state = false;
     }
@@ -160,7 +157,7 @@ bool Neuron::IsInitialized()
 
 }
 
-double Neuron::GetLastOutput()
+double Neuron::GetLastOutput() const
 {
     return this->lastOutput;
 }
@@ -2,6 +2,7 @@
 #define NEURON_H
 
 #include <vector>
+#include <climits>
 #include <numeric>
 #include <stdexcept>
 #include <functional>
@@ -14,30 +15,30 @@ class Neuron
         Neuron();
 
         /// @brief               Create a neuron with no bias or weights, they must be set later on before the neuron is used
-        /// @param inputFunction 
-        Neuron(std::function<double(double)> inputFunction);
+        /// @param inputFunction The activation function that should be used by this neuron
+        Neuron(Activation inputFunction);
 
         /// @class               Simple implementation of a neuron that allows a variable number of inputs
         /// @param inputWeights  Vector of the weights that should be used for each input
         /// @param inputBias     Bias that should be added to the final calculation
         /// @param inputFunction The activation function that should be used by this neuron
-        Neuron(std::vector<double> inputWeights, double inputBias, std::function<double(double)> inputFunction = ActivationFunctions::linear);
+        Neuron(std::vector<double> inputWeights, double inputBias, Activation inputFunction = ActivationFunctions::linear);
 
         /// @brief        Calculates the output for a given set of inputs to a neuron
         /// @param inputs Vector containing the input Neurons that should be fed to this neuron when doing a forward calculation
         /// @return       Output of this neuron, which is f(dotProduct + bias)
-        double Forward(std::vector<Neuron> inputs);
+        double Forward(const std::vector<Neuron>& inputs);
 
         /// @brief        Calculates the output to the derivative for the activation function, which is needed for backwards propogation
         /// @param inputs Vector containing the input neurons that should be fed to this neuron when doing a backwards calculation
         /// @return       Output of this neuron, which is df(dotProduct + bias)
-        double Backward(std::vector<Neuron> inputs);
+        double Backward(const std::vector<Neuron>& inputs);
 
         /// @brief       Calculates the dot product for two given vectors
         /// @param left  The left vector used to calculate the dot product
         /// @param right The right vector used to calculate the dot product 
         /// @return      The dot product
-        double DotProduct(std::vector<Neuron> left, std::vector<double> right);
+        double DotProduct(const std::vector<Neuron>& left, const std::vector<double>& right);
 
         /// @brief         Initialize or set all of the weights on this neuron
         /// @param weights Vector of the weights that should be used for each input
@@ -70,7 +71,7 @@ class Neuron
 
         /// @brief          Initialize or change the activation function on this neuron
         /// @param function The activation function that should be used by this neuron
-        void SetActivationFunction(std::function<double(double)> inputFunction);
+        void SetActivationFunction(Activation inputFunction);
 
         /// @brief  Returns the ouput of the activation function for a given value
         /// @return Output of the activation function
@@ -86,7 +87,7 @@ class Neuron
 
         /// @brief  Returns the last calculated value from this neuron
         /// @return The last value calculated and output by this neuron
-        double GetLastOutput();
+        double GetLastOutput() const;
 
         /// @brief       Set the output value of this neuron, which is needed for setting up input neurons
         /// @param input The value to set this neuron's output to
@@ -103,8 +104,7 @@ class Neuron
         bool state;
         int numInputs;
         double lastOutput;
-        std::function<double(double)> f;
-        std::function<double(double)> df;
+        Activation activation;
         std::vector<double> weights;
 };
 
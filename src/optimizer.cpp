@@ -0,0 +1,393 @@
+#include "optimizer.h"
+#include "kernels.h"
+
+#include <cmath>
+
+Optimizer::Optimizer(double inputLearningRate)
+                    :
+                    learningRate(inputLearningRate),
+                    scalarSize(0),
+                    steps(0)
+{
+    if (!(learningRate >= 0))
+    {
+        throw(std::invalid_argument("The learning rate must not be negative"));
+    }
+}
+
+Optimizer::Optimizer(const Optimizer& other)
+                    :
+                    learningRate(other.learningRate),
+                    blockSizes(other.blockSizes),
+                    scalarSize(other.scalarSize),
+                    steps(other.steps.load())
+{
+    AllocateState(other.doubleState.size() + other.floatState.size());
+    for (size_t b = 0 ; b < doubleState.size() ; b++)
+    {
+        std::copy(other.doubleState[b].begin(), other.doubleState[b].end(), doubleState[b].begin());
+    }
+    for (size_t b = 0 ; b < floatState.size() ; b++)
+    {
+        std::copy(other.floatState[b].begin(), other.floatState[b].end(), floatState[b].begin());
+    }
+}
+
+void Optimizer::Initialize(const std::vector<size_t>& inputBlockSizes, size_t inputScalarSize)
+{
+    if (inputScalarSize != sizeof(float) && inputScalarSize != sizeof(double))
+    {
+        throw(std::invalid_argument("Optimizers only support float and double parameters"));
+    }
+    if (inputBlockSizes == blockSizes && inputScalarSize == scalarSize)
+    {
+        return;
+    }
+
+    blockSizes = inputBlockSizes;
+    scalarSize = inputScalarSize;
+    Reset();
+}
+
+void Optimizer::Reset()
+{
+    AllocateState(static_cast<size_t>(GetNumStates()) * blockSizes.size());
+    steps = 0;
+}
+
+void Optimizer::AllocateState(size_t numBuffers)
+{
+    // Only the buffers of the precision in use are allocated
+    size_t bytes = 0;
+    for (size_t b = 0 ; b < numBuffers ; b++)
+    {
+        const size_t size = blockSizes[b % blockSizes.size()];
+        bytes += (scalarSize == sizeof(double)) ? Arena::GetSize<double>(size) : Arena::GetSize<float>(size);
+    }
+    state.Reserve(bytes);
+
+    doubleState.assign(scalarSize == sizeof(double) ? numBuffers : 0, Span<double>());
+    floatState.assign(scalarSize == sizeof(float) ? numBuffers : 0, Span<float>());
+    for (size_t b = 0 ; b < numBuffers ; b++)
+    {
+        const size_t size = blockSizes[b % blockSizes.size()];
+        if (scalarSize == sizeof(double))
+        {
+            doubleState[b] = state.Allocate<double>(size);
+        }
+        else
+        {
+            floatState[b] = state.Allocate<float>(size);
+        }
+    }
+}
+
+long Optimizer::BeginStep()
+{
+    return ++steps;
+}
+
+double Optimizer::GetLearningRate() const
+{
+    return learningRate;
+}
+
+void Optimizer::SetLearningRate(double inputLearningRate)
+{
+    if (!(inputLearningRate >= 0))
+    {
+        throw(std::invalid_argument("The learning rate must not be negative"));
+    }
+    learningRate = inputLearningRate;
+}
+
+long Optimizer::GetStepCount() const
+{
+    return steps;
+}
+
+void Optimizer::SaveState(Checkpoint::Encoder& encoder) const
+{
+    encoder.Write(learningRate);
+    encoder.Write<int64_t>(steps);
+    encoder.Write<uint64_t>(scalarSize);
+    encoder.Write<uint64_t>(blockSizes.size());
+    for (size_t size : blockSizes)
+    {
+        encoder.Write<uint64_t>(size);
+    }
+    for (const Span<double>& values : doubleState)
+    {
+        encoder.WriteArray(values.data(), values.size());
+    }
+    for (const Span<float>& values : floatState)
+    {
+        encoder.WriteArray(values.data(), values.size());
+    }
+}
+
+void Optimizer::LoadState(Checkpoint::Decoder& decoder)
+{
+    const double savedLearningRate = decoder.Read<double>();
+    const int64_t savedSteps = decoder.Read<int64_t>();
+    const uint64_t savedScalarSize = decoder.Read<uint64_t>();
+    bool matches = savedScalarSize == scalarSize && decoder.ReadCount() == blockSizes.size();
+    for (size_t i = 0 ; matches && i < blockSizes.size() ; i++)
+    {
+        matches = decoder.Read<uint64_t>() == blockSizes[i];
+    }
+    if (!matches)
+    {
+        throw(std::invalid_argument("Optimizer state does not match the parameters it is being loaded for"));
+    }
+
+    // Every buffer is checked before it is read, so that a mismatch never leaves half of the state loaded
+    auto read = [&decoder](auto& buffers)
+    {
+        for (auto& values : buffers)
+        {
+            if (decoder.ReadCount() != values.size())
+            {
+                throw(std::invalid_argument("Optimizer state does not match the parameters it is being loaded for"));
+            }
+            decoder.ReadValues(values.data(), values.size());
+        }
+    };
+    read(doubleState);
+    read(floatState);
+    SetLearningRate(savedLearningRate);
+    steps = savedSteps;
+}
+
+template<>
+double* Optimizer::GetState(int index, int block, size_t start)
+{
+    if (scalarSize != sizeof(double))
+    {
+        throw(std::logic_error("Optimizer has not been initialized for double parameters"));
+    }
+    return doubleState[static_cast<size_t>(index) * blockSizes.size() + block].data() + start;
+}
+
+template<>
+float* Optimizer::GetState(int index, int block, size_t start)
+{
+    if (scalarSize != sizeof(float))
+    {
+        throw(std::logic_error("Optimizer has not been initialized for float parameters"));
+    }
+    return floatState[static_cast<size_t>(index) * blockSizes.size() + block].data() + start;
+}
+
+Optimizers::Sgd::Sgd(double learningRate, double inputWeightDecay)
+                    :
+                    Optimizer(learningRate),
+                    weightDecay(inputWeightDecay)
+{
+}
+
+std::unique_ptr<Optimizer> Optimizers::Sgd::Clone() const
+{
+    return std::make_unique<Sgd>(*this);
+}
+
+std::string Optimizers::Sgd::GetName() const
+{
+    return "sgd";
+}
+
+int Optimizers::Sgd::GetNumStates() const
+{
+    return 0;
+}
+
+void Optimizers::Sgd::Update(long, int block, size_t start, size_t count, double* parameters, const double* gradients, double gradientScale)
+{
+    UpdateValues(block, start, count, parameters, gradients, gradientScale);
+}
+
+void Optimizers::Sgd::Update(long, int block, size_t start, size_t count, float* parameters, const float* gradients, float gradientScale)
+{
+    UpdateValues(block, start, count, parameters, gradients, gradientScale);
+}
+
+template<typename T>
+void Optimizers::Sgd::UpdateValues(int, size_t, size_t count, T* parameters, const T* gradients, T gradientScale)
+{
+    Kernels::StepParameters<T> step;
+    step.learningRate = learningRate;
+    step.gradientScale = gradientScale;
+    step.l2 = weightDecay;
+    Kernels::SgdStep(count, step, parameters, gradients);
+}
+
+Optimizers::Momentum::Momentum(double learningRate, double inputMomentum, double inputWeightDecay)
+                              :
+                              Optimizer(learningRate),
+                              momentum(inputMomentum),
+                              weightDecay(inputWeightDecay)
+{
+    if (momentum < 0 || momentum >= 1)
+    {
+        throw(std::invalid_argument("Momentum must be in [0, 1)"));
+    }
+}
+
+std::unique_ptr<Optimizer> Optimizers::Momentum::Clone() const
+{
+    return std::make_unique<Momentum>(*this);
+}
+
+std::string Optimizers::Momentum::GetName() const
+{
+    return "momentum";
+}
+
+int Optimizers::Momentum::GetNumStates() const
+{
+    return 1;
+}
+
+void Optimizers::Momentum::Update(long, int block, size_t start, size_t count, double* parameters, const double* gradients, double gradientScale)
+{
+    UpdateValues(block, start, count, parameters, gradients, gradientScale);
+}
+
+void Optimizers::Momentum::Update(long, int block, size_t start, size_t count, float* parameters, const float* gradients, float gradientScale)
+{
+    UpdateValues(block, start, count, parameters, gradients, gradientScale);
+}
+
+template<typename T>
+void Optimizers::Momentum::UpdateValues(int block, size_t start, size_t count, T* parameters, const T* gradients, T gradientScale)
+{
+    Kernels::StepParameters<T> step;
+    step.learningRate = learningRate;
+    step.gradientScale = gradientScale;
+    step.l2 = weightDecay;
+    step.beta1 = momentum;
+    Kernels::MomentumStep(count, step, parameters, gradients, GetState<T>(0, block, start));
+}
+
+Optimizers::RmsProp::RmsProp(double learningRate, double inputRho, double inputEpsilon, double inputWeightDecay)
+                            :
+                            Optimizer(learningRate),
+                            rho(inputRho),
+                            epsilon(inputEpsilon),
+                            weightDecay(inputWeightDecay)
+{
+    if (rho < 0 || rho >= 1 || !(epsilon > 0))
+    {
+        throw(std::invalid_argument("RMSProp needs rho in [0, 1) and a positive epsilon"));
+    }
+}
+
+std::unique_ptr<Optimizer> Optimizers::RmsProp::Clone() const
+{
+    return std::make_unique<RmsProp>(*this);
+}
+
+std::string Optimizers::RmsProp::GetName() const
+{
+    return "rmsprop";
+}
+
+int Optimizers::RmsProp::GetNumStates() const
+{
+    return 1;
+}
+
+void Optimizers::RmsProp::Update(long, int block, size_t start, size_t count, double* parameters, const double* gradients, double gradientScale)
+{
+    UpdateValues(block, start, count, parameters, gradients, gradientScale);
+}
+
+void Optimizers::RmsProp::Update(long, int block, size_t start, size_t count, float* parameters, const float* gradients, float gradientScale)
+{
+    UpdateValues(block, start, count, parameters, gradients, gradientScale);
+}
+
+template<typename T>
+void Optimizers::RmsProp::UpdateValues(int block, size_t start, size_t count, T* parameters, const T* gradients, T gradientScale)
+{
+    Kernels::StepParameters<T> step;
+    step.learningRate = learningRate;
+    step.gradientScale = gradientScale;
+    step.l2 = weightDecay;
+    step.beta2 = rho;
+    step.epsilon = epsilon;
+    Kernels::RmsPropStep(count, step, parameters, gradients, GetState<T>(0, block, start));
+}
+
+Optimizers::Adam::Adam(double learningRate, double inputBeta1, double inputBeta2, double inputEpsilon, double inputWeightDecay)
+                      :
+                      Optimizer(learningRate),
+                      beta1(inputBeta1),
+                      beta2(inputBeta2),
+                      epsilon(inputEpsilon),
+                      l2(inputWeightDecay),
+                      decay(0)
+{
+    if (beta1 < 0 || beta1 >= 1 || beta2 < 0 || beta2 >= 1 || !(epsilon > 0))
+    {
+        throw(std::invalid_argument("Adam needs betas in [0, 1) and a positive epsilon"));
+    }
+}
+
+std::unique_ptr<Optimizer> Optimizers::Adam::Clone() const
+{
+    return std::make_unique<Adam>(*this);
+}
+
+std::string Optimizers::Adam::GetName() const
+{
+    return "adam";
+}
+
+int Optimizers::Adam::GetNumStates() const
+{
+    return 2;
+}
+
+void Optimizers::Adam::Update(long step, int block, size_t start, size_t count, double* parameters, const double* gradients, double gradientScale)
+{
+    UpdateValues(step, block, start, count, parameters, gradients, gradientScale);
+}
+
+void Optimizers::Adam::Update(long step, int block, size_t start, size_t count, float* parameters, const float* gradients, float gradientScale)
+{
+    UpdateValues(step, block, start, count, parameters, gradients, gradientScale);
+}
+
+template<typename T>
+void Optimizers::Adam::UpdateValues(long stepNumber, int block, size_t start, size_t count, T* parameters, const T* gradients, T gradientScale)
+{
+    Kernels::StepParameters<T> step;
+    step.learningRate = learningRate;
+    step.gradientScale = gradientScale;
+    step.l2 = l2;
+    step.decay = decay;
+    step.beta1 = beta1;
+    step.beta2 = beta2;
+    step.epsilon = epsilon;
+    step.firstCorrection = 1 / (1 - std::pow(beta1, static_cast<double>(stepNumber)));
+    step.secondCorrection = 1 / (1 - std::pow(beta2, static_cast<double>(stepNumber)));
+    Kernels::AdamStep(count, step, parameters, gradients, GetState<T>(0, block, start), GetState<T>(1, block, start));
+}
+
+Optimizers::AdamW::AdamW(double learningRate, double weightDecay, double beta1, double beta2, double epsilon)
+                        :
+                        Adam(learningRate, beta1, beta2, epsilon)
+{
+    decay = weightDecay;
+}
+
+std::unique_ptr<Optimizer> Optimizers::AdamW::Clone() const
+{
+    return std::make_unique<AdamW>(*this);
+}
+
+std::string Optimizers::AdamW::GetName() const
+{
+    return "adamw";
+}
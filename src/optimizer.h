@@ -0,0 +1,244 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "span.h"
+#include "arena.h"
+#include "checkpoint.h"
+
+class Optimizer
+{
+    public:
+        /// @class              Base class of the optimizers that turn gradients into weight updates during training. The
+        ///                     parameters of a network are split into blocks, the weights and the biases of every layer,
+        ///                     and every optimizer keeps its state (velocities or moments) in one aligned buffer per
+        ///                     block of the same precision as the parameters, all taken from one arena. Updates of
+        ///                     different ranges of a block may run on different threads at the same time. To add an
+        ///                     optimizer, derive from this class, report how many values of state each parameter needs
+        ///                     and implement both Update() overloads.
+        /// @param learningRate The step size of every update
+        explicit Optimizer(double learningRate);
+
+        virtual ~Optimizer() = default;
+
+        /// @brief  Returns a copy of the optimizer, including its state
+        /// @return The copy
+        virtual std::unique_ptr<Optimizer> Clone() const = 0;
+
+        /// @brief  Returns the name of the optimizer, which identifies its kind in checkpoints and must not change once
+        ///         checkpoints have been written with it
+        /// @return The name, for example "adam"
+        virtual std::string GetName() const = 0;
+
+        /// @brief            Sizes the state for a set of parameter blocks. State that already matches the blocks and the
+        ///                   precision is kept, so that training can continue where it stopped, otherwise it is reset.
+        /// @param blockSizes The number of parameters in every block
+        /// @param scalarSize The size of the type the parameters are stored in, sizeof(float) or sizeof(double)
+        void Initialize(const std::vector<size_t>& blockSizes, size_t scalarSize);
+
+        /// @brief Sets every value of state back to zero and restarts the step count
+        void Reset();
+
+        /// @brief  Starts the next update of every block. Safe to call from several threads at once, in which case each
+        ///         gets its own step.
+        /// @return The number of the step, counting from one, to pass to Update()
+        long BeginStep();
+
+        /// @brief               Applies one step to a range of one block of parameters
+        /// @param step          The number returned by BeginStep()
+        /// @param block         Index of the block the parameters belong to
+        /// @param start         Index of the first parameter of the range within the block
+        /// @param count         The number of parameters in the range
+        /// @param parameters    Pointer to the first parameter of the range
+        /// @param gradients     Pointer to the gradients of the range
+        /// @param gradientScale Factor every gradient is multiplied by before it is used, such as 1 / rows for a batch
+        virtual void Update(long step, int block, size_t start, size_t count, double* parameters, const double* gradients, double gradientScale) = 0;
+        virtual void Update(long step, int block, size_t start, size_t count, float* parameters, const float* gradients, float gradientScale) = 0;
+
+        /// @brief  Get the learning rate
+        /// @return The step size of every update
+        double GetLearningRate() const;
+
+        /// @brief              Changes the learning rate, for example to follow a schedule between epochs
+        /// @param learningRate The step size of every update
+        void SetLearningRate(double learningRate);
+
+        /// @brief  Get the number of steps taken since the state was last reset
+        /// @return The step count
+        long GetStepCount() const;
+
+        /// @brief         Writes the learning rate, the step count and every value of state to a checkpoint
+        /// @param encoder The checkpoint being written
+        void SaveState(Checkpoint::Encoder& encoder) const;
+
+        /// @brief         Reads the state written by SaveState(). The optimizer must already be initialized for the same
+        ///                blocks and precision.
+        /// @param decoder The checkpoint being read
+        void LoadState(Checkpoint::Decoder& decoder);
+
+    protected:
+        Optimizer(const Optimizer& other);
+
+        /// @brief  Get the number of values of state kept for every parameter
+        /// @return The number of state buffers per block
+        virtual int GetNumStates() const = 0;
+
+        /// @brief       Returns the state of a range of parameters
+        /// @param index Which of the GetNumStates() buffers to return
+        /// @param block Index of the block
+        /// @param start Index of the first parameter of the range within the block
+        /// @return      Pointer to the state of the first parameter of the range
+        template<typename T>
+        T* GetState(int index, int block, size_t start);
+
+        double learningRate;
+
+    private:
+        /// @brief            Takes zeroed buffers for every state and block from the arena, in the precision of the parameters
+        /// @param numBuffers The number of buffers, GetNumStates() times the number of blocks
+        void AllocateState(size_t numBuffers);
+
+        std::vector<size_t> blockSizes;
+        size_t scalarSize;
+        /// One buffer per state and block, indexed by index * blocks + block, all of them views of a single arena
+        Arena state;
+        std::vector<Span<double>> doubleState;
+        std::vector<Span<float>> floatState;
+        std::atomic<long> steps;
+};
+
+namespace Optimizers
+{
+    /// @brief Namespace holding the built-in optimizers. Each takes a weight decay, which is added to the gradient as an L2
+    ///        penalty (AdamW instead decays the weights directly). It applies to the biases as well as the weights.
+
+    class Sgd : public Optimizer
+    {
+        public:
+            /// @class              Plain stochastic gradient descent, the default optimizer of a network
+            /// @param learningRate The step size of every update
+            /// @param weightDecay  The L2 penalty
+            explicit Sgd(double learningRate = 0.01, double weightDecay = 0);
+
+            std::unique_ptr<Optimizer> Clone() const override;
+            std::string GetName() const override;
+            void Update(long step, int block, size_t start, size_t count, double* parameters, const double* gradients, double gradientScale) override;
+            void Update(long step, int block, size_t start, size_t count, float* parameters, const float* gradients, float gradientScale) override;
+
+        protected:
+            int GetNumStates() const override;
+
+        private:
+            template<typename T>
+            void UpdateValues(int block, size_t start, size_t count, T* parameters, const T* gradients, T gradientScale);
+
+            double weightDecay;
+    };
+
+    class Momentum : public Optimizer
+    {
+        public:
+            /// @class              Gradient descent with momentum, which keeps a velocity per parameter that accumulates the
+            ///                     gradients and decays by the momentum every step
+            /// @param learningRate The step size of every update
+            /// @param momentum     Fraction of the velocity kept from one step to the next
+            /// @param weightDecay  The L2 penalty
+            explicit Momentum(double learningRate = 0.01, double momentum = 0.9, double weightDecay = 0);
+
+            std::unique_ptr<Optimizer> Clone() const override;
+            std::string GetName() const override;
+            void Update(long step, int block, size_t start, size_t count, double* parameters, const double* gradients, double gradientScale) override;
+            void Update(long step, int block, size_t start, size_t count, float* parameters, const float* gradients, float gradientScale) override;
+
+        protected:
+            int GetNumStates() const override;
+
+        private:
+            template<typename T>
+            void UpdateValues(int block, size_t start, size_t count, T* parameters, const T* gradients, T gradientScale);
+
+            double momentum;
+            double weightDecay;
+    };
+
+    class RmsProp : public Optimizer
+    {
+        public:
+            /// @class              RMSProp, which divides every gradient by a running root mean square of its recent values
+            /// @param learningRate The step size of every update
+            /// @param rho          Decay rate of the running mean square
+            /// @param epsilon      Added to the root mean square so that the step stays finite
+            /// @param weightDecay  The L2 penalty
+            explicit RmsProp(double learningRate = 0.001, double rho = 0.9, double epsilon = 1e-8, double weightDecay = 0);
+
+            std::unique_ptr<Optimizer> Clone() const override;
+            std::string GetName() const override;
+            void Update(long step, int block, size_t start, size_t count, double* parameters, const double* gradients, double gradientScale) override;
+            void Update(long step, int block, size_t start, size_t count, float* parameters, const float* gradients, float gradientScale) override;
+
+        protected:
+            int GetNumStates() const override;
+
+        private:
+            template<typename T>
+            void UpdateValues(int block, size_t start, size_t count, T* parameters, const T* gradients, T gradientScale);
+
+            double rho;
+            double epsilon;
+            double weightDecay;
+    };
+
+    class Adam : public Optimizer
+    {
+        public:
+            /// @class              Adam, which scales a running mean of the gradients by the root of a running mean of their
+            ///                     squares, with both corrected for their bias towards zero over the first steps
+            /// @param learningRate The step size of every update
+            /// @param beta1        Decay rate of the mean of the gradients
+            /// @param beta2        Decay rate of the mean of their squares
+            /// @param epsilon      Added to the root mean square so that the step stays finite
+            /// @param weightDecay  The L2 penalty
+            explicit Adam(double learningRate = 0.001, double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8, double weightDecay = 0);
+
+            std::unique_ptr<Optimizer> Clone() const override;
+            std::string GetName() const override;
+            void Update(long step, int block, size_t start, size_t count, double* parameters, const double* gradients, double gradientScale) override;
+            void Update(long step, int block, size_t start, size_t count, float* parameters, const float* gradients, float gradientScale) override;
+
+        protected:
+            int GetNumStates() const override;
+
+            template<typename T>
+            void UpdateValues(long step, int block, size_t start, size_t count, T* parameters, const T* gradients, T gradientScale);
+
+            double beta1;
+            double beta2;
+            double epsilon;
+            /// Weight decay added to the gradient as an L2 penalty, and weight decay applied to the weights directly (AdamW)
+            double l2;
+            double decay;
+    };
+
+    class AdamW : public Adam
+    {
+        public:
+            /// @class              Adam with decoupled weight decay, which shrinks the weights directly instead of adding an L2
+            ///                     penalty to the gradient, so that the decay is not scaled down along with the gradients
+            /// @param learningRate The step size of every update
+            /// @param weightDecay  Fraction of every weight removed per step, scaled by the learning rate
+            /// @param beta1        Decay rate of the mean of the gradients
+            /// @param beta2        Decay rate of the mean of their squares
+            /// @param epsilon      Added to the root mean square so that the step stays finite
+            explicit AdamW(double learningRate = 0.001, double weightDecay = 0.01, double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8);
+
+            std::unique_ptr<Optimizer> Clone() const override;
+            std::string GetName() const override;
+    };
+}
+
+#endif // OPTIMIZER_H
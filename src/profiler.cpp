@@ -0,0 +1,138 @@
+#include "profiler.h"
+
+#include <fstream>
+#include <iomanip>
+
+Profiler::Profiler(int numThreads, int numLayers, bool inputRecordTrace)
+                  :
+                  recordTrace(inputRecordTrace),
+                  origin(Clock::now()),
+                  samples(0),
+                  seconds(0)
+{
+    Resize(numThreads, numLayers);
+}
+
+void Profiler::Resize(int numThreads, int numLayers)
+{
+    if (numThreads < 1 || numLayers < 1)
+    {
+        throw(std::invalid_argument("A profiler needs at least one thread and one layer"));
+    }
+
+    threads.resize(numThreads);
+    for (ThreadRecord& record : threads)
+    {
+        record.layers.resize(numLayers);
+    }
+}
+
+void Profiler::Record(int thread, Phase phase, int layer, Clock::time_point start, Clock::time_point end, double flops)
+{
+    ThreadRecord& record = threads[thread];
+    Counters& counters = record.layers[layer < 0 ? 0 : layer][static_cast<int>(phase)];
+    counters.calls++;
+    counters.seconds += std::chrono::duration<double>(end - start).count();
+    counters.flops += flops;
+
+    if (recordTrace && record.events.size() < MaxTraceEventsPerThread)
+    {
+        record.events.push_back({phase, layer, start, end});
+    }
+}
+
+void Profiler::AddRun(long runSamples, double runSeconds)
+{
+    this->samples += runSamples;
+    this->seconds += runSeconds;
+}
+
+Profiler::Report Profiler::GetReport() const
+{
+    Report report;
+    report.layers.resize(threads.front().layers.size());
+    double flops = 0;
+    for (const ThreadRecord& record : threads)
+    {
+        for (size_t l = 0 ; l < record.layers.size() ; l++)
+        {
+            for (int p = 0 ; p < NumPhases ; p++)
+            {
+                const Counters& counters = record.layers[l][p];
+                report.phases[p].calls += counters.calls;
+                report.phases[p].seconds += counters.seconds;
+                report.phases[p].flops += counters.flops;
+                flops += counters.flops;
+
+                // Slot zero holds the phases that are not specific to a layer, which only count towards the totals
+                if (l > 0)
+                {
+                    report.layers[l][p].calls += counters.calls;
+                    report.layers[l][p].seconds += counters.seconds;
+                    report.layers[l][p].flops += counters.flops;
+                }
+            }
+        }
+    }
+
+    report.samples = samples;
+    report.seconds = seconds;
+    report.samplesPerSecond = seconds > 0 ? samples / seconds : 0;
+    report.flopsPerSecond = seconds > 0 ? flops / seconds : 0;
+    return report;
+}
+
+void Profiler::WriteChromeTrace(const std::string& path) const
+{
+    if (!recordTrace)
+    {
+        throw(std::logic_error("Profiling was not enabled with trace recording"));
+    }
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        throw(std::runtime_error("Could not open " + path + " for writing"));
+    }
+
+    // Complete ("X") events with microsecond timestamps relative to when the profiler was created, one track per thread
+    file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (size_t t = 0 ; t < threads.size() ; t++)
+    {
+        file << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << t
+             << ",\"args\":{\"name\":\"training thread " << t << "\"}}";
+        first = false;
+        for (const TraceEvent& event : threads[t].events)
+        {
+            const double start = std::chrono::duration<double, std::micro>(event.start - origin).count();
+            const double duration = std::chrono::duration<double, std::micro>(event.end - event.start).count();
+            file << ",\n{\"name\":\"" << GetPhaseName(event.phase);
+            if (event.layer >= 0)
+            {
+                file << " layer " << event.layer;
+            }
+            file << "\",\"cat\":\"" << GetPhaseName(event.phase) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << t
+                 << ",\"ts\":" << start << ",\"dur\":" << duration << ",\"args\":{\"layer\":" << event.layer << "}}";
+        }
+    }
+    file << "\n]}\n";
+
+    if (!file)
+    {
+        throw(std::runtime_error("Could not write " + path));
+    }
+}
+
+const char* Profiler::GetPhaseName(Phase phase)
+{
+    switch (phase)
+    {
+        case Phase::DataLoading:  return "data loading";
+        case Phase::Forward:      return "forward";
+        case Phase::Loss:         return "loss";
+        case Phase::Backward:     return "backward";
+        case Phase::WeightUpdate: return "weight update";
+    }
+    return "unknown";
+}
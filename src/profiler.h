@@ -0,0 +1,189 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+class Profiler
+{
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /// @brief Parts of a training step that are timed separately
+        enum class Phase
+        {
+            /// Reading batches from the data source
+            DataLoading,
+            /// Forward pass through a layer, its matrix product and then its activation function and derivative
+            Forward,
+            /// Loss derivative and output error terms
+            Loss,
+            /// Gradients of a layer and the error terms passed back through its weights
+            Backward,
+            /// Applying the gradients of a layer to its weights and biases
+            WeightUpdate
+        };
+
+        static constexpr int NumPhases = 5;
+
+        /// @brief Time spent in, and work done by, one phase
+        struct Counters
+        {
+            long calls = 0;
+            double seconds = 0;
+            /// Estimated floating point operations of the matrix products. Activation functions are not counted but are
+            /// timed with the Forward phase, so its rate understates that of the matrix product.
+            double flops = 0;
+        };
+
+        /// @brief Everything recorded since profiling was enabled, summed over all threads
+        struct Report
+        {
+            /// Totals of each phase, indexed by Phase
+            std::array<Counters, NumPhases> phases;
+            /// Counters of each layer of the network, indexed like its layers and then by Phase. Phases that are not specific
+            /// to a layer (data loading and loss) only appear in the totals.
+            std::vector<std::array<Counters, NumPhases>> layers;
+            /// Rows trained on and wall time spent inside Train()
+            long samples = 0;
+            double seconds = 0;
+            double samplesPerSecond = 0;
+            /// Estimated floating point operations of all phases per second of wall time inside Train()
+            double flopsPerSecond = 0;
+
+            /// @brief       Returns the totals of one phase
+            /// @param phase The phase
+            /// @return      The counters
+            const Counters& Get(Phase phase) const { return phases[static_cast<int>(phase)]; }
+        };
+
+        /// @class             Collects the time spent in each phase of training, per layer and per thread, along with an
+        ///                    optional timeline of every timed region that can be written as a Chrome trace. Every thread
+        ///                    records into its own slot, so recording needs no locking. The calls that record are compiled in
+        ///                    only when NN_ENABLE_PROFILING is defined, see NN_PROFILE_SCOPE.
+        /// @param numThreads  The number of threads that record, each with an index in [0, numThreads)
+        /// @param numLayers   The number of layers in the network
+        /// @param recordTrace Whether every timed region should be kept for WriteChromeTrace()
+        Profiler(int numThreads, int numLayers, bool recordTrace);
+
+        /// @brief            Changes the number of recording threads or layers, keeping what has been recorded so far. Must
+        ///                   not be called while other threads are recording.
+        /// @param numThreads The number of threads that record
+        /// @param numLayers  The number of layers in the network
+        void Resize(int numThreads, int numLayers);
+
+        /// @brief        Adds a timed region to the counters of a thread
+        /// @param thread Index of the thread that ran the region
+        /// @param phase  The phase the region belongs to
+        /// @param layer  Index of the layer the region worked on, or -1 if it is not specific to a layer
+        /// @param start  When the region started
+        /// @param end    When the region ended
+        /// @param flops  Estimated floating point operations of the region
+        void Record(int thread, Phase phase, int layer, Clock::time_point start, Clock::time_point end, double flops);
+
+        /// @brief         Adds a call to Train() to the throughput counters
+        /// @param samples The number of rows trained on
+        /// @param seconds The wall time of the call
+        void AddRun(long samples, double seconds);
+
+        /// @brief  Sums what every thread has recorded
+        /// @return The report
+        Report GetReport() const;
+
+        /// @brief      Writes every recorded region in the Chrome trace event JSON format, which can be opened in
+        ///             chrome://tracing or Perfetto. Throws if the profiler was not created with recordTrace.
+        /// @param path Path of the file to write
+        void WriteChromeTrace(const std::string& path) const;
+
+        /// @brief       Returns a printable name for a phase
+        /// @param phase The phase
+        /// @return      Name of the phase
+        static const char* GetPhaseName(Phase phase);
+
+        /// Regions kept per thread for the trace, beyond which only the counters are updated so that long runs do not grow
+        /// without bound
+        static constexpr size_t MaxTraceEventsPerThread = 1 << 20;
+
+    private:
+        struct TraceEvent
+        {
+            Phase phase;
+            int layer;
+            Clock::time_point start;
+            Clock::time_point end;
+        };
+
+        /// Everything recorded by one thread. Slot zero of layers holds the phases that are not specific to a layer, which
+        /// can use it since the input layer does no work.
+        struct ThreadRecord
+        {
+            std::vector<std::array<Counters, NumPhases>> layers;
+            std::vector<TraceEvent> events;
+        };
+
+        bool recordTrace;
+        Clock::time_point origin;
+        std::vector<ThreadRecord> threads;
+        long samples;
+        double seconds;
+};
+
+class ProfileScope
+{
+    public:
+        /// @class          Times the enclosing scope and records it with a profiler when it ends. Does nothing if the
+        ///                 profiler is null, which is the case while profiling is turned off at runtime.
+        /// @param profiler The profiler to record with, or nullptr
+        /// @param thread   Index of the thread running the scope
+        /// @param phase    The phase the scope belongs to
+        /// @param layer    Index of the layer the scope works on, or -1
+        /// @param flops    Estimated floating point operations of the scope
+        ProfileScope(Profiler* inputProfiler, int inputThread, Profiler::Phase inputPhase, int inputLayer = -1, double inputFlops = 0)
+                    :
+                    profiler(inputProfiler),
+                    thread(inputThread),
+                    phase(inputPhase),
+                    layer(inputLayer),
+                    flops(inputFlops)
+        {
+            if (profiler)
+            {
+                start = Profiler::Clock::now();
+            }
+        }
+
+        ~ProfileScope()
+        {
+            if (profiler)
+            {
+                profiler->Record(thread, phase, layer, start, Profiler::Clock::now(), flops);
+            }
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        Profiler* profiler;
+        int thread;
+        Profiler::Phase phase;
+        int layer;
+        double flops;
+        Profiler::Clock::time_point start;
+};
+
+#define NN_PROFILE_CONCAT_(a, b) a##b
+#define NN_PROFILE_CONCAT(a, b) NN_PROFILE_CONCAT_(a, b)
+
+/// @brief Times the rest of the enclosing scope, taking the arguments of ProfileScope. Without NN_ENABLE_PROFILING this
+///        expands to nothing, and its arguments are not evaluated, so instrumented code has no cost at all.
+#ifdef NN_ENABLE_PROFILING
+#define NN_PROFILE_SCOPE(...) ProfileScope NN_PROFILE_CONCAT(profileScope, __LINE__)(__VA_ARGS__)
+#else
+#define NN_PROFILE_SCOPE(...)
+#endif
+
+#endif // PROFILER_H
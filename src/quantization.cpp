@@ -0,0 +1,222 @@
+#include "quantization.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    /// Largest magnitude of a quantized weight, the range is kept symmetric so that zero needs no offset
+    constexpr int WeightLimit = 127;
+
+    /// Largest quantized activation. Activations only use 7 bits so that Kernels::QuantizedGemm is exact on every CPU, see
+    /// Kernels::Quantize.
+    constexpr int ActivationLimit = 127;
+
+    /// Number of calibration rows run through the network at once
+    constexpr int CalibrationBatchRows = 256;
+
+    /// Widens a range to cover a buffer of values
+    template<typename T>
+    void ExtendRange(const T* values, size_t count, double& low, double& high)
+    {
+        for (size_t i = 0 ; i < count ; i++)
+        {
+            low = std::min(low, static_cast<double>(values[i]));
+            high = std::max(high, static_cast<double>(values[i]));
+        }
+    }
+}
+
+template<typename T, typename Accumulator>
+QuantizedNetwork::QuantizedNetwork(const BasicNeuralNetwork<T, Accumulator>& network, DataSource& calibrationData, const Options& options)
+                                   :
+                                   numInputs(network.GetLayer(0).GetNumNeurons()),
+                                   numOutputs(network.GetLayer(network.GetNumLayers() - 1).GetNumNeurons()),
+                                   lossType(network.GetLossType())
+{
+    if (calibrationData.GetNumInputs() != numInputs)
+    {
+        throw(std::invalid_argument("Calibration data does not match the number of network inputs"));
+    }
+    if (options.calibrationRows < 1)
+    {
+        throw(std::invalid_argument("At least one calibration row is needed"));
+    }
+
+    // Quantize the weights of every layer after the input layer symmetrically, scaling the largest weight to WeightLimit
+    const int numLayers = network.GetNumLayers();
+    for (int i = 1 ; i < numLayers ; i++)
+    {
+        const BasicLayer<T, Accumulator>& source = network.GetLayer(i);
+        const int inputs = source.GetNumInputs();
+        const int neurons = source.GetNumNeurons();
+        const T* weights = source.GetWeights();
+
+        std::vector<double> largest(neurons, 0);
+        for (int j = 0 ; j < neurons ; j++)
+        {
+            for (int k = 0 ; k < inputs ; k++)
+            {
+                largest[j] = std::max(largest[j], std::abs(static_cast<double>(weights[static_cast<size_t>(j) * inputs + k])));
+            }
+        }
+        if (options.granularity == Granularity::PerLayer)
+        {
+            std::fill(largest.begin(), largest.end(), *std::max_element(largest.begin(), largest.end()));
+        }
+
+        QuantizedLayer layer;
+        layer.numInputs = inputs;
+        layer.numNeurons = neurons;
+        layer.activation = source.GetActivationFunction();
+        layer.weights.resize(static_cast<size_t>(neurons) * inputs);
+        layer.outputScales.resize(neurons);
+        layer.offsets.resize(neurons);
+        for (int j = 0 ; j < neurons ; j++)
+        {
+            // The output scale only gets the input scale once calibration has measured it
+            const double scale = largest[j] > 0 ? largest[j] / WeightLimit : 1;
+            for (int k = 0 ; k < inputs ; k++)
+            {
+                const size_t index = static_cast<size_t>(j) * inputs + k;
+                const long value = std::lround(weights[index] / scale);
+                layer.weights[index] = static_cast<int8_t>(std::max<long>(-WeightLimit, std::min<long>(WeightLimit, value)));
+            }
+            layer.outputScales[j] = static_cast<float>(scale);
+        }
+        layers.push_back(layer);
+    }
+
+    // Measure the range of the inputs of every layer by running the original network on the calibration data
+    std::vector<double> low(layers.size(), 0), high(layers.size(), 0);
+    std::vector<double> batchInputs(static_cast<size_t>(CalibrationBatchRows) * numInputs);
+    std::vector<double> batchOutputs(static_cast<size_t>(CalibrationBatchRows) * calibrationData.GetNumOutputs());
+    std::vector<std::vector<T>> activations(numLayers);
+    long calibrated = 0;
+    int rows;
+    calibrationData.Reset();
+    while (calibrated < options.calibrationRows
+           && (rows = calibrationData.ReadBatch(static_cast<int>(std::min<long>(CalibrationBatchRows, options.calibrationRows - calibrated)),
+                                                batchInputs.data(), batchOutputs.data())) > 0)
+    {
+        activations[0].assign(batchInputs.begin(), batchInputs.begin() + static_cast<size_t>(rows) * numInputs);
+        for (int i = 1 ; i < numLayers ; i++)
+        {
+            activations[i].resize(static_cast<size_t>(rows) * network.GetLayer(i).GetNumNeurons());
+            network.GetLayer(i).Forward(activations[i - 1].data(), rows, activations[i].data());
+        }
+        for (size_t l = 0 ; l < layers.size() ; l++)
+        {
+            ExtendRange(activations[l].data(), activations[l].size(), low[l], high[l]);
+        }
+        calibrated += rows;
+    }
+    calibrationData.Reset();
+    if (!calibrated)
+    {
+        throw(std::invalid_argument("Calibration data must not be empty"));
+    }
+
+    // The ranges always include zero, so that zero padding and zero activations are represented exactly
+    for (size_t l = 0 ; l < layers.size() ; l++)
+    {
+        QuantizedLayer& layer = layers[l];
+        const double scale = high[l] > low[l] ? (high[l] - low[l]) / ActivationLimit : 1;
+        layer.inputScale = static_cast<float>(scale);
+        layer.inputZeroPoint = static_cast<int>(std::max(0L, std::min<long>(ActivationLimit, std::lround(-low[l] / scale))));
+
+        // Fold the bias and the zero point into one offset, so that each output is a single multiply-add of its integer sum
+        const BasicLayer<T, Accumulator>& source = network.GetLayer(static_cast<int>(l) + 1);
+        for (int j = 0 ; j < layer.numNeurons ; j++)
+        {
+            long weightSum = 0;
+            for (int k = 0 ; k < layer.numInputs ; k++)
+            {
+                weightSum += layer.weights[static_cast<size_t>(j) * layer.numInputs + k];
+            }
+            const double outputScale = scale * layer.outputScales[j];
+            layer.outputScales[j] = static_cast<float>(outputScale);
+            layer.offsets[j] = static_cast<float>(source.GetBiases()[j] - outputScale * layer.inputZeroPoint * weightSum);
+        }
+    }
+}
+
+void QuantizedNetwork::Predict(const double* input, double* output) const
+{
+    PredictBatch(Span<const double>(input, numInputs), Span<double>(output, numOutputs));
+}
+
+void QuantizedNetwork::PredictBatch(Span<const double> inputs, Span<double> outputs) const
+{
+    const int rows = inputs.size() / numInputs;
+    if (inputs.size() % numInputs || outputs.size() != static_cast<size_t>(rows) * numOutputs)
+    {
+        throw(std::invalid_argument("Input and output sizes must match the network for the same number of rows"));
+    }
+
+    // Each thread keeps its own buffers, which only grow when a larger batch than before is seen
+    thread_local std::vector<uint8_t> quantized;
+    thread_local std::vector<int32_t> sums;
+    thread_local std::vector<float> values;
+
+    // The inputs go through the float buffer on their way to being quantized for the first layer
+    values.assign(inputs.data(), inputs.data() + inputs.size());
+    quantized.resize(inputs.size());
+    Kernels::Quantize(inputs.size(), values.data(), layers.front().inputScale, layers.front().inputZeroPoint, quantized.data());
+    for (size_t l = 0 ; l < layers.size() ; l++)
+    {
+        const QuantizedLayer& layer = layers[l];
+        const size_t count = static_cast<size_t>(rows) * layer.numNeurons;
+        sums.resize(count);
+        values.resize(count);
+        Kernels::QuantizedGemm(rows, layer.numNeurons, layer.numInputs, quantized.data(), layer.numInputs,
+                               layer.weights.data(), layer.numInputs, sums.data(), layer.numNeurons);
+
+        for (int r = 0 ; r < rows ; r++)
+        {
+            const int32_t* rowSums = sums.data() + static_cast<size_t>(r) * layer.numNeurons;
+            float* rowValues = values.data() + static_cast<size_t>(r) * layer.numNeurons;
+            for (int j = 0 ; j < layer.numNeurons ; j++)
+            {
+                rowValues[j] = rowSums[j] * layer.outputScales[j] + layer.offsets[j];
+            }
+        }
+        layer.activation.Apply(values.data(), count);
+
+        // The last layer writes straight to the outputs, every other layer is quantized again for the next one
+        if (l + 1 == layers.size())
+        {
+            std::copy(values.begin(), values.begin() + count, outputs.data());
+            LossFunctions::LogitsToProbabilities(lossType, numOutputs, outputs);
+        }
+        else
+        {
+            quantized.resize(count);
+            Kernels::Quantize(count, values.data(), layers[l + 1].inputScale, layers[l + 1].inputZeroPoint, quantized.data());
+        }
+    }
+}
+
+int QuantizedNetwork::GetNumInputs() const
+{
+    return this->numInputs;
+}
+
+int QuantizedNetwork::GetNumOutputs() const
+{
+    return this->numOutputs;
+}
+
+size_t QuantizedNetwork::GetWeightBytes() const
+{
+    size_t bytes = 0;
+    for (const QuantizedLayer& layer : layers)
+    {
+        bytes += layer.weights.size();
+    }
+    return bytes;
+}
+
+template QuantizedNetwork::QuantizedNetwork(const BasicNeuralNetwork<double>&, DataSource&, const Options&);
+template QuantizedNetwork::QuantizedNetwork(const BasicNeuralNetwork<float>&, DataSource&, const Options&);
+template QuantizedNetwork::QuantizedNetwork(const BasicNeuralNetwork<float, double>&, DataSource&, const Options&);
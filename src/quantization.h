@@ -0,0 +1,93 @@
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include "span.h"
+#include "network.h"
+#include "dataset.h"
+
+class QuantizedNetwork
+{
+    public:
+        /// @brief How many scales the weights of a layer share
+        enum class Granularity
+        {
+            /// One scale for the whole weight matrix of a layer
+            PerLayer,
+            /// One scale for the weights of every neuron (output channel), which tracks neurons of very different
+            /// magnitudes more closely
+            PerChannel
+        };
+
+        /// @brief Settings for quantizing a network
+        struct Options
+        {
+            Granularity granularity = Granularity::PerChannel;
+            /// Number of rows of the calibration data that are run through the network to measure activation ranges
+            long calibrationRows = 1024;
+        };
+
+        /// @class                 Post-training int8 version of a trained network for inference. Weights are quantized
+        ///                        symmetrically to int8 and the inputs of every layer asymmetrically to 7-bit unsigned values,
+        ///                        using ranges measured by running the original network on a sample of calibration data. Each
+        ///                        layer is an integer matrix product with 32-bit sums (see Kernels::QuantizedGemm) that is
+        ///                        then scaled back to float, offset by the bias and passed through the activation function.
+        /// @param network         The trained network to quantize, which is not modified or referenced afterwards
+        /// @param calibrationData Data representative of what the network will be run on, which is rewound before and after
+        /// @param options         Settings for the quantization
+        template<typename T, typename Accumulator>
+        QuantizedNetwork(const BasicNeuralNetwork<T, Accumulator>& network, DataSource& calibrationData, const Options& options);
+
+        /// @brief        Runs the quantized network on a single row of new data. This is const and reentrant, so it can be
+        ///               called concurrently from many threads against one shared model. Like the network it was built
+        ///               from, it outputs probabilities when the loss takes logits.
+        /// @param input  Pointer to the input values, one per input neuron
+        /// @param output Pointer to where the output values are written, one per output neuron
+        void Predict(const double* input, double* output) const;
+
+        /// @brief         Runs the quantized network on a batch of rows of new data, with the same guarantees as Predict().
+        ///                Intermediate results are kept in thread-local buffers that only grow when a larger batch is seen.
+        /// @param inputs  Row-major matrix of input values, whose size must be a multiple of the number of inputs
+        /// @param outputs Row-major matrix the output values are written to, with one row per input row
+        void PredictBatch(Span<const double> inputs, Span<double> outputs) const;
+
+        /// @brief  Get the number of inputs of the network
+        /// @return The number of inputs
+        int GetNumInputs() const;
+
+        /// @brief  Get the number of outputs of the network
+        /// @return The number of outputs
+        int GetNumOutputs() const;
+
+        /// @brief  Get the size of the quantized weights, which is an eighth of the size of the same weights in double
+        /// @return The number of bytes
+        size_t GetWeightBytes() const;
+
+    private:
+        /// @brief Quantized form of one dense layer. A layer output is outputScales[j] * sum_k(q_x[k] * q_w[j][k]) + offsets[j],
+        ///        where the offset folds the bias together with the correction for the zero point of the inputs.
+        struct QuantizedLayer
+        {
+            int numInputs;
+            int numNeurons;
+            Activation activation;
+            /// Row-major numNeurons x numInputs matrix of int8 weights
+            std::vector<int8_t> weights;
+            std::vector<float> outputScales;
+            std::vector<float> offsets;
+            /// Maps the real inputs of the layer to 7-bit values, q = round(x / inputScale) + inputZeroPoint, see Kernels::Quantize()
+            float inputScale;
+            int inputZeroPoint;
+        };
+
+        int numInputs;
+        int numOutputs;
+        /// Loss of the original network, whose softmax or sigmoid is applied to the outputs when it takes logits
+        LossFunctions::LossType lossType;
+        std::vector<QuantizedLayer> layers;
+};
+
+#endif // QUANTIZATION_H
@@ -0,0 +1,190 @@
+#include "schedule.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+    constexpr double Pi = 3.14159265358979323846;
+}
+
+Schedules::StepDecay::StepDecay(int inputStepEpochs, double inputFactor)
+                               :
+                               stepEpochs(inputStepEpochs),
+                               factor(inputFactor)
+{
+    if (stepEpochs < 1 || !(factor > 0))
+    {
+        throw(std::invalid_argument("Step decay needs at least one epoch per step and a positive factor"));
+    }
+}
+
+std::unique_ptr<LearningRateSchedule> Schedules::StepDecay::Clone() const
+{
+    return std::make_unique<StepDecay>(*this);
+}
+
+std::string Schedules::StepDecay::GetName() const
+{
+    return "step_decay";
+}
+
+double Schedules::StepDecay::GetLearningRate(int epoch, double baseRate) const
+{
+    return baseRate * std::pow(factor, epoch / stepEpochs);
+}
+
+Schedules::Cosine::Cosine(int inputNumEpochs, double inputMinRate)
+                         :
+                         numEpochs(inputNumEpochs),
+                         minRate(inputMinRate)
+{
+    if (numEpochs < 1 || minRate < 0)
+    {
+        throw(std::invalid_argument("Cosine annealing needs at least one epoch and a minimum rate that is not negative"));
+    }
+}
+
+std::unique_ptr<LearningRateSchedule> Schedules::Cosine::Clone() const
+{
+    return std::make_unique<Cosine>(*this);
+}
+
+std::string Schedules::Cosine::GetName() const
+{
+    return "cosine";
+}
+
+double Schedules::Cosine::GetLearningRate(int epoch, double baseRate) const
+{
+    const double progress = std::min(epoch, numEpochs) / static_cast<double>(numEpochs);
+    return minRate + (baseRate - minRate) * 0.5 * (1 + std::cos(Pi * progress));
+}
+
+Schedules::Warmup::Warmup(int inputWarmupEpochs)
+                         :
+                         warmupEpochs(inputWarmupEpochs)
+{
+    if (warmupEpochs < 1)
+    {
+        throw(std::invalid_argument("Warmup needs at least one epoch"));
+    }
+}
+
+Schedules::Warmup::Warmup(int inputWarmupEpochs, const LearningRateSchedule& inputAfter)
+                         :
+                         Warmup(inputWarmupEpochs)
+{
+    after = inputAfter.Clone();
+}
+
+Schedules::Warmup::Warmup(const Warmup& other)
+                         :
+                         warmupEpochs(other.warmupEpochs),
+                         after(other.after ? other.after->Clone() : nullptr)
+{
+}
+
+std::unique_ptr<LearningRateSchedule> Schedules::Warmup::Clone() const
+{
+    return std::make_unique<Warmup>(*this);
+}
+
+std::string Schedules::Warmup::GetName() const
+{
+    // The schedule that follows the ramp is part of the name, so that resuming checks it as well
+    return "warmup(" + (after ? after->GetName() : "") + ")";
+}
+
+double Schedules::Warmup::GetLearningRate(int epoch, double baseRate) const
+{
+    if (epoch < warmupEpochs)
+    {
+        return baseRate * (epoch + 1) / warmupEpochs;
+    }
+    return after ? after->GetLearningRate(epoch - warmupEpochs, baseRate) : baseRate;
+}
+
+void Schedules::Warmup::Observe(double loss)
+{
+    if (after)
+    {
+        after->Observe(loss);
+    }
+}
+
+void Schedules::Warmup::SaveState(Checkpoint::Encoder& encoder) const
+{
+    if (after)
+    {
+        after->SaveState(encoder);
+    }
+}
+
+void Schedules::Warmup::LoadState(Checkpoint::Decoder& decoder)
+{
+    if (after)
+    {
+        after->LoadState(decoder);
+    }
+}
+
+Schedules::ReduceOnPlateau::ReduceOnPlateau(double inputFactor, int inputPatience, double inputMinDelta, double inputMinRate)
+                                           :
+                                           factor(inputFactor),
+                                           patience(inputPatience),
+                                           minDelta(inputMinDelta),
+                                           minRate(inputMinRate),
+                                           scale(1),
+                                           best(std::numeric_limits<double>::infinity()),
+                                           waits(0)
+{
+    if (!(factor > 0 && factor < 1) || patience < 1 || minDelta < 0 || minRate < 0)
+    {
+        throw(std::invalid_argument("Reducing on plateaus needs a factor in (0, 1), a patience of at least one and limits that are not negative"));
+    }
+}
+
+std::unique_ptr<LearningRateSchedule> Schedules::ReduceOnPlateau::Clone() const
+{
+    return std::make_unique<ReduceOnPlateau>(*this);
+}
+
+std::string Schedules::ReduceOnPlateau::GetName() const
+{
+    return "reduce_on_plateau";
+}
+
+double Schedules::ReduceOnPlateau::GetLearningRate(int, double baseRate) const
+{
+    return scale < 1 ? std::max(baseRate * scale, minRate) : baseRate;
+}
+
+void Schedules::ReduceOnPlateau::Observe(double loss)
+{
+    if (loss < best - minDelta)
+    {
+        best = loss;
+        waits = 0;
+    }
+    else if (++waits >= patience)
+    {
+        scale *= factor;
+        waits = 0;
+    }
+}
+
+void Schedules::ReduceOnPlateau::SaveState(Checkpoint::Encoder& encoder) const
+{
+    encoder.Write(scale);
+    encoder.Write(best);
+    encoder.Write<int32_t>(waits);
+}
+
+void Schedules::ReduceOnPlateau::LoadState(Checkpoint::Decoder& decoder)
+{
+    scale = decoder.Read<double>();
+    best = decoder.Read<double>();
+    waits = decoder.Read<int32_t>();
+}
@@ -0,0 +1,141 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <memory>
+#include <string>
+#include <stdexcept>
+
+#include "checkpoint.h"
+
+class LearningRateSchedule
+{
+    public:
+        /// @class Base class of the schedules that set the learning rate of the optimizer at the start of every epoch during
+        ///        training. A schedule works relative to a base learning rate, the rate the optimizer had when the schedule
+        ///        or the optimizer was last given to the network.
+        virtual ~LearningRateSchedule() = default;
+
+        /// @brief  Returns a copy of the schedule, including its state
+        /// @return The copy
+        virtual std::unique_ptr<LearningRateSchedule> Clone() const = 0;
+
+        /// @brief  Returns the name of the schedule, which identifies its kind in checkpoints and must not change once
+        ///         checkpoints have been written with it
+        /// @return The name, for example "cosine"
+        virtual std::string GetName() const = 0;
+
+        /// @brief          Returns the learning rate to train an epoch with
+        /// @param epoch    Index of the epoch, counting from zero over every call to Train()
+        /// @param baseRate The base learning rate
+        /// @return         The learning rate
+        virtual double GetLearningRate(int epoch, double baseRate) const = 0;
+
+        /// @brief      Called with the monitored loss every time it is evaluated, which is the validation loss when the
+        ///             network has validation data and the mean training loss of the epoch otherwise. Does nothing by
+        ///             default.
+        /// @param loss The loss
+        virtual void Observe([[maybe_unused]] double loss) {}
+
+        /// @brief         Writes the state of the schedule to a checkpoint. Does nothing by default, for schedules that only
+        ///                depend on the epoch.
+        /// @param encoder The checkpoint being written
+        virtual void SaveState([[maybe_unused]] Checkpoint::Encoder& encoder) const {}
+
+        /// @brief         Reads the state written by SaveState()
+        /// @param decoder The checkpoint being read
+        virtual void LoadState([[maybe_unused]] Checkpoint::Decoder& decoder) {}
+};
+
+namespace Schedules
+{
+    /// @brief Namespace holding the built-in learning rate schedules
+
+    class StepDecay : public LearningRateSchedule
+    {
+        public:
+            /// @class            Multiplies the learning rate by a factor every fixed number of epochs
+            /// @param stepEpochs The number of epochs between reductions
+            /// @param factor     The factor the rate is multiplied by at each reduction
+            StepDecay(int stepEpochs, double factor = 0.1);
+
+            std::unique_ptr<LearningRateSchedule> Clone() const override;
+            std::string GetName() const override;
+            double GetLearningRate(int epoch, double baseRate) const override;
+
+        private:
+            int stepEpochs;
+            double factor;
+    };
+
+    class Cosine : public LearningRateSchedule
+    {
+        public:
+            /// @class           Anneals the learning rate from the base rate down to a minimum along half a cosine wave,
+            ///                  staying at the minimum once the last epoch has passed
+            /// @param numEpochs The number of epochs the rate takes to reach the minimum
+            /// @param minRate   The learning rate at the end of the schedule
+            Cosine(int numEpochs, double minRate = 0);
+
+            std::unique_ptr<LearningRateSchedule> Clone() const override;
+            std::string GetName() const override;
+            double GetLearningRate(int epoch, double baseRate) const override;
+
+        private:
+            int numEpochs;
+            double minRate;
+    };
+
+    class Warmup : public LearningRateSchedule
+    {
+        public:
+            /// @class              Ramps the learning rate up linearly over the first epochs, then follows another schedule,
+            ///                     or stays at the base rate
+            /// @param warmupEpochs The number of epochs of the ramp, the first training at 1 / warmupEpochs of the base rate
+            /// @param after        The schedule to follow after the ramp, with its epochs counted from the end of the ramp
+            Warmup(int warmupEpochs);
+            Warmup(int warmupEpochs, const LearningRateSchedule& after);
+            Warmup(const Warmup& other);
+
+            std::unique_ptr<LearningRateSchedule> Clone() const override;
+            std::string GetName() const override;
+            double GetLearningRate(int epoch, double baseRate) const override;
+            void Observe(double loss) override;
+            void SaveState(Checkpoint::Encoder& encoder) const override;
+            void LoadState(Checkpoint::Decoder& decoder) override;
+
+        private:
+            int warmupEpochs;
+            std::unique_ptr<LearningRateSchedule> after;
+    };
+
+    class ReduceOnPlateau : public LearningRateSchedule
+    {
+        public:
+            /// @class          Multiplies the learning rate by a factor whenever the monitored loss has not improved for a
+            ///                 number of evaluations
+            /// @param factor   The factor the rate is multiplied by at each reduction
+            /// @param patience The number of evaluations without improvement before the rate is reduced
+            /// @param minDelta The amount the loss has to fall by to count as an improvement
+            /// @param minRate  The rate is never reduced below this
+            ReduceOnPlateau(double factor = 0.1, int patience = 10, double minDelta = 0, double minRate = 0);
+
+            std::unique_ptr<LearningRateSchedule> Clone() const override;
+            std::string GetName() const override;
+            double GetLearningRate(int epoch, double baseRate) const override;
+            void Observe(double loss) override;
+            void SaveState(Checkpoint::Encoder& encoder) const override;
+            void LoadState(Checkpoint::Decoder& decoder) override;
+
+        private:
+            double factor;
+            int patience;
+            double minDelta;
+            double minRate;
+            /// Product of the reductions so far, the best loss seen and the evaluations since it was seen
+            double scale;
+            double best;
+            int waits;
+    };
+}
+
+#endif // SCHEDULE_H
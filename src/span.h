@@ -0,0 +1,49 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <vector>
+#include <cstddef>
+#include <type_traits>
+
+template <typename T>
+class Span
+{
+    public:
+        /// @class Non-owning view of a contiguous range of values, used to pass buffers without copying them or tying the
+        ///        caller to a specific container. Mirrors the parts of std::span that are needed while building as C++17.
+        Span() : first(nullptr), count(0) {}
+
+        /// @param data Pointer to the first value
+        /// @param size Number of values in the range
+        Span(T* data, size_t size) : first(data), count(size) {}
+
+        /// @param values Vector that should be viewed, which must outlive the span
+        template <typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+        Span(const std::vector<U>& values) : first(values.data()), count(values.size()) {}
+
+        template <typename U, typename = std::enable_if_t<std::is_same<std::remove_const_t<T>, U>::value>>
+        Span(std::vector<U>& values) : first(values.data()), count(values.size()) {}
+
+        /// @param other Span of mutable values, which can always be viewed as a span of const values
+        template <typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+        Span(const Span<U>& other) : first(other.data()), count(other.size()) {}
+
+        T* data() const { return first; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        T* begin() const { return first; }
+        T* end() const { return first + count; }
+        T& operator[](size_t index) const { return first[index]; }
+
+        /// @brief        Returns a view of part of this span
+        /// @param offset Index of the first value of the sub-span
+        /// @param size   Number of values in the sub-span
+        /// @return       The sub-span
+        Span subspan(size_t offset, size_t size) const { return Span(first + offset, size); }
+
+    private:
+        T* first;
+        size_t count;
+};
+
+#endif // SPAN_H
@@ -0,0 +1,355 @@
+#ifndef STATIC_NETWORK_H
+#define STATIC_NETWORK_H
+
+#include <array>
+#include <ios>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include <stdexcept>
+
+#include "span.h"
+#include "kernels.h"
+#include "support_functions.h"
+
+template<typename T, typename Accumulator>
+class BasicNeuralNetwork;
+
+/// @brief Shape of one layer of a StaticNetwork: its number of neurons, the built-in activation function they use and how
+///        it is evaluated. Accuracy::Fast evaluates the smooth functions with the vectorised approximations of
+///        Kernels::ApproximateActivation(), which needs the library, and makes no difference to the other functions.
+template<int Neurons,
+         ActivationFunctions::ActivationType Type = ActivationFunctions::ActivationType::Linear,
+         ActivationFunctions::Accuracy Evaluation = ActivationFunctions::Accuracy::Exact>
+struct StaticLayer
+{
+    static_assert(Neurons > 0, "A layer needs at least one neuron");
+    static_assert(Type != ActivationFunctions::ActivationType::Custom, "Only built-in activation functions have a static form");
+
+    static constexpr int NumNeurons = Neurons;
+    static constexpr ActivationFunctions::ActivationType Activation = Type;
+    static constexpr ActivationFunctions::Accuracy Accuracy = Evaluation;
+};
+
+namespace StaticNetworkDetail
+{
+    /// @brief Returns whether an activation type has a fast approximation, and which one
+    constexpr bool GetSmoothFunction(ActivationFunctions::ActivationType type, Kernels::SmoothFunction& function)
+    {
+        switch (type)
+        {
+            case ActivationFunctions::ActivationType::Sigmoid:  function = Kernels::SmoothFunction::Sigmoid;  return true;
+            case ActivationFunctions::ActivationType::Tanh:     function = Kernels::SmoothFunction::Tanh;     return true;
+            case ActivationFunctions::ActivationType::Elu:      function = Kernels::SmoothFunction::Elu;      return true;
+            case ActivationFunctions::ActivationType::Softplus: function = Kernels::SmoothFunction::Softplus; return true;
+            case ActivationFunctions::ActivationType::Gelu:     function = Kernels::SmoothFunction::Gelu;     return true;
+            case ActivationFunctions::ActivationType::Silu:     function = Kernels::SmoothFunction::Silu;     return true;
+            default:                                            return false;
+        }
+    }
+
+    /// @brief Whether a layer evaluates its activation with Kernels::ApproximateActivation()
+    template<ActivationFunctions::ActivationType Type, ActivationFunctions::Accuracy Accuracy>
+    constexpr bool Approximated()
+    {
+        Kernels::SmoothFunction function = Kernels::SmoothFunction::Sigmoid;
+        return Accuracy == ActivationFunctions::Accuracy::Fast && GetSmoothFunction(Type, function);
+    }
+
+    /// @brief The approximation of a smooth activation type
+    template<ActivationFunctions::ActivationType Type>
+    constexpr Kernels::SmoothFunction SmoothFunctionOf()
+    {
+        Kernels::SmoothFunction function = Kernels::SmoothFunction::Sigmoid;
+        GetSmoothFunction(Type, function);
+        return function;
+    }
+
+    /// @brief Parameters and forward pass of one dense layer whose sizes are known at compile time. The weights are stored
+    ///        as the transpose of the weights of BasicLayer, one row per input, and the neurons are computed in blocks
+    ///        whose sums stay in registers while every input is multiplied with the contiguous weights of the block.
+    template<typename T, int Inputs, int Neurons, ActivationFunctions::ActivationType Type, ActivationFunctions::Accuracy Accuracy>
+    struct Dense
+    {
+        static constexpr size_t NumParameters = static_cast<size_t>(Inputs) * Neurons + Neurons;
+        /// Number of neurons summed together, whose weights for one input fill a cache line of doubles or a 256-bit register
+        /// of floats. Wider blocks of floats are vectorised across inputs instead, which is slower for short layers.
+        static constexpr int BlockSize = 8;
+
+        std::array<T, static_cast<size_t>(Inputs) * Neurons> weights{};
+        std::array<T, Neurons> biases{};
+
+        /// Reads the row-major Neurons x Inputs weights followed by the biases, the order of BasicLayer and model files
+        constexpr void SetParameters(const T* parameters)
+        {
+            for (int j = 0 ; j < Neurons ; j++)
+            {
+                for (int k = 0 ; k < Inputs ; k++)
+                {
+                    weights[k * Neurons + j] = parameters[j * Inputs + k];
+                }
+                biases[j] = parameters[Inputs * Neurons + j];
+            }
+        }
+
+        constexpr void GetParameters(T* parameters) const
+        {
+            for (int j = 0 ; j < Neurons ; j++)
+            {
+                for (int k = 0 ; k < Inputs ; k++)
+                {
+                    parameters[j * Inputs + k] = weights[k * Neurons + j];
+                }
+                parameters[Inputs * Neurons + j] = biases[j];
+            }
+        }
+
+        void Forward(const T* inputs, T* outputs) const
+        {
+            T sums[Neurons];
+            for (int start = 0 ; start < Neurons ; start += BlockSize)
+            {
+                // The last block is narrower when the number of neurons is not a multiple of the block size
+                constexpr int Last = Neurons % BlockSize ? Neurons % BlockSize : BlockSize;
+                if (start + BlockSize <= Neurons)
+                {
+                    SumBlock<BlockSize>(inputs, start, sums + start);
+                }
+                else
+                {
+                    SumBlock<Last>(inputs, start, sums + start);
+                }
+            }
+            if constexpr (Approximated<Type, Accuracy>())
+            {
+                Kernels::ApproximateActivation(SmoothFunctionOf<Type>(), Neurons, sums, outputs, static_cast<T*>(nullptr));
+            }
+            else
+            {
+                for (int j = 0 ; j < Neurons ; j++)
+                {
+                    outputs[j] = ActivationFunctions::Kernel<Type>::Value(sums[j]);
+                }
+            }
+        }
+
+        template<int Width>
+        void SumBlock(const T* inputs, int start, T* sums) const
+        {
+            T block[Width];
+            for (int j = 0 ; j < Width ; j++)
+            {
+                block[j] = biases[start + j];
+            }
+            for (int k = 0 ; k < Inputs ; k++)
+            {
+                const T x = inputs[k];
+                const T* row = weights.data() + static_cast<size_t>(k) * Neurons + start;
+                for (int j = 0 ; j < Width ; j++)
+                {
+                    block[j] += x * row[j];
+                }
+            }
+            for (int j = 0 ; j < Width ; j++)
+            {
+                sums[j] = block[j];
+            }
+        }
+    };
+
+    /// @brief The layers of a StaticNetwork after its input layer, each one holding the layers after it, so that the
+    ///        intermediate results of a row live in fixed-size arrays on the stack
+    template<typename T, int Inputs, typename... Layers>
+    struct Chain;
+
+    template<typename T, int Inputs, typename Last>
+    struct Chain<T, Inputs, Last>
+    {
+        using Layer = Dense<T, Inputs, Last::NumNeurons, Last::Activation, Last::Accuracy>;
+        static constexpr int NumOutputs = Last::NumNeurons;
+        static constexpr size_t NumParameters = Layer::NumParameters;
+
+        Layer layer;
+
+        constexpr void SetParameters(const T* parameters) { layer.SetParameters(parameters); }
+        constexpr void GetParameters(T* parameters) const { layer.GetParameters(parameters); }
+        void Forward(const T* inputs, T* outputs) const { layer.Forward(inputs, outputs); }
+    };
+
+    template<typename T, int Inputs, typename First, typename Second, typename... Rest>
+    struct Chain<T, Inputs, First, Second, Rest...>
+    {
+        using Layer = Dense<T, Inputs, First::NumNeurons, First::Activation, First::Accuracy>;
+        using Next = Chain<T, First::NumNeurons, Second, Rest...>;
+        static constexpr int NumOutputs = Next::NumOutputs;
+        static constexpr size_t NumParameters = Layer::NumParameters + Next::NumParameters;
+
+        Layer layer;
+        Next next;
+
+        constexpr void SetParameters(const T* parameters)
+        {
+            layer.SetParameters(parameters);
+            next.SetParameters(parameters + Layer::NumParameters);
+        }
+
+        constexpr void GetParameters(T* parameters) const
+        {
+            layer.GetParameters(parameters);
+            next.GetParameters(parameters + Layer::NumParameters);
+        }
+
+        void Forward(const T* inputs, T* outputs) const
+        {
+            T hidden[First::NumNeurons];
+            layer.Forward(inputs, hidden);
+            next.Forward(hidden, outputs);
+        }
+    };
+}
+
+/// @brief Feed-forward network whose topology is fixed at compile time, for latency-critical inference with small models,
+///        for example StaticNetwork<float, 4, StaticLayer<8, ActivationType::Relu>, StaticLayer<1>> for 4 inputs, a relu
+///        hidden layer of 8 neurons and a linear output. Every loop bound is a constant and every weight lives in a
+///        std::array inside the object, so the compiler unrolls and vectorises the whole forward pass, and a prediction
+///        never allocates, dispatches on the activation type or calls through a function object. The activations are
+///        evaluated as by Activation with the accuracy of their layer, see StaticLayer. The outputs are those of the
+///        output layer, so a network trained with a loss that takes logits predicts logits, see
+///        LossFunctions::LogitsToProbabilities(). Only the constructor from a network and Load() need network.h and the
+///        library, everything else is header-only.
+///
+///        The gain is in the fixed cost of a prediction, so it shrinks as the layers grow. static_network_bench measures
+///        about 7x over BasicNeuralNetwork::Predict() for 4-8-1, 1.5x for 16-32-3 silu, but only 1.0-1.2x for 16-32-16-4
+///        and 8-64-64-10: the dynamic network runs its sums through kernels picked for the CPU at runtime, while this
+///        header is compiled for the target of the build, which is plain SSE2 unless ARCH is set.
+template<typename T, int Inputs, typename... Layers>
+class StaticNetwork
+{
+    static_assert(Inputs > 0, "A network needs at least one input");
+    static_assert(sizeof...(Layers) > 0, "A network needs at least an output layer");
+
+    using Chain = StaticNetworkDetail::Chain<T, Inputs, Layers...>;
+
+    public:
+        static constexpr int NumInputs = Inputs;
+        static constexpr int NumOutputs = Chain::NumOutputs;
+        /// Number of layers, including the input and output layers, as for BasicNeuralNetwork::GetNumLayers()
+        static constexpr int NumLayers = sizeof...(Layers) + 1;
+        /// Number of weights and biases of every layer together
+        static constexpr size_t NumParameters = Chain::NumParameters;
+
+        /// @brief Create a network whose weights and biases are all zero
+        constexpr StaticNetwork() = default;
+
+        /// @class            Create a network from its parameters, which can be a constant expression, so that a trained model
+        ///                   is compiled into the program as read-only data, see WriteParameters()
+        /// @param parameters The weights and then the biases of each layer in turn, the weights of a layer in the row-major
+        ///                   neurons x inputs order of BasicLayer::GetWeights()
+        constexpr explicit StaticNetwork(const std::array<T, NumParameters>& parameters)
+        {
+            chain.SetParameters(parameters.data());
+        }
+
+        /// @brief         Copies the weights and biases of a trained network, converting them to T. Throws if the network does
+        ///                not have the same number of layers, sizes and activation types as the template arguments. The
+        ///                accuracy of the activations is taken from the template arguments rather than the network.
+        /// @param network The trained network
+        template<typename U, typename Accumulator>
+        explicit StaticNetwork(const BasicNeuralNetwork<U, Accumulator>& network)
+        {
+            const int sizes[] = {Inputs, Layers::NumNeurons...};
+            const ActivationFunctions::ActivationType types[] = {Layers::Activation...};
+            if (network.GetNumLayers() != NumLayers || network.GetLayer(0).GetNumNeurons() != Inputs)
+            {
+                throw(std::invalid_argument("Network does not have the topology of the static network"));
+            }
+
+            std::vector<T> parameters;
+            parameters.reserve(NumParameters);
+            for (int i = 1 ; i < NumLayers ; i++)
+            {
+                const auto& layer = network.GetLayer(i);
+                if (layer.GetNumNeurons() != sizes[i] || layer.GetActivationFunction().GetType() != types[i - 1])
+                {
+                    throw(std::invalid_argument("Layer " + std::to_string(i) + " does not match the static network"));
+                }
+                parameters.insert(parameters.end(), layer.GetWeights(), layer.GetWeights() + layer.GetNumWeights());
+                parameters.insert(parameters.end(), layer.GetBiases(), layer.GetBiases() + layer.GetNumBiases());
+            }
+            chain.SetParameters(parameters.data());
+        }
+
+        /// @brief      Opens a model file written by BasicNeuralNetwork::Save() and copies its parameters, throwing if its
+        ///             topology does not match
+        /// @param path Path of the file to open
+        /// @return     The network
+        static StaticNetwork Load(const std::string& path)
+        {
+            return StaticNetwork(BasicNeuralNetwork<T, T>::Load(path));
+        }
+
+        /// @brief        Runs the network on a single row
+        /// @param input  Pointer to the NumInputs input values
+        /// @param output Pointer to where the NumOutputs output values are written
+        void Predict(const T* input, T* output) const
+        {
+            chain.Forward(input, output);
+        }
+
+        /// @brief       Runs the network on a single row
+        /// @param input The input values
+        /// @return      The output values
+        std::array<T, NumOutputs> Predict(const std::array<T, NumInputs>& input) const
+        {
+            std::array<T, NumOutputs> output;
+            chain.Forward(input.data(), output.data());
+            return output;
+        }
+
+        /// @brief         Runs the network on a batch of rows
+        /// @param inputs  Row-major matrix of input values, whose size must be a multiple of the number of inputs
+        /// @param outputs Row-major matrix the output values are written to, with one row per input row
+        void PredictBatch(Span<const T> inputs, Span<T> outputs) const
+        {
+            const size_t rows = inputs.size() / Inputs;
+            if (inputs.size() % Inputs || outputs.size() != rows * NumOutputs)
+            {
+                throw(std::invalid_argument("Input and output sizes must match the network for the same number of rows"));
+            }
+            for (size_t r = 0 ; r < rows ; r++)
+            {
+                chain.Forward(inputs.data() + r * Inputs, outputs.data() + r * NumOutputs);
+            }
+        }
+
+        /// @brief  Get the parameters of the network, in the order the constructor takes them
+        /// @return The weights and biases of every layer
+        constexpr std::array<T, NumParameters> GetParameters() const
+        {
+            std::array<T, NumParameters> parameters{};
+            chain.GetParameters(parameters.data());
+            return parameters;
+        }
+
+        /// @brief        Writes the parameters as a braced initializer list of exact hexadecimal floating point literals,
+        ///               which can be pasted into source code and passed to the constexpr constructor
+        /// @param stream The stream to write to
+        void WriteParameters(std::ostream& stream) const
+        {
+            const std::array<T, NumParameters> parameters = GetParameters();
+            const std::ios_base::fmtflags flags = stream.flags();
+            stream << std::hexfloat << "{";
+            for (size_t i = 0 ; i < NumParameters ; i++)
+            {
+                stream << (i ? ", " : "") << parameters[i];
+            }
+            stream << "}";
+            stream.flags(flags);
+        }
+
+    private:
+        Chain chain;
+};
+
+#endif // STATIC_NETWORK_H
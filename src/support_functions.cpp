@@ -1,91 +1,427 @@
 #include "support_functions.h"
+#include "kernels.h"
 
 double ActivationFunctions::binary(double x)
 {
-    return (x < 0) ? 0 : 1;
+    return Kernel<ActivationType::Binary>::Value(x);
 }
 
 double ActivationFunctions::d_binary(double x)
 {
-    return 0;
+    return Kernel<ActivationType::Binary>::Derivative(x);
 }
 
 double ActivationFunctions::linear(double x)
 {
-    return x;
+    return Kernel<ActivationType::Linear>::Value(x);
 }
 
 double ActivationFunctions::d_linear(double x)
 {
-    return 1;
+    return Kernel<ActivationType::Linear>::Derivative(x);
 }
 
 double ActivationFunctions::sigmoid(double x)
 {
-    return 1 / (1 + exp(-x));
+    return Kernel<ActivationType::Sigmoid>::Value(x);
 }
 
 double ActivationFunctions::d_sigmoid(double x)
 {
-    return sigmoid(x) * (1 - sigmoid(x));
+    return Kernel<ActivationType::Sigmoid>::Derivative(x);
 }
 
 double ActivationFunctions::tanh(double x)
 {
-    return (exp(x) - exp(-x)) / (exp(x) + exp(-x));
+    return Kernel<ActivationType::Tanh>::Value(x);
 }
 
 double ActivationFunctions::d_tanh(double x)
 {
-    return 1 - tanh(x) * tanh(x);
+    return Kernel<ActivationType::Tanh>::Derivative(x);
 }
 
 double ActivationFunctions::relu(double x)
 {
-    return (x > 0) ? x : 0;
+    return Kernel<ActivationType::Relu>::Value(x);
 }
 
 double ActivationFunctions::d_relu(double x)
 {
-    return (x > 0) ? 1 : 0;
+    return Kernel<ActivationType::Relu>::Derivative(x);
 }
 
 double ActivationFunctions::lrelu(double x)
 {
-    return (x > 0) ? x : 0.1 * x;
+    return Kernel<ActivationType::LRelu>::Value(x);
 }
 
 double ActivationFunctions::d_lrelu(double x)
 {
-    return (x > 0) ? 1 : 0.1;
+    return Kernel<ActivationType::LRelu>::Derivative(x);
 }
 
 double ActivationFunctions::elu(double x)
 {
-    return (x > 0) ? x : exp(-x) - 1;
+    return Kernel<ActivationType::Elu>::Value(x);
 }
 
 double ActivationFunctions::d_elu(double x)
 {
-    return (x > 0) ? x : - exp(-x);
+    return Kernel<ActivationType::Elu>::Derivative(x);
+}
+
+double ActivationFunctions::softplus(double x)
+{
+    return Kernel<ActivationType::Softplus>::Value(x);
+}
+
+double ActivationFunctions::d_softplus(double x)
+{
+    return Kernel<ActivationType::Softplus>::Derivative(x);
+}
+
+double ActivationFunctions::gelu(double x)
+{
+    return Kernel<ActivationType::Gelu>::Value(x);
+}
+
+double ActivationFunctions::d_gelu(double x)
+{
+    return Kernel<ActivationType::Gelu>::Derivative(x);
+}
+
+double ActivationFunctions::silu(double x)
+{
+    return Kernel<ActivationType::Silu>::Value(x);
+}
+
+double ActivationFunctions::d_silu(double x)
+{
+    return Kernel<ActivationType::Silu>::Derivative(x);
 }
 
 std::function<double(double)> ActivationFunctions::GetDerivativeFunctionName(std::function<double(double)> f)
 {
-    auto functionName = *f.target<double(*)(double)>();
     std::function<double(double)> df;
-    
-    if      (functionName == ActivationFunctions::binary)  { df = ActivationFunctions::d_binary; }
-    else if (functionName == ActivationFunctions::linear)  { df = ActivationFunctions::d_linear; }
-    else if (functionName == ActivationFunctions::sigmoid) { df = ActivationFunctions::d_sigmoid; }
-    else if (functionName == ActivationFunctions::tanh)    { df = ActivationFunctions::d_tanh; }
-    else if (functionName == ActivationFunctions::relu)    { df = ActivationFunctions::d_relu; }
-    else if (functionName == ActivationFunctions::lrelu)   { df = ActivationFunctions::d_lrelu; }
-    else if (functionName == ActivationFunctions::elu)     { df = ActivationFunctions::d_elu; }
-    
+    switch (GetActivationType(f))
+    {
+        case ActivationType::Binary:   df = ActivationFunctions::d_binary;   break;
+        case ActivationType::Linear:   df = ActivationFunctions::d_linear;   break;
+        case ActivationType::Sigmoid:  df = ActivationFunctions::d_sigmoid;  break;
+        case ActivationType::Tanh:     df = ActivationFunctions::d_tanh;     break;
+        case ActivationType::Relu:     df = ActivationFunctions::d_relu;     break;
+        case ActivationType::LRelu:    df = ActivationFunctions::d_lrelu;    break;
+        case ActivationType::Elu:      df = ActivationFunctions::d_elu;      break;
+        case ActivationType::Softplus: df = ActivationFunctions::d_softplus; break;
+        case ActivationType::Gelu:     df = ActivationFunctions::d_gelu;     break;
+        case ActivationType::Silu:     df = ActivationFunctions::d_silu;     break;
+        default: break;
+    }
     return df;
 }
 
+ActivationFunctions::ActivationType ActivationFunctions::GetActivationType(const std::function<double(double)>& f)
+{
+    auto functionName = f.target<double(*)(double)>();
+    if (!functionName)
+    {
+        return ActivationType::Custom;
+    }
+
+    if      (*functionName == ActivationFunctions::binary)   { return ActivationType::Binary; }
+    else if (*functionName == ActivationFunctions::linear)   { return ActivationType::Linear; }
+    else if (*functionName == ActivationFunctions::sigmoid)  { return ActivationType::Sigmoid; }
+    else if (*functionName == ActivationFunctions::tanh)     { return ActivationType::Tanh; }
+    else if (*functionName == ActivationFunctions::relu)     { return ActivationType::Relu; }
+    else if (*functionName == ActivationFunctions::lrelu)    { return ActivationType::LRelu; }
+    else if (*functionName == ActivationFunctions::elu)      { return ActivationType::Elu; }
+    else if (*functionName == ActivationFunctions::softplus) { return ActivationType::Softplus; }
+    else if (*functionName == ActivationFunctions::gelu)     { return ActivationType::Gelu; }
+    else if (*functionName == ActivationFunctions::silu)     { return ActivationType::Silu; }
+
+    return ActivationType::Custom;
+}
+
+std::function<double(double)> ActivationFunctions::GetActivationFunction(ActivationType type)
+{
+    switch (type)
+    {
+        case ActivationType::Binary:   return ActivationFunctions::binary;
+        case ActivationType::Linear:   return ActivationFunctions::linear;
+        case ActivationType::Sigmoid:  return ActivationFunctions::sigmoid;
+        case ActivationType::Tanh:     return ActivationFunctions::tanh;
+        case ActivationType::Relu:     return ActivationFunctions::relu;
+        case ActivationType::LRelu:    return ActivationFunctions::lrelu;
+        case ActivationType::Elu:      return ActivationFunctions::elu;
+        case ActivationType::Softplus: return ActivationFunctions::softplus;
+        case ActivationType::Gelu:     return ActivationFunctions::gelu;
+        case ActivationType::Silu:     return ActivationFunctions::silu;
+        default: throw(std::invalid_argument("Unknown activation function type"));
+    }
+}
+
+namespace
+{
+    using ActivationFunctions::ActivationType;
+    using ActivationFunctions::Kernel;
+
+    // Each pass is instantiated once per built-in function, so the kernel is inlined into a loop the compiler can vectorise
+
+    template<ActivationType Type>
+    struct ApplyPass
+    {
+        template<typename T>
+        static void Run(T* values, size_t count)
+        {
+            for (size_t i = 0 ; i < count ; i++)
+            {
+                values[i] = Kernel<Type>::Value(values[i]);
+            }
+        }
+    };
+
+    template<ActivationType Type>
+    struct DerivativePass
+    {
+        template<typename T>
+        static void Run(T* values, size_t count)
+        {
+            for (size_t i = 0 ; i < count ; i++)
+            {
+                values[i] = Kernel<Type>::Derivative(values[i]);
+            }
+        }
+    };
+
+    template<ActivationType Type>
+    struct FusedPass
+    {
+        template<typename T>
+        static void Run(const T* inputs, size_t count, T* outputs, T* derivatives)
+        {
+            for (size_t i = 0 ; i < count ; i++)
+            {
+                T y, dy;
+                Kernel<Type>::ValueAndDerivative(inputs[i], y, dy);
+                outputs[i] = y;
+                derivatives[i] = dy;
+            }
+        }
+    };
+
+    /// Runs a pass with the built-in activation type as its template argument
+    template<template<ActivationType> class Pass, typename... Arguments>
+    void Dispatch(ActivationType type, Arguments... arguments)
+    {
+        switch (type)
+        {
+            case ActivationType::Binary:   Pass<ActivationType::Binary>::Run(arguments...);   break;
+            case ActivationType::Linear:   Pass<ActivationType::Linear>::Run(arguments...);   break;
+            case ActivationType::Sigmoid:  Pass<ActivationType::Sigmoid>::Run(arguments...);  break;
+            case ActivationType::Tanh:     Pass<ActivationType::Tanh>::Run(arguments...);     break;
+            case ActivationType::Relu:     Pass<ActivationType::Relu>::Run(arguments...);     break;
+            case ActivationType::LRelu:    Pass<ActivationType::LRelu>::Run(arguments...);    break;
+            case ActivationType::Elu:      Pass<ActivationType::Elu>::Run(arguments...);      break;
+            case ActivationType::Softplus: Pass<ActivationType::Softplus>::Run(arguments...); break;
+            case ActivationType::Gelu:     Pass<ActivationType::Gelu>::Run(arguments...);     break;
+            case ActivationType::Silu:     Pass<ActivationType::Silu>::Run(arguments...);     break;
+            default: throw(std::invalid_argument("Unknown activation function type"));
+        }
+    }
+
+    /// Returns whether an activation type has a fast approximation, and which one
+    bool GetSmoothFunction(ActivationType type, Kernels::SmoothFunction& function)
+    {
+        switch (type)
+        {
+            case ActivationType::Sigmoid:  function = Kernels::SmoothFunction::Sigmoid;  return true;
+            case ActivationType::Tanh:     function = Kernels::SmoothFunction::Tanh;     return true;
+            case ActivationType::Elu:      function = Kernels::SmoothFunction::Elu;      return true;
+            case ActivationType::Softplus: function = Kernels::SmoothFunction::Softplus; return true;
+            case ActivationType::Gelu:     function = Kernels::SmoothFunction::Gelu;     return true;
+            case ActivationType::Silu:     function = Kernels::SmoothFunction::Silu;     return true;
+            default:                       return false;
+        }
+    }
+}
+
+Activation::Activation(ActivationFunctions::ActivationType inputType, ActivationFunctions::Accuracy inputAccuracy)
+           :
+           type(inputType),
+           accuracy(inputAccuracy)
+{
+    // Validates the type
+    ActivationFunctions::GetActivationFunction(type);
+}
+
+Activation::Activation(double (*inputFunction)(double))
+           :
+           Activation(std::function<double(double)>(inputFunction))
+{
+}
+
+Activation::Activation(std::function<double(double)> inputFunction)
+           :
+           type(ActivationFunctions::GetActivationType(inputFunction)),
+           accuracy(ActivationFunctions::Accuracy::Exact)
+{
+    if (type == ActivationType::Custom)
+    {
+        if (!inputFunction)
+        {
+            throw(std::invalid_argument("Activation function must not be empty"));
+        }
+        this->function = inputFunction;
+    }
+}
+
+Activation::Activation(std::function<double(double)> inputFunction, std::function<double(double)> inputDerivative)
+           :
+           type(ActivationType::Custom),
+           accuracy(ActivationFunctions::Accuracy::Exact),
+           function(inputFunction),
+           derivative(inputDerivative)
+{
+    if (!function || !derivative)
+    {
+        throw(std::invalid_argument("Custom activation function and derivative must not be empty"));
+    }
+}
+
+ActivationFunctions::ActivationType Activation::GetType() const
+{
+    return this->type;
+}
+
+void Activation::SetAccuracy(ActivationFunctions::Accuracy inputAccuracy)
+{
+    this->accuracy = inputAccuracy;
+}
+
+ActivationFunctions::Accuracy Activation::GetAccuracy() const
+{
+    return this->accuracy;
+}
+
+std::function<double(double)> Activation::GetFunction() const
+{
+    return (type == ActivationType::Custom) ? function : ActivationFunctions::GetActivationFunction(type);
+}
+
+double Activation::operator()(double x) const
+{
+    double y = x;
+    Apply(&y, 1);
+    return y;
+}
+
+double Activation::Derivative(double x) const
+{
+    double dy = x;
+    ApplyDerivative(&dy, 1);
+    return dy;
+}
+
+void Activation::Apply(double* values, size_t count) const
+{
+    ApplyValues(values, count);
+}
+
+void Activation::Apply(float* values, size_t count) const
+{
+    ApplyValues(values, count);
+}
+
+void Activation::ApplyDerivative(double* values, size_t count) const
+{
+    ApplyDerivativeValues(values, count);
+}
+
+void Activation::ApplyDerivative(float* values, size_t count) const
+{
+    ApplyDerivativeValues(values, count);
+}
+
+void Activation::ApplyWithDerivative(const double* inputs, size_t count, double* outputs, double* derivatives) const
+{
+    ApplyValuesWithDerivative(inputs, count, outputs, derivatives);
+}
+
+void Activation::ApplyWithDerivative(const float* inputs, size_t count, float* outputs, float* derivatives) const
+{
+    ApplyValuesWithDerivative(inputs, count, outputs, derivatives);
+}
+
+template<typename T>
+void Activation::ApplyValues(T* values, size_t count) const
+{
+    Kernels::SmoothFunction smooth;
+    if (accuracy == ActivationFunctions::Accuracy::Fast && GetSmoothFunction(type, smooth))
+    {
+        Kernels::ApproximateActivation<T>(smooth, count, values, values, nullptr);
+        return;
+    }
+    if (type != ActivationType::Custom)
+    {
+        Dispatch<ApplyPass>(type, values, count);
+        return;
+    }
+    for (size_t i = 0 ; i < count ; i++)
+    {
+        values[i] = static_cast<T>(function(values[i]));
+    }
+}
+
+template<typename T>
+void Activation::ApplyDerivativeValues(T* values, size_t count) const
+{
+    Kernels::SmoothFunction smooth;
+    if (accuracy == ActivationFunctions::Accuracy::Fast && GetSmoothFunction(type, smooth))
+    {
+        Kernels::ApproximateActivation<T>(smooth, count, values, nullptr, values);
+        return;
+    }
+    if (type != ActivationType::Custom)
+    {
+        Dispatch<DerivativePass>(type, values, count);
+        return;
+    }
+    if (!derivative)
+    {
+        throw(std::logic_error("Custom activation functions need a derivative to be trained, see Activation(function, derivative)"));
+    }
+    for (size_t i = 0 ; i < count ; i++)
+    {
+        values[i] = static_cast<T>(derivative(values[i]));
+    }
+}
+
+template<typename T>
+void Activation::ApplyValuesWithDerivative(const T* inputs, size_t count, T* outputs, T* derivatives) const
+{
+    Kernels::SmoothFunction smooth;
+    if (accuracy == ActivationFunctions::Accuracy::Fast && GetSmoothFunction(type, smooth))
+    {
+        Kernels::ApproximateActivation(smooth, count, inputs, outputs, derivatives);
+        return;
+    }
+    if (type != ActivationType::Custom)
+    {
+        Dispatch<FusedPass>(type, inputs, count, outputs, derivatives);
+        return;
+    }
+    if (!derivative)
+    {
+        throw(std::logic_error("Custom activation functions need a derivative to be trained, see Activation(function, derivative)"));
+    }
+    for (size_t i = 0 ; i < count ; i++)
+    {
+        const T x = inputs[i];
+        outputs[i] = static_cast<T>(function(x));
+        derivatives[i] = static_cast<T>(derivative(x));
+    }
+}
 
 double LossFunctions::mse(std::vector<double> predicted, std::vector<double> actual)
 {
@@ -140,13 +476,206 @@ double LossFunctions::d_mae(double predicted, double actual)
     return sum;
 }
 
+double LossFunctions::cross_entropy(std::vector<double> logits, std::vector<double> actual)
+{
+    if (logits.size() != actual.size())
+    {
+        throw(std::invalid_argument("Size of the predicted and true value vectors must be the same."));
+    }
+    return BatchLoss<double>(LossType::SoftmaxCrossEntropy, logits.size(), logits, actual);
+}
+
+double LossFunctions::binary_cross_entropy(std::vector<double> logits, std::vector<double> actual)
+{
+    if (logits.size() != actual.size())
+    {
+        throw(std::invalid_argument("Size of the predicted and true value vectors must be the same."));
+    }
+    return BatchLoss<double>(LossType::BinaryCrossEntropy, logits.size(), logits, actual);
+}
+
+double LossFunctions::d_binary_cross_entropy(double logit, double actual)
+{
+    // The sigmoid of the logit, from an exponential that cannot overflow
+    const double e = std::exp(-std::abs(logit));
+    return (logit >= 0 ? 1 : e) / (1 + e) - actual;
+}
+
 std::function<double(double, double)> LossFunctions::GetDerivativeFunctionName(std::function<double(std::vector<double>, std::vector<double>)> f)
 {
-    auto functionName = *f.target<double(*)(std::vector<double>, std::vector<double>)>();
+    auto functionName = f.target<double(*)(std::vector<double>, std::vector<double>)>();
     std::function<double(double, double)> df;
+    if (!functionName)
+    {
+        return df;
+    }
     
-    if      (functionName == LossFunctions::mse)  { df = LossFunctions::d_mse; }
-    else if (functionName == LossFunctions::mae)  { df = LossFunctions::d_mae; }
+    // The softmax couples the outputs of a row, so cross_entropy has no per-output derivative, see BatchLoss()
+    if      (*functionName == LossFunctions::mse)  { df = LossFunctions::d_mse; }
+    else if (*functionName == LossFunctions::mae)  { df = LossFunctions::d_mae; }
+    else if (*functionName == LossFunctions::binary_cross_entropy) { df = LossFunctions::d_binary_cross_entropy; }
     
     return df;
-}
\ No newline at end of file
+}
+
+LossFunctions::LossType LossFunctions::GetLossType(const std::function<double(std::vector<double>, std::vector<double>)>& f)
+{
+    auto functionName = f.target<double(*)(std::vector<double>, std::vector<double>)>();
+    if (!functionName)
+    {
+        return LossType::Custom;
+    }
+
+    if      (*functionName == LossFunctions::mse) { return LossType::Mse; }
+    else if (*functionName == LossFunctions::mae) { return LossType::Mae; }
+    else if (*functionName == LossFunctions::cross_entropy) { return LossType::SoftmaxCrossEntropy; }
+    else if (*functionName == LossFunctions::binary_cross_entropy) { return LossType::BinaryCrossEntropy; }
+
+    return LossType::Custom;
+}
+
+std::function<double(std::vector<double>, std::vector<double>)> LossFunctions::GetLossFunction(LossType type)
+{
+    switch (type)
+    {
+        case LossType::Mse: return LossFunctions::mse;
+        case LossType::Mae: return LossFunctions::mae;
+        case LossType::SoftmaxCrossEntropy: return LossFunctions::cross_entropy;
+        case LossType::BinaryCrossEntropy: return LossFunctions::binary_cross_entropy;
+        default: throw(std::invalid_argument("Unknown loss function type"));
+    }
+}
+
+bool LossFunctions::TakesLogits(LossType type)
+{
+    return type == LossType::SoftmaxCrossEntropy || type == LossType::BinaryCrossEntropy;
+}
+
+template<typename T>
+double LossFunctions::BatchLoss(LossType type, int columns, Span<const T> outputs, Span<const double> targets, Span<T> gradients)
+{
+    if (columns <= 0 || outputs.size() % columns || targets.size() != outputs.size() || (!gradients.empty() && gradients.size() != outputs.size()))
+    {
+        throw(std::invalid_argument("Outputs, targets and gradients must hold the same whole number of rows"));
+    }
+
+    const bool withGradients = !gradients.empty();
+    const size_t rows = outputs.size() / columns;
+    double sum = 0;
+    switch (type)
+    {
+        case LossType::Mse:
+            for (size_t k = 0 ; k < outputs.size() ; k++)
+            {
+                const double difference = outputs[k] - targets[k];
+                sum += difference * difference;
+                if (withGradients)
+                {
+                    gradients[k] = static_cast<T>(2 * difference);
+                }
+            }
+            return sum / columns;
+        case LossType::Mae:
+            for (size_t k = 0 ; k < outputs.size() ; k++)
+            {
+                const double difference = outputs[k] - targets[k];
+                sum += std::abs(difference);
+                if (withGradients)
+                {
+                    gradients[k] = static_cast<T>((difference > 0) - (difference < 0));
+                }
+            }
+            return sum / columns;
+        case LossType::SoftmaxCrossEntropy:
+            for (size_t r = 0 ; r < rows ; r++)
+            {
+                const T* z = outputs.data() + r * columns;
+                const double* y = targets.data() + r * columns;
+
+                // Shifting by the largest logit keeps every exponential in (0, 1], so that their sum cannot overflow
+                double largest = z[0];
+                for (int k = 1 ; k < columns ; k++)
+                {
+                    largest = std::max<double>(largest, z[k]);
+                }
+                double total = 0, weight = 0, weighted = 0;
+                for (int k = 0 ; k < columns ; k++)
+                {
+                    const double e = std::exp(z[k] - largest);
+                    total += e;
+                    weight += y[k];
+                    weighted += y[k] * z[k];
+                    if (withGradients)
+                    {
+                        gradients[r * columns + k] = static_cast<T>(e);
+                    }
+                }
+
+                // -sum(y * log(p)) with log(p) = z - logsumexp(z)
+                const double logSumExp = largest + std::log(total);
+                sum += weight * logSumExp - weighted;
+                if (withGradients)
+                {
+                    const double scale = weight / total;
+                    T* g = gradients.data() + r * columns;
+                    for (int k = 0 ; k < columns ; k++)
+                    {
+                        g[k] = static_cast<T>(g[k] * scale - y[k]);
+                    }
+                }
+            }
+            return sum;
+        case LossType::BinaryCrossEntropy:
+            for (size_t k = 0 ; k < outputs.size() ; k++)
+            {
+                // log(1 + exp(z)) - y * z = max(z, 0) + log1p(exp(-|z|)) - y * z, with the same exponential giving the sigmoid
+                const double z = outputs[k];
+                const double e = std::exp(-std::abs(z));
+                sum += std::max(z, 0.0) - targets[k] * z + std::log1p(e);
+                if (withGradients)
+                {
+                    gradients[k] = static_cast<T>((z >= 0 ? 1 : e) / (1 + e) - targets[k]);
+                }
+            }
+            return sum / columns;
+        default:
+            throw(std::invalid_argument("Only built-in loss functions can be evaluated over a batch"));
+    }
+}
+
+template<typename T>
+void LossFunctions::LogitsToProbabilities(LossType type, int columns, Span<T> values)
+{
+    if (type == LossType::BinaryCrossEntropy)
+    {
+        for (T& value : values)
+        {
+            const T e = std::exp(-std::abs(value));
+            value = (value >= 0 ? 1 : e) / (1 + e);
+        }
+    }
+    else if (type == LossType::SoftmaxCrossEntropy)
+    {
+        for (size_t start = 0 ; start < values.size() ; start += columns)
+        {
+            T* row = values.data() + start;
+            const T largest = *std::max_element(row, row + columns);
+            T total = 0;
+            for (int k = 0 ; k < columns ; k++)
+            {
+                row[k] = std::exp(row[k] - largest);
+                total += row[k];
+            }
+            for (int k = 0 ; k < columns ; k++)
+            {
+                row[k] /= total;
+            }
+        }
+    }
+}
+
+// Supported precisions
+template double LossFunctions::BatchLoss<double>(LossType, int, Span<const double>, Span<const double>, Span<double>);
+template double LossFunctions::BatchLoss<float>(LossType, int, Span<const float>, Span<const double>, Span<float>);
+template void LossFunctions::LogitsToProbabilities<double>(LossType, int, Span<double>);
+template void LossFunctions::LogitsToProbabilities<float>(LossType, int, Span<float>);
@@ -3,8 +3,14 @@
 
 #include <cmath>
 #include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#include <type_traits>
 #include <unordered_map>
 
+#include "span.h"
+
 namespace ActivationFunctions
 {
     /// @brief   Namespace to hold common types of activaction functions that a user can input when creating a neuron or neural network.
@@ -20,6 +26,9 @@ namespace ActivationFunctions
     double relu(double x);
     double lrelu(double x);
     double elu(double x);
+    double softplus(double x);
+    double gelu(double x);
+    double silu(double x);
 
     double d_binary(double x);
     double d_linear(double x);
@@ -28,8 +37,258 @@ namespace ActivationFunctions
     double d_relu(double x);
     double d_lrelu(double x);
     double d_elu(double x);
+    double d_softplus(double x);
+    double d_gelu(double x);
+    double d_silu(double x);
 
+    /// @brief   Returns the derivative of one of the activation functions above, or an empty function for any other function
+    /// @param f The activation function
+    /// @return  The derivative of the activation function
     std::function<double(double)> GetDerivativeFunctionName(std::function<double(double)> f);
+
+    /// @brief Identifies each of the activation functions above, so that they can be stored in saved models. The values
+    ///        are part of the model file format and must not be changed.
+    enum class ActivationType : unsigned
+    {
+        Binary   = 0,
+        Linear   = 1,
+        Sigmoid  = 2,
+        Tanh     = 3,
+        Relu     = 4,
+        LRelu    = 5,
+        Elu      = 6,
+        Softplus = 7,
+        Gelu     = 8,
+        Silu     = 9,
+        Custom   = 0xFFFFFFFF
+    };
+
+    /// @brief How the smooth built-in activation functions (sigmoid, tanh, elu, softplus, gelu and silu) are evaluated over
+    ///        buffers. Exact calls libm for every value, while Fast uses the vectorised approximations of
+    ///        Kernels::ApproximateActivation(), whose largest errors are listed there. The other functions are exact in both.
+    enum class Accuracy
+    {
+        Exact,
+        Fast
+    };
+
+    /// @brief   Returns the type of an activation function, or ActivationType::Custom if it is not one of the functions above
+    /// @param f The activation function
+    /// @return  The activation type
+    ActivationType GetActivationType(const std::function<double(double)>& f);
+
+    /// @brief      Returns the activation function for a type, throwing if the type is not one of the functions above
+    /// @param type The activation type
+    /// @return     The activation function
+    std::function<double(double)> GetActivationFunction(ActivationType type);
+
+    /// @brief Inlinable implementation of each built-in activation function, selected at compile time by its type so that
+    ///        sweeps over whole buffers contain no indirect calls. Value() is the function, Derivative() its derivative and
+    ///        ValueAndDerivative() computes both at once, reusing the function value where the derivative depends on it.
+    ///        Each is templated on the numeric type, so float buffers are evaluated in float.
+    template<ActivationType Type>
+    struct Kernel;
+
+    template<>
+    struct Kernel<ActivationType::Binary>
+    {
+        template<typename T> static T Value(T x) { return (x < 0) ? 0 : 1; }
+        template<typename T> static T Derivative(T x) { return 0; }
+        template<typename T> static void ValueAndDerivative(T x, T& y, T& dy) { y = Value(x); dy = 0; }
+    };
+
+    template<>
+    struct Kernel<ActivationType::Linear>
+    {
+        template<typename T> static T Value(T x) { return x; }
+        template<typename T> static T Derivative(T x) { return 1; }
+        template<typename T> static void ValueAndDerivative(T x, T& y, T& dy) { y = x; dy = 1; }
+    };
+
+    template<>
+    struct Kernel<ActivationType::Sigmoid>
+    {
+        template<typename T> static T Value(T x) { return 1 / (1 + std::exp(-x)); }
+        template<typename T> static T Derivative(T x) { const T y = Value(x); return y * (1 - y); }
+        template<typename T> static void ValueAndDerivative(T x, T& y, T& dy) { y = Value(x); dy = y * (1 - y); }
+    };
+
+    template<>
+    struct Kernel<ActivationType::Tanh>
+    {
+        template<typename T> static T Value(T x) { return std::tanh(x); }
+        template<typename T> static T Derivative(T x) { const T y = Value(x); return 1 - y * y; }
+        template<typename T> static void ValueAndDerivative(T x, T& y, T& dy) { y = Value(x); dy = 1 - y * y; }
+    };
+
+    template<>
+    struct Kernel<ActivationType::Relu>
+    {
+        template<typename T> static T Value(T x) { return (x > 0) ? x : 0; }
+        template<typename T> static T Derivative(T x) { return (x > 0) ? 1 : 0; }
+        template<typename T> static void ValueAndDerivative(T x, T& y, T& dy) { y = Value(x); dy = Derivative(x); }
+    };
+
+    template<>
+    struct Kernel<ActivationType::LRelu>
+    {
+        template<typename T> static T Value(T x) { return (x > 0) ? x : T(0.1) * x; }
+        template<typename T> static T Derivative(T x) { return (x > 0) ? T(1) : T(0.1); }
+        template<typename T> static void ValueAndDerivative(T x, T& y, T& dy) { y = Value(x); dy = Derivative(x); }
+    };
+
+    template<>
+    struct Kernel<ActivationType::Elu>
+    {
+        template<typename T> static T Value(T x) { return (x > 0) ? x : std::expm1(x); }
+        template<typename T> static T Derivative(T x) { return (x > 0) ? 1 : std::exp(x); }
+        template<typename T> static void ValueAndDerivative(T x, T& y, T& dy) { y = Value(x); dy = (x > 0) ? 1 : y + 1; }
+    };
+
+    /// log(1 + exp(x)), written so that exp never overflows, whose derivative is the sigmoid
+    template<>
+    struct Kernel<ActivationType::Softplus>
+    {
+        template<typename T> static T Value(T x) { return std::max(x, T(0)) + std::log1p(std::exp(-std::abs(x))); }
+        template<typename T> static T Derivative(T x) { return Kernel<ActivationType::Sigmoid>::Value(x); }
+        template<typename T> static void ValueAndDerivative(T x, T& y, T& dy)
+        {
+            const T t = std::exp(-std::abs(x));
+            y = std::max(x, T(0)) + std::log1p(t);
+            dy = (x > 0) ? 1 / (1 + t) : t / (1 + t);
+        }
+    };
+
+    /// x * Phi(x), with Phi the cumulative distribution function of the standard normal distribution, whose derivative is
+    /// Phi(x) + x * phi(x)
+    template<>
+    struct Kernel<ActivationType::Gelu>
+    {
+        template<typename T> static T Phi(T x) { return T(0.5) * std::erfc(T(-0.70710678118654752440) * x); }
+        template<typename T> static T Value(T x) { return x * Phi(x); }
+        template<typename T> static T Derivative(T x) { T y, dy; ValueAndDerivative(x, y, dy); return dy; }
+        template<typename T> static void ValueAndDerivative(T x, T& y, T& dy)
+        {
+            const T phi = Phi(x);
+            y = x * phi;
+            dy = phi + x * T(0.39894228040143267794) * std::exp(T(-0.5) * x * x);
+        }
+    };
+
+    /// x * sigmoid(x), also known as swish, whose derivative is sigmoid(x) + y * (1 - sigmoid(x)). For positive x,
+    /// 1 - sigmoid(x) is formed as exp(-x) * sigmoid(x) to avoid the cancellation.
+    template<>
+    struct Kernel<ActivationType::Silu>
+    {
+        template<typename T> static T Value(T x) { return x * Kernel<ActivationType::Sigmoid>::Value(x); }
+        template<typename T> static T Derivative(T x) { T y, dy; ValueAndDerivative(x, y, dy); return dy; }
+        template<typename T> static void ValueAndDerivative(T x, T& y, T& dy)
+        {
+            const T e = std::exp(-x);
+            const T s = 1 / (1 + e);
+            y = x * s;
+            dy = s + y * ((x > 0) ? e * s : 1 - s);
+        }
+    };
+};
+
+class Activation
+{
+    public:
+        /// @class      An activation function applied to whole buffers at once. Built-in functions are identified by their
+        ///             type and run through the inlined kernels above, while user-defined functions are called through the
+        ///             slower std::function path and carry their own derivative.
+        /// @param type     The built-in activation function, which must not be ActivationType::Custom
+        /// @param accuracy Whether smooth functions are evaluated exactly or with the fast approximations
+        Activation(ActivationFunctions::ActivationType type = ActivationFunctions::ActivationType::Linear,
+                   ActivationFunctions::Accuracy accuracy = ActivationFunctions::Accuracy::Exact);
+
+        /// @brief          Wraps a function pointer, which is recognised as a built-in activation function when it is one.
+        ///                 Any other function is custom and has no derivative, so it can only be used for inference.
+        /// @param function The activation function
+        Activation(double (*function)(double));
+
+        /// @brief          Wraps a function object, which is recognised as a built-in activation function when it holds one.
+        ///                 Any other function is custom and has no derivative, so it can only be used for inference.
+        /// @param function The activation function
+        Activation(std::function<double(double)> function);
+
+        /// @brief          Wraps any other callable, such as a lambda, as a custom activation function without a derivative
+        /// @param function The activation function
+        template<typename Function,
+                 typename = std::enable_if_t<std::is_invocable_r<double, Function, double>::value &&
+                                             !std::is_same<std::decay_t<Function>, Activation>::value>>
+        Activation(Function function)
+                  :
+                  Activation(std::function<double(double)>(function))
+        {
+        }
+
+        /// @brief            Creates a custom activation function that can be trained with
+        /// @param function   The activation function
+        /// @param derivative The derivative of the activation function
+        Activation(std::function<double(double)> function, std::function<double(double)> derivative);
+
+        /// @brief  Returns the type of the activation function, ActivationType::Custom for user-defined functions
+        /// @return The activation type
+        ActivationFunctions::ActivationType GetType() const;
+
+        /// @brief          Sets whether the smooth built-in functions are evaluated exactly or with the fast approximations of
+        ///                 Kernels::ApproximateActivation(). Has no effect on the other functions, including custom ones.
+        /// @param accuracy The accuracy
+        void SetAccuracy(ActivationFunctions::Accuracy accuracy);
+
+        /// @brief  Returns whether the smooth built-in functions are evaluated exactly or with the fast approximations
+        /// @return The accuracy
+        ActivationFunctions::Accuracy GetAccuracy() const;
+
+        /// @brief  Returns the activation function as a function object
+        /// @return The activation function
+        std::function<double(double)> GetFunction() const;
+
+        /// @brief   Evaluates the activation function for a single value
+        /// @param x The input value
+        /// @return  The function value
+        double operator()(double x) const;
+
+        /// @brief   Evaluates the derivative of the activation function for a single value
+        /// @param x The input value
+        /// @return  The derivative
+        double Derivative(double x) const;
+
+        /// @brief        Replaces every value of a buffer by the activation function of that value
+        /// @param values Pointer to the values
+        /// @param count  The number of values
+        void Apply(double* values, size_t count) const;
+        void Apply(float* values, size_t count) const;
+
+        /// @brief        Replaces every value of a buffer by the derivative of the activation function at that value
+        /// @param values Pointer to the values
+        /// @param count  The number of values
+        void ApplyDerivative(double* values, size_t count) const;
+        void ApplyDerivative(float* values, size_t count) const;
+
+        /// @brief             Evaluates the activation function and its derivative for every value of a buffer in one sweep
+        /// @param inputs      Pointer to the input values
+        /// @param count       The number of values
+        /// @param outputs     Pointer to where the function values are written, which may be the same as inputs
+        /// @param derivatives Pointer to where the derivatives are written
+        void ApplyWithDerivative(const double* inputs, size_t count, double* outputs, double* derivatives) const;
+        void ApplyWithDerivative(const float* inputs, size_t count, float* outputs, float* derivatives) const;
+
+    private:
+        template<typename T>
+        void ApplyValues(T* values, size_t count) const;
+        template<typename T>
+        void ApplyDerivativeValues(T* values, size_t count) const;
+        template<typename T>
+        void ApplyValuesWithDerivative(const T* inputs, size_t count, T* outputs, T* derivatives) const;
+
+        ActivationFunctions::ActivationType type;
+        ActivationFunctions::Accuracy accuracy;
+        /// Only used by custom activation functions
+        std::function<double(double)> function;
+        std::function<double(double)> derivative;
 };
 
 namespace LossFunctions
@@ -44,10 +303,69 @@ namespace LossFunctions
     double mse(std::vector<double> predicted, std::vector<double> actual);
     double mae(std::vector<double> predicted, std::vector<double> actual);
 
+    /// @brief Losses that take the logits of the output layer rather than its activations, and apply the softmax or the
+    ///        sigmoid themselves, so that they can be computed without overflow for any logits. The output layer must be
+    ///        linear, and the network turns its predictions into probabilities. cross_entropy is the categorical cross
+    ///        entropy of a softmax over the outputs of a row, binary_cross_entropy the mean of the cross entropies of a
+    ///        sigmoid on every output.
+    double cross_entropy(std::vector<double> logits, std::vector<double> actual);
+    double binary_cross_entropy(std::vector<double> logits, std::vector<double> actual);
+
     double d_mse(double predicted, double actual);
     double d_mae(double predicted, double actual);
+    double d_binary_cross_entropy(double logit, double actual);
 
     std::function<double(double, double)> GetDerivativeFunctionName(std::function<double(std::vector<double>, std::vector<double>)> f);
+
+    /// @brief Identifies each of the loss functions above, so that they can be stored in saved models. The values are part
+    ///        of the model file format and must not be changed.
+    enum class LossType : unsigned
+    {
+        Mse                 = 0,
+        Mae                 = 1,
+        SoftmaxCrossEntropy = 2,
+        BinaryCrossEntropy  = 3,
+        Custom              = 0xFFFFFFFF
+    };
+
+    /// @brief   Returns the type of a loss function, or LossType::Custom if it is not one of the functions above
+    /// @param f The loss function
+    /// @return  The loss type
+    LossType GetLossType(const std::function<double(std::vector<double>, std::vector<double>)>& f);
+
+    /// @brief      Returns the loss function for a type, throwing if the type is not one of the functions above
+    /// @param type The loss type
+    /// @return     The loss function
+    std::function<double(std::vector<double>, std::vector<double>)> GetLossFunction(LossType type);
+
+    /// @brief      Returns whether a loss takes the logits of the output layer, see cross_entropy()
+    /// @param type The loss type
+    /// @return     Whether the output layer must be linear and its outputs turned into probabilities for predictions
+    bool TakesLogits(LossType type);
+
+    /// @brief           Calculates the loss of a batch of rows and its gradient with respect to the outputs in one pass over
+    ///                  the batch, without copying rows into vectors. The softmax of a row is stabilised by its largest logit
+    ///                  and computed once for both the loss, through the log-sum-exp, and the gradient p - y * sum(y), which
+    ///                  is p - y for targets that sum to one. Binary cross entropy uses exp(-|z|) for both its loss and its
+    ///                  gradient sigmoid(z) - y. The other built-in losses have the gradients of their derivative functions.
+    ///                  Throws for LossType::Custom.
+    /// @param type      The loss type
+    /// @param columns   The number of outputs of each row
+    /// @param outputs   Row-major matrix of the values predicted by the network, the logits if the loss takes them
+    /// @param targets   Row-major matrix of the values that should have been predicted
+    /// @param gradients Row-major matrix the gradients are written to, or empty to only calculate the loss
+    /// @return          The sum of the losses of the rows
+    template<typename T>
+    double BatchLoss(LossType type, int columns, Span<const T> outputs, Span<const double> targets, Span<T> gradients = {});
+
+    /// @brief         Turns logits into the probabilities that a loss taking logits models, a softmax over every row for
+    ///                cross entropy and a sigmoid on every value for binary cross entropy, in place. Does nothing for other
+    ///                loss types.
+    /// @param type    The loss type
+    /// @param columns The number of outputs of each row
+    /// @param values  Row-major matrix of logits, overwritten by the probabilities
+    template<typename T>
+    void LogitsToProbabilities(LossType type, int columns, Span<T> values);
 }
 
 #endif // SUPPORT_FUNCTIONS_H
\ No newline at end of file
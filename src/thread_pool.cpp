@@ -0,0 +1,147 @@
+#include "thread_pool.h"
+
+#include <stdexcept>
+
+ThreadPool::ThreadPool(int numThreads)
+                       :
+                       numThreads(numThreads),
+                       spinLimit(0),
+                       currentFunction(nullptr),
+                       currentContext(nullptr),
+                       generation(0),
+                       remaining(0),
+                       stopping(false)
+{
+    if (numThreads < 1)
+    {
+        throw(std::invalid_argument("Thread pool must have at least one thread"));
+    }
+
+    // Spinning only pays off while every thread has a core of its own, otherwise it takes time from the thread being waited for
+    if (numThreads <= static_cast<int>(std::thread::hardware_concurrency()))
+    {
+        spinLimit = SpinPolls;
+    }
+
+    // The calling thread acts as worker 0, so only the remaining threads are started
+    for (int i = 1 ; i < numThreads ; i++)
+    {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::RunTask(TaskFunction function, const void* context)
+{
+    if (numThreads == 1)
+    {
+        function(context, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentFunction = function;
+        currentContext = context;
+        remaining = numThreads - 1;
+        error = nullptr;
+        generation++;
+    }
+    taskReady.notify_all();
+
+    std::exception_ptr localError;
+    try
+    {
+        function(context, 0);
+    }
+    catch (...)
+    {
+        localError = std::current_exception();
+    }
+
+    auto finished = [this]() { return remaining == 0; };
+    if (!Spin(finished))
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        taskDone.wait(lock, finished);
+    }
+    currentFunction = nullptr;
+    currentContext = nullptr;
+
+    if (localError)
+    {
+        std::rethrow_exception(localError);
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+int ThreadPool::GetNumThreads() const
+{
+    return this->numThreads;
+}
+
+void ThreadPool::WorkerLoop(int threadIndex)
+{
+    unsigned long seenGeneration = 0;
+    while (true)
+    {
+        auto woken = [&]() { return stopping || generation != seenGeneration; };
+        if (!Spin(woken))
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskReady.wait(lock, woken);
+        }
+        if (stopping)
+        {
+            return;
+        }
+
+        // The task of a generation stays in place until every worker has finished it
+        seenGeneration = generation;
+        const TaskFunction function = currentFunction;
+        const void* context = currentContext;
+
+        std::exception_ptr taskError;
+        try
+        {
+            function(context, threadIndex);
+        }
+        catch (...)
+        {
+            taskError = std::current_exception();
+        }
+
+        if (taskError)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+            {
+                error = taskError;
+            }
+        }
+        if (--remaining == 0)
+        {
+            // The caller may be between checking remaining and blocking, which it does while holding the mutex
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+            }
+            taskDone.notify_one();
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <condition_variable>
+
+class ThreadPool
+{
+    public:
+        /// @class            Fixed-size pool of persistent worker threads that all run the same task together. The thread calling
+        ///                   Run() takes part as worker 0, so a pool of one thread runs tasks inline without any synchronization.
+        ///                   Training runs a task or two per batch, so while the pool has no more threads than the machine has
+        ///                   cores, workers spin for a short while for the next task, and Run() for the last worker, before
+        ///                   blocking on a condition variable.
+        /// @param numThreads The total number of threads that run each task, including the calling thread
+        ThreadPool(int numThreads = 1);
+
+        /// @brief Stops and joins all worker threads
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// @brief      Runs task(threadIndex) once on every thread of the pool and blocks until all of them have finished.
+        ///             If any of the tasks throws, the first exception is rethrown on the calling thread. The task is passed
+        ///             to the workers by reference, so a lambda is never copied into a std::function and Run() does not
+        ///             allocate.
+        /// @param task The task to run, which receives the index of the thread running it in [0, GetNumThreads())
+        template<typename Task>
+        void Run(const Task& task)
+        {
+            RunTask([](const void* context, int threadIndex) { (*static_cast<const Task*>(context))(threadIndex); }, &task);
+        }
+
+        /// @brief  Get the number of threads that run each task
+        /// @return The number of threads
+        int GetNumThreads() const;
+
+    private:
+        /// Calls the task behind a context pointer, type-erasing it without a copy
+        using TaskFunction = void (*)(const void* context, int threadIndex);
+
+        /// @brief          Runs function(context, threadIndex) on every thread of the pool, as described for Run()
+        /// @param function Calls the task
+        /// @param context  Pointer to the task
+        void RunTask(TaskFunction function, const void* context);
+
+        /// @brief             Main loop of each worker thread, waiting for a new task generation and running it
+        /// @param threadIndex Index of this worker thread
+        void WorkerLoop(int threadIndex);
+
+        /// @brief           Spins for up to spinLimit polls until a condition holds, yielding the core between polls
+        /// @param condition Returns whether to stop waiting
+        /// @return          Whether the condition held before the limit was reached
+        template<typename Condition>
+        bool Spin(const Condition& condition) const
+        {
+            for (int i = 0 ; i < spinLimit ; i++)
+            {
+                if (condition())
+                {
+                    return true;
+                }
+                std::this_thread::yield();
+            }
+            return false;
+        }
+
+        /// Polls of a waiting thread before it blocks, long enough to span the gap between the tasks of one batch
+        static constexpr int SpinPolls = 4000;
+
+        /// Pool attributes
+        int numThreads;
+        int spinLimit;
+        std::vector<std::thread> workers;
+
+        /// State shared with the workers, guarded by the mutex. Spinning threads poll generation, remaining and stopping
+        /// without it, so those are atomic, and a thread that changes them still passes through the mutex before notifying
+        /// so that a thread about to block cannot miss the change.
+        std::mutex mutex;
+        std::condition_variable taskReady;
+        std::condition_variable taskDone;
+        TaskFunction currentFunction;
+        const void* currentContext;
+        std::atomic<unsigned long> generation;
+        std::atomic<int> remaining;
+        std::atomic<bool> stopping;
+        std::exception_ptr error;
+};
+
+#endif // THREAD_POOL_H
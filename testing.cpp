@@ -27,9 +27,15 @@ int main()
     // Train it
     n.Train();
 
-    return 0;
-}
+    // Save the weights and open them again, running the loaded network on each of the inputs
+    n.Save("xor.nnm");
+    NeuralNetwork loaded = NeuralNetwork::Load("xor.nnm");
+    for (const std::vector<double>& row : data_input)
+    {
+        double prediction;
+        loaded.Predict(row.data(), &prediction);
+        std::cout << row[0] << " XOR " << row[1] << " = " << prediction << std::endl;
+    }
 
-// TODO
-// Save and open neural net weights
-// Import an entire excel spreadsheet and run it through
\ No newline at end of file
+    return 0;
+}
\ No newline at end of file
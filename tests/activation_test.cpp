@@ -0,0 +1,170 @@
+#include "../src/kernels.h"
+#include "../src/support_functions.h"
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <iomanip>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    using ActivationFunctions::Accuracy;
+    using ActivationFunctions::ActivationType;
+
+    struct Function
+    {
+        const char* name;
+        ActivationType type;
+        /// Largest error the fast approximations are documented to reach, for the value and derivative in float and double
+        double floatBound[2];
+        double doubleBound[2];
+    };
+
+    const Function functions[] = {
+        {"sigmoid",  ActivationType::Sigmoid,  {1.2e-7, 1.2e-7}, {4e-15, 2e-15}},
+        {"tanh",     ActivationType::Tanh,     {2.4e-7, 3e-7},   {6e-15, 6e-15}},
+        {"elu",      ActivationType::Elu,      {2e-7, 2e-7},     {8e-15, 8e-15}},
+        {"softplus", ActivationType::Softplus, {2.4e-7, 1.2e-7}, {6e-15, 4e-15}},
+        {"gelu",     ActivationType::Gelu,     {3e-7, 3e-7},     {3e-7, 1e-7}},
+        {"silu",     ActivationType::Silu,     {2e-7, 2e-7},     {4e-15, 4e-15}},
+    };
+
+    /// The value and derivative of each function in long double, computed independently of the library
+    void Reference(ActivationType type, long double x, long double& y, long double& dy)
+    {
+        const long double sigmoid = 1 / (1 + std::exp(-x));
+        switch (type)
+        {
+            case ActivationType::Sigmoid:
+                y = sigmoid;
+                dy = std::exp(-x) / ((1 + std::exp(-x)) * (1 + std::exp(-x)));
+                break;
+            case ActivationType::Tanh:
+                y = std::tanh(x);
+                dy = 1 / (std::cosh(x) * std::cosh(x));
+                break;
+            case ActivationType::Elu:
+                y = (x > 0) ? x : std::expm1(x);
+                dy = (x > 0) ? 1 : std::exp(x);
+                break;
+            case ActivationType::Softplus:
+                y = std::max(x, 0.0L) + std::log1p(std::exp(-std::abs(x)));
+                dy = sigmoid;
+                break;
+            case ActivationType::Gelu:
+                y = 0.5L * x * std::erfc(-x / std::sqrt(2.0L));
+                dy = 0.5L * std::erfc(-x / std::sqrt(2.0L)) + x * std::exp(-0.5L * x * x) / std::sqrt(2 * 3.14159265358979323846264L);
+                break;
+            default:
+                y = x * sigmoid;
+                dy = sigmoid + x * sigmoid * (1 - sigmoid);
+                break;
+        }
+    }
+
+    /// Inputs spanning the region where the functions curve, plus both tails and values that overflow a naive exp
+    template<typename T>
+    std::vector<T> SweepInputs()
+    {
+        std::vector<T> inputs;
+        for (int i = -300001 ; i <= 300001 ; i++)
+        {
+            inputs.push_back(static_cast<T>(i * 1e-4));
+        }
+        for (double x : {-1e4, -1000.0, -745.0, -710.0, -100.0, -88.5, -87.5, -50.0, 50.0, 87.5, 88.5, 100.0, 710.0, 1000.0, 1e4, 1e-30, -1e-30})
+        {
+            inputs.push_back(static_cast<T>(x));
+        }
+        return inputs;
+    }
+
+    /// Largest error of the value and the derivative over a sweep, absolute below 1 and relative above
+    template<typename T>
+    void MeasureError(const Activation& activation, const std::vector<T>& inputs, double error[2])
+    {
+        std::vector<T> outputs(inputs.size()), derivatives(inputs.size());
+        activation.ApplyWithDerivative(inputs.data(), inputs.size(), outputs.data(), derivatives.data());
+        error[0] = error[1] = 0;
+        for (size_t i = 0 ; i < inputs.size() ; i++)
+        {
+            long double y, dy;
+            Reference(activation.GetType(), inputs[i], y, dy);
+            error[0] = std::max(error[0], static_cast<double>(std::abs(outputs[i] - y) / std::max(1.0L, std::abs(y))));
+            error[1] = std::max(error[1], static_cast<double>(std::abs(derivatives[i] - dy) / std::max(1.0L, std::abs(dy))));
+        }
+    }
+
+    /// Whether evaluating the value or derivative alone gives the same results as evaluating both, and NaN stays NaN
+    template<typename T>
+    bool Consistent(const Activation& activation, const std::vector<T>& inputs)
+    {
+        std::vector<T> outputs(inputs.size()), derivatives(inputs.size());
+        activation.ApplyWithDerivative(inputs.data(), inputs.size(), outputs.data(), derivatives.data());
+        std::vector<T> values = inputs, slopes = inputs;
+        activation.Apply(values.data(), values.size());
+        activation.ApplyDerivative(slopes.data(), slopes.size());
+        T nan = std::numeric_limits<T>::quiet_NaN();
+        activation.Apply(&nan, 1);
+        return values == outputs && slopes == derivatives && std::isnan(nan);
+    }
+
+    template<typename T>
+    bool Run(Kernels::InstructionSet set)
+    {
+        Kernels::SetInstructionSet(set);
+        const std::vector<T> inputs = SweepInputs<T>();
+        const bool isDouble = std::is_same<T, double>::value;
+        const std::string precision = isDouble ? "double" : "float";
+        const double epsilon = std::numeric_limits<T>::epsilon();
+
+        bool passed = true;
+        for (const Function& function : functions)
+        {
+            const Activation exact(function.type, Accuracy::Exact);
+            const Activation fast(function.type, Accuracy::Fast);
+            double exactError[2], fastError[2];
+            MeasureError(exact, inputs, exactError);
+            MeasureError(fast, inputs, fastError);
+            const double* bound = isDouble ? function.doubleBound : function.floatBound;
+
+            // libm is within a few rounding errors
+            const double exactBound = 8 * epsilon;
+            const bool accurate = fastError[0] <= bound[0] && fastError[1] <= bound[1]
+                               && exactError[0] <= exactBound && exactError[1] <= exactBound;
+            const bool consistent = Consistent(fast, inputs);
+            passed = passed && accurate && consistent;
+
+            std::cout << Kernels::GetInstructionSetName(set) << "\t" << precision << "\t" << std::setw(8) << function.name
+                      << std::scientific << std::setprecision(2)
+                      << "\tfast error " << fastError[0] << " / " << fastError[1]
+                      << " (bound " << bound[0] << " / " << bound[1] << ")"
+                      << "\texact error " << exactError[0] << " / " << exactError[1]
+                      << (accurate ? "" : "\tTOO LARGE") << (consistent ? "" : "\tINCONSISTENT") << std::endl;
+        }
+        return passed;
+    }
+}
+
+int main()
+{
+    const Kernels::InstructionSet sets[] = {Kernels::InstructionSet::Scalar, Kernels::InstructionSet::Avx2, Kernels::InstructionSet::Avx512};
+    const Kernels::InstructionSet detected = Kernels::DetectInstructionSet();
+
+    bool passed = true;
+    for (Kernels::InstructionSet set : sets)
+    {
+        if (static_cast<int>(set) > static_cast<int>(detected))
+        {
+            continue;
+        }
+        passed = Run<double>(set) && passed;
+        passed = Run<float>(set) && passed;
+    }
+    Kernels::SetInstructionSet(detected);
+
+    std::cout << "activation " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
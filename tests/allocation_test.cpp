@@ -0,0 +1,235 @@
+#include "../src/network.h"
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    /// Number of heap allocations made while counting is switched on, by any thread, including the aligned allocations that
+    /// back arenas
+    std::atomic<long> allocations(0);
+    std::atomic<bool> counting(false);
+
+    /// Stream buffer that drops everything written to it without allocating, unlike a std::ostringstream
+    class NullBuffer : public std::streambuf
+    {
+        protected:
+            int overflow(int character) override { return character; }
+    };
+}
+
+void* operator new(size_t size)
+{
+    if (counting)
+    {
+        allocations++;
+    }
+    if (void* memory = std::malloc(size ? size : 1))
+    {
+        return memory;
+    }
+    throw(std::bad_alloc());
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if (counting)
+    {
+        allocations++;
+    }
+    // aligned_alloc needs a size that is a multiple of the alignment
+    const size_t align = static_cast<size_t>(alignment);
+    if (void* memory = std::aligned_alloc(align, (size + align - 1) / align * align + (size ? 0 : align)))
+    {
+        return memory;
+    }
+    throw(std::bad_alloc());
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+    /// Counts the heap allocations made by a function
+    template<typename Function>
+    long CountAllocations(Function function)
+    {
+        allocations = 0;
+        counting = true;
+        function();
+        counting = false;
+        return allocations;
+    }
+
+    /// Synthetic regression dataset with a few outputs, y_j = sin(x_j + x_{j+1})
+    void MakeDataset(int rows, int inputs, int outputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(17);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(outputs));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            for (double& value : x[r]) { value = distribution(generator); }
+            for (int j = 0 ; j < outputs ; j++) { y[r][j] = std::sin(x[r][j] + x[r][j + 1]); }
+        }
+    }
+
+    /// After a first call to Train() has set everything up, further calls must not allocate, nor must predictions
+    template<typename T, typename Accumulator = T>
+    bool SteadyState(const char* name, int threads, typename BasicNeuralNetwork<T, Accumulator>::TrainingMode mode,
+                     const Optimizer& optimizer, bool validation)
+    {
+        using Network = BasicNeuralNetwork<T, Accumulator>;
+        std::vector<std::vector<double>> x, y;
+        MakeDataset(2000, 16, 4, x, y);
+        Network network({64, 32}, ActivationFunctions::tanh, LossFunctions::mse, 3, 0.01);
+        network.SetSeed(2);
+        network.SetBatchSize(32);
+        network.SetNumThreads(threads);
+        network.SetTrainingMode(mode);
+        network.SetOptimizer(optimizer);
+        if (validation)
+        {
+            network.SetValidationSplit(0.2);
+            network.SetEarlyStopping(100);
+        }
+        network.Initialize(x, y);
+
+        NullBuffer discarded;
+        std::streambuf* original = std::cout.rdbuf(&discarded);
+        network.Train();
+        const long training = CountAllocations([&]() { network.Train(); network.Train(); });
+        std::cout.rdbuf(original);
+
+        std::vector<T> inputs(64 * 16, static_cast<T>(0.25)), outputs(64 * 4);
+        network.PredictBatch(inputs, outputs);
+        const long inference = CountAllocations([&]()
+        {
+            for (int r = 0 ; r < 64 ; r++)
+            {
+                network.Predict(inputs.data() + 16 * r, outputs.data() + 4 * r);
+            }
+            for (int rows = 1 ; rows <= 64 ; rows *= 2)
+            {
+                network.PredictBatch(Span<const T>(inputs.data(), 16 * rows), Span<T>(outputs.data(), 4 * rows));
+            }
+        });
+
+        // Changing the batch size plans the workspaces again, which must be seen by the hook
+        const long resized = CountAllocations([&]() { network.SetBatchSize(64); });
+
+        std::cout << std::setw(34) << std::left << name << std::right << "\tallocations in two calls to Train() " << training
+                  << "\tin 71 predictions " << inference << "\tin a change of batch size " << resized << std::endl;
+        return training == 0 && inference == 0 && resized > 0;
+    }
+
+    /// Allocations are aligned, zeroed when the arena is reused, and never exceed the planned size
+    bool VerifyArena()
+    {
+        Arena arena;
+        arena.Reserve(Arena::GetSize<double>(3) + Arena::GetSize<float>(100));
+        Span<double> first = arena.Allocate<double>(3);
+        Span<float> second = arena.Allocate<float>(100);
+        bool passed = reinterpret_cast<uintptr_t>(first.data()) % Arena::Alignment == 0
+                   && reinterpret_cast<uintptr_t>(second.data()) % Arena::Alignment == 0 && arena.GetUsed() == 64 + 448;
+        first[2] = 5;
+
+        bool rejected = false;
+        try
+        {
+            arena.Allocate<char>(1);
+        }
+        catch (const std::logic_error&)
+        {
+            rejected = true;
+        }
+
+        // Reserving no more than the arena holds keeps the block and hands out zeroed memory again
+        const long reuse = CountAllocations([&]()
+        {
+            arena.Reserve(64);
+            first = arena.Allocate<double>(3);
+        });
+        passed = passed && rejected && reuse == 0 && first[2] == 0;
+
+        // Huge pages are requested from the kernel for blocks of at least 2 MB
+        Arena huge;
+        huge.Reserve(8 << 20, true);
+        Span<double> values = huge.Allocate<double>(1 << 20);
+        values[(1 << 20) - 1] = 1;
+#ifdef __linux__
+        passed = passed && huge.UsesHugePages();
+#endif
+        std::cout << "arena\t\t\t\t\talignment, bounds and reuse " << (passed ? "correct" : "WRONG") << "\thuge pages "
+                  << (huge.UsesHugePages() ? "requested" : "unavailable") << std::endl;
+        return passed;
+    }
+}
+
+int main()
+{
+    bool passed = VerifyArena();
+    passed = SteadyState<double>("double, sgd", 1, NeuralNetwork::TrainingMode::Synchronous, Optimizers::Sgd(0.01), false) && passed;
+    passed = SteadyState<double>("double, adam, 2 threads, validation", 2, NeuralNetwork::TrainingMode::Synchronous,
+                                 Optimizers::Adam(0.001), true) && passed;
+    passed = SteadyState<float>("float, momentum, 2 threads, hogwild", 2, FloatNeuralNetwork::TrainingMode::Hogwild,
+                                Optimizers::Momentum(0.01), false) && passed;
+    passed = SteadyState<float, double>("mixed, adamw, 3 threads", 3, MixedPrecisionNeuralNetwork::TrainingMode::Synchronous,
+                                        Optimizers::AdamW(0.001), true) && passed;
+
+    std::cout << "allocation " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
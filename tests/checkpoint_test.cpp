@@ -0,0 +1,160 @@
+#include "../src/network.h"
+#include "../src/data_pipeline.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+
+namespace
+{
+    /// Synthetic regression dataset, y = sin(sum of x) with inputs drawn uniformly from [-1, 1]
+    void MakeDataset(int rows, int inputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(1));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double sum = 0;
+            for (double& value : x[r]) { value = distribution(generator); sum += value; }
+            y[r][0] = std::sin(sum);
+        }
+    }
+
+    struct Result
+    {
+        std::vector<std::vector<double>> parameters;
+        std::vector<NeuralNetwork::EpochStats> history;
+        NeuralNetwork::ResumePoint resumedFrom;
+    };
+
+    /// Builds a network from the shared initial weights with the same configuration for every run. Checkpointing is set up
+    /// when a directory is given, and the run continues from a checkpoint when resumeFrom is given.
+    Result Run(const std::string& initialModel, InMemoryDataSource& source, const std::vector<std::vector<double>>& validationX,
+               const std::vector<std::vector<double>>& validationY, const std::string& directory = "", const std::string& resumeFrom = "")
+    {
+        NeuralNetwork network = NeuralNetwork::Load(initialModel);
+        network.SetEpochs(8);
+        network.SetBatchSize(32);
+        network.SetNumThreads(2);
+        network.SetOptimizer(Optimizers::Adam(0.003));
+        network.SetLearningRateSchedule(Schedules::Warmup(2, Schedules::ReduceOnPlateau(0.5, 2)));
+        network.SetEarlyStopping(100);
+        network.SetValidationData(validationX, validationY);
+        network.Initialize(source);
+        if (!directory.empty())
+        {
+            network.SetCheckpointing(directory, 130, 3);
+        }
+
+        // Every run reads through its own shuffling pipeline, as a resumed process would
+        DataPipeline::Options options;
+        options.batchRows = 64;
+        options.seed = 7;
+        DataPipeline pipeline(source, options);
+
+        // Train() reports every epoch on std::cout, which would drown out the results
+        Result result;
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        if (!resumeFrom.empty())
+        {
+            // Resuming moves a pipeline that has already been read from on to the shuffle of the resumed epoch
+            std::vector<double> inputs(64 * source.GetNumInputs()), outputs(64 * source.GetNumOutputs());
+            pipeline.ReadBatch(64, inputs.data(), outputs.data());
+            result.resumedFrom = network.Resume(resumeFrom);
+        }
+        network.Train(pipeline);
+        std::cout.rdbuf(original);
+
+        for (int i = 1 ; i < network.GetNumLayers() ; i++)
+        {
+            const NeuralNetwork::Layer& layer = network.GetLayer(i);
+            result.parameters.emplace_back(layer.GetWeights(), layer.GetWeights() + layer.GetNumWeights());
+            result.parameters.emplace_back(layer.GetBiases(), layer.GetBiases() + layer.GetNumBiases());
+        }
+        result.history = network.GetHistory();
+        return result;
+    }
+
+    /// Whether resuming a network with a different optimizer or schedule from a checkpoint is refused
+    bool Refuses(const std::string& initialModel, InMemoryDataSource& source, const std::string& file, const Optimizer& optimizer,
+                 const LearningRateSchedule& schedule)
+    {
+        NeuralNetwork network = NeuralNetwork::Load(initialModel);
+        network.SetOptimizer(optimizer);
+        network.SetLearningRateSchedule(schedule);
+        network.Initialize(source);
+        try
+        {
+            network.Resume(file);
+        }
+        catch (const std::invalid_argument&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    /// Whether two runs ended with bit-identical parameters and histories, where unevaluated validation losses are both NaN
+    bool Identical(const Result& a, const Result& b)
+    {
+        bool same = a.parameters == b.parameters && a.history.size() == b.history.size();
+        for (size_t e = 0 ; same && e < a.history.size() ; e++)
+        {
+            const NeuralNetwork::EpochStats& x = a.history[e];
+            const NeuralNetwork::EpochStats& y = b.history[e];
+            same = x.epoch == y.epoch && x.trainingLoss == y.trainingLoss && x.learningRate == y.learningRate
+                && (x.validationLoss == y.validationLoss || (std::isnan(x.validationLoss) && std::isnan(y.validationLoss)));
+        }
+        return same;
+    }
+}
+
+int main()
+{
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(4000, 4, x, y);
+    const std::vector<std::vector<double>> trainX(x.begin(), x.begin() + 3200), trainY(y.begin(), y.begin() + 3200);
+    const std::vector<std::vector<double>> validationX(x.begin() + 3200, x.end()), validationY(y.begin() + 3200, y.end());
+    InMemoryDataSource source(trainX, trainY);
+
+    const std::string initialModel = "checkpoint_test_initial.nnm";
+    const std::string directory = "checkpoint_test_checkpoints";
+    std::filesystem::remove_all(directory);
+    NeuralNetwork initial({32, 16}, ActivationFunctions::tanh, LossFunctions::mse);
+    initial.Initialize(trainX, trainY);
+    initial.Save(initialModel);
+
+    // 100 steps per epoch over 8 epochs, with a checkpoint every 130 steps of which the last 3 are kept
+    const Result uninterrupted = Run(initialModel, source, validationX, validationY);
+    const Result checkpointed = Run(initialModel, source, validationX, validationY, directory);
+    const std::vector<std::string> files = Checkpoint::ListFiles(directory);
+    const bool kept = files.size() == 3 && files.back().find("checkpoint-000000000520.nnc") != std::string::npos;
+
+    // Resume part way through the sixth epoch from the oldest checkpoint kept, as if training had been preempted there
+    const Result resumed = Run(initialModel, source, validationX, validationY, "", files.back());
+
+    // Checkpoints name their optimizer and schedule, including the schedule that follows a warm-up
+    const bool refused = Refuses(initialModel, source, files.back(), Optimizers::Sgd(0.003), Schedules::Warmup(2, Schedules::ReduceOnPlateau(0.5, 2)))
+                      && Refuses(initialModel, source, files.back(), Optimizers::Adam(0.003), Schedules::Warmup(2, Schedules::Cosine(8)));
+
+    // A damaged newer checkpoint, as a crash of the file system could leave, is skipped in favour of the latest intact one
+    std::ofstream(directory + "/checkpoint-000000999999.nnc", std::ios::binary) << "not a checkpoint";
+    const Result recovered = Run(initialModel, source, validationX, validationY, "", directory);
+    const NeuralNetwork::ResumePoint& point = recovered.resumedFrom;
+    const bool reported = point.file == files.front() && point.step == 780 && point.epoch == 8 && point.epochRows == 2560
+                       && point.skipped.size() == 1 && point.skipped[0].find("999999") != std::string::npos;
+    std::filesystem::remove_all(directory);
+    std::remove(initialModel.c_str());
+
+    const bool passed = kept && refused && reported && Identical(uninterrupted, checkpointed) && Identical(uninterrupted, resumed) && Identical(uninterrupted, recovered);
+    std::cout << "checkpoint " << (passed ? "passed" : "FAILED") << (kept ? "" : "\t(wrong checkpoints kept)")
+              << (refused ? "" : "\t(resumed with a different optimizer or schedule)")
+              << (reported ? "" : "\t(wrong resume point reported)") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+#include "../src/network.h"
+#include "../src/dataset.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+
+namespace
+{
+    const char* const CsvPath = "dataset_test.csv";
+    const char* const BinaryPath = "dataset_test.nnd";
+
+    void WriteFile(const std::string& contents)
+    {
+        std::ofstream file(CsvPath, std::ios::binary);
+        file << contents;
+    }
+
+    /// Number of files the process has open, or -1 where it cannot be counted
+    long CountOpenFiles()
+    {
+#ifdef __linux__
+        long count = 0;
+        for (const auto& entry : std::filesystem::directory_iterator("/proc/self/fd"))
+        {
+            (void)entry;
+            count++;
+        }
+        return count;
+#else
+        return -1;
+#endif
+    }
+
+    /// Reads every row of a source, inputs and outputs of each row one after the other
+    std::vector<double> ReadAll(DataSource& source, int batchRows = 3)
+    {
+        const int numInputs = source.GetNumInputs(), numOutputs = source.GetNumOutputs();
+        std::vector<double> inputs(static_cast<size_t>(batchRows) * numInputs), outputs(static_cast<size_t>(batchRows) * numOutputs);
+        std::vector<double> rows;
+        source.Reset();
+        int count;
+        while ((count = source.ReadBatch(batchRows, inputs.data(), outputs.data())) > 0)
+        {
+            for (int r = 0 ; r < count ; r++)
+            {
+                rows.insert(rows.end(), inputs.begin() + r * numInputs, inputs.begin() + (r + 1) * numInputs);
+                rows.insert(rows.end(), outputs.begin() + r * numOutputs, outputs.begin() + (r + 1) * numOutputs);
+            }
+        }
+        return rows;
+    }
+
+    bool Report(const char* name, bool passed, const std::string& detail = "")
+    {
+        std::cout << name << "\t" << (passed ? "ok" : "FAILED") << (detail.empty() ? "" : "\t" + detail) << std::endl;
+        return passed;
+    }
+
+    /// The header is skipped, CRLF line endings, blank and whitespace-only lines and a missing final newline are accepted,
+    /// and Reset() reads the same rows again
+    bool ParsesLayout()
+    {
+        WriteFile("x1,x2,y\r\n1, 2,3\r\n\r\n   \n\t4 ,5.5,-6e-1\n\n7,8,9");
+        CsvDataSource source(CsvPath, 1, true);
+        const std::vector<double> expected = {1, 2, 3, 4, 5.5, -0.6, 7, 8, 9};
+        const std::vector<double> first = ReadAll(source, 2), second = ReadAll(source, 5);
+        return Report("csv layout", source.GetNumInputs() == 2 && source.GetNumOutputs() == 1 && first == expected && second == expected);
+    }
+
+    /// Reading a file throws with a message that contains the expected text
+    bool Rejects(const char* name, const std::string& contents, bool hasHeader, const std::string& message)
+    {
+        WriteFile(contents);
+        std::string error;
+        try
+        {
+            CsvDataSource source(CsvPath, 1, hasHeader);
+            ReadAll(source);
+        }
+        catch (const std::runtime_error& exception)
+        {
+            error = exception.what();
+        }
+        return Report(name, error.find(message) != std::string::npos, error.empty() ? "nothing thrown" : error);
+    }
+
+    /// Constructors that throw after opening the file close it again
+    bool ClosesOnError()
+    {
+        const long before = CountOpenFiles();
+        for (const char* contents : {"", "1,2\n", "1,a,3\n"})
+        {
+            WriteFile(contents);
+            try
+            {
+                CsvDataSource source(CsvPath, 2);
+            }
+            catch (const std::runtime_error&)
+            {
+            }
+        }
+        const long after = CountOpenFiles();
+        return Report("csv constructor errors close the file", before == after,
+                      std::to_string(before) + " files open before, " + std::to_string(after) + " after");
+    }
+
+    /// Rows of y = (sin(x1 + x2), x2 * x3), written with enough digits to read back exactly
+    void WriteRegression(int rows, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(21);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(3));
+        y.assign(rows, std::vector<double>(2));
+        std::ofstream file(CsvPath, std::ios::binary);
+        file.precision(17);
+        file << "a,b,c,sum,product\n";
+        for (int r = 0 ; r < rows ; r++)
+        {
+            for (double& value : x[r]) { value = distribution(generator); }
+            y[r][0] = std::sin(x[r][0] + x[r][1]);
+            y[r][1] = x[r][1] * x[r][2];
+            file << x[r][0] << "," << x[r][1] << "," << x[r][2] << "," << y[r][0] << "," << y[r][1] << "\r\n";
+        }
+    }
+
+    /// A network trained by streaming the CSV file follows the same descent as one trained on the same rows in memory, and
+    /// converting the file to the binary format keeps every value
+    bool StreamsAndConverts()
+    {
+        std::vector<std::vector<double>> x, y;
+        WriteRegression(5000, x, y);
+        CsvDataSource csv(CsvPath, 2, true);
+        InMemoryDataSource memory(x, y);
+
+        const std::vector<double> csvRows = ReadAll(csv, 64);
+        const bool identical = csvRows == ReadAll(memory, 64);
+
+        BinaryDataWriter::Convert(csv, BinaryPath, 1000);
+        BinaryDataSource binary(BinaryPath);
+        const bool converted = binary.GetNumRows() == 5000 && binary.GetNumInputs() == 3 && binary.GetNumOutputs() == 2
+                            && ReadAll(binary, 77) == csvRows;
+        std::remove(BinaryPath);
+
+        auto train = [](DataSource& source)
+        {
+            NeuralNetwork network({12}, ActivationFunctions::tanh, LossFunctions::mse, 5, 0.02);
+            network.SetSeed(6);
+            network.SetBatchSize(16);
+            network.Initialize(source);
+            std::ostringstream discarded;
+            std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+            network.Train(source);
+            std::cout.rdbuf(original);
+            return network.GetHistory();
+        };
+        const std::vector<NeuralNetwork::EpochStats> streamed = train(csv), inMemory = train(memory);
+        bool sameDescent = streamed.size() == inMemory.size() && streamed.back().trainingLoss < 0.5 * streamed.front().trainingLoss;
+        for (size_t e = 0 ; sameDescent && e < streamed.size() ; e++)
+        {
+            sameDescent = streamed[e].trainingLoss == inMemory[e].trainingLoss;
+        }
+
+        std::ostringstream detail;
+        detail << "final loss " << streamed.back().trainingLoss << " (first epoch " << streamed.front().trainingLoss << ")";
+        return Report("csv rows match the in-memory rows", identical)
+             & Report("csv to binary conversion keeps every row", converted)
+             & Report("streaming the csv trains like the in-memory rows", sameDescent, detail.str());
+    }
+}
+
+int main()
+{
+    bool passed = ParsesLayout();
+    passed = Rejects("non-numeric cell", "a,b,c\n1,2,3\n\n4,x,6\n", true, "line 4 column 2 is not a number") && passed;
+    passed = Rejects("too few columns", "1,2,3\n4,5\n", false, "line 2 has too few columns") && passed;
+    passed = Rejects("too many columns", "1,2,3\n4,5,6,7\n", false, "line 2 has too many columns") && passed;
+    passed = Rejects("unexpected delimiter", "1,2,3\n4;5;6\n", false, "line 2 has an unexpected character") && passed;
+    passed = Rejects("empty file", "\n\n", false, "does not contain any rows") && passed;
+    passed = ClosesOnError() && passed;
+    passed = StreamsAndConverts() && passed;
+    std::remove(CsvPath);
+
+    std::cout << "dataset " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <limits>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    /// Synthetic regression dataset, y = sin(sum of x) with inputs drawn uniformly from [-1, 1], plus optional noise on y
+    void MakeDataset(int rows, int inputs, double noise, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(1));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double sum = 0;
+            for (double& value : x[r]) { value = distribution(generator); sum += value; }
+            y[r][0] = std::sin(sum) + noise * distribution(generator);
+        }
+    }
+
+    /// Mean squared error of the network over a dataset, computed one row at a time
+    double MeanSquaredError(const NeuralNetwork& network, const std::vector<std::vector<double>>& x, const std::vector<std::vector<double>>& y)
+    {
+        double sum = 0;
+        for (size_t r = 0 ; r < x.size() ; r++)
+        {
+            double prediction;
+            network.Predict(x[r].data(), &prediction);
+            sum += (prediction - y[r][0]) * (prediction - y[r][0]);
+        }
+        return sum / x.size();
+    }
+
+    bool Near(double value, double expected)
+    {
+        return std::abs(value - expected) <= 1e-12 * std::max(1.0, std::abs(expected));
+    }
+
+    /// The schedules are pure functions of the epoch, apart from ReduceOnPlateau which follows the losses it observes
+    bool VerifySchedules()
+    {
+        const Schedules::StepDecay step(10, 0.5);
+        const Schedules::Cosine cosine(100, 0.001);
+        const Schedules::Warmup warmup(5, Schedules::StepDecay(10, 0.1));
+        Schedules::ReduceOnPlateau plateau(0.5, 2);
+
+        bool passed = Near(step.GetLearningRate(0, 0.1), 0.1) && Near(step.GetLearningRate(9, 0.1), 0.1)
+                   && Near(step.GetLearningRate(10, 0.1), 0.05) && Near(step.GetLearningRate(25, 0.1), 0.025);
+        passed = passed && Near(cosine.GetLearningRate(0, 0.1), 0.1) && Near(cosine.GetLearningRate(50, 0.1), 0.0505)
+                        && Near(cosine.GetLearningRate(100, 0.1), 0.001) && Near(cosine.GetLearningRate(500, 0.1), 0.001);
+        passed = passed && Near(warmup.GetLearningRate(0, 0.1), 0.02) && Near(warmup.GetLearningRate(4, 0.1), 0.1)
+                        && Near(warmup.GetLearningRate(14, 0.1), 0.1) && Near(warmup.GetLearningRate(15, 0.1), 0.01);
+
+        // Improves twice, then stalls for two evaluations, which halves the rate, then stalls for two more
+        const double losses[] = {1.0, 0.9, 0.95, 0.9, 0.91, 0.92};
+        const double expected[] = {0.1, 0.1, 0.1, 0.05, 0.05, 0.025};
+        for (int i = 0 ; i < 6 ; i++)
+        {
+            plateau.Observe(losses[i]);
+            passed = passed && Near(plateau.GetLearningRate(i, 0.1), expected[i]);
+        }
+
+        std::cout << "schedules " << (passed ? "passed" : "FAILED") << std::endl;
+        return passed;
+    }
+}
+
+int main()
+{
+    const int maxEpochs = 600;
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(2500, 4, 0.3, x, y);
+    const std::vector<std::vector<double>> validationX(x.begin() + 2000, x.end()), validationY(y.begin() + 2000, y.end());
+
+    NeuralNetwork network({16}, ActivationFunctions::tanh, LossFunctions::mse, maxEpochs, 0.01);
+    network.SetBatchSize(16);
+    network.SetValidationSplit(0.2);
+    network.SetValidationInterval(2);
+    network.SetOptimizer(Optimizers::Adam(0.003));
+    network.SetLearningRateSchedule(Schedules::Warmup(3, Schedules::ReduceOnPlateau(0.5, 5, 1e-4)));
+    network.SetEarlyStopping(15, 1e-4, true);
+    network.Initialize(x, y);
+
+    // Train() reports every epoch on std::cout, which would drown out the results
+    std::ostringstream discarded;
+    std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+    network.Train();
+    std::cout.rdbuf(original);
+
+    const std::vector<NeuralNetwork::EpochStats>& history = network.GetHistory();
+    double best = std::numeric_limits<double>::infinity();
+    for (const NeuralNetwork::EpochStats& stats : history)
+    {
+        best = std::isnan(stats.validationLoss) ? best : std::min(best, stats.validationLoss);
+    }
+    const double restored = MeanSquaredError(network, validationX, validationY);
+    std::cout << std::fixed << std::setprecision(4) << "early stopping\tepochs " << history.size() << "\tbest validation mse "
+              << best << "\trestored " << restored << "\tfinal learning rate " << history.back().learningRate << std::endl;
+
+    // Training should stop well before the last epoch, with the weights of the best evaluation restored, validations only
+    // every other epoch and the learning rate ramping up over the first three
+    bool passed = VerifySchedules();
+    passed = passed && history.size() < static_cast<size_t>(maxEpochs) && std::abs(restored - best) < 1e-9
+                    && std::isnan(history[0].validationLoss) && !std::isnan(history[1].validationLoss)
+                    && Near(history[0].learningRate, 0.001) && Near(history[2].learningRate, 0.003);
+    std::cout << "early stopping " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <random>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    constexpr int NumInputs = 3;
+    constexpr int NumOutputs = 2;
+    constexpr int NumRows = 8;
+
+    /// Random rows of inputs, with targets inside the range of a sigmoid output layer
+    void MakeDataset(std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(31);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(NumRows, std::vector<double>(NumInputs));
+        y.assign(NumRows, std::vector<double>(NumOutputs));
+        for (int r = 0 ; r < NumRows ; r++)
+        {
+            for (double& value : x[r]) { value = distribution(generator); }
+            for (double& value : y[r]) { value = 0.5 + 0.4 * distribution(generator); }
+        }
+    }
+
+    /// The objective a training step descends: the squared error summed over the outputs and averaged over the rows
+    double Objective(const NeuralNetwork& network, const std::vector<std::vector<double>>& x, const std::vector<std::vector<double>>& y)
+    {
+        double sum = 0;
+        for (int r = 0 ; r < NumRows ; r++)
+        {
+            double outputs[NumOutputs];
+            network.Predict(x[r].data(), outputs);
+            for (int k = 0 ; k < NumOutputs ; k++)
+            {
+                sum += (outputs[k] - y[r][k]) * (outputs[k] - y[r][k]);
+            }
+        }
+        return sum / NumRows;
+    }
+
+    /// Every weight and bias of the network, weights then biases for each layer in turn. The network owns its parameters
+    /// (it was not loaded from a mapped file), so the test can perturb them in place.
+    std::vector<double*> Parameters(NeuralNetwork& network)
+    {
+        std::vector<double*> parameters;
+        for (int i = 1 ; i < network.GetNumLayers() ; i++)
+        {
+            NeuralNetwork::Layer& layer = const_cast<NeuralNetwork::Layer&>(network.GetLayer(i));
+            for (size_t k = 0 ; k < layer.GetNumWeights() ; k++) { parameters.push_back(layer.GetWeights() + k); }
+            for (size_t k = 0 ; k < layer.GetNumBiases() ; k++) { parameters.push_back(layer.GetBiases() + k); }
+        }
+        return parameters;
+    }
+
+    /// Compares the gradient applied by one full-batch step of plain gradient descent with a learning rate of 1 against
+    /// central differences of the objective, for a network with tanh and sigmoid hidden layers and a sigmoid output layer
+    double LargestRelativeError()
+    {
+        std::vector<std::vector<double>> x, y;
+        MakeDataset(x, y);
+        NeuralNetwork network({5, 4}, ActivationFunctions::tanh, LossFunctions::mse, 1, 1.0);
+        network.SetSeed(13);
+        network.SetBatchSize(NumRows);
+        network.Initialize(x, y);
+        network.ChangeHiddenLayerActivationFunction(ActivationFunctions::sigmoid, 2);
+        network.SetOutputActivationFunction(ActivationFunctions::sigmoid);
+
+        const std::vector<double*> parameters = Parameters(network);
+        const double step = 1e-5;
+        std::vector<double> initial(parameters.size()), numeric(parameters.size());
+        for (size_t p = 0 ; p < parameters.size() ; p++)
+        {
+            initial[p] = *parameters[p];
+            *parameters[p] = initial[p] + step;
+            const double above = Objective(network, x, y);
+            *parameters[p] = initial[p] - step;
+            const double below = Objective(network, x, y);
+            *parameters[p] = initial[p];
+            numeric[p] = (above - below) / (2 * step);
+        }
+
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        network.Train();
+        std::cout.rdbuf(original);
+
+        double largest = 0;
+        for (size_t p = 0 ; p < parameters.size() ; p++)
+        {
+            const double analytic = initial[p] - *parameters[p];
+            const double scale = std::max({std::abs(analytic), std::abs(numeric[p]), 1e-6});
+            largest = std::max(largest, std::abs(analytic - numeric[p]) / scale);
+        }
+        std::cout << "3-5-4-2, tanh and sigmoid\t" << parameters.size() << " parameters\tlargest relative error against central differences "
+                  << std::scientific << std::setprecision(2) << largest << std::endl;
+        return largest;
+    }
+}
+
+int main()
+{
+    const bool passed = LargestRelativeError() < 2e-3;
+    std::cout << "gradient " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
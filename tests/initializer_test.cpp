@@ -0,0 +1,116 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    /// Synthetic regression dataset, y = sin(sum of x) with inputs drawn uniformly from [-1, 1]
+    void MakeDataset(int rows, int inputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(1));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double sum = 0;
+            for (double& value : x[r]) { value = distribution(generator); sum += value; }
+            y[r][0] = std::sin(sum);
+        }
+    }
+
+    /// Every weight of a network, layer after layer
+    std::vector<double> Weights(const NeuralNetwork& network)
+    {
+        std::vector<double> weights;
+        for (int i = 1 ; i < network.GetNumLayers() ; i++)
+        {
+            const NeuralNetwork::Layer& layer = network.GetLayer(i);
+            weights.insert(weights.end(), layer.GetWeights(), layer.GetWeights() + layer.GetNumWeights());
+        }
+        return weights;
+    }
+
+    /// Initializes a wide network and returns its weights
+    std::vector<double> InitializeWide(uint64_t seed, int threads, const Initializer* initializer = nullptr)
+    {
+        std::vector<std::vector<double>> x(1, std::vector<double>(1024)), y(1, std::vector<double>(1));
+        NeuralNetwork network({1024, 1024}, ActivationFunctions::relu, LossFunctions::mse);
+        network.SetSeed(seed);
+        network.SetNumThreads(threads);
+        if (initializer)
+        {
+            network.SetWeightInitializer(*initializer);
+        }
+        network.Initialize(x, y);
+        return Weights(network);
+    }
+
+    /// Standard deviation of the first hidden layer of a wide network, whose weights are the first 1024 * 1024
+    double StdDev(const std::vector<double>& weights)
+    {
+        const size_t count = 1024 * 1024;
+        double sum = 0, squares = 0;
+        for (size_t i = 0 ; i < count ; i++)
+        {
+            sum += weights[i];
+            squares += weights[i] * weights[i];
+        }
+        const double mean = sum / count;
+        return std::sqrt(squares / count - mean * mean);
+    }
+
+    /// Trains a small tanh network from one initializer and returns the epochs it took to reach the target error
+    int EpochsToTarget(const Initializer& initializer, const std::vector<std::vector<double>>& x, const std::vector<std::vector<double>>& y,
+                       int maxEpochs, double target)
+    {
+        NeuralNetwork network({32, 16}, ActivationFunctions::tanh, LossFunctions::mse, 1, 0.01);
+        network.SetSeed(42);
+        network.SetWeightInitializer(initializer);
+        network.SetBatchSize(32);
+        network.Initialize(x, y);
+
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        int epochs = 0;
+        do
+        {
+            network.Train();
+            epochs++;
+        }
+        while (epochs < maxEpochs && network.GetHistory().back().trainingLoss > target);
+        std::cout.rdbuf(original);
+        return epochs;
+    }
+}
+
+int main()
+{
+    // The same seed gives the same weights whatever the thread count, and a different seed gives different weights
+    const std::vector<double> single = InitializeWide(7, 1);
+    const bool reproducible = single == InitializeWide(7, 4) && single != InitializeWide(8, 1);
+
+    // He normal for relu layers gives a standard deviation of sqrt(2 / fan in)
+    const double expected = std::sqrt(2.0 / 1024);
+    const double measured = StdDev(single);
+    const Initializer xavier = Initializers::XavierUniform();
+    const bool spread = std::abs(measured / expected - 1) < 0.01 && std::abs(StdDev(InitializeWide(7, 1, &xavier)) * std::sqrt(1024.0) - 1) < 0.01;
+    std::cout << std::fixed << std::setprecision(4) << "relu layer standard deviation " << measured << ", expected " << expected << std::endl;
+
+    // Scaled initialization trains much faster than weights spread as widely as the old integer scheme
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(4000, 4, x, y);
+    const int maxEpochs = 50;
+    const int scaled = EpochsToTarget(Initializers::XavierUniform(), x, y, maxEpochs, 0.05);
+    const int wide = EpochsToTarget(Initializers::Uniform(5), x, y, maxEpochs, 0.05);
+    std::cout << "epochs to a training loss of 0.05\txavier " << scaled << "\tuniform [-5, 5] " << wide
+              << (wide == maxEpochs ? " (did not reach it)" : "") << std::endl;
+
+    const bool passed = reproducible && spread && scaled < wide;
+    std::cout << "initializer " << (passed ? "passed" : "FAILED") << (reproducible ? "" : "\t(not reproducible)")
+              << (spread ? "" : "\t(wrong spread)") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,248 @@
+#include "../src/kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    template<typename T>
+    std::vector<T> RandomVector(size_t size, std::mt19937& generator)
+    {
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        std::vector<T> values(size);
+        for (auto& v : values) { v = static_cast<T>(distribution(generator)); }
+        return values;
+    }
+
+    template<typename T>
+    double MaxDifference(const std::vector<T>& left, const std::vector<T>& right)
+    {
+        double worst = 0;
+        for (size_t i = 0 ; i < left.size() ; i++)
+        {
+            worst = std::max(worst, std::abs(static_cast<double>(left[i]) - right[i]));
+        }
+        return worst;
+    }
+
+    /// Compares every kernel against the reference for a set of awkward shapes, returning false on a mismatch. The reference
+    /// accumulates in double, so the tolerance per product follows the rounding error of the data and accumulator types.
+    template<typename T, typename Accumulator>
+    bool Verify(Kernels::InstructionSet set)
+    {
+        Kernels::SetInstructionSet(set);
+        const double epsilon = std::is_same<T, double>::value ? 1e-10 : std::is_same<Accumulator, double>::value ? 1e-6 : 1e-5;
+        std::mt19937 generator(42);
+        const int shapes[][3] = {{1, 1, 1}, {1, 17, 33}, {5, 1, 7}, {7, 9, 1}, {13, 29, 300}, {67, 531, 259}, {130, 70, 513}};
+        bool passed = true;
+
+        for (auto& shape : shapes)
+        {
+            const int m = shape[0], n = shape[1], k = shape[2];
+            for (int transA = 0 ; transA < 2 ; transA++)
+            {
+                for (int transB = 0 ; transB < 2 ; transB++)
+                {
+                    std::vector<T> a = RandomVector<T>(static_cast<size_t>(m) * k, generator);
+                    std::vector<T> b = RandomVector<T>(static_cast<size_t>(k) * n, generator);
+                    std::vector<T> c = RandomVector<T>(static_cast<size_t>(m) * n, generator);
+                    std::vector<T> expected = c;
+                    const int lda = transA ? m : k;
+                    const int ldb = transB ? k : n;
+
+                    Kernels::Gemm<T, Accumulator>(transA, transB, m, n, k, 0.5, a.data(), lda, b.data(), ldb, 0.25, c.data(), n);
+                    Kernels::Reference::Gemm(transA, transB, m, n, k, 0.5, a.data(), lda, b.data(), ldb, 0.25, expected.data(), n);
+                    if (MaxDifference(c, expected) > epsilon * k)
+                    {
+                        std::cout << "  gemm mismatch m=" << m << " n=" << n << " k=" << k << " transA=" << transA << " transB=" << transB << std::endl;
+                        passed = false;
+                    }
+                }
+            }
+
+            for (int transA = 0 ; transA < 2 ; transA++)
+            {
+                std::vector<T> a = RandomVector<T>(static_cast<size_t>(m) * n, generator);
+                std::vector<T> x = RandomVector<T>(transA ? m : n, generator);
+                std::vector<T> y = RandomVector<T>(transA ? n : m, generator);
+                std::vector<T> expected = y;
+                Kernels::Gemv<T, Accumulator>(transA, m, n, 1.5, a.data(), n, x.data(), -1, y.data());
+                Kernels::Reference::Gemv(transA, m, n, 1.5, a.data(), n, x.data(), -1, expected.data());
+                if (MaxDifference(y, expected) > epsilon * std::max(m, n))
+                {
+                    std::cout << "  gemv mismatch m=" << m << " n=" << n << " transA=" << transA << std::endl;
+                    passed = false;
+                }
+            }
+
+            std::vector<T> a = RandomVector<T>(static_cast<size_t>(m) * n, generator);
+            std::vector<T> x = RandomVector<T>(m, generator);
+            std::vector<T> y = RandomVector<T>(n, generator);
+            std::vector<T> expected = a;
+            Kernels::Ger(m, n, -0.75, x.data(), y.data(), a.data(), n);
+            Kernels::Reference::Ger(m, n, -0.75, x.data(), y.data(), expected.data(), n);
+            if (MaxDifference(a, expected) > (std::is_same<T, double>::value ? 1e-12 : 1e-6))
+            {
+                std::cout << "  ger mismatch m=" << m << " n=" << n << std::endl;
+                passed = false;
+            }
+        }
+
+        return passed;
+    }
+
+    /// Random quantized operands, A in the [0, 127] range the integer kernels require and B over the whole int8 range
+    void RandomQuantized(size_t size, std::mt19937& generator, std::vector<uint8_t>& a, std::vector<int8_t>& b)
+    {
+        std::uniform_int_distribution<int> unsignedValues(0, 127), signedValues(-128, 127);
+        a.resize(size);
+        b.resize(size);
+        for (auto& v : a) { v = static_cast<uint8_t>(unsignedValues(generator)); }
+        for (auto& v : b) { v = static_cast<int8_t>(signedValues(generator)); }
+    }
+
+    /// Integer sums are exact, so the quantized kernels must match the reference bit for bit
+    bool VerifyQuantized(Kernels::InstructionSet set)
+    {
+        Kernels::SetInstructionSet(set);
+        std::mt19937 generator(42);
+        const int shapes[][3] = {{1, 1, 1}, {1, 17, 33}, {5, 1, 7}, {7, 9, 64}, {13, 29, 300}, {67, 531, 259}, {3, 2000, 65}};
+        bool passed = true;
+
+        for (auto& shape : shapes)
+        {
+            const int m = shape[0], n = shape[1], k = shape[2];
+            std::vector<uint8_t> a, unused;
+            std::vector<int8_t> b, unusedSigned;
+            RandomQuantized(static_cast<size_t>(m) * k, generator, a, unusedSigned);
+            RandomQuantized(static_cast<size_t>(n) * k, generator, unused, b);
+            std::vector<int32_t> c(static_cast<size_t>(m) * n), expected(c.size());
+            Kernels::QuantizedGemm(m, n, k, a.data(), k, b.data(), k, c.data(), n);
+            Kernels::Reference::QuantizedGemm(m, n, k, a.data(), k, b.data(), k, expected.data(), n);
+            if (c != expected)
+            {
+                std::cout << "  quantized gemm mismatch m=" << m << " n=" << n << " k=" << k << std::endl;
+                passed = false;
+            }
+        }
+
+        // Quantizing must clamp values far outside the range and round halfway cases to even, like the scalar code
+        std::uniform_real_distribution<float> distribution(-4, 4);
+        for (int n : {1, 7, 8, 31, 64, 1000})
+        {
+            const float scale = 0.03125f;
+            const int zeroPoint = 60;
+            std::vector<float> x(n);
+            for (int i = 0 ; i < n ; i++)
+            {
+                x[i] = i % 3 ? distribution(generator) : (static_cast<int>(distribution(generator) * 32) + 0.5f) * scale;
+            }
+            std::vector<uint8_t> q(n), expected(n);
+            Kernels::Quantize(n, x.data(), scale, zeroPoint, q.data());
+            for (int i = 0 ; i < n ; i++)
+            {
+                const float value = std::max(0.0f, std::min(127.0f, x[i] * (1.0f / scale) + static_cast<float>(zeroPoint)));
+                expected[i] = static_cast<uint8_t>(std::nearbyint(value));
+            }
+            if (q != expected)
+            {
+                std::cout << "  quantize mismatch n=" << n << std::endl;
+                passed = false;
+            }
+        }
+        return passed;
+    }
+
+    /// Compares the fused optimizer steps of an instruction set with the scalar steps over several lengths, so that both the
+    /// vector loops and their scalar tails are covered. Vector fused multiply-adds round differently, hence the tolerance.
+    template<typename T>
+    bool VerifyOptimizer(Kernels::InstructionSet set)
+    {
+        const double epsilon = std::is_same<T, double>::value ? 1e-12 : 1e-5;
+        std::mt19937 generator(42);
+        bool passed = true;
+
+        Kernels::StepParameters<T> step;
+        step.learningRate = 0.01;
+        step.gradientScale = 0.25;
+        step.l2 = 0.001;
+        step.decay = 0.01;
+        step.beta1 = 0.9;
+        step.beta2 = 0.999;
+        step.epsilon = 1e-8;
+        step.firstCorrection = 10;
+        step.secondCorrection = 1000;
+
+        for (int n : {1, 7, 8, 31, 64, 1000})
+        {
+            const std::vector<T> gradients = RandomVector<T>(n, generator);
+            const std::vector<T> initial = RandomVector<T>(n, generator);
+            std::vector<T> first = RandomVector<T>(n, generator), second = RandomVector<T>(n, generator);
+            for (T& value : second) { value = std::abs(value); }
+
+            // Results of every step for the instruction set under test, then for the scalar code
+            std::vector<T> results[2][5];
+            const Kernels::InstructionSet order[2] = {set, Kernels::InstructionSet::Scalar};
+            for (int run = 0 ; run < 2 ; run++)
+            {
+                Kernels::SetInstructionSet(order[run]);
+                std::vector<T>* result = results[run];
+                result[0] = initial;
+                Kernels::SgdStep(n, step, result[0].data(), gradients.data());
+                result[1] = initial;
+                result[2] = first;
+                Kernels::MomentumStep(n, step, result[1].data(), gradients.data(), result[2].data());
+                std::vector<T> moment = first, squares = second;
+                result[3] = initial;
+                Kernels::AdamStep(n, step, result[3].data(), gradients.data(), moment.data(), squares.data());
+                result[3].insert(result[3].end(), moment.begin(), moment.end());
+                result[3].insert(result[3].end(), squares.begin(), squares.end());
+                squares = second;
+                result[4] = initial;
+                Kernels::RmsPropStep(n, step, result[4].data(), gradients.data(), squares.data());
+                result[4].insert(result[4].end(), squares.begin(), squares.end());
+            }
+
+            const char* names[5] = {"sgd", "momentum", "momentum velocity", "adam", "rmsprop"};
+            for (int k = 0 ; k < 5 ; k++)
+            {
+                if (MaxDifference(results[0][k], results[1][k]) > epsilon)
+                {
+                    std::cout << "  " << names[k] << " step mismatch n=" << n << std::endl;
+                    passed = false;
+                }
+            }
+        }
+
+        Kernels::SetInstructionSet(set);
+        return passed;
+    }
+}
+
+int main()
+{
+    const Kernels::InstructionSet sets[] = {Kernels::InstructionSet::Scalar, Kernels::InstructionSet::Avx2, Kernels::InstructionSet::Avx512};
+    const Kernels::InstructionSet detected = Kernels::DetectInstructionSet();
+    bool passed = true;
+
+    std::cout << "Detected instruction set: " << Kernels::GetInstructionSetName(detected) << std::endl;
+    for (auto set : sets)
+    {
+        if (static_cast<int>(set) > static_cast<int>(detected))
+        {
+            continue;
+        }
+
+        bool verified = Verify<double, double>(set) && Verify<float, float>(set) && Verify<float, double>(set) && VerifyQuantized(set)
+                     && VerifyOptimizer<double>(set) && VerifyOptimizer<float>(set);
+        std::cout << Kernels::GetInstructionSetName(set) << "\tverification " << (verified ? "passed" : "FAILED") << std::endl;
+        passed = passed && verified;
+    }
+
+    std::cout << "kernels " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <limits>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    using LossFunctions::LossType;
+
+    /// Logits and targets of a batch, one-hot for cross entropy and probabilities for binary cross entropy
+    void MakeBatch(LossType type, int rows, int columns, double spread, std::vector<double>& logits, std::vector<double>& targets)
+    {
+        std::mt19937 generator(99);
+        std::uniform_real_distribution<double> distribution(-spread, spread);
+        logits.resize(static_cast<size_t>(rows) * columns);
+        targets.resize(logits.size());
+        for (size_t k = 0 ; k < logits.size() ; k++)
+        {
+            logits[k] = distribution(generator);
+            targets[k] = (type == LossType::SoftmaxCrossEntropy) ? 0 : 0.5 + 0.5 * distribution(generator) / spread;
+        }
+        if (type == LossType::SoftmaxCrossEntropy)
+        {
+            for (int r = 0 ; r < rows ; r++)
+            {
+                targets[static_cast<size_t>(r) * columns + generator() % columns] = 1;
+            }
+        }
+    }
+
+    /// Largest difference between the batched gradients and central differences of the batched loss
+    double GradientError(LossType type)
+    {
+        const int rows = 8, columns = 5;
+        std::vector<double> logits, targets, gradients(rows * columns);
+        MakeBatch(type, rows, columns, 4, logits, targets);
+        LossFunctions::BatchLoss<double>(type, columns, logits, targets, gradients);
+
+        double error = 0;
+        const double step = 1e-6;
+        for (size_t k = 0 ; k < logits.size() ; k++)
+        {
+            const double original = logits[k];
+            logits[k] = original + step;
+            const double above = LossFunctions::BatchLoss<double>(type, columns, logits, targets);
+            logits[k] = original - step;
+            const double below = LossFunctions::BatchLoss<double>(type, columns, logits, targets);
+            logits[k] = original;
+
+            // The batched gradients are per output, as for d_mse, while the mean losses divide by the number of columns
+            const double scale = (type == LossType::SoftmaxCrossEntropy) ? 1 : columns;
+            error = std::max(error, std::abs(gradients[k] - scale * (above - below) / (2 * step)));
+        }
+        return error;
+    }
+
+    /// Logits far beyond the range of exp must still give finite losses that match the exact values, and probabilities
+    /// that sum to one
+    bool Stable()
+    {
+        const std::vector<double> logits = {1000, -1000, 998, 0, -1e4, 1e4, 50, 40};
+        const std::vector<double> onehot = {0, 0, 1, 0, 0, 1, 0, 0};
+        std::vector<double> gradients(logits.size());
+        const double loss = LossFunctions::BatchLoss<double>(LossType::SoftmaxCrossEntropy, 4, logits, onehot, gradients);
+
+        // Row 1 loses log(1 + e^2) to the larger logit, row 2 is certain of its class
+        const double expected = std::log1p(std::exp(2.0));
+        bool stable = std::abs(loss - expected) < 1e-12 && std::abs(gradients[0] + gradients[2]) < 1e-12 && gradients[5] == 0;
+
+        const std::vector<double> targets = {1, 0, 1, 0.5, 0, 1, 1, 0};
+        const double binary = LossFunctions::BatchLoss<double>(LossType::BinaryCrossEntropy, 4, logits, targets, gradients);
+        // Only the undecided logit and the confident mistake at 40 cost more than e^-50
+        const double binaryExpected = (std::log(2.0) + 40 + std::log1p(std::exp(-40.0)) + std::log1p(std::exp(-50.0))) / 4;
+        stable = stable && std::abs(binary - binaryExpected) < 1e-12 && gradients[0] == 0 && gradients[1] == 0 && gradients[3] == 0;
+
+        std::vector<float> probabilities(logits.begin(), logits.end());
+        LossFunctions::LogitsToProbabilities<float>(LossType::SoftmaxCrossEntropy, 4, probabilities);
+        stable = stable && std::abs(probabilities[0] + probabilities[2] - 1) < 1e-6 && probabilities[5] == 1;
+
+        std::cout << "large logits\tcross entropy " << loss << " (expected " << expected << ")\tbinary " << binary << std::endl;
+        return stable && std::isfinite(loss) && std::isfinite(binary);
+    }
+
+    /// The vector loss functions give the same losses as the batched path, and a network trained with cross entropy learns
+    /// to classify separable blobs and predicts probabilities
+    bool TrainsClassifier()
+    {
+        const int classes = 3, rows = 1500;
+        std::mt19937 generator(7);
+        std::normal_distribution<double> noise(0, 0.4);
+        std::vector<std::vector<double>> x(rows, std::vector<double>(2)), y(rows, std::vector<double>(classes, 0));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            const int label = r % classes;
+            x[r][0] = std::cos(2.0944 * label) + noise(generator);
+            x[r][1] = std::sin(2.0944 * label) + noise(generator);
+            y[r][label] = 1;
+        }
+
+        NeuralNetwork network({16}, ActivationFunctions::tanh, LossFunctions::cross_entropy, 1, 0.05);
+        bool rejected = false;
+        try
+        {
+            network.SetOutputActivationFunction(ActivationFunctions::sigmoid);
+        }
+        catch (const std::logic_error&)
+        {
+            rejected = true;
+        }
+
+        network.SetSeed(3);
+        network.SetBatchSize(16);
+        network.Initialize(x, y);
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        for (int epoch = 0 ; epoch < 30 ; epoch++)
+        {
+            network.Train();
+        }
+        std::cout.rdbuf(original);
+
+        int correct = 0;
+        double largestSumError = 0;
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double probabilities[classes];
+            network.Predict(x[r].data(), probabilities);
+            const int predicted = std::max_element(probabilities, probabilities + classes) - probabilities;
+            correct += y[r][predicted] == 1;
+            largestSumError = std::max(largestSumError, std::abs(probabilities[0] + probabilities[1] + probabilities[2] - 1));
+        }
+        const double accuracy = static_cast<double>(correct) / rows;
+
+        // The vector form of the loss agrees with the batch form it is built on
+        const std::vector<double> logits = {2, -1, 0.5}, onehot = {0, 1, 0};
+        const double vectorLoss = LossFunctions::cross_entropy(logits, onehot);
+        const double expected = std::log(std::exp(2.0) + std::exp(-1.0) + std::exp(0.5)) + 1;
+        const bool agrees = std::abs(vectorLoss - expected) < 1e-12
+                         && LossFunctions::GetLossType(LossFunctions::cross_entropy) == LossType::SoftmaxCrossEntropy
+                         && LossFunctions::GetLossType(LossFunctions::binary_cross_entropy) == LossType::BinaryCrossEntropy;
+
+        std::cout << "classifier\taccuracy " << std::fixed << std::setprecision(3) << accuracy << "\tfinal loss "
+                  << network.GetHistory().back().trainingLoss << std::scientific << "\tlargest probability sum error "
+                  << largestSumError << (rejected ? "" : "\t(sigmoid output accepted)") << std::endl;
+        return rejected && agrees && accuracy > 0.9 && largestSumError < 1e-12;
+    }
+
+    /// Squared error of a row, a custom loss given as a plain function pointer
+    double SquaredError(std::vector<double> predicted, std::vector<double> actual)
+    {
+        double sum = 0;
+        for (size_t k = 0 ; k < predicted.size() ; k++)
+        {
+            sum += (predicted[k] - actual[k]) * (predicted[k] - actual[k]);
+        }
+        return sum / predicted.size();
+    }
+
+    /// Custom losses, given as a lambda or as a function pointer, are refused for training until they have a derivative,
+    /// and then train like the built-in loss they compute
+    bool TrainsCustomLoss()
+    {
+        std::mt19937 generator(5);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        std::vector<std::vector<double>> x(400, std::vector<double>(3)), y(400, std::vector<double>(2));
+        for (size_t r = 0 ; r < x.size() ; r++)
+        {
+            for (double& value : x[r]) { value = distribution(generator); }
+            y[r][0] = std::sin(x[r][0] + x[r][1]);
+            y[r][1] = x[r][1] * x[r][2];
+        }
+
+        auto train = [&](NeuralNetwork& network, bool withDerivative)
+        {
+            network.SetSeed(8);
+            network.SetBatchSize(8);
+            network.Initialize(x, y);
+            if (withDerivative)
+            {
+                network.SetLossDerivative(LossFunctions::d_mse);
+            }
+            std::ostringstream discarded;
+            std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+            try
+            {
+                network.Train();
+            }
+            catch (const std::invalid_argument&)
+            {
+                std::cout.rdbuf(original);
+                return false;
+            }
+            std::cout.rdbuf(original);
+            return true;
+        };
+
+        auto lambda = [](std::vector<double> predicted, std::vector<double> actual) { return SquaredError(predicted, actual); };
+        NeuralNetwork builtIn({16}, ActivationFunctions::tanh, LossFunctions::mse, 20, 0.02);
+        NeuralNetwork fromLambda({16}, ActivationFunctions::tanh, lambda, 20, 0.02);
+        NeuralNetwork fromPointer({16}, ActivationFunctions::tanh, SquaredError, 20, 0.02);
+        NeuralNetwork withoutDerivative({16}, ActivationFunctions::tanh, lambda, 20, 0.02);
+
+        bool builtInRefused = false;
+        try
+        {
+            builtIn.SetLossDerivative(LossFunctions::d_mae);
+        }
+        catch (const std::invalid_argument&)
+        {
+            builtInRefused = true;
+        }
+        const bool custom = fromLambda.GetLossType() == LossType::Custom && fromPointer.GetLossType() == LossType::Custom;
+        const bool refused = !train(withoutDerivative, false);
+        const bool trained = train(builtIn, false) && train(fromLambda, true) && train(fromPointer, true);
+
+        // The custom losses compute the same values and gradients as mse, so they follow the same descent
+        const double first = builtIn.GetHistory().front().trainingLoss, last = builtIn.GetHistory().back().trainingLoss;
+        double largestDifference = 0;
+        for (const NeuralNetwork* network : {&fromLambda, &fromPointer})
+        {
+            largestDifference = std::max(largestDifference, std::abs(network->GetHistory().back().trainingLoss - last));
+        }
+        const bool passed = custom && builtInRefused && refused && trained && last < 0.5 * first && largestDifference < 1e-9;
+
+        std::cout << "custom loss\tlambda and function pointer, final loss " << std::scientific << std::setprecision(3) << last
+                  << " (first epoch " << first << ")\tlargest difference from mse " << largestDifference
+                  << "\ttraining without a derivative " << (refused ? "refused" : "ACCEPTED") << "\t" << (passed ? "ok" : "FAILED") << std::endl;
+        return passed;
+    }
+}
+
+int main()
+{
+    bool passed = true;
+    const LossType types[] = {LossType::Mse, LossType::Mae, LossType::SoftmaxCrossEntropy, LossType::BinaryCrossEntropy};
+    const char* names[] = {"mse", "mae", "cross entropy", "binary cross entropy"};
+    for (int i = 0 ; i < 4 ; i++)
+    {
+        const double error = GradientError(types[i]);
+        const bool accurate = error < 1e-6;
+        passed = passed && accurate;
+        std::cout << "gradient\t" << names[i] << "\tlargest error against central differences " << std::scientific
+                  << std::setprecision(2) << error << (accurate ? "" : "\tTOO LARGE") << std::endl;
+    }
+    passed = Stable() && passed;
+    passed = TrainsClassifier() && passed;
+    passed = TrainsCustomLoss() && passed;
+
+    std::cout << "loss " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
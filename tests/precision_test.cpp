@@ -0,0 +1,170 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    /// Results of training one precision on a dataset
+    struct Result
+    {
+        double initialLoss = 0;
+        double finalLoss = 0;
+    };
+
+    /// Reference datasets, each with inputs drawn uniformly from [-1, 1]
+    void MakeRegression(int rows, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(16));
+        y.assign(rows, std::vector<double>(1));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double sum = 0;
+            for (double& value : x[r]) { value = distribution(generator); sum += value; }
+            y[r][0] = std::sin(sum);
+        }
+    }
+
+    void MakeClassification(int rows, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(4321);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(2));
+        y.assign(rows, std::vector<double>(2));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            x[r][0] = distribution(generator);
+            x[r][1] = distribution(generator);
+            const bool inside = x[r][0] * x[r][0] + x[r][1] * x[r][1] < 0.5;
+            y[r][0] = inside ? 1 : 0;
+            y[r][1] = inside ? 0 : 1;
+        }
+    }
+
+    /// Mean squared error of a network over a whole dataset, with the predictions made in the precision of the network
+    template<typename T, typename Accumulator>
+    double MeanSquaredError(const BasicNeuralNetwork<T, Accumulator>& network, const std::vector<std::vector<double>>& x,
+                            const std::vector<std::vector<double>>& y)
+    {
+        std::vector<T> inputs, outputs(x.size() * y[0].size());
+        for (const auto& row : x)
+        {
+            inputs.insert(inputs.end(), row.begin(), row.end());
+        }
+        network.PredictBatch(inputs, outputs);
+
+        double sum = 0;
+        for (size_t r = 0 ; r < y.size() ; r++)
+        {
+            for (size_t j = 0 ; j < y[r].size() ; j++)
+            {
+                const double error = outputs[r * y[r].size() + j] - y[r][j];
+                sum += error * error;
+            }
+        }
+        return sum / outputs.size();
+    }
+
+    /// Loads the shared initial weights into a network of the given precision, trains it and measures the loss before and after
+    template<typename T, typename Accumulator>
+    Result Train(const std::string& path, const std::vector<std::vector<double>>& x, const std::vector<std::vector<double>>& y)
+    {
+        BasicNeuralNetwork<T, Accumulator> network = BasicNeuralNetwork<T, Accumulator>::Load(path);
+        network.SetBatchSize(32);
+        network.Initialize(x, y);
+
+        Result result;
+        result.initialLoss = MeanSquaredError(network, x, y);
+
+        // Train() reports every epoch on std::cout, which would drown out the results
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        network.Train();
+        std::cout.rdbuf(original);
+
+        result.finalLoss = MeanSquaredError(network, x, y);
+        return result;
+    }
+
+    /// Trains every precision from the same initial weights and checks that single and mixed precision reach the same loss as
+    /// double precision to within a tolerance, returning false if they do not
+    bool Compare(const char* name, NeuralNetwork& network, const std::vector<std::vector<double>>& x, const std::vector<std::vector<double>>& y)
+    {
+        const std::string path = "precision_test.nnm";
+        network.Initialize(x, y);
+        network.Save(path);
+
+        const Result results[] = {Train<double, double>(path, x, y), Train<float, float>(path, x, y), Train<float, double>(path, x, y)};
+        const char* precisions[] = {"double", "float", "mixed"};
+        std::remove(path.c_str());
+
+        bool passed = true;
+        const double reference = results[0].finalLoss;
+        for (int i = 0 ; i < 3 ; i++)
+        {
+            // Rounding to float changes the trajectory slightly, so the losses are only expected to agree to a few percent
+            const bool initialMatches = std::abs(results[i].initialLoss - results[0].initialLoss) <= 1e-5 * (1 + results[0].initialLoss);
+            const bool finalMatches = std::abs(results[i].finalLoss - reference) <= 0.05 * reference + 1e-4;
+            std::cout << name << "\t" << precisions[i] << "\tloss " << results[i].initialLoss << " -> " << results[i].finalLoss
+                      << (initialMatches && finalMatches ? "" : "\tMISMATCH") << std::endl;
+            passed = passed && initialMatches && finalMatches;
+        }
+        return passed;
+    }
+
+    /// A model file whose layer table points a weight matrix past the end of the file, with an offset so large that adding
+    /// the size of the matrix wraps around, is rejected rather than read out of bounds
+    bool RejectsOverflowingOffsets()
+    {
+        const std::string path = "precision_test_corrupt.nnm";
+        std::vector<std::vector<double>> x(4, std::vector<double>(2)), y(4, std::vector<double>(1));
+        NeuralNetwork network({4}, ActivationFunctions::tanh, LossFunctions::mse);
+        network.Initialize(x, y);
+        network.Save(path);
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            const uint64_t offset = std::numeric_limits<uint64_t>::max() - ModelFile::Alignment + 1;
+            file.seekp(sizeof(ModelFile::Header) + sizeof(ModelFile::LayerRecord) + offsetof(ModelFile::LayerRecord, weightOffset));
+            file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+        }
+
+        bool rejected = false;
+        try
+        {
+            NeuralNetwork::Load(path, false);
+        }
+        catch (const std::runtime_error& error)
+        {
+            rejected = std::string(error.what()).find("invalid layer table") != std::string::npos;
+        }
+        std::remove(path.c_str());
+        std::cout << "layer offset past the end of the file\t" << (rejected ? "rejected" : "ACCEPTED") << std::endl;
+        return rejected;
+    }
+}
+
+int main()
+{
+    std::vector<std::vector<double>> x, y;
+    bool passed = true;
+
+    MakeRegression(4000, x, y);
+    NeuralNetwork regression({64, 64}, ActivationFunctions::tanh, LossFunctions::mse, 20, 0.001);
+    passed = Compare("regression", regression, x, y) && passed;
+
+    MakeClassification(4000, x, y);
+    NeuralNetwork classification({32}, ActivationFunctions::tanh, LossFunctions::mse, 20, 0.01);
+    classification.SetOutputActivationFunction(ActivationFunctions::sigmoid);
+    passed = Compare("classification", classification, x, y) && passed;
+
+    passed = RejectsOverflowingOffsets() && passed;
+
+    std::cout << "precision " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include "../src/network.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <iostream>
+
+#ifndef NN_ENABLE_PROFILING
+#error "The profiler test must be built with -DNN_ENABLE_PROFILING"
+#endif
+
+namespace
+{
+    /// Synthetic regression dataset, y = sin(sum of x) with inputs drawn uniformly from [-1, 1]
+    void MakeDataset(int rows, int inputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(1));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double sum = 0;
+            for (double& value : x[r]) { value = distribution(generator); sum += value; }
+            y[r][0] = std::sin(sum);
+        }
+    }
+}
+
+int main()
+{
+    const int rows = 5000, batchSize = 32, epochs = 3;
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(rows, 32, x, y);
+
+    NeuralNetwork network({128, 64}, ActivationFunctions::tanh, LossFunctions::mse, epochs, 0.001);
+    network.SetBatchSize(batchSize);
+    network.Initialize(x, y);
+    network.EnableProfiling(true, true);
+
+    // Train() reports every epoch on std::cout, which would drown out the results
+    std::ostringstream discarded;
+    std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+    network.Train();
+    std::cout.rdbuf(original);
+    const Profiler::Report report = network.GetProfile();
+
+    const Profiler::Phase phases[] = {Profiler::Phase::DataLoading, Profiler::Phase::Forward, Profiler::Phase::Loss,
+                                      Profiler::Phase::Backward, Profiler::Phase::WeightUpdate};
+    double timed = 0;
+    for (Profiler::Phase phase : phases)
+    {
+        timed += report.Get(phase).seconds;
+    }
+
+    // Every batch runs each layer forward, backward and through the update once, and the timed phases cover the run
+    const long batches = static_cast<long>(epochs) * ((rows + batchSize - 1) / batchSize);
+    const long layerCalls = batches * (static_cast<long>(report.layers.size()) - 1);
+    const bool consistent = report.samples == static_cast<long>(epochs) * rows
+                         && report.Get(Profiler::Phase::Forward).calls == layerCalls
+                         && report.Get(Profiler::Phase::Backward).calls == layerCalls
+                         && report.Get(Profiler::Phase::WeightUpdate).calls == layerCalls
+                         && report.Get(Profiler::Phase::Loss).calls == batches
+                         && report.Get(Profiler::Phase::DataLoading).calls == batches + epochs
+                         && timed <= report.seconds && timed > 0.5 * report.seconds;
+    std::cout << "profile\t" << report.samples << " samples\t" << batches << " batches\t"
+              << (consistent ? "consistent" : "INCONSISTENT") << std::endl;
+
+    // The trace is in the Chrome trace event format, with a complete event for every timed scope
+    const std::string path = "profiler_test_trace.json";
+    network.WriteProfileTrace(path);
+    std::ifstream file(path);
+    const std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path.c_str());
+    const bool written = trace.find("\"traceEvents\"") != std::string::npos && trace.find("\"ph\":\"X\"") != std::string::npos;
+    std::cout << "trace\t" << trace.size() << " bytes\t" << (written ? "ok" : "FAILED") << std::endl;
+
+    const bool passed = consistent && written;
+    std::cout << "profiler " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
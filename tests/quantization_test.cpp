@@ -0,0 +1,188 @@
+#include "../src/network.h"
+#include "../src/quantization.h"
+
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    /// Synthetic classification dataset with four classes, decided by the signs of two random projections of the inputs
+    void MakeDataset(int rows, int inputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(2024);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        std::vector<double> first(inputs), second(inputs);
+        for (int k = 0 ; k < inputs ; k++)
+        {
+            first[k] = distribution(generator);
+            second[k] = distribution(generator);
+        }
+
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(4, 0));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            double a = 0, b = 0;
+            for (int k = 0 ; k < inputs ; k++)
+            {
+                x[r][k] = distribution(generator);
+                a += first[k] * x[r][k];
+                b += second[k] * x[r][k];
+            }
+            y[r][(a > 0 ? 1 : 0) + (b > 0 ? 2 : 0)] = 1;
+        }
+    }
+
+    /// Writes a model file of ReLU hidden layers with weights drawn uniformly from +-sqrt(6 / inputs) and zero biases, which
+    /// the test loads as its starting point so that the deep model it quantizes is well trained
+    void WriteInitialModel(const std::string& path, const std::vector<int>& sizes)
+    {
+        std::mt19937 generator(99);
+        std::vector<ModelFile::LayerRecord> records(sizes.size());
+        uint64_t offset = ModelFile::AlignUp(sizeof(ModelFile::Header) + records.size() * sizeof(ModelFile::LayerRecord));
+        const uint64_t parameterOffset = offset;
+        for (size_t i = 0 ; i < sizes.size() ; i++)
+        {
+            ModelFile::LayerRecord& record = records[i];
+            std::memset(&record, 0, sizeof(record));
+            record.numInputs = i ? sizes[i - 1] : 0;
+            record.numNeurons = sizes[i];
+            const bool hidden = i > 0 && i + 1 < sizes.size();
+            record.activationType = static_cast<uint32_t>(hidden ? ActivationFunctions::ActivationType::Relu : ActivationFunctions::ActivationType::Linear);
+            record.weightOffset = offset;
+            offset = ModelFile::AlignUp(offset + static_cast<uint64_t>(record.numInputs) * record.numNeurons * sizeof(double));
+            record.biasOffset = offset;
+            offset = ModelFile::AlignUp(offset + (record.numInputs ? record.numNeurons : 0) * sizeof(double));
+        }
+
+        std::vector<char> parameters(offset - parameterOffset, 0);
+        for (size_t i = 1 ; i < sizes.size() ; i++)
+        {
+            const double limit = std::sqrt(6.0 / records[i].numInputs);
+            std::uniform_real_distribution<double> distribution(-limit, limit);
+            double* weights = reinterpret_cast<double*>(parameters.data() + (records[i].weightOffset - parameterOffset));
+            for (size_t w = 0 ; w < static_cast<size_t>(records[i].numInputs) * records[i].numNeurons ; w++)
+            {
+                weights[w] = distribution(generator);
+            }
+        }
+
+        ModelFile::Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, ModelFile::Magic, sizeof(header.magic));
+        header.version = ModelFile::Version;
+        header.byteOrderMark = ModelFile::ByteOrderMark;
+        header.scalarSize = sizeof(double);
+        header.numLayers = records.size();
+        header.lossType = static_cast<uint32_t>(LossFunctions::LossType::Mse);
+        header.parameterOffset = parameterOffset;
+        header.fileSize = offset;
+        header.checksum = ModelFile::Checksum(records.data(), records.size() * sizeof(ModelFile::LayerRecord));
+        header.checksum = ModelFile::Checksum(parameters.data(), parameters.size(), header.checksum);
+
+        std::vector<char> padding(parameterOffset - sizeof(header) - records.size() * sizeof(ModelFile::LayerRecord), 0);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ModelFile::LayerRecord));
+        file.write(padding.data(), padding.size());
+        file.write(parameters.data(), parameters.size());
+    }
+
+    /// Accuracy and error of a model's predictions over a dataset
+    struct Accuracy
+    {
+        double meanSquaredError = 0;
+        double accuracy = 0;
+    };
+
+    Accuracy Evaluate(const std::vector<double>& predictions, const std::vector<std::vector<double>>& y)
+    {
+        Accuracy result;
+        const size_t outputs = y[0].size();
+        long correct = 0;
+        for (size_t r = 0 ; r < y.size() ; r++)
+        {
+            const double* row = predictions.data() + r * outputs;
+            for (size_t j = 0 ; j < outputs ; j++)
+            {
+                result.meanSquaredError += (row[j] - y[r][j]) * (row[j] - y[r][j]);
+            }
+            const size_t predicted = std::max_element(row, row + outputs) - row;
+            correct += y[r][predicted] == 1;
+        }
+        result.meanSquaredError /= predictions.size();
+        result.accuracy = static_cast<double>(correct) / y.size();
+        return result;
+    }
+
+    /// Fraction of rows where two models pick the same class
+    double Agreement(const std::vector<double>& left, const std::vector<double>& right, size_t outputs)
+    {
+        long same = 0;
+        for (size_t r = 0 ; r < left.size() / outputs ; r++)
+        {
+            const double* a = left.data() + r * outputs;
+            const double* b = right.data() + r * outputs;
+            same += (std::max_element(a, a + outputs) - a) == (std::max_element(b, b + outputs) - b);
+        }
+        return static_cast<double>(same) / (left.size() / outputs);
+    }
+}
+
+int main()
+{
+    const int numInputs = 64;
+    std::vector<std::vector<double>> x, y, testX, testY;
+    MakeDataset(8000, numInputs, x, y);
+    MakeDataset(4096, numInputs, testX, testY);
+
+    WriteInitialModel("quantization_test.nnm", {numInputs, 256, 256, 4});
+    NeuralNetwork network = NeuralNetwork::Load("quantization_test.nnm");
+    std::remove("quantization_test.nnm");
+    network.SetEpochs(10);
+    network.SetBatchSize(32);
+    network.Initialize(x, y);
+
+    // Train() reports every epoch on std::cout, which would drown out the results
+    std::ostringstream discarded;
+    std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+    network.Train();
+    std::cout.rdbuf(original);
+
+    std::vector<double> testInputs;
+    for (const auto& row : testX)
+    {
+        testInputs.insert(testInputs.end(), row.begin(), row.end());
+    }
+    std::vector<double> reference(testY.size() * 4);
+    network.PredictBatch(testInputs, reference);
+    const Accuracy baseline = Evaluate(reference, testY);
+    std::cout << "double\taccuracy=" << baseline.accuracy << "\tmse=" << baseline.meanSquaredError << std::endl;
+
+    // Calibrate on the training data and compare against the double model on held out data
+    InMemoryDataSource calibration(x, y);
+    bool passed = true;
+    for (auto granularity : {QuantizedNetwork::Granularity::PerLayer, QuantizedNetwork::Granularity::PerChannel})
+    {
+        QuantizedNetwork::Options options;
+        options.granularity = granularity;
+        QuantizedNetwork quantized(network, calibration, options);
+
+        std::vector<double> predictions(reference.size());
+        quantized.PredictBatch(testInputs, predictions);
+        const Accuracy result = Evaluate(predictions, testY);
+        const double agreement = Agreement(reference, predictions, 4);
+        const bool withinBounds = baseline.accuracy - result.accuracy <= 0.02 && agreement >= 0.97;
+        std::cout << (granularity == QuantizedNetwork::Granularity::PerLayer ? "int8 per-layer" : "int8 per-channel")
+                  << "\taccuracy=" << result.accuracy << " (" << (result.accuracy - baseline.accuracy) * 100 << " points)"
+                  << "\tmse=" << result.meanSquaredError << "\tagreement=" << agreement << (withinBounds ? "" : "\tOUT OF BOUNDS") << std::endl;
+        passed = passed && withinBounds;
+    }
+
+    std::cout << "quantization " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+#include "../src/network.h"
+#include "../src/inference_server.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <iomanip>
+#include <iostream>
+#include <functional>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+#define NN_HAS_SOCKETS 1
+#endif
+
+namespace
+{
+    constexpr int NumInputs = 32;
+    constexpr int NumOutputs = 4;
+    const char* const ModelPath = "server_test.nnm";
+    const char* const SocketPath = "server_test.sock";
+
+    /// Saves a 32-512-512-4 network with random weights, which the servers load as the tools would
+    void SaveModel()
+    {
+        std::mt19937 generator(9);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        std::vector<std::vector<double>> x(256, std::vector<double>(NumInputs)), y(256, std::vector<double>(NumOutputs));
+        for (size_t r = 0 ; r < x.size() ; r++)
+        {
+            for (double& value : x[r]) { value = distribution(generator); }
+            for (double& value : y[r]) { value = distribution(generator); }
+        }
+        NeuralNetwork network({512, 512}, ActivationFunctions::tanh, LossFunctions::mse);
+        network.SetSeed(4);
+        network.Initialize(x, y);
+        network.Save(ModelPath);
+    }
+
+    /// Random rows of inputs
+    std::vector<double> MakeInputs(int rows, int seed)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        std::vector<double> inputs(static_cast<size_t>(rows) * NumInputs);
+        for (double& value : inputs)
+        {
+            value = distribution(generator);
+        }
+        return inputs;
+    }
+
+    /// Checks that a client of the server at an endpoint sees the served model, and gets the predictions of the local copy
+    /// for requests of several sizes
+    bool VerifyAnswers(const char* name, const InferenceProtocol::Endpoint& endpoint, const NeuralNetwork& reference)
+    {
+        InferenceClient client(endpoint);
+        bool passed = client.GetNumInputs() == NumInputs && client.GetNumOutputs() == NumOutputs;
+        double maxError = 0;
+        for (int rows : {1, 7, 64, 100})
+        {
+            const std::vector<double> inputs = MakeInputs(rows, rows);
+            std::vector<double> outputs(static_cast<size_t>(rows) * NumOutputs), expected(outputs.size());
+            client.Predict(inputs, outputs);
+            reference.PredictBatch(inputs, expected);
+            for (size_t k = 0 ; k < outputs.size() ; k++)
+            {
+                maxError = std::max(maxError, std::abs(outputs[k] - expected[k]));
+            }
+        }
+        passed = passed && maxError <= 1e-12;
+
+        // The client refuses requests the server would reject, without sending them
+        bool refused = false;
+        try
+        {
+            const int rows = client.GetMaxRequestRows() + 1;
+            std::vector<double> inputs(static_cast<size_t>(rows) * NumInputs), outputs(static_cast<size_t>(rows) * NumOutputs);
+            client.Predict(inputs, outputs);
+        }
+        catch (const std::invalid_argument&)
+        {
+            refused = true;
+        }
+        passed = passed && refused;
+
+        std::cout << std::scientific << std::setprecision(1) << name << "\t\tmax error against the local model " << maxError
+                  << "\toversized request refused " << (refused ? "yes" : "no") << "\t" << (passed ? "ok" : "FAILED") << std::endl;
+        return passed;
+    }
+
+    /// Sends a request of zero rows past the client's checks, which the server must answer with BadRequest
+    bool VerifyRejection(const std::string& socketPath)
+    {
+        bool passed = false;
+#ifdef NN_HAS_SOCKETS
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        socketPath.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        const int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+        InferenceProtocol::Hello hello;
+        const InferenceProtocol::RequestHeader request = {InferenceProtocol::RequestMagic, 0, 42};
+        InferenceProtocol::ResponseHeader response;
+        passed = descriptor >= 0 && connect(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0
+              && recv(descriptor, &hello, sizeof(hello), MSG_WAITALL) == sizeof(hello)
+              && send(descriptor, &request, sizeof(request), 0) == sizeof(request)
+              && recv(descriptor, &response, sizeof(response), MSG_WAITALL) == sizeof(response)
+              && response.magic == InferenceProtocol::ResponseMagic && response.status == InferenceProtocol::BadRequest && response.id == 42;
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+#endif
+        std::cout << "empty request answered with BadRequest\t" << (passed ? "ok" : "FAILED") << std::endl;
+        return passed;
+    }
+
+    /// Sends single-row requests from several connections at once to a server that batches them, checking every answer
+    /// against the local copy, and that the server combined requests into larger batches
+    bool VerifyBatching(const NeuralNetwork& reference)
+    {
+        InferenceServer::Options options;
+        options.endpoint.socketPath = SocketPath;
+        options.maxBatchRows = 16;
+        options.maxWaitMicroseconds = 500;
+        InferenceServer server(NeuralNetwork::Load(ModelPath), options);
+        server.Start();
+
+        const int connections = 16, requests = 40;
+        std::atomic<long> mismatches(0);
+        auto client = [&](int seed)
+        {
+            try
+            {
+                InferenceClient connection(server.GetEndpoint());
+                const std::vector<double> inputs = MakeInputs(1, seed);
+                std::vector<double> outputs(NumOutputs), expected(NumOutputs);
+                reference.PredictBatch(inputs, expected);
+                for (int r = 0 ; r < requests ; r++)
+                {
+                    connection.Predict(inputs, outputs);
+                    for (int k = 0 ; k < NumOutputs ; k++)
+                    {
+                        if (std::abs(outputs[k] - expected[k]) > 1e-12)
+                        {
+                            mismatches++;
+                            break;
+                        }
+                    }
+                }
+            }
+            catch (const std::exception&)
+            {
+                mismatches++;
+            }
+        };
+        std::vector<std::thread> clients;
+        for (int c = 0 ; c < connections ; c++)
+        {
+            clients.emplace_back(client, c + 1);
+        }
+        for (std::thread& thread : clients)
+        {
+            thread.join();
+        }
+        const InferenceServer::Report report = server.GetReport();
+        server.Stop();
+
+        const bool passed = mismatches == 0 && report.requests == connections * requests && report.meanBatchRows > 1;
+        std::cout << std::fixed << std::setprecision(2) << connections << " concurrent connections\twrong answers " << mismatches
+                  << "\tmean rows per batch " << report.meanBatchRows << "\t" << (passed ? "ok" : "FAILED") << std::endl;
+        return passed;
+    }
+}
+
+int main()
+{
+    bool passed = true;
+    SaveModel();
+    const NeuralNetwork reference = NeuralNetwork::Load(ModelPath);
+
+    {
+        InferenceServer::Options options;
+        options.endpoint.socketPath = SocketPath;
+        options.maxRequestRows = 128;
+        InferenceServer server(NeuralNetwork::Load(ModelPath), options);
+        server.Start();
+        passed = VerifyAnswers("unix socket", server.GetEndpoint(), reference) && passed;
+        passed = VerifyRejection(SocketPath) && passed;
+        passed = server.GetReport().rejected == 1 && passed;
+        server.Stop();
+    }
+    {
+        // Port 0 listens on a free port on 127.0.0.1, reported by GetEndpoint()
+        InferenceServer::Options options;
+        options.maxRequestRows = 128;
+        InferenceServer server(NeuralNetwork::Load(ModelPath), options);
+        server.Start();
+        passed = server.GetEndpoint().port > 0 && passed;
+        passed = VerifyAnswers("tcp port", server.GetEndpoint(), reference) && passed;
+        server.Stop();
+    }
+
+    // Concurrent single-row requests must be combined into batches, and still get their own answers
+    passed = VerifyBatching(reference) && passed;
+
+    std::remove(ModelPath);
+    std::cout << "server " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+#include "../src/network.h"
+#include "../src/static_network.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    using ActivationFunctions::Accuracy;
+    using ActivationFunctions::ActivationType;
+
+    /// Exclusive-or from two relu neurons, relu(a + b) - 2 * relu(a + b - 1), compiled in as a constant
+    constexpr StaticNetwork<double, 2, StaticLayer<2, ActivationType::Relu>, StaticLayer<1>> Xor({1, 1, 1, 1, 0, -1, 1, -2, 0});
+    static_assert(Xor.GetParameters()[5] == -1, "The parameters of an embedded network are known at compile time");
+
+    /// Random rows of inputs and targets, only used to size and initialize the dynamic networks
+    void MakeDataset(int rows, int inputs, int outputs, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(5);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(inputs));
+        y.assign(rows, std::vector<double>(outputs));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            for (double& value : x[r]) { value = distribution(generator); }
+            for (double& value : y[r]) { value = distribution(generator); }
+        }
+    }
+
+    /// Builds a dynamic network with the topology of a static one, and checks that the static copy, and the copy loaded
+    /// from a saved model, predict the same outputs
+    template<typename T, typename Static>
+    bool Compare(const char* name, std::vector<int> hidden, std::vector<ActivationType> activations, double tolerance,
+                 Accuracy accuracy = Accuracy::Exact)
+    {
+        std::vector<std::vector<double>> x, y;
+        MakeDataset(1024, Static::NumInputs, Static::NumOutputs, x, y);
+        BasicNeuralNetwork<T> network(hidden, Activation(activations[0], accuracy), LossFunctions::mse);
+        network.SetSeed(11);
+        network.Initialize(x, y);
+        for (size_t i = 1 ; i < hidden.size() ; i++)
+        {
+            network.ChangeHiddenLayerActivationFunction(Activation(activations[i], accuracy), static_cast<int>(i) + 1);
+        }
+
+        const Static model(network);
+        const std::string path = std::string("static_network_test_") + name + ".nnm";
+        network.Save(path);
+        const Static loaded = Static::Load(path);
+        std::remove(path.c_str());
+
+        const int rows = static_cast<int>(x.size());
+        std::vector<T> inputs(static_cast<size_t>(rows) * Static::NumInputs);
+        for (int r = 0 ; r < rows ; r++)
+        {
+            std::copy(x[r].begin(), x[r].end(), inputs.begin() + static_cast<size_t>(r) * Static::NumInputs);
+        }
+        std::vector<T> dynamicOutputs(static_cast<size_t>(rows) * Static::NumOutputs), staticOutputs(dynamicOutputs.size());
+        std::vector<T> loadedOutputs(dynamicOutputs.size());
+        network.PredictBatch(inputs, dynamicOutputs);
+        model.PredictBatch(inputs, staticOutputs);
+        loaded.PredictBatch(inputs, loadedOutputs);
+
+        // The sums are added in a different order than the blocked kernels, so they only agree to a few rounding errors
+        double error = 0;
+        for (size_t k = 0 ; k < dynamicOutputs.size() ; k++)
+        {
+            error = std::max(error, std::abs(static_cast<double>(staticOutputs[k] - dynamicOutputs[k])) / std::max(1.0, std::abs(static_cast<double>(dynamicOutputs[k]))));
+        }
+        const bool matches = error <= tolerance && loadedOutputs == staticOutputs;
+
+        std::cout << std::setw(22) << std::left << name << std::right << std::scientific << std::setprecision(2)
+                  << "\tlargest difference " << error << (matches ? "" : "\tMISMATCH") << std::endl;
+        return matches;
+    }
+
+    /// The embedded exclusive-or network, a topology mismatch that must throw, and parameters written as source code
+    /// that read back exactly
+    bool VerifyConstruction()
+    {
+        bool passed = true;
+        const double expected[4] = {0, 1, 1, 0};
+        for (int i = 0 ; i < 4 ; i++)
+        {
+            const std::array<double, 1> output = Xor.Predict({static_cast<double>(i & 1), static_cast<double>(i >> 1)});
+            passed = passed && output[0] == expected[i];
+        }
+
+        std::vector<std::vector<double>> x, y;
+        MakeDataset(16, 3, 2, x, y);
+        NeuralNetwork network({5}, ActivationFunctions::tanh, LossFunctions::mse);
+        network.Initialize(x, y);
+        bool rejected = false;
+        try
+        {
+            StaticNetwork<double, 3, StaticLayer<5, ActivationType::Relu>, StaticLayer<2>> mismatched(network);
+        }
+        catch (const std::invalid_argument&)
+        {
+            rejected = true;
+        }
+
+        const StaticNetwork<float, 3, StaticLayer<5, ActivationType::Tanh>, StaticLayer<2>> model(network);
+        std::ostringstream source;
+        model.WriteParameters(source);
+        std::string text = source.str();
+        const std::array<float, decltype(model)::NumParameters> parameters = model.GetParameters();
+        const char* position = text.c_str() + 1;
+        for (float parameter : parameters)
+        {
+            char* end;
+            passed = passed && static_cast<float>(std::strtod(position, &end)) == parameter;
+            position = end + 1;
+        }
+
+        std::cout << "construction\texclusive or " << (passed ? "correct" : "WRONG") << "\tmismatched topology "
+                  << (rejected ? "rejected" : "ACCEPTED") << std::endl;
+        return passed && rejected;
+    }
+}
+
+int main()
+{
+    bool passed = VerifyConstruction();
+
+    using Small = StaticNetwork<double, 4, StaticLayer<8, ActivationType::Relu>, StaticLayer<1>>;
+    using Medium = StaticNetwork<double, 16, StaticLayer<32, ActivationType::Tanh>, StaticLayer<16, ActivationType::Relu>, StaticLayer<4>>;
+    using MediumFast = StaticNetwork<double, 16, StaticLayer<32, ActivationType::Tanh, Accuracy::Fast>, StaticLayer<16, ActivationType::Relu>, StaticLayer<4>>;
+    using Wide = StaticNetwork<float, 8, StaticLayer<64, ActivationType::Relu>, StaticLayer<64, ActivationType::Relu>, StaticLayer<10>>;
+    using Smooth = StaticNetwork<float, 16, StaticLayer<32, ActivationType::Silu>, StaticLayer<3>>;
+    passed = Compare<double, Small>("4-8-1 relu", {8}, {ActivationType::Relu}, 1e-13) && passed;
+    passed = Compare<double, Medium>("16-32-16-4 tanh relu", {32, 16}, {ActivationType::Tanh, ActivationType::Relu}, 1e-13) && passed;
+    passed = Compare<double, MediumFast>("16-32-16-4 fast tanh", {32, 16}, {ActivationType::Tanh, ActivationType::Relu}, 1e-13, Accuracy::Fast) && passed;
+    passed = Compare<float, Wide>("8-64-64-10 relu", {64, 64}, {ActivationType::Relu, ActivationType::Relu}, 1e-5) && passed;
+    passed = Compare<float, Smooth>("16-32-3 silu", {32}, {ActivationType::Silu}, 1e-5) && passed;
+
+    std::cout << "static network " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
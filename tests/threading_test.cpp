@@ -0,0 +1,124 @@
+#include "../src/network.h"
+#include "../src/thread_pool.h"
+
+#include <cmath>
+#include <atomic>
+#include <random>
+#include <cstring>
+#include <sstream>
+#include <iostream>
+
+namespace
+{
+    /// Synthetic regression dataset, y = (sin(x1 + x2), x3 * x4) with inputs drawn uniformly from [-1, 1]
+    void MakeDataset(int rows, std::vector<std::vector<double>>& x, std::vector<std::vector<double>>& y)
+    {
+        std::mt19937 generator(17);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+        x.assign(rows, std::vector<double>(8));
+        y.assign(rows, std::vector<double>(2));
+        for (int r = 0 ; r < rows ; r++)
+        {
+            for (double& value : x[r]) { value = distribution(generator); }
+            y[r][0] = std::sin(x[r][0] + x[r][1]);
+            y[r][1] = x[r][2] * x[r][3];
+        }
+    }
+
+    /// Bytes of every weight and bias of a network after training it from a fixed seed
+    template<typename T>
+    std::vector<unsigned char> TrainedParameters(int threads, const Optimizer& optimizer, const std::vector<std::vector<double>>& x,
+                                                 const std::vector<std::vector<double>>& y)
+    {
+        BasicNeuralNetwork<T> network({32, 16}, ActivationFunctions::tanh, LossFunctions::mse, 3);
+        network.SetSeed(12);
+        network.SetBatchSize(64);
+        network.SetNumThreads(threads);
+        network.SetOptimizer(optimizer);
+        network.Initialize(x, y);
+        std::ostringstream discarded;
+        std::streambuf* original = std::cout.rdbuf(discarded.rdbuf());
+        network.Train();
+        std::cout.rdbuf(original);
+
+        std::vector<unsigned char> bytes;
+        for (int i = 1 ; i < network.GetNumLayers() ; i++)
+        {
+            const auto& layer = network.GetLayer(i);
+            const unsigned char* weights = reinterpret_cast<const unsigned char*>(layer.GetWeights());
+            const unsigned char* biases = reinterpret_cast<const unsigned char*>(layer.GetBiases());
+            bytes.insert(bytes.end(), weights, weights + layer.GetNumWeights() * sizeof(T));
+            bytes.insert(bytes.end(), biases, biases + layer.GetNumBiases() * sizeof(T));
+        }
+        return bytes;
+    }
+
+    /// Two runs with the same seed and thread count end with bit-identical parameters
+    template<typename T>
+    bool Reproducible(const char* name, const Optimizer& optimizer, const std::vector<std::vector<double>>& x,
+                      const std::vector<std::vector<double>>& y)
+    {
+        bool passed = true;
+        std::cout << name;
+        for (int threads : {1, 2, 4})
+        {
+            const bool identical = TrainedParameters<T>(threads, optimizer, x, y) == TrainedParameters<T>(threads, optimizer, x, y);
+            passed = passed && identical;
+            std::cout << "\t" << threads << (threads == 1 ? " thread " : " threads ") << (identical ? "identical" : "DIFFERENT");
+        }
+        std::cout << std::endl;
+        return passed;
+    }
+
+    /// An exception thrown by any thread of the pool, including the calling one, reaches the caller of Run() once every
+    /// thread has finished, and the pool keeps working afterwards
+    bool RethrowsErrors()
+    {
+        bool passed = true;
+        for (int threads : {1, 4})
+        {
+            ThreadPool pool(threads);
+            for (int thrower = 0 ; thrower < threads ; thrower++)
+            {
+                std::atomic<int> finished(0);
+                std::string message;
+                try
+                {
+                    pool.Run([&](int threadIndex)
+                    {
+                        if (threadIndex == thrower)
+                        {
+                            throw(std::runtime_error("thread " + std::to_string(threadIndex)));
+                        }
+                        finished++;
+                    });
+                }
+                catch (const std::runtime_error& error)
+                {
+                    message = error.what();
+                }
+                passed = passed && message == "thread " + std::to_string(thrower) && finished == threads - 1;
+            }
+
+            std::atomic<int> ran(0);
+            pool.Run([&](int) { ran++; });
+            passed = passed && ran == threads;
+        }
+        std::cout << "thread pool rethrows the exception of any worker\t" << (passed ? "ok" : "FAILED") << std::endl;
+        return passed;
+    }
+}
+
+int main()
+{
+    std::vector<std::vector<double>> x, y;
+    MakeDataset(2000, x, y);
+
+    bool passed = Reproducible<double>("double, sgd", Optimizers::Sgd(0.05), x, y);
+    passed = Reproducible<double>("double, adam", Optimizers::Adam(0.002), x, y) && passed;
+    passed = Reproducible<float>("float, momentum", Optimizers::Momentum(0.02), x, y) && passed;
+    passed = RethrowsErrors() && passed;
+
+    std::cout << "threading " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#include "../src/inference_server.h"
+
+#include <csignal>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    void RequestStop(int)
+    {
+        stopRequested = 1;
+    }
+
+    int Usage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " MODEL (--socket=PATH | --port=PORT) [--max-batch=ROWS] [--max-wait-us=MICROSECONDS]\n"
+                  << "       [--workers=THREADS] [--max-request-rows=ROWS] [--report-seconds=SECONDS]\n\n"
+                  << "Serves predictions of a model saved with NeuralNetwork::Save() over a Unix domain socket or a TCP port on\n"
+                  << "127.0.0.1, batching concurrent requests. Prints latency percentiles and batch sizes every --report-seconds\n"
+                  << "(0 for never) and when stopped with SIGINT or SIGTERM." << std::endl;
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string modelPath;
+    InferenceServer::Options options;
+    double reportSeconds = 10;
+    try
+    {
+        for (int i = 1 ; i < argc ; i++)
+        {
+            const std::string flag = argv[i];
+            auto value = [&flag](const char* name) { return flag.substr(std::strlen(name)); };
+            if (flag.rfind("--socket=", 0) == 0)
+            {
+                options.endpoint.socketPath = value("--socket=");
+            }
+            else if (flag.rfind("--port=", 0) == 0)
+            {
+                options.endpoint.port = std::stoi(value("--port="));
+            }
+            else if (flag.rfind("--max-batch=", 0) == 0)
+            {
+                options.maxBatchRows = std::stoi(value("--max-batch="));
+            }
+            else if (flag.rfind("--max-wait-us=", 0) == 0)
+            {
+                options.maxWaitMicroseconds = std::stoi(value("--max-wait-us="));
+            }
+            else if (flag.rfind("--workers=", 0) == 0)
+            {
+                options.numWorkers = std::stoi(value("--workers="));
+            }
+            else if (flag.rfind("--max-request-rows=", 0) == 0)
+            {
+                options.maxRequestRows = std::stoi(value("--max-request-rows="));
+            }
+            else if (flag.rfind("--report-seconds=", 0) == 0)
+            {
+                reportSeconds = std::stod(value("--report-seconds="));
+            }
+            else if (flag.rfind("--", 0) != 0 && modelPath.empty())
+            {
+                modelPath = flag;
+            }
+            else
+            {
+                std::cerr << "Unknown flag " << flag << std::endl;
+                return Usage(argv[0]);
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        return Usage(argv[0]);
+    }
+    if (modelPath.empty() || (options.endpoint.socketPath.empty() && options.endpoint.port == 0))
+    {
+        return Usage(argv[0]);
+    }
+
+    try
+    {
+        InferenceServer server(NeuralNetwork::Load(modelPath), options);
+        server.Start();
+        const InferenceProtocol::Endpoint endpoint = server.GetEndpoint();
+        std::cout << "Serving " << modelPath << " on " << (endpoint.socketPath.empty() ? "127.0.0.1:" + std::to_string(endpoint.port) : endpoint.socketPath)
+                  << " with batches of up to " << options.maxBatchRows << " rows, waiting at most " << options.maxWaitMicroseconds
+                  << " us, on " << options.numWorkers << " worker" << (options.numWorkers == 1 ? "" : "s") << std::endl;
+
+        std::signal(SIGINT, RequestStop);
+        std::signal(SIGTERM, RequestStop);
+        auto lastReport = InferenceServer::Clock::now();
+        while (!stopRequested)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            const auto now = InferenceServer::Clock::now();
+            if (reportSeconds > 0 && std::chrono::duration<double>(now - lastReport).count() >= reportSeconds)
+            {
+                InferenceServer::WriteReport(server.GetReport(), std::cout);
+                lastReport = now;
+            }
+        }
+
+        server.Stop();
+        InferenceServer::WriteReport(server.GetReport(), std::cout);
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
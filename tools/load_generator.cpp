@@ -0,0 +1,169 @@
+#include "../src/inference_server.h"
+
+#include <cmath>
+#include <random>
+#include <cstring>
+#include <iomanip>
+#include <functional>
+#include <iostream>
+
+namespace
+{
+    int Usage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " (--socket=PATH | --port=PORT) [--connections=N] [--rows=ROWS] [--seconds=SECONDS]\n"
+                  << "       [--warmup-seconds=SECONDS] [--verify=MODEL]\n\n"
+                  << "Benchmarks an inference server with N connections that each send a request of random inputs and wait for\n"
+                  << "its response before sending the next (a closed loop), then prints the throughput and the latency seen by\n"
+                  << "the clients. --verify compares every response with the predictions of a local copy of the model." << std::endl;
+        return 2;
+    }
+
+    /// @brief What the clients measured after the warm-up
+    struct Totals
+    {
+        std::atomic<long> requests{0};
+        std::atomic<long> mismatches{0};
+        std::atomic<long> failures{0};
+        LatencyHistogram latency;
+    };
+
+    /// @brief Sends requests on one connection until the deadline, recording those sent after the warm-up
+    void RunClient(const InferenceProtocol::Endpoint& endpoint, int rows, int seed, const NeuralNetwork* reference,
+                   InferenceServer::Clock::time_point measureStart, InferenceServer::Clock::time_point end, Totals& totals)
+    {
+        try
+        {
+            InferenceClient client(endpoint);
+            std::mt19937 generator(seed);
+            std::uniform_real_distribution<double> distribution(-1, 1);
+            std::vector<double> inputs(static_cast<size_t>(rows) * client.GetNumInputs());
+            std::vector<double> outputs(static_cast<size_t>(rows) * client.GetNumOutputs()), expected(outputs.size());
+
+            InferenceServer::Clock::time_point now;
+            while ((now = InferenceServer::Clock::now()) < end)
+            {
+                for (double& value : inputs)
+                {
+                    value = distribution(generator);
+                }
+                client.Predict(inputs, outputs);
+                const InferenceServer::Clock::time_point done = InferenceServer::Clock::now();
+                if (now < measureStart)
+                {
+                    continue;
+                }
+
+                totals.requests++;
+                totals.latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(done - now).count());
+                if (reference)
+                {
+                    reference->PredictBatch(inputs, expected);
+                    for (size_t k = 0 ; k < outputs.size() ; k++)
+                    {
+                        if (std::abs(outputs[k] - expected[k]) > 1e-9 * std::max(1.0, std::abs(expected[k])))
+                        {
+                            totals.mismatches++;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        catch (const std::exception& error)
+        {
+            std::cerr << error.what() << std::endl;
+            totals.failures++;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    InferenceProtocol::Endpoint endpoint;
+    int connections = 16;
+    int rows = 1;
+    double seconds = 5;
+    double warmupSeconds = 1;
+    std::string verifyPath;
+    try
+    {
+        for (int i = 1 ; i < argc ; i++)
+        {
+            const std::string flag = argv[i];
+            auto value = [&flag](const char* name) { return flag.substr(std::strlen(name)); };
+            if (flag.rfind("--socket=", 0) == 0)
+            {
+                endpoint.socketPath = value("--socket=");
+            }
+            else if (flag.rfind("--port=", 0) == 0)
+            {
+                endpoint.port = std::stoi(value("--port="));
+            }
+            else if (flag.rfind("--connections=", 0) == 0)
+            {
+                connections = std::stoi(value("--connections="));
+            }
+            else if (flag.rfind("--rows=", 0) == 0)
+            {
+                rows = std::stoi(value("--rows="));
+            }
+            else if (flag.rfind("--seconds=", 0) == 0)
+            {
+                seconds = std::stod(value("--seconds="));
+            }
+            else if (flag.rfind("--warmup-seconds=", 0) == 0)
+            {
+                warmupSeconds = std::stod(value("--warmup-seconds="));
+            }
+            else if (flag.rfind("--verify=", 0) == 0)
+            {
+                verifyPath = value("--verify=");
+            }
+            else
+            {
+                std::cerr << "Unknown flag " << flag << std::endl;
+                return Usage(argv[0]);
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        return Usage(argv[0]);
+    }
+    if ((endpoint.socketPath.empty() && endpoint.port == 0) || connections < 1 || rows < 1 || seconds <= 0 || warmupSeconds < 0)
+    {
+        return Usage(argv[0]);
+    }
+
+    std::unique_ptr<NeuralNetwork> reference;
+    if (!verifyPath.empty())
+    {
+        reference.reset(new NeuralNetwork(NeuralNetwork::Load(verifyPath)));
+    }
+
+    Totals totals;
+    const auto measureStart = InferenceServer::Clock::now() + std::chrono::duration_cast<InferenceServer::Clock::duration>(std::chrono::duration<double>(warmupSeconds));
+    const auto end = measureStart + std::chrono::duration_cast<InferenceServer::Clock::duration>(std::chrono::duration<double>(seconds));
+    std::vector<std::thread> clients;
+    for (int c = 0 ; c < connections ; c++)
+    {
+        clients.emplace_back(RunClient, endpoint, rows, c + 1, reference.get(), measureStart, end, std::ref(totals));
+    }
+    for (std::thread& client : clients)
+    {
+        client.join();
+    }
+
+    const long requests = totals.requests;
+    std::cout << std::fixed << std::setprecision(1) << connections << " connections, " << rows << " row" << (rows == 1 ? "" : "s")
+              << " per request\trequests per second " << requests / seconds << "\trows per second " << requests * rows / seconds << std::endl;
+    std::cout << "latency (us)\tp50 " << totals.latency.GetPercentile(0.5) / 1e3 << "\tp90 " << totals.latency.GetPercentile(0.9) / 1e3
+              << "\tp99 " << totals.latency.GetPercentile(0.99) / 1e3 << "\tp99.9 " << totals.latency.GetPercentile(0.999) / 1e3
+              << "\tmax " << totals.latency.GetMax() / 1e3 << std::endl;
+    if (reference)
+    {
+        std::cout << "verified " << requests << " responses, " << totals.mismatches << " differ from the local model" << std::endl;
+    }
+    return (totals.failures || totals.mismatches) ? 1 : 0;
+}